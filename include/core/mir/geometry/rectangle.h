@@ -23,6 +23,7 @@
 #include "displacement.h"
 
 #include <ostream>
+#include <vector>
 
 namespace mir
 {
@@ -123,6 +124,28 @@ Rectangle<T> intersection_of(Rectangle<T> const& a, Rectangle<T> const& b)
         return {};
 }
 
+/// The parts of \a rect outside \a hole, as up to four non-overlapping rectangles
+template<typename T>
+std::vector<Rectangle<T>> difference_of(Rectangle<T> const& rect, Rectangle<T> const& hole)
+{
+    auto const overlap = intersection_of(rect, hole);
+    if (overlap == Rectangle<T>{})
+        return {rect};
+
+    std::vector<Rectangle<T>> pieces;
+    auto const add = [&pieces](X<T> left, Y<T> top, X<T> right, Y<T> bottom)
+        {
+            if (left < right && top < bottom)
+                pieces.push_back({{left, top}, {(right - left).as_value(), (bottom - top).as_value()}});
+        };
+
+    add(rect.left(), rect.top(), rect.right(), overlap.top());
+    add(rect.left(), overlap.bottom(), rect.right(), rect.bottom());
+    add(rect.left(), overlap.top(), overlap.left(), overlap.bottom());
+    add(overlap.right(), overlap.top(), rect.right(), overlap.bottom());
+    return pieces;
+}
+
 template<typename T>
 inline constexpr bool operator == (Rectangle<T> const& lhs, Rectangle<T> const& rhs)
 {
@@ -0,0 +1,73 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIRAL_FRAME_STATISTICS_H
+#define MIRAL_FRAME_STATISTICS_H
+
+#include <mir/geometry/rectangle.h>
+
+#include <chrono>
+#include <memory>
+#include <vector>
+
+namespace mir { class Server; }
+
+namespace miral
+{
+/// Frame timings of each output, for a shell to monitor the compositor's performance at runtime.
+/// The timings are gathered whichever --compositor-report is chosen (with "log" they are logged too),
+/// unless the shell replaces the compositor report.
+/// \remark Since MirAL 4.1
+class FrameStatistics
+{
+public:
+    FrameStatistics();
+    ~FrameStatistics();
+    FrameStatistics(FrameStatistics const& that);
+    auto operator=(FrameStatistics const& rhs) -> FrameStatistics&;
+
+    void operator()(mir::Server& server) const;
+
+    /// The distribution of one frame timing
+    struct Percentiles
+    {
+        std::chrono::nanoseconds p50;
+        std::chrono::nanoseconds p95;
+        std::chrono::nanoseconds p99;
+        std::chrono::nanoseconds max;
+    };
+
+    /// An output's frame timings over the compositor report's most recent reporting interval
+    struct OutputStatistics
+    {
+        mir::geometry::Rectangle extents;   ///< Of the output, as Output::extents()
+        long frames;                        ///< Frames posted during the interval
+        Percentiles frame_interval;         ///< Between successive frames, not counting idle gaps
+        Percentiles render_time;            ///< Rendering each frame
+        Percentiles latency;                ///< From the scene changing to the frame being posted
+        long missed_vblanks;                ///< Refreshes a frame was due for, but not yet posted by
+    };
+
+    /// The statistics of each output (empty until the server has started)
+    auto outputs() const -> std::vector<OutputStatistics>;
+
+private:
+    struct Self;
+    std::shared_ptr<Self> self;
+};
+}
+
+#endif //MIRAL_FRAME_STATISTICS_H
@@ -180,6 +180,13 @@ public:
     /// \remark Since MirAL 3.6
     static char const* const ext_session_lock_manager_v1;
 
+    /// Allows clients to hint that their frames may be shown as soon as they are ready, even if
+    /// that tears, to reduce latency (typically games). Only affects fullscreen clients scanned out
+    /// directly (on gbm-kms, dma-buf buffers on the display's device), and only if the driver
+    /// supports asynchronous page flips. Not enabled by default.
+    /// \remark Since MirAL 4.1
+    static char const* const wp_tearing_control_manager_v1;
+
     /// Add a bespoke Wayland extension both to "supported" and "enabled by default".
     /// \remark Since MirAL 2.5
     void add_extension(Builder const& builder);
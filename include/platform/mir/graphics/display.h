@@ -22,6 +22,7 @@
 #include <memory>
 #include <functional>
 #include <chrono>
+#include <optional>
 
 namespace mir
 {
@@ -75,6 +76,31 @@ public:
      */
     virtual std::chrono::milliseconds recommended_sleep() const = 0;
 
+    /**
+     * How long the compositor has, from post() returning, to post the next
+     * frame if it is to reach the screen at the following refresh.
+     *
+     * This is only meaningful for groups whose post() returns as the frame
+     * reaches the screen. The compositor can then measure its own render
+     * times and start each frame as late as is safe, in preference to
+     * recommended_sleep(). If unknown, return std::nullopt.
+     */
+    virtual auto frame_budget() const -> std::optional<std::chrono::nanoseconds>
+    {
+        return std::nullopt;
+    }
+
+    /**
+     * How the frame most recently post()ed reached the screen.
+     *
+     * This is only meaningful once the frame is on screen, so groups whose
+     * post() returns before that (or that can't tell) return std::nullopt.
+     */
+    virtual auto last_presentation() const -> std::optional<FramePresentation>
+    {
+        return std::nullopt;
+    }
+
     virtual ~DisplaySyncGroup() = default;
 protected:
     DisplaySyncGroup() = default;
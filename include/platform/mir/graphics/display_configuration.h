@@ -150,6 +150,11 @@ struct DisplayConfigurationOutput
     /// Custom attributes (typically set via the .display configuration file
     std::map<std::string const, std::optional<std::string>> custom_attribute = {};
 
+    /** Whether the output can vary its refresh rate (VRR, aka adaptive sync) */
+    bool vrr_capable{false};
+    /** Whether to vary the refresh rate to present fullscreen clients' frames as they arrive */
+    bool vrr_enabled{false};
+
     /** The logical rectangle occupied by the output, based on its position,
         current mode and orientation (rotation) */
     geometry::Rectangle extents() const;
@@ -197,6 +202,8 @@ struct UserDisplayConfigurationOutput
     std::string const& name;
     /// Custom attributes (typically set by the .display configuration file
     std::map<std::string const, std::optional<std::string>>& custom_attribute;
+    bool const& vrr_capable;
+    bool& vrr_enabled;
 
     UserDisplayConfigurationOutput(DisplayConfigurationOutput& main);
     geometry::Rectangle extents() const;
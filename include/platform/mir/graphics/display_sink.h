@@ -47,6 +47,8 @@ struct DisplayElement
      */
     geometry::RectangleF source_position;
     std::shared_ptr<Framebuffer> buffer;
+    /// Whether the buffer may be shown as soon as possible, even if that tears
+    bool tearing_allowed{false};
 };
 /**
  * Interface to an output sink.
@@ -74,6 +76,24 @@ public:
     **/
     virtual bool overlay(std::vector<DisplayElement> const& renderlist) = 0;
 
+    /** Show the topmost elements of a scene directly, above the next image.
+     *
+     *  When overlay() cannot take a whole scene the hardware may still be able
+     *  to show some of its topmost elements (a video playing in a window, say)
+     *  itself, leaving only the elements below them to be composited into the
+     *  image passed to set_next_image().
+     *  \param [in] elements
+     *      The topmost elements of the scene, bottom to top.
+     *  \returns
+     *      How many elements, counted from the top of the list, will be shown
+     *      above the next image. The caller must composite the rest into that
+     *      image. The default implementation shows none.
+    **/
+    virtual auto overlay_above_next_image(std::vector<DisplayElement> const& /*elements*/) -> std::size_t
+    {
+        return 0;
+    }
+
     /**
      * Set the content for the next submission of this display
      *
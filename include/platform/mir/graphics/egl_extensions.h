@@ -181,6 +181,11 @@ typedef EGLBoolean (EGLAPIENTRYP PFNEGLQUERYDMABUFFORMATSEXTPROC) (EGLDisplay dp
 typedef EGLBoolean (EGLAPIENTRYP PFNEGLQUERYDMABUFMODIFIERSEXTPROC) (EGLDisplay dpy, EGLint format, EGLint max_modifiers, EGLuint64KHR *modifiers, EGLBoolean *external_only, EGLint *num_modifiers);
 #endif /* EGL_EXT_image_dma_buf_import_modifiers */
 
+#ifndef EGL_EXT_device_drm_render_node
+#define EGL_EXT_device_drm_render_node 1
+#define EGL_DRM_RENDER_NODE_FILE_EXT      0x3377
+#endif /* EGL_EXT_device_drm_render_node */
+
 /*
  * Just enough polyfill for rawhide headers...
  */
@@ -326,6 +331,29 @@ struct EGLExtensions
         PFNEGLEXPORTDMABUFIMAGEMESAPROC const eglExportDMABUFImageMESA;
         PFNEGLEXPORTDMABUFIMAGEQUERYMESAPROC const eglExportDMABUFImageQueryMESA;
     };
+
+    struct KHRFenceSync
+    {
+        KHRFenceSync(EGLDisplay dpy);
+
+        static auto extension_if_supported(EGLDisplay dpy) -> std::optional<KHRFenceSync>;
+
+        PFNEGLCREATESYNCKHRPROC const eglCreateSyncKHR;
+        PFNEGLDESTROYSYNCKHRPROC const eglDestroySyncKHR;
+        PFNEGLCLIENTWAITSYNCKHRPROC const eglClientWaitSyncKHR;
+        /// From EGL_KHR_wait_sync, letting the GPU wait for the fence; null if unsupported
+        PFNEGLWAITSYNCKHRPROC const eglWaitSyncKHR;
+    };
+
+    struct EXTDeviceQuery
+    {
+        EXTDeviceQuery();
+
+        static auto extension_if_supported() -> std::optional<EXTDeviceQuery>;
+
+        PFNEGLQUERYDISPLAYATTRIBEXTPROC const eglQueryDisplayAttribEXT;
+        PFNEGLQUERYDEVICESTRINGEXTPROC const eglQueryDeviceStringEXT;
+    };
 };
 }
 }
@@ -40,6 +40,21 @@ struct Frame
     Timestamp ust;     /**< Unadjusted System Time */
 };
 
+/**
+ * How a frame reached the screen, as far as the display can tell us.
+ *
+ * The flags follow the meaning of the equivalent wp_presentation_feedback
+ * kinds, so frontends can pass them on directly.
+ */
+struct FramePresentation
+{
+    Frame frame;                ///< When (and on which refresh) the frame was presented
+    bool vsync{false};          ///< Presentation was synchronised to vertical retrace
+    bool hw_clock{false};       ///< frame.ust was supplied by the display hardware's clock
+    bool hw_completion{false};  ///< The display signalled completion (rather than it being inferred)
+    bool zero_copy{false};      ///< A client buffer was scanned out without the compositor copying it
+};
+
 }} // namespace mir::graphics
 
 #endif // MIR_GRAPHICS_FRAME_H_
@@ -18,10 +18,12 @@
 #define MIR_GRAPHICS_GRAPHIC_BUFFER_ALLOCATOR_H_
 
 #include "mir/graphics/buffer.h"
+#include "mir/geometry/rectangles.h"
 
 #include <vector>
 #include <memory>
 #include <functional>
+#include <optional>
 
 struct wl_display;
 struct wl_resource;
@@ -86,11 +88,31 @@ public:
         std::function<void()>&& on_consumed,
         std::function<void()>&& on_release) = 0;
 
+    /**
+     * Import a client's SHM buffer
+     *
+     * \param shm_data [in]    The client's buffer. Each commit of the same client buffer passes the same
+     *                         shm_data, so the allocator may reuse what it made of the last one.
+     * \param damage [in]      The regions of shm_data changed since it was last passed in, or std::nullopt
+     *                         if that isn't known
+     */
     virtual auto buffer_from_shm(
         std::shared_ptr<renderer::software::RWMappableBuffer> shm_data,
+        std::optional<geometry::Rectangles> const& damage,
         std::function<void()>&& on_consumed,
         std::function<void()>&& on_release) -> std::shared_ptr<Buffer> = 0;
 
+    /**
+     * Note whether a client surface's buffers could be scanned out directly (e.g. it's fullscreen)
+     *
+     * An allocator importing client buffers can use this to steer the client towards buffers
+     * the display can scan out. The default does nothing.
+     *
+     * \param surface [in]      The client's wl_surface
+     * \param candidate [in]    Whether the surface's buffers could be scanned out
+     */
+    virtual void set_scanout_candidate(wl_resource* /*surface*/, bool /*candidate*/) {}
+
 protected:
     GraphicBufferAllocator() = default;
     GraphicBufferAllocator(const GraphicBufferAllocator&) = delete;
@@ -22,7 +22,9 @@
 
 #include <EGL/egl.h>
 #include <memory>
+#include <optional>
 #include <span>
+#include <sys/types.h>
 
 #include "mir/graphics/buffer.h"
 #include "mir/graphics/drm_formats.h"
@@ -51,8 +53,10 @@ class EGLContextExecutor;
 }
 
 class DmaBufFormatDescriptors;
+class DmaBufFormatTable;
 class DMABufBuffer;
 class EGLBufferCopier;
+class GBMDisplayProvider;
 
 class DMABufEGLProvider : public std::enable_shared_from_this<DMABufEGLProvider>
 {
@@ -87,6 +91,11 @@ public:
         -> std::shared_ptr<gl::Texture>;
 
      auto supported_formats() const -> DmaBufFormatDescriptors const&;
+
+    /**
+     * The DRM device that imports the buffers, if EGL can tell us
+     */
+    auto main_device() const -> std::optional<dev_t>;
 private:
     EGLDisplay const dpy;
     std::shared_ptr<EGLExtensions> const egl_extensions;
@@ -95,14 +104,20 @@ private:
     std::shared_ptr<common::EGLContextExecutor> const egl_delegate;
     EGLImageAllocator allocate_importable_image;
     std::unique_ptr<EGLBufferCopier> const blitter;
+    std::optional<dev_t> const device;
 };
 
 class LinuxDmaBufUnstable : public mir::wayland::LinuxDmabufV1::Global
 {
 public:
+    /**
+     * \param scanout_display  The display client buffers can be scanned out on, if any.
+     *                         Surface feedback prefers the formats it can scan out.
+     */
     LinuxDmaBufUnstable(
         wl_display* display,
-        std::shared_ptr<DMABufEGLProvider> provider);
+        std::shared_ptr<DMABufEGLProvider> provider,
+        std::shared_ptr<GBMDisplayProvider> const& scanout_display);
 
     auto buffer_from_resource(
         wl_resource* buffer,
@@ -110,11 +125,23 @@ public:
         std::function<void()>&& on_release,
         std::shared_ptr<common::EGLContextExecutor> egl_delegate)
         -> std::shared_ptr<Buffer>;
+
+    /**
+     * Whether a surface's buffers could be scanned out, so its feedback should prefer the scanout formats
+     *
+     * Clients holding feedback for the surface are sent the updated formats. Call on the Wayland thread.
+     */
+    void set_scanout_candidate(wl_resource* surface, bool candidate);
 private:
     class Instance;
+    class Feedback;
+    class SurfaceFeedback;
     void bind(wl_resource* new_resource) override;
 
     std::shared_ptr<DMABufEGLProvider> const provider;
+    /// Null if we can't tell clients which device imports their buffers; they then get version 3
+    std::shared_ptr<DmaBufFormatTable const> const format_table;
+    std::shared_ptr<SurfaceFeedback> const surface_feedback;
 };
 
 }
@@ -21,6 +21,7 @@
 #include <any>
 #include <span>
 #include <gbm.h>
+#include <sys/types.h>
 
 #include "mir/graphics/drm_formats.h"
 #include "mir/module_properties.h"
@@ -309,6 +310,15 @@ public:
         virtual ~MappableFB() override = default;
 
         using renderer::software::WriteMappableBuffer::size;
+
+        /**
+         * Age, in alloc_fb() calls, of the contents of this framebuffer
+         *
+         * This has the same meaning as EGL_EXT_buffer_age: 0 means the contents are
+         * undefined, 1 means this framebuffer was also returned by the previous
+         * alloc_fb() call, 2 by the call before that, and so on.
+         */
+        virtual auto buffer_age() const -> int { return 0; }
     };
 
     virtual auto supported_formats() const
@@ -344,6 +354,25 @@ public:
      * Get the GBM device for this display
      */
     virtual auto gbm_device() const -> std::shared_ptr<struct gbm_device> = 0;
+
+    /**
+     * Formats the display can scan out from a client's buffer, on a primary or overlay plane
+     */
+    virtual auto scanout_formats() const -> std::vector<DRMFormat> = 0;
+
+    /**
+     * Modifiers the display can scan out format with
+     *
+     * This may include DRM_FORMAT_MOD_INVALID if the display accepts buffers with an implicit modifier.
+     */
+    virtual auto scanout_modifiers_for_format(DRMFormat format) const -> std::vector<uint64_t> = 0;
+
+    /**
+     * The DRM device node driving the display
+     *
+     * On a multi-GPU system this need not be the device that renders, or that imports client buffers.
+     */
+    virtual auto scanout_device() const -> dev_t = 0;
 };
 
 class GBMDisplayAllocator : public DisplayAllocator
@@ -19,6 +19,8 @@
 
 #include <optional>
 #include <mir/geometry/rectangle.h>
+#include <mir/geometry/rectangles.h>
+#include <mir/graphics/buffer_id.h>
 #include <glm/glm.hpp>
 #include <memory>
 #include <vector>
@@ -69,6 +71,49 @@ public:
     virtual glm::mat4 transformation() const = 0;
 
     virtual bool shaped() const = 0;  // meaning the pixel format has alpha
+
+    /**
+     * The area of the renderable, in screen coordinates, whose pixels are
+     * known to be fully opaque (before alpha() is applied).
+     *
+     * By default this is the whole renderable, unless it is shaped().
+     * Renderables that know more (e.g. a client declared an opaque region
+     * of a shaped buffer) should say so, as it allows what is behind them
+     * to be culled.
+     */
+    virtual auto opaque_region() const -> geometry::Rectangles
+    {
+        if (shaped())
+        {
+            return {};
+        }
+        return {screen_position()};
+    }
+
+    /**
+     * The area of the renderable, in screen coordinates, that has changed since
+     * \a previous was its buffer.
+     *
+     * By default this is unknown (nullopt), and the whole renderable should be
+     * treated as changed whenever its buffer changes.
+     */
+    virtual auto damage_since(BufferID previous) const -> std::optional<geometry::Rectangles>
+    {
+        (void)previous;
+        return std::nullopt;
+    }
+
+    /**
+     * Whether new content may be shown as soon as it's ready, rather than at
+     * the display's next vblank, even if that tears.
+     *
+     * This is only a hint: displays only honour it when showing the
+     * renderable's buffer directly.
+     */
+    virtual bool tearing_allowed() const
+    {
+        return false;
+    }
 protected:
     Renderable() = default;
     Renderable(Renderable const&) = delete;
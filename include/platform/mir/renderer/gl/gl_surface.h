@@ -18,7 +18,9 @@
 #define MIR_RENDERER_GL_SURFACE_H_
 
 #include "mir/geometry/size.h"
+#include "mir/geometry/rectangle.h"
 #include <memory>
+#include <optional>
 
 namespace mir
 {
@@ -51,6 +53,24 @@ public:
         GL = BottomRowFirst     //< GL texture layout is in decreasing-y order.
     };
     virtual auto layout() const -> Layout = 0;
+
+    /**
+     * Age, in frames, of the contents of the buffer the next frame will be drawn into
+     *
+     * This has the same meaning as EGL_EXT_buffer_age: 0 means the contents are
+     * undefined, 1 means the buffer holds the last committed frame, 2 the frame
+     * before that, and so on. It is only meaningful after bind().
+     */
+    virtual auto buffer_age() const -> int { return 0; }
+
+    /**
+     * The area the next commit() changes from the last committed frame
+     *
+     * The area is in GL window coordinates, as passed to glScissor(); std::nullopt
+     * means the whole surface may have changed. Surfaces that copy their contents
+     * elsewhere on commit() can use this to copy only what changed.
+     */
+    virtual void set_damage(std::optional<geometry::Rectangle> const& /*area*/) {}
 };
 }
 }
@@ -18,10 +18,14 @@
 #define MIR_RENDERER_RENDERER_H_
 
 #include "mir/geometry/rectangle.h"
+#include "mir/geometry/rectangles.h"
 #include "mir/graphics/renderable.h"
 #include "mir_toolkit/common.h"
 #include <glm/glm.hpp>
 
+#include <chrono>
+#include <optional>
+
 namespace mir
 {
 namespace graphics
@@ -39,9 +43,26 @@ public:
 
     virtual void set_viewport(geometry::Rectangle const& rect) = 0;
     virtual void set_output_transform(glm::mat2 const&) = 0;
+    /**
+     * Limit the next render() to the given region of the viewport
+     *
+     * The renderer must repaint at least \a damage, but may repaint more (for
+     * example, to bring an older back buffer up to date). If this is not called
+     * before render() the whole viewport is repainted.
+     */
+    virtual void set_damage(geometry::Rectangles const& damage) = 0;
     virtual auto render(graphics::RenderableList const&) const -> std::unique_ptr<graphics::Framebuffer> = 0;
     virtual void suspend() = 0; // called when render() is skipped
 
+    /**
+     * How long the GPU took to execute an earlier render()
+     *
+     * GPU work completes some time after render() returns, so this is the
+     * oldest measurement that has become available since the last call, if
+     * any. Renderers that don't measure GPU time always return nullopt.
+     */
+    virtual auto completed_gpu_time() -> std::optional<std::chrono::nanoseconds> { return std::nullopt; }
+
 protected:
     Renderer() = default;
     Renderer(const Renderer&) = delete;
@@ -23,6 +23,7 @@ namespace mir
 {
 namespace graphics
 {
+class DisplaySink;
 class GLRenderingProvider;
 namespace gl
 {
@@ -47,6 +48,18 @@ public:
         std::unique_ptr<graphics::gl::OutputSurface> output_surface,
         std::shared_ptr<graphics::GLRenderingProvider> gl_provider) const -> std::unique_ptr<Renderer> = 0;
 
+    /**
+     * Create a renderer that draws straight into \a sink's buffers, without an OutputSurface
+     *
+     * \return The renderer, or nullptr if this factory's renderers need an OutputSurface
+     *         or can't draw into \a sink
+     */
+    virtual auto create_renderer_for_sink(graphics::DisplaySink& sink) const -> std::unique_ptr<Renderer>
+    {
+        (void)sink;
+        return nullptr;
+    }
+
 protected:
     RendererFactory() = default;
     RendererFactory(RendererFactory const&) = delete;
@@ -23,6 +23,7 @@
 #include "mir/graphics/buffer_id.h"
 
 #include <memory>
+#include <optional>
 
 namespace mir
 {
@@ -46,6 +47,14 @@ public:
     virtual void drop_old_buffers() = 0;
     virtual auto has_submitted_buffer() const -> bool = 0;
     virtual auto framedropping() const -> bool = 0;
+    /**
+     * The area, in buffer coordinates, that changed between buffer \a from and buffer \a to
+     *
+     * Returns nullopt if this is unknown (for example, if \a from is too old), in which case
+     * all of \a to should be treated as changed.
+     */
+    virtual auto damage_between(graphics::BufferID from, graphics::BufferID to) const
+        -> std::optional<geometry::Rectangles> = 0;
 };
 
 }
@@ -18,6 +18,11 @@
 #define MIR_COMPOSITOR_COMPOSITOR_REPORT_H_
 
 #include "mir/graphics/renderable.h"
+#include "mir/geometry/rectangle.h"
+
+#include <chrono>
+#include <optional>
+#include <vector>
 
 namespace mir
 {
@@ -28,14 +33,45 @@ class CompositorReport
 {
 public:
     typedef const void* SubCompositorId;  // e.g. thread/display buffer ID
+
+    /// Distribution of one frame timing over a reporting interval
+    struct FrameTimePercentiles
+    {
+        std::chrono::nanoseconds p50{0};
+        std::chrono::nanoseconds p95{0};
+        std::chrono::nanoseconds p99{0};
+        std::chrono::nanoseconds max{0};
+    };
+
+    struct FrameStatistics
+    {
+        geometry::Rectangle display_area;   ///< As added_display() reported it
+        long frames;                        ///< Frames posted during the interval
+        FrameTimePercentiles frame_interval;///< Between successive posts, not counting idle gaps
+        FrameTimePercentiles render_time;   ///< From began_frame() to rendered_frame()
+        FrameTimePercentiles latency;       ///< From scheduled() to posted_frame()
+        long missed_vblanks;                ///< Refreshes a frame was due for, but not yet posted by
+    };
+
     virtual void added_display(int width, int height, int x, int y, SubCompositorId id) = 0;
     virtual void began_frame(SubCompositorId id) = 0;
     virtual void renderables_in_frame(SubCompositorId id, graphics::RenderableList const& renderables) = 0;
     virtual void rendered_frame(SubCompositorId id) = 0;
     virtual void finished_frame(SubCompositorId id) = 0;
+    /// The GPU time of a frame rendered earlier, reported once the GPU has finished it
+    virtual void rendered_frame_on_gpu(SubCompositorId id, std::chrono::nanoseconds gpu_time) = 0;
+    /// The frame composited by \a id has been posted to a display refreshing every \a refresh_period, if known
+    virtual void posted_frame(SubCompositorId id, std::optional<std::chrono::nanoseconds> refresh_period) = 0;
     virtual void started() = 0;
     virtual void stopped() = 0;
     virtual void scheduled() = 0;
+
+    /**
+     * Frame timings of each display over the most recent reporting interval
+     *
+     * This is for shells to poll at runtime. Reports that don't keep statistics return none.
+     */
+    virtual auto frame_statistics() const -> std::vector<FrameStatistics> = 0;
 protected:
     CompositorReport() = default;
     virtual ~CompositorReport() = default;
@@ -19,6 +19,9 @@
 
 #include "mir/compositor/scene.h"
 
+#include <chrono>
+#include <optional>
+
 namespace mir
 {
 namespace compositor
@@ -32,6 +35,9 @@ public:
     /// Returns true if any compositing happened, otherwise false.
     virtual bool composite(SceneElementSequence&& scene_sequence) = 0;
 
+    /// The frame last composited has been posted to a display refreshing every \a refresh_period, if known
+    virtual void frame_posted(std::optional<std::chrono::nanoseconds> /*refresh_period*/) {}
+
 protected:
     DisplayBufferCompositor() = default;
     DisplayBufferCompositor& operator=(DisplayBufferCompositor const&) = delete;
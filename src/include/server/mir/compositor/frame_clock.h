@@ -0,0 +1,96 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_COMPOSITOR_FRAME_CLOCK_H_
+#define MIR_COMPOSITOR_FRAME_CLOCK_H_
+
+#include "mir/executor.h"
+#include "mir/graphics/frame.h"
+#include "mir/time/types.h"
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+namespace mir
+{
+namespace compositor
+{
+
+/**
+ * Tracks the frames presented by a compositor thread (and so by the outputs
+ * that thread drives), and runs work when the next of those frames is presented.
+ *
+ * Work spawned on a FrameClock is run on the compositor thread once the frame
+ * being composited has been posted. Where the display paces post() to its
+ * refresh, that is when the frame reaches the screen.
+ */
+class FrameClock : public Executor
+{
+public:
+    /**
+     * The FrameClock of the compositor thread we're running on
+     *
+     * \return  null if the calling thread is not a compositor thread
+     */
+    static auto for_this_thread() -> std::shared_ptr<FrameClock>;
+
+    /// Make \a clock the FrameClock of the calling thread (null to clear it)
+    static void set_for_this_thread(std::shared_ptr<FrameClock> const& clock);
+
+    /// Run \a work when the next frame is presented
+    void spawn(std::function<void()>&& work) override;
+
+    /**
+     * A frame was presented at \a when
+     *
+     * \param [in] interval     The time until the next refresh, if the display reports it
+     * \param [in] presentation How the frame was presented, if known. Work spawned for this
+     *                          frame can query it with last_presentation().
+     */
+    void frame_presented(
+        time::Timestamp when,
+        std::optional<std::chrono::nanoseconds> interval,
+        std::optional<graphics::FramePresentation> const& presentation = std::nullopt);
+
+    /// How the frame most recently presented reached the screen, if known
+    auto last_presentation() const -> std::optional<graphics::FramePresentation>;
+
+    /// The display's refresh interval, if known
+    auto refresh() const -> std::optional<std::chrono::nanoseconds>;
+
+    /**
+     * Our best guess at when the next frame after \a now could be presented
+     *
+     * \return  nullopt if we don't know the display's refresh interval
+     */
+    auto next_frame_after(time::Timestamp now) const -> std::optional<time::Timestamp>;
+
+private:
+    std::mutex mutable mutex;
+    std::vector<std::function<void()>> queued;
+    std::optional<time::Timestamp> last_presented;
+    std::optional<std::chrono::nanoseconds> refresh_interval;
+    std::optional<graphics::FramePresentation> presentation;
+};
+
+}
+}
+
+#endif // MIR_COMPOSITOR_FRAME_CLOCK_H_
@@ -20,6 +20,7 @@
 #include <mir_toolkit/common.h>
 #include "mir/graphics/buffer_id.h"
 #include "mir/geometry/size.h"
+#include "mir/geometry/rectangles.h"
 #include <functional>
 #include <memory>
 
@@ -39,10 +40,26 @@ class BufferStream
 public:
     virtual ~BufferStream() = default;
 
-    virtual void submit_buffer(std::shared_ptr<graphics::Buffer> const& buffer) = 0;
+    /**
+     * Submit a new buffer to the stream
+     *
+     * \param [in] buffer  The buffer to show next
+     * \param [in] damage  The parts of \a buffer that differ from the previously submitted
+     *                     buffer, in buffer coordinates. This is ignored (and the whole
+     *                     buffer is treated as damaged) if \a buffer changes the stream's size.
+     */
+    virtual void submit_buffer(
+        std::shared_ptr<graphics::Buffer> const& buffer,
+        geometry::Rectangles const& damage) = 0;
 
+    /**
+     * Set the callback to be called whenever a buffer is submitted
+     *
+     * The callback is given the size of the new buffer and the damage it was submitted with,
+     * in buffer coordinates.
+     */
     virtual void set_frame_posted_callback(
-        std::function<void(geometry::Size const&)> const& callback) = 0;
+        std::function<void(geometry::Size const&, geometry::Rectangles const&)> const& callback) = 0;
 
     virtual void with_most_recent_buffer_do(
         std::function<void(graphics::Buffer&)> const& exec) = 0;
@@ -27,6 +27,7 @@
 
 #include <vector>
 #include <list>
+#include <optional>
 
 namespace mir
 {
@@ -39,6 +40,10 @@ struct StreamInfo
     std::shared_ptr<compositor::BufferStream> stream;
     geometry::Displacement displacement;
     optional_value<geometry::Size> size;
+    /// The area of the stream known to be opaque, relative to its top-left (if declared)
+    std::shared_ptr<std::vector<geometry::Rectangle> const> opaque_region{};
+    /// Whether new content may be shown as soon as it's ready, even if that tears
+    bool tearing_allowed{false};
 };
 
 class SurfaceObserver;
@@ -64,6 +69,12 @@ public:
     virtual geometry::Size window_size() const = 0;
 
     virtual graphics::RenderableList generate_renderables(compositor::CompositorID id) const = 0; 
+    /// As generate_renderables(), but appends to an existing list (that can be reused from frame to frame)
+    virtual void append_renderables(compositor::CompositorID id, graphics::RenderableList& renderables) const
+    {
+        auto const generated = generate_renderables(id);
+        renderables.insert(renderables.end(), generated.begin(), generated.end());
+    }
     virtual int buffers_ready_for_compositor(void const* compositor_id) const = 0;
 
     virtual MirWindowType type() const = 0;
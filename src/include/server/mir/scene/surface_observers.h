@@ -51,6 +51,7 @@ public:
     void input_consumed(Surface const* surf, std::shared_ptr<MirEvent const> const& event) override;
     void depth_layer_set_to(Surface const* surf, MirDepthLayer depth_layer) override;
     void application_id_set_to(Surface const* surf, std::string const& application_id) override;
+    void input_region_set_to(Surface const* surf, std::vector<geometry::Rectangle> const& region) override;
 };
 
 }
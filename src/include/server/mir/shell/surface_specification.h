@@ -22,12 +22,15 @@
 #include "mir/frontend/surface_id.h"
 #include "mir/geometry/point.h"
 #include "mir/geometry/displacement.h"
+#include "mir/geometry/rectangle.h"
 #include "mir/graphics/buffer_properties.h"
 #include "mir/graphics/display_configuration.h"
 #include "mir/frontend/buffer_stream_id.h"
 
 #include <string>
 #include <memory>
+#include <optional>
+#include <vector>
 
 namespace mir
 {
@@ -49,6 +52,10 @@ struct StreamSpecification
     std::weak_ptr<frontend::BufferStream> stream;
     geometry::Displacement displacement;
     optional_value<geometry::Size> size;
+    /// The area of the stream known to be opaque, relative to its top-left (if declared)
+    std::optional<std::vector<geometry::Rectangle>> opaque_region{};
+    /// Whether new content may be shown as soon as it's ready, even if that tears
+    bool tearing_allowed{false};
 };
 auto operator==(StreamSpecification const& lhs, StreamSpecification const& rhs) -> bool;
 
@@ -0,0 +1,83 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "miral/frame_statistics.h"
+
+#include <mir/compositor/compositor_report.h>
+#include <mir/server.h>
+
+#include <mutex>
+
+namespace mc = mir::compositor;
+
+namespace
+{
+auto percentiles_of(mc::CompositorReport::FrameTimePercentiles const& from) -> miral::FrameStatistics::Percentiles
+{
+    return {from.p50, from.p95, from.p99, from.max};
+}
+}
+
+struct miral::FrameStatistics::Self
+{
+    std::mutex mutex;
+    std::weak_ptr<mc::CompositorReport> report;
+};
+
+miral::FrameStatistics::FrameStatistics() :
+    self{std::make_shared<Self>()}
+{
+}
+
+miral::FrameStatistics::~FrameStatistics() = default;
+
+miral::FrameStatistics::FrameStatistics(FrameStatistics const&) = default;
+
+auto miral::FrameStatistics::operator=(FrameStatistics const&) -> FrameStatistics& = default;
+
+void miral::FrameStatistics::operator()(mir::Server& server) const
+{
+    server.add_init_callback([self=self, &server]
+        {
+            std::lock_guard lock{self->mutex};
+            self->report = server.the_compositor_report();
+        });
+}
+
+auto miral::FrameStatistics::outputs() const -> std::vector<OutputStatistics>
+{
+    std::shared_ptr<mc::CompositorReport> report;
+    {
+        std::lock_guard lock{self->mutex};
+        report = self->report.lock();
+    }
+
+    std::vector<OutputStatistics> result;
+    if (report)
+    {
+        for (auto const& statistics : report->frame_statistics())
+        {
+            result.push_back(OutputStatistics{
+                statistics.display_area,
+                statistics.frames,
+                percentiles_of(statistics.frame_interval),
+                percentiles_of(statistics.render_time),
+                percentiles_of(statistics.latency),
+                statistics.missed_vblanks});
+        }
+    }
+    return result;
+}
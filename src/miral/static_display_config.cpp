@@ -63,6 +63,7 @@ char const* const mode = "mode";
 char const* const orientation = "orientation";
 char const* const scale = "scale";
 char const* const group = "group";
+char const* const vrr = "vrr";
 char const* const orientation_value[] = { "normal", "left", "inverted", "right" };
 char const* const layout_suffix = "-layout";
 
@@ -257,6 +258,14 @@ try
                         output_config.scale = s.as<float>();
                     }
 
+                    if (auto const v = port_config[vrr])
+                    {
+                        auto const vrr = v.as<std::string>();
+                        if (vrr != state_enabled && vrr != state_disabled)
+                            throw mir::AbnormalExit{error_prefix(filename) + "invalid 'vrr' (" + vrr + ") for port: " + port_name};
+                        output_config.vrr = (vrr == state_enabled);
+                    }
+
                     for (auto const& key : custom_output_attributes)
                     {
                         if (auto const value = port_config[key])
@@ -393,6 +402,12 @@ void miral::YamlFileDisplayConfig::serialize_output_configuration(
                    "\n        scale: " << conf_output.scale
                 << "\n        group: " << conf_output.logical_group_id.as_value()
                 << "\t# Outputs with the same non-zero value are treated as a single display";
+
+            if (conf_output.vrr_capable)
+            {
+                out << "\n        vrr: " << (conf_output.vrr_enabled ? state_enabled : state_disabled)
+                    << "\t# {enabled, disabled}, defaults to disabled. Variable refresh rate for fullscreen clients";
+            }
         }
     }
     else
@@ -481,6 +496,8 @@ void miral::YamlFileDisplayConfig::apply_to_output(mg::UserDisplayConfigurationO
         {
             conf_output.logical_group_id = mg::DisplayConfigurationLogicalGroupId{};
         }
+
+        conf_output.vrr_enabled = conf.vrr.is_set() && conf.vrr.value();
     }
     else
     {
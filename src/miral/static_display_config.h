@@ -69,6 +69,7 @@ private:
         mir::optional_value<float>  scale;
         mir::optional_value<MirOrientation>  orientation;
         mir::optional_value<int> group_id;
+        mir::optional_value<bool> vrr;
         std::map<std::string const, std::optional<std::string>> custom_attribute;
     };
 
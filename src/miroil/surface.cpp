@@ -44,6 +44,9 @@ public:
   void hidden_set_to(mir::scene::Surface const *surf, bool hide) override;
   void input_consumed(mir::scene::Surface const *surf,
                       std::shared_ptr<MirEvent const> const& event) override;
+  void
+  input_region_set_to(mir::scene::Surface const * /*surf*/,
+                      std::vector<mir::geometry::Rectangle> const& /*region*/) override{};
   void moved_to(mir::scene::Surface const *surf,
                 mir::geometry::Point const &top_left) override;
   void orientation_set_to(mir::scene::Surface const *surf,
@@ -0,0 +1,126 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "dmabuf_format_table.h"
+
+#include "mir/anonymous_shm_file.h"
+#include "mir/graphics/platform.h"
+#include "mir/log.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <string>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace mg = mir::graphics;
+
+mg::DmaBufFormatTable::DmaBufFormatTable(
+    dev_t main_device,
+    std::vector<std::pair<DRMFormat, std::vector<uint64_t>>> const& importable,
+    GBMDisplayProvider const* scanout_display)
+    : main_device_{main_device}
+{
+    if (scanout_display)
+    {
+        try
+        {
+            scanout_device = scanout_display->scanout_device();
+        }
+        catch (std::exception const& error)
+        {
+            mir::log_warning("Not preferring scanout formats for dma-bufs: %s", error.what());
+        }
+    }
+
+    for (auto const& [format, modifiers] : importable)
+    {
+        std::vector<uint64_t> const scanout_modifiers = scanout_device ?
+            scanout_display->scanout_modifiers_for_format(format) :
+            std::vector<uint64_t>{};
+
+        for (auto const modifier : modifiers)
+        {
+            // Clients index the table with 16 bits
+            if (entries.size() > std::numeric_limits<uint16_t>::max())
+            {
+                mir::log_warning("Too many dma-buf format + modifier pairs; not advertising them all");
+                break;
+            }
+
+            auto const index = static_cast<uint16_t>(entries.size());
+            entries.push_back(Entry{format, 0, modifier});
+            render_indices.push_back(index);
+            if (std::find(scanout_modifiers.begin(), scanout_modifiers.end(), modifier) != scanout_modifiers.end())
+            {
+                scanout_indices.push_back(index);
+            }
+        }
+    }
+
+    mir::AnonymousShmFile file{size()};
+    memcpy(file.base_ptr(), entries.data(), size());
+
+    /* Opening the file again read-only gives clients a file description
+     * they can only map read-only.
+     */
+    auto const path = "/proc/self/fd/" + std::to_string(file.fd());
+    read_only_file = Fd{open(path.c_str(), O_RDONLY | O_CLOEXEC)};
+    if (read_only_file == Fd::invalid)
+    {
+        mir::log_debug("Cannot reopen dma-buf format table read-only; each client gets its own copy");
+    }
+}
+
+auto mg::DmaBufFormatTable::main_device() const -> dev_t
+{
+    return main_device_;
+}
+
+auto mg::DmaBufFormatTable::file() const -> Fd
+{
+    if (read_only_file != Fd::invalid)
+    {
+        return read_only_file;
+    }
+
+    mir::AnonymousShmFile copy{size()};
+    memcpy(copy.base_ptr(), entries.data(), size());
+    return Fd{dup(copy.fd())};
+}
+
+auto mg::DmaBufFormatTable::size() const -> size_t
+{
+    return entries.size() * sizeof(Entry);
+}
+
+auto mg::DmaBufFormatTable::tranches(bool scanout_candidate) const -> std::vector<Tranche>
+{
+    std::vector<Tranche> result;
+
+    /* A candidate's buffers may be put straight on a plane of the scanout device,
+     * so we'd rather the client allocated a format + modifier that device can scan out.
+     */
+    if (scanout_candidate && scanout_device && !scanout_indices.empty())
+    {
+        result.push_back(Tranche{*scanout_device, true, scanout_indices});
+    }
+    result.push_back(Tranche{main_device_, false, render_indices});
+
+    return result;
+}
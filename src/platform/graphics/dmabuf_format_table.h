@@ -0,0 +1,92 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_GRAPHICS_DMABUF_FORMAT_TABLE_H_
+#define MIR_GRAPHICS_DMABUF_FORMAT_TABLE_H_
+
+#include "mir/fd.h"
+#include "mir/graphics/drm_formats.h"
+
+#include <cstdint>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include <sys/types.h>
+
+namespace mir::graphics
+{
+class GBMDisplayProvider;
+
+/**
+ * The format + modifier pairs linux-dmabuf feedback advertises, and the tranches preferring them
+ */
+class DmaBufFormatTable
+{
+public:
+    struct Tranche
+    {
+        dev_t target_device;
+        bool scanout;
+        std::vector<uint16_t> indices;      ///< Of the entries in the table
+    };
+
+    /**
+     * \param main_device       The DRM device that imports client buffers
+     * \param importable        The formats main_device can import, each with its modifiers
+     * \param scanout_display   The display client buffers could be scanned out on, if any
+     */
+    DmaBufFormatTable(
+        dev_t main_device,
+        std::vector<std::pair<DRMFormat, std::vector<uint64_t>>> const& importable,
+        GBMDisplayProvider const* scanout_display);
+
+    auto main_device() const -> dev_t;
+
+    /**
+     * The table, as the protocol lays it out, for a client to map
+     *
+     * Clients share the table, so this is a file they can only map read-only where we can manage it.
+     */
+    auto file() const -> Fd;
+    auto size() const -> size_t;
+
+    /**
+     * The tranches for feedback, most preferred first
+     *
+     * \param scanout_candidate Whether the feedback is for a surface whose buffers could be scanned out
+     */
+    auto tranches(bool scanout_candidate) const -> std::vector<Tranche>;
+
+private:
+    struct Entry
+    {
+        uint32_t format;
+        uint32_t padding;
+        uint64_t modifier;
+    };
+    static_assert(sizeof(Entry) == 16, "The protocol requires format table entries to be 16 bytes");
+
+    dev_t const main_device_;
+    std::optional<dev_t> scanout_device;
+    std::vector<Entry> entries;
+    std::vector<uint16_t> render_indices;
+    std::vector<uint16_t> scanout_indices;
+    Fd read_only_file;
+};
+}
+
+#endif // MIR_GRAPHICS_DMABUF_FORMAT_TABLE_H_
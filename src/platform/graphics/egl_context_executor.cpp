@@ -51,24 +51,30 @@ void mgc::EGLContextExecutor::process_loop(mgc::EGLContextExecutor* const me)
     me->ctx->make_current();
 
     std::unique_lock lock{me->mutex};
-    while (!me->shutdown_requested)
+    for (;;)
     {
-        for (auto& work : me->work_queue)
+        me->new_work.wait(lock, [me]() { return me->shutdown_requested || !me->work_queue.empty(); });
+
+        // On shutdown, carry on until the work-queue is drained
+        if (me->work_queue.empty())
         {
-            work();
+            break;
         }
-        me->work_queue.clear();
 
-        me->new_work.wait(lock);
-    }
+        // Run the work without the lock held, so that (possibly slow) work doesn't block spawn()
+        decltype(me->work_queue) work_queue;
+        work_queue.swap(me->work_queue);
+        lock.unlock();
 
-    // Drain the work-queue
-    for (auto& work : me->work_queue)
-    {
-        work();
+        for (auto& work : work_queue)
+        {
+            work();
+        }
+        // …and ensure any functor cleanup happens with the EGL context current, too.
+        work_queue.clear();
+
+        lock.lock();
     }
-    // …and ensure any functor cleanup happens with the EGL context current, too.
-    me->work_queue.clear();
 
     me->ctx->release_current();
 }
@@ -253,3 +253,71 @@ auto mg::EGLExtensions::MESADmaBufExport::extension_if_supported(EGLDisplay dpy)
     }
 }
 
+mg::EGLExtensions::KHRFenceSync::KHRFenceSync(EGLDisplay dpy)
+    : eglCreateSyncKHR{
+          reinterpret_cast<PFNEGLCREATESYNCKHRPROC>(
+              eglGetProcAddress("eglCreateSyncKHR"))},
+      eglDestroySyncKHR{
+          reinterpret_cast<PFNEGLDESTROYSYNCKHRPROC>(
+              eglGetProcAddress("eglDestroySyncKHR"))},
+      eglClientWaitSyncKHR{
+          reinterpret_cast<PFNEGLCLIENTWAITSYNCKHRPROC>(
+              eglGetProcAddress("eglClientWaitSyncKHR"))},
+      eglWaitSyncKHR{
+          has_egl_extension(dpy, "EGL_KHR_wait_sync") ?
+              reinterpret_cast<PFNEGLWAITSYNCKHRPROC>(eglGetProcAddress("eglWaitSyncKHR")) :
+              nullptr}
+{
+    if (!has_egl_extension(dpy, "EGL_KHR_fence_sync"))
+    {
+        BOOST_THROW_EXCEPTION((std::runtime_error{"Missing required EGL_KHR_fence_sync extension"}));
+    }
+    if (!eglCreateSyncKHR || !eglDestroySyncKHR || !eglClientWaitSyncKHR)
+    {
+        BOOST_THROW_EXCEPTION((std::runtime_error{"EGL implementation missing EGL_KHR_fence_sync functions"}));
+    }
+}
+
+auto mg::EGLExtensions::KHRFenceSync::extension_if_supported(EGLDisplay dpy) -> std::optional<KHRFenceSync>
+{
+    try
+    {
+        return KHRFenceSync{dpy};
+    }
+    catch (std::runtime_error const&)
+    {
+        return std::nullopt;
+    }
+}
+
+mg::EGLExtensions::EXTDeviceQuery::EXTDeviceQuery()
+    : eglQueryDisplayAttribEXT{
+          reinterpret_cast<PFNEGLQUERYDISPLAYATTRIBEXTPROC>(
+              eglGetProcAddress("eglQueryDisplayAttribEXT"))},
+      eglQueryDeviceStringEXT{
+          reinterpret_cast<PFNEGLQUERYDEVICESTRINGEXTPROC>(
+              eglGetProcAddress("eglQueryDeviceStringEXT"))}
+{
+    // EGL_EXT_device_query is a client extension, but may also be exposed through EGL_EXT_device_base
+    if (!has_egl_client_extension("EGL_EXT_device_query") && !has_egl_client_extension("EGL_EXT_device_base"))
+    {
+        BOOST_THROW_EXCEPTION((std::runtime_error{"Missing required EGL_EXT_device_query extension"}));
+    }
+    if (!eglQueryDisplayAttribEXT || !eglQueryDeviceStringEXT)
+    {
+        BOOST_THROW_EXCEPTION((std::runtime_error{"EGL implementation missing EGL_EXT_device_query functions"}));
+    }
+}
+
+auto mg::EGLExtensions::EXTDeviceQuery::extension_if_supported() -> std::optional<EXTDeviceQuery>
+{
+    try
+    {
+        return EXTDeviceQuery{};
+    }
+    catch (std::runtime_error const&)
+    {
+        return std::nullopt;
+    }
+}
+
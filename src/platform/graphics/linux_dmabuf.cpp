@@ -18,6 +18,7 @@
 #include "mir/fd.h"
 #include "mir/graphics/drm_formats.h"
 #include "egl_buffer_copy.h"
+#include "dmabuf_format_table.h"
 
 #include "wayland_wrapper.h"
 #include "mir/wayland/protocol_error.h"
@@ -32,9 +33,11 @@
 #include "mir/graphics/egl_context_executor.h"
 
 #include <EGL/egl.h>
+#include <algorithm>
 #include <cstdint>
 #include <cstring>
 #include <stdexcept>
+#include <sys/stat.h>
 
 #define MIR_LOG_COMPONENT "linux-dmabuf-import"
 #include "mir/log.h"
@@ -587,7 +590,7 @@ public:
     LinuxDmaBufParams(
         wl_resource* new_resource,
         std::shared_ptr<mg::DMABufEGLProvider> provider)
-        : mir::wayland::LinuxBufferParamsV1(new_resource, Version<3>{}),
+        : mir::wayland::LinuxBufferParamsV1(new_resource, Version<4>{}),
           consumed{false},
           provider{std::move(provider)}
     {
@@ -1046,15 +1049,240 @@ private:
 
 }
 
+namespace
+{
+class WlArray
+{
+public:
+    WlArray(void const* data, size_t size)
+    {
+        wl_array_init(&array);
+        memcpy(wl_array_add(&array, size), data, size);
+    }
+
+    ~WlArray()
+    {
+        wl_array_release(&array);
+    }
+
+    operator wl_array*()
+    {
+        return &array;
+    }
+
+private:
+    WlArray(WlArray const&) = delete;
+    WlArray& operator=(WlArray const&) = delete;
+
+    wl_array array;
+};
+
+auto drm_device_of(EGLDisplay dpy) -> std::optional<dev_t>
+{
+    auto const device_query = mg::EGLExtensions::EXTDeviceQuery::extension_if_supported();
+    if (!device_query)
+    {
+        return std::nullopt;
+    }
+
+    EGLAttrib device;
+    if (device_query->eglQueryDisplayAttribEXT(dpy, EGL_DEVICE_EXT, &device) != EGL_TRUE)
+    {
+        return std::nullopt;
+    }
+
+    // Prefer the render node; it's what clients allocate buffers on
+    for (auto const node : {EGL_DRM_RENDER_NODE_FILE_EXT, EGL_DRM_DEVICE_FILE_EXT})
+    {
+        if (auto const path = device_query->eglQueryDeviceStringEXT(reinterpret_cast<EGLDeviceEXT>(device), node))
+        {
+            struct stat info;
+            if (stat(path, &info) == 0)
+            {
+                return info.st_rdev;
+            }
+        }
+    }
+    return std::nullopt;
+}
+}
+
+namespace
+{
+auto importable_formats(mg::DmaBufFormatDescriptors const& formats)
+    -> std::vector<std::pair<mg::DRMFormat, std::vector<uint64_t>>>
+{
+    std::vector<std::pair<mg::DRMFormat, std::vector<uint64_t>>> result;
+    for (auto i = 0u; i < formats.num_formats(); ++i)
+    {
+        auto [format, modifiers, external_only] = formats[i];
+        result.emplace_back(
+            mg::DRMFormat{static_cast<uint32_t>(format)},
+            std::vector<uint64_t>{modifiers.begin(), modifiers.end()});
+    }
+    return result;
+}
+
+auto make_format_table(mg::DMABufEGLProvider const& provider, mg::GBMDisplayProvider const* scanout_display)
+    -> std::shared_ptr<mg::DmaBufFormatTable const>
+{
+    if (auto const main_device = provider.main_device())
+    {
+        return std::make_shared<mg::DmaBufFormatTable>(
+            *main_device,
+            importable_formats(provider.supported_formats()),
+            scanout_display);
+    }
+
+    mir::log_warning("Cannot determine the DRM device dma-bufs are imported with; not offering dma-buf feedback");
+    return nullptr;
+}
+
+/// Send all the feedback parameters; the protocol has us send them all whenever any change
+void send_feedback(mw::LinuxDmabufFeedbackV1& feedback, mg::DmaBufFormatTable const& table, bool scanout_candidate)
+{
+    feedback.send_format_table_event(table.file(), table.size());
+
+    auto const main_device = table.main_device();
+    WlArray device{&main_device, sizeof(main_device)};
+    feedback.send_main_device_event(device);
+
+    for (auto const& tranche : table.tranches(scanout_candidate))
+    {
+        WlArray target{&tranche.target_device, sizeof(tranche.target_device)};
+        feedback.send_tranche_target_device_event(target);
+        feedback.send_tranche_flags_event(tranche.scanout ? mw::LinuxDmabufFeedbackV1::TrancheFlags::scanout : 0);
+        WlArray formats{tranche.indices.data(), tranche.indices.size() * sizeof(uint16_t)};
+        feedback.send_tranche_formats_event(formats);
+        feedback.send_tranche_done_event();
+    }
+
+    feedback.send_done_event();
+}
+}
+
+class mg::LinuxDmaBufUnstable::Feedback : public mw::LinuxDmabufFeedbackV1
+{
+public:
+    Feedback(wl_resource* new_resource, std::shared_ptr<DmaBufFormatTable const> format_table, bool scanout_candidate)
+        : mw::LinuxDmabufFeedbackV1(new_resource, Version<4>{}),
+          format_table{std::move(format_table)},
+          scanout_candidate{scanout_candidate}
+    {
+        send_feedback(*this, *this->format_table, scanout_candidate);
+    }
+
+    /// Send the feedback again if the surface it's for has become, or stopped being, a scanout candidate
+    void update(bool scanout_candidate)
+    {
+        if (scanout_candidate != this->scanout_candidate)
+        {
+            this->scanout_candidate = scanout_candidate;
+            send_feedback(*this, *format_table, scanout_candidate);
+        }
+    }
+
+private:
+    std::shared_ptr<DmaBufFormatTable const> const format_table;
+    bool scanout_candidate;
+};
+
+/**
+ * The surfaces that are scanout candidates, and the feedback clients have for each surface
+ *
+ * Only used on the Wayland thread.
+ */
+class mg::LinuxDmaBufUnstable::SurfaceFeedback
+{
+public:
+    auto is_scanout_candidate(wl_resource* surface) -> bool
+    {
+        auto const entry = find(surface);
+        return entry != entries.end() && entry->scanout_candidate;
+    }
+
+    void add(wl_resource* surface, Feedback& feedback)
+    {
+        if (auto const entry = entry_for(surface))
+        {
+            entry->feedback.emplace_back(&feedback);
+        }
+    }
+
+    void set_scanout_candidate(wl_resource* surface, bool candidate)
+    {
+        if (auto const entry = entry_for(surface))
+        {
+            entry->scanout_candidate = candidate;
+            for (auto const& feedback : entry->feedback)
+            {
+                if (feedback)
+                {
+                    feedback.value().update(candidate);
+                }
+            }
+        }
+    }
+
+private:
+    struct Entry
+    {
+        mw::Weak<mw::Surface> surface;
+        bool scanout_candidate;
+        std::vector<mw::Weak<Feedback>> feedback;
+    };
+
+    auto find(wl_resource* surface) -> std::vector<Entry>::iterator
+    {
+        auto const wrapper = mw::Surface::from(surface);
+        return std::find_if(entries.begin(), entries.end(), [&](auto const& entry)
+            {
+                return wrapper && entry.surface.is(*wrapper);
+            });
+    }
+
+    auto entry_for(wl_resource* surface) -> Entry*
+    {
+        // Forget the surfaces (and feedback) that have gone
+        std::erase_if(entries, [](auto const& entry) { return !entry.surface; });
+        for (auto& entry : entries)
+        {
+            std::erase_if(entry.feedback, [](auto const& feedback) { return !feedback; });
+        }
+
+        if (auto const entry = find(surface); entry != entries.end())
+        {
+            return &*entry;
+        }
+        if (auto const wrapper = mw::Surface::from(surface))
+        {
+            return &entries.emplace_back(Entry{mw::Weak<mw::Surface>{wrapper}, false, {}});
+        }
+        return nullptr;
+    }
+
+    std::vector<Entry> entries;
+};
+
 class mg::LinuxDmaBufUnstable::Instance : public mir::wayland::LinuxDmabufV1
 {
 public:
     Instance(
         wl_resource* new_resource,
-        std::shared_ptr<mg::DMABufEGLProvider> provider)
-        : mir::wayland::LinuxDmabufV1(new_resource, Version<3>{}),
-          provider{std::move(provider)}
+        std::shared_ptr<mg::DMABufEGLProvider> provider,
+        std::shared_ptr<DmaBufFormatTable const> format_table,
+        std::shared_ptr<SurfaceFeedback> surface_feedback)
+        : mir::wayland::LinuxDmabufV1(new_resource, Version<4>{}),
+          provider{std::move(provider)},
+          format_table{std::move(format_table)},
+          surface_feedback{std::move(surface_feedback)}
     {
+        // From version 4 clients get the formats from feedback instead
+        if (wl_resource_get_version(resource) >= 4)
+        {
+            return;
+        }
+
         auto const& formats = this->provider->supported_formats();
         for (auto i = 0u; i < formats.num_formats(); ++i)
         {
@@ -1077,14 +1305,30 @@ private:
         new LinuxDmaBufParams{params_id, provider};
     }
 
+    void get_default_feedback(struct wl_resource* id) override
+    {
+        new Feedback{id, format_table, false};
+    }
+
+    void get_surface_feedback(struct wl_resource* id, struct wl_resource* surface) override
+    {
+        auto const feedback = new Feedback{id, format_table, surface_feedback->is_scanout_candidate(surface)};
+        surface_feedback->add(surface, *feedback);
+    }
+
     std::shared_ptr<mg::DMABufEGLProvider> const provider;
+    std::shared_ptr<DmaBufFormatTable const> const format_table;
+    std::shared_ptr<SurfaceFeedback> const surface_feedback;
 };
 
 mg::LinuxDmaBufUnstable::LinuxDmaBufUnstable(
     wl_display* display,
-    std::shared_ptr<mg::DMABufEGLProvider> provider)
-    : mir::wayland::LinuxDmabufV1::Global(display, Version<3>{}),
-      provider{std::move(provider)}
+    std::shared_ptr<mg::DMABufEGLProvider> provider,
+    std::shared_ptr<GBMDisplayProvider> const& scanout_display)
+    : mir::wayland::LinuxDmabufV1::Global(display, provider->main_device() ? 4 : 3),
+      provider{std::move(provider)},
+      format_table{make_format_table(*this->provider, scanout_display.get())},
+      surface_feedback{std::make_shared<SurfaceFeedback>()}
 {
 }
 
@@ -1105,9 +1349,14 @@ auto mg::LinuxDmaBufUnstable::buffer_from_resource(
     return nullptr;
 }
 
+void mg::LinuxDmaBufUnstable::set_scanout_candidate(wl_resource* surface, bool candidate)
+{
+    surface_feedback->set_scanout_candidate(surface, candidate);
+}
+
 void mg::LinuxDmaBufUnstable::bind(wl_resource* new_resource)
 {
-    new LinuxDmaBufUnstable::Instance{new_resource, provider};
+    new LinuxDmaBufUnstable::Instance{new_resource, provider, format_table, surface_feedback};
 }
 
 mg::DMABufEGLProvider::DMABufEGLProvider(
@@ -1122,7 +1371,8 @@ mg::DMABufEGLProvider::DMABufEGLProvider(
       formats{std::make_unique<DmaBufFormatDescriptors>(dpy, dmabuf_ext)},
       egl_delegate{std::move(egl_delegate)},
       allocate_importable_image{std::move(allocate_importable_image)},
-      blitter{std::make_unique<mg::EGLBufferCopier>(this->egl_delegate)}
+      blitter{std::make_unique<mg::EGLBufferCopier>(this->egl_delegate)},
+      device{drm_device_of(dpy)}
 {
 }
 
@@ -1133,6 +1383,11 @@ auto mg::DMABufEGLProvider::supported_formats() const -> mg::DmaBufFormatDescrip
     return *formats;
 }
 
+auto mg::DMABufEGLProvider::main_device() const -> std::optional<dev_t>
+{
+    return device;
+}
+
 auto mg::DMABufEGLProvider::import_dma_buf(
     mg::DMABufBuffer const& dma_buf,
     std::function<void()>&& on_consumed,
@@ -24,10 +24,15 @@
 
 #include "mir/graphics/egl_error.h"
 #include "mir/graphics/platform.h"
+#include "mir/geometry/rectangles.h"
 #include "mir/log.h"
 
 #include "cpu_copy_output_surface.h"
 
+#include <cstdio>
+#include <cstring>
+#include <deque>
+
 namespace mg = mir::graphics;
 namespace mgc = mg::common;
 namespace geom = mir::geometry;
@@ -95,6 +100,19 @@ auto create_current_context(EGLDisplay dpy, EGLContext share_ctx)
     return ctx;
 }
 
+auto supports_pack_row_length() -> bool
+{
+    // GL_PACK_ROW_LENGTH is core in GLES 3; GL_NV_pack_subimage adds it to GLES 2
+    int major_version{0};
+    auto const version = reinterpret_cast<char const*>(glGetString(GL_VERSION));
+    if (version && sscanf(version, "OpenGL ES %d", &major_version) == 1 && major_version >= 3)
+    {
+        return true;
+    }
+    auto const extensions = reinterpret_cast<char const*>(glGetString(GL_EXTENSIONS));
+    return extensions && strstr(extensions, "GL_NV_pack_subimage");
+}
+
 auto select_format_from(mg::CPUAddressableDisplayAllocator const& provider) -> mg::DRMFormat
 {
     std::optional<mg::DRMFormat> best_format;
@@ -138,14 +156,27 @@ public:
 
     auto size() const -> geom::Size;
     auto layout() const -> Layout;
+    auto buffer_age() const -> int;
+    void set_damage(std::optional<geom::Rectangle> const& area);
 
 private:
+    /// The area of the renderbuffer that fb, which holds the frame committed age frames ago, lacks
+    auto stale_area_of(mg::CPUAddressableDisplayAllocator::MappableFB const& fb, int age) const -> geom::Rectangle;
+    void read_pixels(geom::Rectangle area, GLenum pixel_layout, mir::renderer::software::Mapping<unsigned char>& mapping);
+
+    // Beyond this a framebuffer is as good as undefined; we read back the whole frame
+    static size_t const max_tracked_age = 4;
+
     mg::CPUAddressableDisplayAllocator& allocator;
     EGLDisplay const dpy;
     EGLContext const ctx;
     DRMFormat const format;
+    bool const can_pack_subimage;
     RenderbufferHandle const colour_buffer;
     FramebufferHandle const fbo;
+    bool has_committed_frame{false};
+    std::optional<geom::Rectangle> damage;                        //< Of the frame being drawn
+    std::deque<std::optional<geom::Rectangle>> committed_damage;  //< Of the frames committed, newest first
 };
 
 mgc::CPUCopyOutputSurface::CPUCopyOutputSurface(
@@ -188,6 +219,16 @@ auto mgc::CPUCopyOutputSurface::layout() const -> Layout
     return impl->layout();
 }
 
+auto mgc::CPUCopyOutputSurface::buffer_age() const -> int
+{
+    return impl->buffer_age();
+}
+
+void mgc::CPUCopyOutputSurface::set_damage(std::optional<geom::Rectangle> const& area)
+{
+    impl->set_damage(area);
+}
+
 mgc::CPUCopyOutputSurface::Impl::Impl(
     EGLDisplay dpy,
     EGLContext share_ctx,
@@ -195,7 +236,8 @@ mgc::CPUCopyOutputSurface::Impl::Impl(
     : allocator{allocator},
       dpy{dpy},
       ctx{create_current_context(dpy, share_ctx)},
-      format{select_format_from(allocator)}
+      format{select_format_from(allocator)},
+      can_pack_subimage{supports_pack_row_length()}
 {
     glBindRenderbuffer(GL_RENDERBUFFER, colour_buffer);
     glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8_OES, size().width.as_int(), size().height.as_int());
@@ -260,6 +302,14 @@ void mgc::CPUCopyOutputSurface::Impl::release_current()
 auto mgc::CPUCopyOutputSurface::Impl::commit() -> std::unique_ptr<mg::Framebuffer>
 {
     auto fb = allocator.alloc_fb(format);
+    auto const area = stale_area_of(*fb, fb->buffer_age());
+
+    committed_damage.push_front(std::exchange(damage, std::nullopt));
+    if (committed_damage.size() > max_tracked_age)
+    {
+        committed_damage.pop_back();
+    }
+
     glBindFramebuffer(GL_FRAMEBUFFER, fbo);
     {
         /* TODO: We can usefully put this *into* DRMFormat */
@@ -275,20 +325,95 @@ auto mgc::CPUCopyOutputSurface::Impl::commit() -> std::unique_ptr<mg::Framebuffe
         auto mapping = fb->map_writeable();
         /*
          * TODO: This introduces a pipeline stall; GL must wait for all previous rendering commands
-         * to complete before glReadPixels returns. We could instead do something fancy with
-         * pixel buffer objects to defer this cost.
+         * to complete before glReadPixels returns. A pixel buffer object would only move that wait
+         * to mapping the PBO, though: the display needs this frame before we draw the next.
          */
         /*
          * TODO: We are assuming that the framebuffer pixel format is RGBX
          */
-        glReadPixels(
-            0, 0,
-            fb->size().width.as_uint32_t(), fb->size().height.as_uint32_t(),
-            pixel_layout, GL_UNSIGNED_BYTE, mapping->data());
+        read_pixels(area, pixel_layout, *mapping);
     }
+    has_committed_frame = true;
     return fb;
 }
 
+void mgc::CPUCopyOutputSurface::Impl::set_damage(std::optional<geom::Rectangle> const& area)
+{
+    damage = area;
+}
+
+auto mgc::CPUCopyOutputSurface::Impl::stale_area_of(
+    mg::CPUAddressableDisplayAllocator::MappableFB const& fb,
+    int age) const -> geom::Rectangle
+{
+    geom::Rectangle const whole_frame{{0, 0}, fb.size()};
+
+    if (age < 1 || !damage || static_cast<size_t>(age - 1) > committed_damage.size())
+    {
+        return whole_frame;
+    }
+
+    // fb lacks this frame's changes, and those of each frame committed since fb last was
+    geom::Rectangles stale{*damage};
+    for (auto i = 0; i != age - 1; ++i)
+    {
+        if (!committed_damage[i])
+        {
+            return whole_frame;
+        }
+        stale.add(*committed_damage[i]);
+    }
+    return intersection_of(stale.bounding_rectangle(), whole_frame);
+}
+
+void mgc::CPUCopyOutputSurface::Impl::read_pixels(
+    geom::Rectangle area,
+    GLenum pixel_layout,
+    mir::renderer::software::Mapping<unsigned char>& mapping)
+{
+    // The renderbuffer's first row is the top of the frame, as is the mapping's
+    auto const bytes_per_pixel = 4;
+    auto const stride = mapping.stride().as_int();
+    auto const width = mapping.size().width.as_int();
+
+    if (!can_pack_subimage)
+    {
+        // GL packs the rows we read tightly, so we can only read whole rows in one go
+        area.top_left.x = geom::X{0};
+        area.size.width = geom::Width{width};
+    }
+
+    auto const destination =
+        mapping.data() + area.top_left.y.as_int() * stride + area.top_left.x.as_int() * bytes_per_pixel;
+
+    if (can_pack_subimage)
+    {
+        glPixelStorei(GL_PACK_ROW_LENGTH_NV, stride / bytes_per_pixel);
+        glReadPixels(
+            area.top_left.x.as_int(), area.top_left.y.as_int(),
+            area.size.width.as_int(), area.size.height.as_int(),
+            pixel_layout, GL_UNSIGNED_BYTE, destination);
+        glPixelStorei(GL_PACK_ROW_LENGTH_NV, 0);
+    }
+    else if (stride == width * bytes_per_pixel)
+    {
+        glReadPixels(
+            0, area.top_left.y.as_int(),
+            width, area.size.height.as_int(),
+            pixel_layout, GL_UNSIGNED_BYTE, destination);
+    }
+    else
+    {
+        for (auto row = 0; row != area.size.height.as_int(); ++row)
+        {
+            glReadPixels(
+                0, area.top_left.y.as_int() + row,
+                width, 1,
+                pixel_layout, GL_UNSIGNED_BYTE, destination + row * stride);
+        }
+    }
+}
+
 auto mgc::CPUCopyOutputSurface::Impl::size() const -> geom::Size
 {
     return allocator.output_size();
@@ -298,3 +423,9 @@ auto mgc::CPUCopyOutputSurface::Impl::layout() const -> Layout
 {
     return Layout::TopRowFirst;
 }
+
+auto mgc::CPUCopyOutputSurface::Impl::buffer_age() const -> int
+{
+    // We always render into the same renderbuffer, so it holds the last frame we committed
+    return has_committed_frame ? 1 : 0;
+}
@@ -51,6 +51,11 @@ public:
 
     auto layout() const -> Layout override;
 
+    auto buffer_age() const -> int override;
+
+    /// Only the damaged area is read back into framebuffers that hold an earlier frame
+    void set_damage(std::optional<geometry::Rectangle> const& area) override;
+
 private:
     class Impl;
     std::unique_ptr<Impl> const impl;
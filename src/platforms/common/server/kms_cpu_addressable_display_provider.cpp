@@ -19,6 +19,11 @@
 #include <drm_fourcc.h>
 #include <xf86drm.h>
 
+#include <algorithm>
+#include <mutex>
+#include <optional>
+#include <vector>
+
 namespace
 {
 auto drm_get_cap_checked(mir::Fd const& drm_fd, uint64_t cap) -> uint64_t
@@ -39,10 +44,129 @@ auto drm_get_cap_checked(mir::Fd const& drm_fd, uint64_t cap) -> uint64_t
 namespace mg = mir::graphics;
 namespace geom = mir::geometry;
 
+/// The dumb buffers KMS has finished with, kept to hand out again rather than reallocating every frame
+class mg::kms::CPUAddressableDisplayAllocator::Pool
+{
+public:
+    struct Entry
+    {
+        std::unique_ptr<CPUAddressableFB> fb;
+        DRMFormat format;
+        uint64_t serial;    //< The alloc_fb() call that last handed out fb
+    };
+
+    auto next_serial() -> uint64_t
+    {
+        std::lock_guard lock{mutex};
+        return ++serial;
+    }
+
+    /// The most recently used spare framebuffer of format, if any
+    auto take(DRMFormat format) -> std::optional<Entry>
+    {
+        std::lock_guard lock{mutex};
+
+        auto newest = spares.end();
+        for (auto i = spares.begin(); i != spares.end(); ++i)
+        {
+            if (static_cast<uint32_t>(i->format) == static_cast<uint32_t>(format) &&
+                (newest == spares.end() || i->serial > newest->serial))
+            {
+                newest = i;
+            }
+        }
+
+        if (newest == spares.end())
+        {
+            return std::nullopt;
+        }
+        auto entry = std::move(*newest);
+        spares.erase(newest);
+        return entry;
+    }
+
+    void give_back(Entry entry)
+    {
+        std::lock_guard lock{mutex};
+
+        spares.push_back(std::move(entry));
+        if (spares.size() > max_spares)
+        {
+            // Drop the stalest; it has the most to be redrawn anyway
+            spares.erase(std::min_element(
+                spares.begin(), spares.end(),
+                [](auto const& a, auto const& b) { return a.serial < b.serial; }));
+        }
+    }
+
+private:
+    // Enough for a frame to be drawn while another is scheduled and a third is on screen
+    static size_t const max_spares = 2;
+
+    std::mutex mutex;
+    uint64_t serial{0};
+    std::vector<Entry> spares;
+};
+
+class mg::kms::CPUAddressableDisplayAllocator::PooledFB : public FBHandle, public MappableFB
+{
+public:
+    PooledFB(std::shared_ptr<Pool> const& pool, Pool::Entry entry, int age)
+        : pool{pool},
+          entry{std::move(entry)},
+          age{age}
+    {
+    }
+
+    ~PooledFB() override
+    {
+        if (auto const live_pool = pool.lock())
+        {
+            live_pool->give_back(std::move(entry));
+        }
+    }
+
+    auto map_writeable() -> std::unique_ptr<mir::renderer::software::Mapping<unsigned char>> override
+    {
+        return entry.fb->map_writeable();
+    }
+
+    auto format() const -> MirPixelFormat override
+    {
+        return entry.fb->format();
+    }
+
+    auto stride() const -> geom::Stride override
+    {
+        return entry.fb->stride();
+    }
+
+    auto size() const -> geom::Size override
+    {
+        return entry.fb->size();
+    }
+
+    auto buffer_age() const -> int override
+    {
+        return age;
+    }
+
+    operator uint32_t() const override
+    {
+        return *entry.fb;
+    }
+
+private:
+    std::weak_ptr<Pool> const pool;
+    Pool::Entry entry;
+    int const age;
+};
+
 mg::kms::CPUAddressableDisplayAllocator::CPUAddressableDisplayAllocator(mir::Fd drm_fd, geom::Size size)
     : drm_fd{std::move(drm_fd)},
       supports_modifiers{drm_get_cap_checked(this->drm_fd, DRM_CAP_ADDFB2_MODIFIERS) == 1},
-      size{size}
+      size{size},
+      pool{std::make_shared<Pool>()}
 {
 }
 
@@ -55,7 +179,19 @@ auto mg::kms::CPUAddressableDisplayAllocator::supported_formats() const
 
 auto mg::kms::CPUAddressableDisplayAllocator::alloc_fb(DRMFormat format) -> std::unique_ptr<MappableFB>
 {
-    return std::make_unique<mg::CPUAddressableFB>(drm_fd, supports_modifiers, format, size);
+    auto const serial = pool->next_serial();
+
+    if (auto spare = pool->take(format))
+    {
+        auto const age = static_cast<int>(serial - spare->serial);
+        spare->serial = serial;
+        return std::make_unique<PooledFB>(pool, std::move(*spare), age);
+    }
+
+    return std::make_unique<PooledFB>(
+        pool,
+        Pool::Entry{std::make_unique<mg::CPUAddressableFB>(drm_fd, supports_modifiers, format, size), format, serial},
+        0);
 }
 
 auto mg::kms::CPUAddressableDisplayAllocator::output_size() const -> geom::Size
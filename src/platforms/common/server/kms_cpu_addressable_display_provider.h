@@ -44,9 +44,13 @@ public:
 private:
     explicit CPUAddressableDisplayAllocator(mir::Fd drm_fd, geometry::Size size);
 
+    class Pool;
+    class PooledFB;
+
     mir::Fd const drm_fd;
     bool const supports_modifiers;
     geometry::Size const size;
+    std::shared_ptr<Pool> const pool;
 };
 }
 }
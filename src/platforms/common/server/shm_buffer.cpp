@@ -20,6 +20,7 @@
 #include "mir/graphics/program_factory.h"
 #include "mir/graphics/program.h"
 #include "mir/graphics/egl_context_executor.h"
+#include "mir/graphics/egl_extensions.h"
 
 #define MIR_LOG_COMPONENT "gfx-common"
 #include "mir/log.h"
@@ -85,6 +86,164 @@ bool mg::get_gl_pixel_format(MirPixelFormat mir_format,
     return gl_format != GL_INVALID_ENUM && gl_type != GL_INVALID_ENUM;
 }
 
+/**
+ * The GL texture ShmBuffers are drawn from
+ *
+ * Successive commits of a client buffer share one, each updating it with what has changed since
+ * the previous commit. The last reference must be dropped on a thread with a current GL context.
+ */
+class mgc::ShmTexture
+{
+public:
+    ~ShmTexture()
+    {
+        if (id != 0)
+        {
+            glDeleteTextures(1, &id);
+        }
+        if (upload_fence != EGL_NO_SYNC_KHR)
+        {
+            auto const dpy = eglGetCurrentDisplay();
+            mg::EGLExtensions::KHRFenceSync{dpy}.eglDestroySyncKHR(dpy, upload_fence);
+        }
+    }
+
+    /// Number the next commit sharing this texture; commits must be applied in this order
+    auto next_serial() -> std::uint64_t
+    {
+        std::lock_guard lock{mutex};
+        return ++committed;
+    }
+
+    /// \note This must be called with mutex held and a current GL context
+    void bind()
+    {
+        bool const needs_initialisation = id == 0;
+        if (needs_initialisation)
+        {
+            glGenTextures(1, &id);
+        }
+        glBindTexture(GL_TEXTURE_2D, id);
+        if (needs_initialisation)
+        {
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        }
+    }
+
+    /**
+     * Bring the (bound) texture up to date with commit serial of the client buffer
+     *
+     * Only the damaged regions are uploaded if the texture holds the previous commit, otherwise
+     * the whole of pixels is.
+     *
+     * \note This must be called with mutex held and a current GL context
+     * \return false if pixel_format can't be uploaded
+     */
+    auto update(
+        std::uint64_t serial,
+        MirPixelFormat pixel_format,
+        geom::Size const& size,
+        void const* pixels,
+        geom::Stride const& stride,
+        std::optional<geom::Rectangles> const& damage) -> bool
+    {
+        bool const holds_previous_commit =
+            applied + 1 == serial && size == allocated_size && pixel_format == allocated_format;
+        applied = serial;
+
+        GLenum format, type;
+        if (!mg::get_gl_pixel_format(pixel_format, format, type))
+        {
+            return false;
+        }
+
+        auto const bytes_per_pixel = MIR_BYTES_PER_PIXEL(pixel_format);
+        auto const stride_in_px = stride.as_int() / bytes_per_pixel;
+        /*
+         * We assume (as does Weston, AFAICT) that stride is
+         * a multiple of whole pixels, but it need not be.
+         *
+         * TODO: Handle non-pixel-multiple strides.
+         * This should be possible by calculating GL_UNPACK_ALIGNMENT
+         * to match the size of the partial-pixel-stride().
+         */
+
+        glPixelStorei(GL_UNPACK_ROW_LENGTH_EXT, stride_in_px);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+        if (holds_previous_commit && damage)
+        {
+            geom::Rectangle const extents{{0, 0}, size};
+            for (auto const& rect : *damage)
+            {
+                auto const region = intersection_of(rect, extents);
+                if (region.size.width.as_int() <= 0 || region.size.height.as_int() <= 0)
+                {
+                    continue;
+                }
+
+                // GL_UNPACK_ROW_LENGTH_EXT lets us start part-way through the buffer's rows
+                auto const offset =
+                    region.top_left.y.as_int() * stride.as_int() +
+                    region.top_left.x.as_int() * bytes_per_pixel;
+
+                glTexSubImage2D(
+                    GL_TEXTURE_2D,
+                    0,
+                    region.top_left.x.as_int(), region.top_left.y.as_int(),
+                    region.size.width.as_int(), region.size.height.as_int(),
+                    format,
+                    type,
+                    static_cast<unsigned char const*>(pixels) + offset);
+            }
+        }
+        else
+        {
+            glTexImage2D(
+                GL_TEXTURE_2D,
+                0,
+                format,
+                size.width.as_int(), size.height.as_int(),
+                0,
+                format,
+                type,
+                pixels);
+            allocated_size = size;
+            allocated_format = pixel_format;
+        }
+
+        // Be nice to other users of the GL context by reverting our changes to shared state
+        glPixelStorei(GL_UNPACK_ROW_LENGTH_EXT, 0);     // 0 is default, meaning “use width”
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);          // 4 is default; word alignment.
+        return true;
+    }
+
+    std::mutex mutex;
+    GLuint id{0};
+    std::uint64_t committed{0};                 ///< The serial of the latest commit of the client buffer
+    std::uint64_t applied{0};                   ///< The serial of the commit the texture holds
+    EGLSyncKHR upload_fence{EGL_NO_SYNC_KHR};   ///< Signalled when the latest background update has completed
+
+private:
+    // What the texture's storage was last specified with
+    geom::Size allocated_size;
+    MirPixelFormat allocated_format{mir_pixel_format_invalid};
+};
+
+namespace
+{
+void log_incompatible_format(mg::BufferID id, MirPixelFormat format)
+{
+    mir::log_error(
+        "Buffer %i has non-GL-compatible pixel format %i; rendering will be incomplete",
+        id.as_value(),
+        format);
+}
+}
+
 bool mgc::ShmBuffer::supports(MirPixelFormat mir_format)
 {
     GLenum gl_format, gl_type;
@@ -94,10 +253,15 @@ bool mgc::ShmBuffer::supports(MirPixelFormat mir_format)
 mgc::ShmBuffer::ShmBuffer(
     geom::Size const& size,
     MirPixelFormat const& format,
-    std::shared_ptr<EGLContextExecutor> egl_delegate)
+    std::shared_ptr<EGLContextExecutor> egl_delegate,
+    std::shared_ptr<ShmTexture> texture,
+    std::optional<geom::Rectangles> damage)
     : size_{size},
       pixel_format_{format},
-      egl_delegate{std::move(egl_delegate)}
+      egl_delegate{std::move(egl_delegate)},
+      texture{texture ? std::move(texture) : std::make_shared<ShmTexture>()},
+      serial{this->texture->next_serial()},
+      damage{std::move(damage)}
 {
 }
 
@@ -113,14 +277,9 @@ mgc::MemoryBackedShmBuffer::MemoryBackedShmBuffer(
 
 mgc::ShmBuffer::~ShmBuffer() noexcept
 {
-    if (tex_id != 0)
-    {
-        egl_delegate->spawn(
-            [id = tex_id]()
-            {
-                glDeleteTextures(1, &id);
-            });
-    }
+    // If ours is the last reference, the texture needs deleting with a current context.
+    // (This also comes after any background update, which was queued on the same executor.)
+    egl_delegate->spawn([texture = std::move(texture)]() {});
 }
 
 geom::Size mgc::ShmBuffer::size() const
@@ -135,46 +294,63 @@ MirPixelFormat mgc::ShmBuffer::pixel_format() const
 
 void mgc::ShmBuffer::upload_to_texture(void const* pixels, geom::Stride const& stride)
 {
-    GLenum format, type;
-
-    if (mg::get_gl_pixel_format(pixel_format_, format, type))
+    // The renderer samples the texture on this same context, so there's no need to wait for the GPU
+    if (!texture->update(serial, pixel_format_, size(), pixels, stride, damage))
     {
-        auto const stride_in_px =
-            stride.as_int() / MIR_BYTES_PER_PIXEL(pixel_format());
-        /*
-         * We assume (as does Weston, AFAICT) that stride is
-         * a multiple of whole pixels, but it need not be.
-         *
-         * TODO: Handle non-pixel-multiple strides.
-         * This should be possible by calculating GL_UNPACK_ALIGNMENT
-         * to match the size of the partial-pixel-stride().
-         */
+        log_incompatible_format(id(), pixel_format());
+    }
+}
 
-        glPixelStorei(GL_UNPACK_ROW_LENGTH_EXT, stride_in_px);
-        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+void mgc::ShmBuffer::upload_in_background(std::shared_ptr<mrs::RWMappableBuffer> const& data)
+{
+    egl_delegate->spawn(
+        [texture = texture, data, serial = serial, damage = damage, id = id(), format = pixel_format_, size = size_]()
+        {
+            std::lock_guard lock{texture->mutex};
+            if (serial <= texture->applied)
+            {
+                // The renderer needed the buffer before we got to it
+                return;
+            }
 
-        glTexImage2D(
-            GL_TEXTURE_2D,
-            0,
-            format,
-            size().width.as_int(), size().height.as_int(),
-            0,
-            format,
-            type,
-            pixels);
+            texture->bind();
+            auto const mapping = data->map_readable();
+            if (!texture->update(serial, format, size, mapping->data(), mapping->stride(), damage))
+            {
+                log_incompatible_format(id, format);
+                return;
+            }
+
+            auto const dpy = eglGetCurrentDisplay();
+            auto const sync = dpy != EGL_NO_DISPLAY ?
+                mg::EGLExtensions::KHRFenceSync::extension_if_supported(dpy) : std::nullopt;
+            if (sync)
+            {
+                // Waiting for this update implies waiting for any before it
+                if (texture->upload_fence != EGL_NO_SYNC_KHR)
+                {
+                    sync->eglDestroySyncKHR(dpy, texture->upload_fence);
+                }
+                texture->upload_fence = sync->eglCreateSyncKHR(dpy, EGL_SYNC_FENCE_KHR, nullptr);
+            }
+
+            if (texture->upload_fence != EGL_NO_SYNC_KHR)
+            {
+                // The renderer's context can only wait on the fence once it has been submitted
+                glFlush();
+            }
+            else
+            {
+                // Without a fence to wait on, the update needs to be complete before the renderer uses it
+                glFinish();
+            }
+        });
+}
 
-        // Be nice to other users of the GL context by reverting our changes to shared state
-        glPixelStorei(GL_UNPACK_ROW_LENGTH_EXT, 0);     // 0 is default, meaning “use width”
-        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);          // 4 is default; word alignment.
-        glFinish();
-    }
-    else
-    {
-        mir::log_error(
-            "Buffer %i has non-GL-compatible pixel format %i; rendering will be incomplete",
-            id().as_value(),
-            pixel_format());
-    }
+void mgc::ShmBuffer::after_background_upload(std::function<void()>&& work)
+{
+    // The executor runs work in order, so this comes after any upload queued for this buffer
+    egl_delegate->spawn(std::move(work));
 }
 
 mg::NativeBufferBase* mgc::ShmBuffer::native_buffer_base()
@@ -184,32 +360,33 @@ mg::NativeBufferBase* mgc::ShmBuffer::native_buffer_base()
 
 void mgc::ShmBuffer::bind()
 {
-    std::lock_guard lock{tex_id_mutex};
-    bool const needs_initialisation = tex_id == 0;
-    if (needs_initialisation)
+    std::lock_guard lock{texture->mutex};
+    texture->bind();
+    if (texture->upload_fence != EGL_NO_SYNC_KHR)
     {
-        glGenTextures(1, &tex_id);
+        // Updated on the EGL context executor; only wait if the GPU isn't done with that
+        auto const dpy = eglGetCurrentDisplay();
+        mg::EGLExtensions::KHRFenceSync const sync{dpy};
+        if (sync.eglWaitSyncKHR)
+        {
+            sync.eglWaitSyncKHR(dpy, texture->upload_fence, 0);
+        }
+        else
+        {
+            sync.eglClientWaitSyncKHR(dpy, texture->upload_fence, 0, EGL_FOREVER_KHR);
+        }
+        sync.eglDestroySyncKHR(dpy, texture->upload_fence);
+        texture->upload_fence = EGL_NO_SYNC_KHR;
     }
-    glBindTexture(GL_TEXTURE_2D, tex_id);
-    if (needs_initialisation)
+    if (serial > texture->applied)
     {
-        // The ShmBuffer *should* be immutable, so we can just upload once.
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        upload();
     }
 }
 
-void mgc::MemoryBackedShmBuffer::bind()
+void mgc::MemoryBackedShmBuffer::upload()
 {
-    mgc::ShmBuffer::bind();
-    std::lock_guard lock{uploaded_mutex};
-    if (!uploaded)
-    {
-        upload_to_texture(pixels.get(), stride_);
-        uploaded = true;
-    }
+    upload_to_texture(pixels.get(), stride_);
 }
 
 template<typename T>
@@ -289,10 +466,18 @@ void mgc::ShmBuffer::add_syncpoint()
 
 mgc::MappableBackedShmBuffer::MappableBackedShmBuffer(
     std::shared_ptr<mrs::RWMappableBuffer> data,
-    std::shared_ptr<EGLContextExecutor> egl_delegate)
-    : ShmBuffer(data->size(), data->format(), std::move(egl_delegate)),
+    std::shared_ptr<EGLContextExecutor> egl_delegate,
+    std::shared_ptr<ShmTexture> texture,
+    std::optional<geom::Rectangles> damage,
+    bool upload_at_commit)
+    : ShmBuffer(data->size(), data->format(), std::move(egl_delegate), std::move(texture), std::move(damage)),
       data{std::move(data)}
 {
+    if (upload_at_commit)
+    {
+        // Get the contents onto the GPU before the renderer needs them
+        upload_in_background(this->data);
+    }
 }
 
 auto mgc::MappableBackedShmBuffer::map_writeable() -> std::unique_ptr<mrs::Mapping<unsigned char>>
@@ -310,16 +495,10 @@ auto mgc::MappableBackedShmBuffer::map_rw() -> std::unique_ptr<mrs::Mapping<unsi
     return data->map_rw();
 }
 
-void mgc::MappableBackedShmBuffer::bind()
+void mgc::MappableBackedShmBuffer::upload()
 {
-    mgc::ShmBuffer::bind();
-    std::lock_guard lock{uploaded_mutex};
-    if (!uploaded)
-    {
-        auto mapping = data->map_readable();
-        upload_to_texture(mapping->data(), mapping->stride());
-        uploaded = true;
-    }
+    auto mapping = data->map_readable();
+    upload_to_texture(mapping->data(), mapping->stride());
 }
 
 auto mgc::MappableBackedShmBuffer::format() const -> MirPixelFormat
@@ -341,8 +520,16 @@ mgc::NotifyingMappableBackedShmBuffer::NotifyingMappableBackedShmBuffer(
     std::shared_ptr<mrs::RWMappableBuffer> data,
     std::shared_ptr<mgc::EGLContextExecutor> egl_delegate,
     std::function<void()>&& on_consumed,
-    std::function<void()>&& on_release)
-    :  MappableBackedShmBuffer(std::move(data), std::move(egl_delegate)),
+    std::function<void()>&& on_release,
+    std::shared_ptr<ShmTexture> texture,
+    std::optional<geom::Rectangles> damage,
+    bool upload_at_commit)
+    :  MappableBackedShmBuffer(
+           std::move(data),
+           std::move(egl_delegate),
+           std::move(texture),
+           std::move(damage),
+           upload_at_commit),
        on_consumed{std::move(on_consumed)},
        on_release{std::move(on_release)}
 {
@@ -350,7 +537,8 @@ mgc::NotifyingMappableBackedShmBuffer::NotifyingMappableBackedShmBuffer(
 
 mgc::NotifyingMappableBackedShmBuffer::~NotifyingMappableBackedShmBuffer()
 {
-    on_release();
+    // The client may write to the buffer as soon as it's released, so not before we're done reading it
+    after_background_upload(std::function<void()>{on_release});
 }
 
 void mgc::NotifyingMappableBackedShmBuffer::notify_consumed()
@@ -383,3 +571,47 @@ auto mgc::NotifyingMappableBackedShmBuffer::map_rw() -> std::unique_ptr<mrs::Map
     notify_consumed();
     return MappableBackedShmBuffer::map_rw();
 }
+
+mgc::ShmTextureCache::ShmTextureCache(std::shared_ptr<EGLContextExecutor> egl_delegate)
+    : egl_delegate{std::move(egl_delegate)}
+{
+}
+
+mgc::ShmTextureCache::~ShmTextureCache()
+{
+    // The textures need deleting with a current context
+    egl_delegate->spawn([textures = std::move(textures)]() {});
+}
+
+auto mgc::ShmTextureCache::texture_for(std::shared_ptr<mrs::RWMappableBuffer> const& data)
+    -> std::shared_ptr<ShmTexture>
+{
+    std::lock_guard lock{mutex};
+
+    std::vector<std::shared_ptr<ShmTexture>> unused;
+    std::erase_if(
+        textures,
+        [&unused](auto& entry)
+        {
+            if (entry.first.expired())
+            {
+                unused.push_back(std::move(entry.second));
+                return true;
+            }
+            return false;
+        });
+    if (!unused.empty())
+    {
+        egl_delegate->spawn([unused = std::move(unused)]() {});
+    }
+
+    for (auto const& [buffer, texture] : textures)
+    {
+        if (buffer.lock() == data)
+        {
+            return texture;
+        }
+    }
+
+    return textures.emplace_back(data, std::make_shared<ShmTexture>()).second;
+}
@@ -20,6 +20,7 @@
 #include "mir/graphics/buffer_basic.h"
 #include "mir/geometry/dimensions.h"
 #include "mir/geometry/size.h"
+#include "mir/geometry/rectangles.h"
 #include "mir_toolkit/common.h"
 #include "mir_toolkit/mir_native_buffer.h"
 #include "mir/renderer/sw/pixel_source.h"
@@ -27,7 +28,11 @@
 
 #include <GLES2/gl2.h>
 
+#include <cstdint>
+#include <functional>
 #include <mutex>
+#include <optional>
+#include <vector>
 
 namespace mir
 {
@@ -38,6 +43,7 @@ namespace graphics
 namespace common
 {
 class EGLContextExecutor;
+class ShmTexture;
 
 class ShmBuffer :
     public BufferBasic,
@@ -58,19 +64,51 @@ public:
     Layout layout() const override;
     void add_syncpoint() override;
 protected:
+    /**
+     * \param texture [in]    The texture of earlier commits of the same client buffer, to update
+     *                        rather than upload the whole buffer. If null, the buffer has its own.
+     * \param damage [in]     The regions changed since the client buffer was last committed, or
+     *                        std::nullopt if that isn't known
+     */
     ShmBuffer(
         geometry::Size const& size,
         MirPixelFormat const& format,
-        std::shared_ptr<EGLContextExecutor> egl_delegate);
+        std::shared_ptr<EGLContextExecutor> egl_delegate,
+        std::shared_ptr<ShmTexture> texture = nullptr,
+        std::optional<geometry::Rectangles> damage = std::nullopt);
 
-    /// \note This must be called with a current GL context
+    /// \note This must be called with a current GL context, from upload()
     void upload_to_texture(void const* pixels, geometry::Stride const& stride);
+
+    /**
+     * Fill the texture with the buffer's contents
+     *
+     * Called from bind(), with the texture bound, unless the contents were already uploaded.
+     * \note This must be called with a current GL context
+     */
+    virtual void upload() = 0;
+
+    /**
+     * Start uploading data to the texture on the EGL context executor's thread
+     *
+     * If that hasn't finished by the time the buffer is bound, bind() waits for it
+     * (or, if it hasn't started, uploads the contents itself).
+     */
+    void upload_in_background(std::shared_ptr<renderer::software::RWMappableBuffer> const& data);
+
+    /**
+     * Run work once any upload_in_background() has finished reading the buffer's contents
+     *
+     * GL has copied the pixels by the time glTex(Sub)Image2D returns, so this doesn't wait for the GPU.
+     */
+    void after_background_upload(std::function<void()>&& work);
 private:
     geometry::Size const size_;
     MirPixelFormat const pixel_format_;
     std::shared_ptr<EGLContextExecutor> const egl_delegate;
-    std::mutex tex_id_mutex;
-    GLuint tex_id{0};
+    std::shared_ptr<ShmTexture> texture;
+    std::uint64_t const serial;                         ///< Which commit of the client buffer this is
+    std::optional<geometry::Rectangles> const damage;
 };
 
 class MemoryBackedShmBuffer :
@@ -88,8 +126,6 @@ public:
 
     auto map_rw() -> std::unique_ptr<renderer::software::Mapping<unsigned char>> override;
 
-    void bind() override;
-
     auto format() const -> MirPixelFormat override { return ShmBuffer::pixel_format(); }
     auto stride() const -> geometry::Stride override { return stride_; }
     auto size() const -> geometry::Size override { return ShmBuffer::size(); }
@@ -103,10 +139,10 @@ private:
     template<typename T>
     friend class Mapping;
 
+    void upload() override;
+
     geometry::Stride const stride_;
     std::unique_ptr<unsigned char[]> const pixels;
-    std::mutex uploaded_mutex;
-    bool uploaded{false};
 };
 
 class MappableBackedShmBuffer :
@@ -114,16 +150,22 @@ class MappableBackedShmBuffer :
     public renderer::software::RWMappableBuffer
 {
 public:
+    /**
+     * \param upload_at_commit [in]  Start uploading the contents to the texture straight away, rather
+     *                               than when (and if) the buffer is bound. A renderer that maps the
+     *                               buffer instead of binding it has no use for the upload.
+     */
     MappableBackedShmBuffer(
         std::shared_ptr<renderer::software::RWMappableBuffer> data,
-        std::shared_ptr<EGLContextExecutor> egl_delegate);
+        std::shared_ptr<EGLContextExecutor> egl_delegate,
+        std::shared_ptr<ShmTexture> texture = nullptr,
+        std::optional<geometry::Rectangles> damage = std::nullopt,
+        bool upload_at_commit = true);
 
     auto map_writeable() -> std::unique_ptr<renderer::software::Mapping<unsigned char>> override;
     auto map_readable() -> std::unique_ptr<renderer::software::Mapping<unsigned char const>> override;
     auto map_rw() -> std::unique_ptr<renderer::software::Mapping<unsigned char>> override;
 
-    void bind() override;
-
     auto format() const -> MirPixelFormat override;
     auto stride() const -> geometry::Stride override;
     auto size() const -> geometry::Size override;
@@ -131,9 +173,9 @@ public:
     MappableBackedShmBuffer(MappableBackedShmBuffer const&) = delete;
     MappableBackedShmBuffer& operator=(MappableBackedShmBuffer const&) = delete;
 private:
+    void upload() override;
+
     std::shared_ptr<renderer::software::RWMappableBuffer> const data;
-    std::mutex uploaded_mutex;
-    bool uploaded{false};
 };
 
 class NotifyingMappableBackedShmBuffer : public MappableBackedShmBuffer
@@ -143,7 +185,10 @@ public:
         std::shared_ptr<renderer::software::RWMappableBuffer> data,
         std::shared_ptr<common::EGLContextExecutor> egl_delegate,
         std::function<void()>&& on_consumed,
-        std::function<void()>&& on_release);
+        std::function<void()>&& on_release,
+        std::shared_ptr<ShmTexture> texture = nullptr,
+        std::optional<geometry::Rectangles> damage = std::nullopt,
+        bool upload_at_commit = true);
 
     ~NotifyingMappableBackedShmBuffer() override;
 
@@ -160,6 +205,32 @@ private:
     std::function<void()> on_consumed;
     std::function<void()> const on_release;
 };
+
+/**
+ * The textures of client SHM buffers, kept between commits
+ *
+ * Clients usually cycle through a few buffers, changing a little of each before committing it
+ * again. ShmBuffers sharing a texture only upload the damaged regions of the buffer to it.
+ *
+ * The textures of client buffers that have been destroyed are freed on the next texture_for().
+ */
+class ShmTextureCache
+{
+public:
+    ShmTextureCache(std::shared_ptr<EGLContextExecutor> egl_delegate);
+    ~ShmTextureCache();
+
+    /// The texture to use for a commit of data; the same data gets the same texture
+    auto texture_for(std::shared_ptr<renderer::software::RWMappableBuffer> const& data)
+        -> std::shared_ptr<ShmTexture>;
+
+    ShmTextureCache(ShmTextureCache const&) = delete;
+    ShmTextureCache& operator=(ShmTextureCache const&) = delete;
+private:
+    std::shared_ptr<EGLContextExecutor> const egl_delegate;
+    std::mutex mutex;
+    std::vector<std::pair<std::weak_ptr<renderer::software::RWMappableBuffer>, std::shared_ptr<ShmTexture>>> textures;
+};
 }
 }
 }
@@ -68,10 +68,12 @@ namespace geom = mir::geometry;
 #define EGL_WAYLAND_EGLSTREAM_WL              0x334B
 #endif /* EGL_WL_wayland_eglstream */
 
-mge::BufferAllocator::BufferAllocator(std::unique_ptr<renderer::gl::Context> ctx)
+mge::BufferAllocator::BufferAllocator(std::unique_ptr<renderer::gl::Context> ctx, bool upload_shm_at_commit)
     : wayland_ctx{ctx->make_share_context()},
       egl_delegate{
-          std::make_shared<mgc::EGLContextExecutor>(std::move(ctx))}
+          std::make_shared<mgc::EGLContextExecutor>(std::move(ctx))},
+      shm_textures{std::make_shared<mgc::ShmTextureCache>(egl_delegate)},
+      upload_shm_at_commit{upload_shm_at_commit}
 {
 }
 
@@ -538,14 +540,19 @@ mir::graphics::eglstream::BufferAllocator::buffer_from_resource(
 
 auto mge::BufferAllocator::buffer_from_shm(
     std::shared_ptr<renderer::software::RWMappableBuffer> data,
+    std::optional<geometry::Rectangles> const& damage,
     std::function<void()>&& on_consumed,
     std::function<void()>&& on_release) -> std::shared_ptr<Buffer>
 {
+    auto texture = shm_textures->texture_for(data);
     return std::make_shared<mgc::NotifyingMappableBackedShmBuffer>(
         std::move(data),
         egl_delegate,
         std::move(on_consumed),
-        std::move(on_release));
+        std::move(on_release),
+        std::move(texture),
+        damage,
+        upload_shm_at_commit);
 }
 
 namespace
@@ -46,6 +46,11 @@ namespace gl
 class Program;
 }
 
+namespace common
+{
+class ShmTextureCache;
+}
+
 namespace eglstream
 {
 
@@ -53,7 +58,7 @@ class BufferAllocator:
     public graphics::GraphicBufferAllocator
 {
 public:
-    BufferAllocator(std::unique_ptr<renderer::gl::Context> ctx);
+    BufferAllocator(std::unique_ptr<renderer::gl::Context> ctx, bool upload_shm_at_commit);
     ~BufferAllocator();
 
     std::shared_ptr<Buffer> alloc_software_buffer(geometry::Size size, MirPixelFormat format) override;
@@ -69,6 +74,7 @@ public:
 
     auto buffer_from_shm(
         std::shared_ptr<renderer::software::RWMappableBuffer> shm_data,
+        std::optional<geometry::Rectangles> const& damage,
         std::function<void()>&& on_consumed,
         std::function<void()>&& on_release) -> std::shared_ptr<Buffer> override;
 
@@ -88,6 +94,8 @@ private:
     EGLExtensions::LazyDisplayExtensions<EGLExtensions::NVStreamAttribExtensions> const nv_extensions;
     std::shared_ptr<renderer::gl::Context> const wayland_ctx;
     std::shared_ptr<common::EGLContextExecutor> const egl_delegate;
+    std::shared_ptr<common::ShmTextureCache> const shm_textures;
+    bool const upload_shm_at_commit;
     std::unique_ptr<gl::Program> shader;
     static struct wl_eglstream_controller_interface const impl;
 };
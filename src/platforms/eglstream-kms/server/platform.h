@@ -41,7 +41,11 @@ namespace eglstream
 class RenderingPlatform : public graphics::RenderingPlatform
 {
 public:
-    RenderingPlatform(EGLDisplay dpy);
+    /**
+     * \param upload_shm_at_commit  Whether to upload client SHM buffers to GL textures as they're committed,
+     *                              rather than waiting for the renderer to need them
+     */
+    RenderingPlatform(EGLDisplay dpy, bool upload_shm_at_commit);
     ~RenderingPlatform() override;
 
     UniqueModulePtr<GraphicBufferAllocator>
@@ -53,6 +57,7 @@ protected:
 private:
     EGLDisplay const dpy;
     std::unique_ptr<renderer::gl::Context> const ctx;
+    bool const upload_shm_at_commit;
 };
 
 class DisplayPlatform : public graphics::DisplayPlatform
@@ -50,7 +50,7 @@ namespace mge = mir::graphics::eglstream;
 auto create_rendering_platform(
     mg::SupportedDevice const& device,
     std::vector<std::shared_ptr<mg::DisplayPlatform>> const& /*displays*/,
-    mo::Option const&,
+    mo::Option const& options,
     mir::EmergencyCleanupRegistry&) -> mir::UniqueModulePtr<mg::RenderingPlatform>
 {
     mir::assert_entry_point_signature<mg::CreateRenderPlatform>(&create_rendering_platform);
@@ -82,7 +82,9 @@ auto create_rendering_platform(
         }
     }
 
-    return mir::make_module_ptr<mge::RenderingPlatform>(display);
+    // The software renderer maps SHM buffers rather than binding them, so has no use for an upload
+    auto const upload_shm_at_commit = options.get(mo::renderer_opt, "gl") != std::string{"software"};
+    return mir::make_module_ptr<mge::RenderingPlatform>(display, upload_shm_at_commit);
 }
 
 void add_graphics_platform_options(boost::program_options::options_description& /*config*/)
@@ -41,6 +41,7 @@
 #include "mir/graphics/egl_error.h"
 #include "cpu_copy_output_surface.h"
 #include "surfaceless_egl_context.h"
+#include "dmabuf_framebuffer_provider.h"
 
 #include <boost/throw_exception.hpp>
 #include <boost/exception/errinfo_errno.hpp>
@@ -71,11 +72,16 @@ namespace geom = mir::geometry;
 mgg::BufferAllocator::BufferAllocator(
     std::unique_ptr<mgg::SurfacelessEGLContext> context,
     std::shared_ptr<mgc::EGLContextExecutor> egl_delegate,
-    std::shared_ptr<mg::DMABufEGLProvider> dmabuf_provider)
+    std::shared_ptr<mg::DMABufEGLProvider> dmabuf_provider,
+    std::shared_ptr<mg::GBMDisplayProvider> scanout_display,
+    bool upload_shm_at_commit)
     : ctx{std::move(context)},
       egl_delegate{std::move(egl_delegate)},
+      shm_textures{std::make_shared<mgc::ShmTextureCache>(this->egl_delegate)},
       egl_extensions(std::make_shared<mg::EGLExtensions>()),
-      dmabuf_provider{std::move(dmabuf_provider)}
+      dmabuf_provider{std::move(dmabuf_provider)},
+      scanout_display{std::move(scanout_display)},
+      upload_shm_at_commit{upload_shm_at_commit}
 {
 }
 
@@ -149,6 +155,7 @@ void mgg::BufferAllocator::bind_display(wl_display* display, std::shared_ptr<Exe
                     new LinuxDmaBufUnstable{
                         display,
                         dmabuf_provider,
+                        scanout_display,
                     },
                     [wayland_executor](LinuxDmaBufUnstable* global)
                     {
@@ -225,14 +232,27 @@ std::shared_ptr<mg::Buffer> mgg::BufferAllocator::buffer_from_resource(
 
 auto mgg::BufferAllocator::buffer_from_shm(
     std::shared_ptr<renderer::software::RWMappableBuffer> data,
+    std::optional<geometry::Rectangles> const& damage,
     std::function<void()>&& on_consumed,
     std::function<void()>&& on_release) -> std::shared_ptr<Buffer>
 {
+    auto texture = shm_textures->texture_for(data);
     return std::make_shared<mgc::NotifyingMappableBackedShmBuffer>(
         std::move(data),
         egl_delegate,
         std::move(on_consumed),
-        std::move(on_release));
+        std::move(on_release),
+        std::move(texture),
+        damage,
+        upload_shm_at_commit);
+}
+
+void mgg::BufferAllocator::set_scanout_candidate(wl_resource* surface, bool candidate)
+{
+    if (dmabuf_extension)
+    {
+        dmabuf_extension->set_scanout_candidate(surface, candidate);
+    }
 }
 
 auto mgg::BufferAllocator::shared_egl_context() -> EGLContext
@@ -328,6 +348,22 @@ public:
         return Layout::GL;
     }
 
+    auto buffer_age() const -> int override
+    {
+        if (!has_buffer_age)
+        {
+            return 0;
+        }
+
+        EGLint age;
+        if (eglQuerySurface(dpy, egl_surf, EGL_BUFFER_AGE_EXT, &age) != EGL_TRUE)
+        {
+            mir::log_debug("Failed to query EGL buffer age: %s", mg::egl_category().message(eglGetError()).c_str());
+            return 0;
+        }
+        return age;
+    }
+
 private:
     static auto get_matching_configs(EGLDisplay dpy, EGLint const attr[]) -> std::vector<EGLConfig>
     {
@@ -466,7 +502,8 @@ private:
         : surface{std::move(std::get<0>(renderables))},
           egl_surf{std::get<2>(renderables)},
           dpy{dpy},
-          ctx{std::get<1>(renderables)}
+          ctx{std::get<1>(renderables)},
+          has_buffer_age{mg::has_egl_extension(dpy, "EGL_EXT_buffer_age")}
     {
     }
 
@@ -474,6 +511,7 @@ private:
     EGLSurface const egl_surf;
     EGLDisplay const dpy;
     EGLContext const ctx;
+    bool const has_buffer_age;
 };
 }
 
@@ -540,10 +578,22 @@ auto mgg::GLRenderingProvider::surface_for_sink(
         *cpu_allocator);
 }
 
-auto mgg::GLRenderingProvider::make_framebuffer_provider(DisplaySink& /*sink*/)
+auto mgg::GLRenderingProvider::make_framebuffer_provider(DisplaySink& sink)
     -> std::unique_ptr<FramebufferProvider>
 {
-    // TODO: Make this not a null implementation, so bypass/overlays can work again
+    if (bound_display && bound_display->on_this_sink(sink))
+    {
+        return std::make_unique<DMABufFramebufferProvider>(
+            bound_display->gbm_device(),
+            [dmabuf_provider = dmabuf_provider](std::shared_ptr<Buffer> const& buffer)
+            {
+                /* We're being naughty here and using the fact that `as_texture()` has a side-effect
+                 * of invoking the buffer's `on_consumed()` callback.
+                 */
+                dmabuf_provider->as_texture(buffer);
+            });
+    }
+
     class NullFramebufferProvider : public FramebufferProvider
     {
     public:
@@ -43,6 +43,7 @@ struct EGLExtensions;
 namespace common
 {
 class EGLContextExecutor;
+class ShmTextureCache;
 }
 
 namespace gbm
@@ -58,7 +59,9 @@ public:
     BufferAllocator(
         std::unique_ptr<SurfacelessEGLContext> ctx,
         std::shared_ptr<common::EGLContextExecutor> egl_delegate,
-        std::shared_ptr<DMABufEGLProvider> dmabuf_provider);
+        std::shared_ptr<DMABufEGLProvider> dmabuf_provider,
+        std::shared_ptr<GBMDisplayProvider> scanout_display,
+        bool upload_shm_at_commit);
 
     std::shared_ptr<Buffer> alloc_software_buffer(geometry::Size size, MirPixelFormat) override;
     std::vector<MirPixelFormat> supported_pixel_formats() override;
@@ -71,17 +74,22 @@ public:
         std::function<void()>&& on_release) -> std::shared_ptr<Buffer> override;
     auto buffer_from_shm(
         std::shared_ptr<renderer::software::RWMappableBuffer> data,
+        std::optional<geometry::Rectangles> const& damage,
         std::function<void()>&& on_consumed,
         std::function<void()>&& on_release) -> std::shared_ptr<Buffer> override;
+    void set_scanout_candidate(wl_resource* surface, bool candidate) override;
 
     auto shared_egl_context() -> EGLContext;
 private:
     std::unique_ptr<renderer::gl::Context> const ctx;
     std::shared_ptr<common::EGLContextExecutor> const egl_delegate;
+    std::shared_ptr<common::ShmTextureCache> const shm_textures;
     std::shared_ptr<Executor> wayland_executor;
     std::unique_ptr<LinuxDmaBufUnstable, std::function<void(LinuxDmaBufUnstable*)>> dmabuf_extension;
     std::shared_ptr<EGLExtensions> const egl_extensions;
     std::shared_ptr<DMABufEGLProvider> const dmabuf_provider;
+    std::shared_ptr<GBMDisplayProvider> const scanout_display;  ///< Display client buffers could be scanned out on (null is valid)
+    bool const upload_shm_at_commit;
     bool egl_display_bound{false};
 };
 
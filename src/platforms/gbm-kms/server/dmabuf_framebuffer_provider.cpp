@@ -0,0 +1,161 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "dmabuf_framebuffer_provider.h"
+#include "kms_framebuffer.h"
+
+#include "mir/graphics/dmabuf_buffer.h"
+#include "mir/graphics/drm_formats.h"
+
+#include <drm_fourcc.h>
+#include <xf86drmMode.h>
+#include <gbm.h>
+
+namespace mg = mir::graphics;
+namespace mgg = mir::graphics::gbm;
+namespace geom = mir::geometry;
+
+namespace
+{
+class DMABufFramebuffer : public mg::FBHandle
+{
+public:
+    DMABufFramebuffer(std::shared_ptr<mg::Buffer> buffer, std::shared_ptr<uint32_t const> fb_id)
+        : buffer{std::move(buffer)},
+          fb_id{std::move(fb_id)}
+    {
+    }
+
+    operator uint32_t() const override
+    {
+        return *fb_id;
+    }
+
+    auto size() const -> geom::Size override
+    {
+        return buffer->size();
+    }
+
+private:
+    // The client mustn't reuse the buffer while it's being scanned out
+    std::shared_ptr<mg::Buffer> const buffer;
+    std::shared_ptr<uint32_t const> const fb_id;
+};
+}
+
+mgg::DMABufFramebufferProvider::DMABufFramebufferProvider(
+    std::shared_ptr<struct gbm_device> gbm,
+    std::function<void(std::shared_ptr<Buffer> const&)> on_scanout)
+    : gbm{std::move(gbm)},
+      on_scanout{std::move(on_scanout)}
+{
+}
+
+auto mgg::DMABufFramebufferProvider::buffer_to_framebuffer(std::shared_ptr<Buffer> buffer)
+    -> std::unique_ptr<Framebuffer>
+{
+    std::erase_if(imports, [](auto const& entry) { return entry.second.buffer.expired(); });
+
+    auto cached = imports.find(buffer.get());
+    if (cached == imports.end())
+    {
+        cached = imports.emplace(buffer.get(), Import{buffer, import_buffer(*buffer)}).first;
+    }
+
+    auto fb_id = cached->second.fb_id;
+    if (!fb_id)
+    {
+        return nullptr;
+    }
+
+    on_scanout(buffer);
+    return std::make_unique<DMABufFramebuffer>(std::move(buffer), std::move(fb_id));
+}
+
+auto mgg::DMABufFramebufferProvider::import_buffer(Buffer& buffer) const -> std::shared_ptr<uint32_t const>
+{
+    auto const dmabuf = dynamic_cast<DMABufBuffer const*>(buffer.native_buffer_base());
+    if (!dmabuf)
+    {
+        return nullptr;
+    }
+
+    auto const& planes = dmabuf->planes();
+    if (planes.empty() || planes.size() > 4)
+    {
+        return nullptr;
+    }
+
+    auto const size = dmabuf->size();
+    uint32_t const format = dmabuf->format();
+    auto const modifier = dmabuf->modifier().value_or(DRM_FORMAT_MOD_INVALID);
+
+    gbm_import_fd_modifier_data import_data{};
+    import_data.width = size.width.as_uint32_t();
+    import_data.height = size.height.as_uint32_t();
+    import_data.format = format;
+    import_data.num_fds = static_cast<uint32_t>(planes.size());
+    import_data.modifier = modifier;
+    for (size_t i = 0; i < planes.size(); ++i)
+    {
+        import_data.fds[i] = planes[i].dma_buf;
+        import_data.strides[i] = static_cast<int>(planes[i].stride);
+        import_data.offsets[i] = static_cast<int>(planes[i].offset);
+    }
+
+    // Importing through GBM shares the GEM handles with anything else on this device using the same dma-bufs
+    auto const bo = gbm_bo_import(gbm.get(), GBM_BO_IMPORT_FD_MODIFIER, &import_data, GBM_BO_USE_SCANOUT);
+    if (!bo)
+    {
+        return nullptr;
+    }
+
+    uint32_t handles[4] = {0, 0, 0, 0};
+    uint32_t strides[4] = {0, 0, 0, 0};
+    uint32_t offsets[4] = {0, 0, 0, 0};
+    uint64_t modifiers[4] = {0, 0, 0, 0};
+    for (size_t i = 0; i < planes.size(); ++i)
+    {
+        handles[i] = gbm_bo_get_handle_for_plane(bo, static_cast<int>(i)).u32;
+        strides[i] = planes[i].stride;
+        offsets[i] = planes[i].offset;
+        modifiers[i] = modifier;
+    }
+
+    auto const drm_fd = gbm_device_get_fd(gbm.get());
+    uint32_t fb_id{0};
+    auto const result = modifier != DRM_FORMAT_MOD_INVALID ?
+        drmModeAddFB2WithModifiers(
+            drm_fd, import_data.width, import_data.height, format,
+            handles, strides, offsets, modifiers, &fb_id, DRM_MODE_FB_MODIFIERS) :
+        drmModeAddFB2(
+            drm_fd, import_data.width, import_data.height, format,
+            handles, strides, offsets, &fb_id, 0);
+    if (result)
+    {
+        gbm_bo_destroy(bo);
+        return nullptr;
+    }
+
+    return std::shared_ptr<uint32_t const>{
+        new uint32_t{fb_id},
+        [device = gbm, bo](uint32_t const* id)
+        {
+            drmModeRmFB(gbm_device_get_fd(device.get()), *id);
+            gbm_bo_destroy(bo);
+            delete id;
+        }};
+}
@@ -0,0 +1,64 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_GRAPHICS_GBM_DMABUF_FRAMEBUFFER_PROVIDER_H_
+#define MIR_GRAPHICS_GBM_DMABUF_FRAMEBUFFER_PROVIDER_H_
+
+#include "mir/graphics/platform.h"
+
+#include <functional>
+#include <memory>
+#include <unordered_map>
+
+struct gbm_device;
+
+namespace mir::graphics::gbm
+{
+/**
+ * Makes KMS framebuffers of clients' dma-buf buffers, so the display can scan them out directly
+ */
+class DMABufFramebufferProvider : public RenderingProvider::FramebufferProvider
+{
+public:
+    /**
+     * \param gbm           The GBM device of the display the framebuffers will be shown on
+     * \param on_scanout    Called with each buffer made into a framebuffer. A buffer that is
+     *                      scanned out is never textured from, so this must mark it consumed.
+     */
+    DMABufFramebufferProvider(
+        std::shared_ptr<struct gbm_device> gbm,
+        std::function<void(std::shared_ptr<Buffer> const&)> on_scanout);
+
+    auto buffer_to_framebuffer(std::shared_ptr<Buffer> buffer) -> std::unique_ptr<Framebuffer> override;
+
+private:
+    auto import_buffer(Buffer& buffer) const -> std::shared_ptr<uint32_t const>;
+
+    std::shared_ptr<struct gbm_device> const gbm;
+    std::function<void(std::shared_ptr<Buffer> const&)> const on_scanout;
+
+    /// The compositor asks for the same buffers each frame, so keep their KMS framebuffers
+    /// (or that they have none) for as long as the buffers live.
+    struct Import
+    {
+        std::weak_ptr<Buffer> buffer;
+        std::shared_ptr<uint32_t const> fb_id;    ///< null if the buffer can't be scanned out
+    };
+    std::unordered_map<Buffer const*, Import> imports;
+};
+}
+
+#endif // MIR_GRAPHICS_GBM_DMABUF_FRAMEBUFFER_PROVIDER_H_
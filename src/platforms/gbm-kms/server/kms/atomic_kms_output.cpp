@@ -0,0 +1,589 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "atomic_kms_output.h"
+#include "kms_framebuffer.h"
+#include "page_flipper.h"
+#include "kms-utils/kms_connector.h"
+#include "mir/fatal.h"
+#include "mir/log.h"
+
+#include <boost/throw_exception.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+#include <xf86drm.h>
+#include <xf86drmMode.h>
+
+namespace mg = mir::graphics;
+namespace mgg = mg::gbm;
+namespace mgk = mg::kms;
+namespace geom = mir::geometry;
+
+class mgg::AtomicKMSOutput::AtomicRequest
+{
+public:
+    AtomicRequest()
+        : request{drmModeAtomicAlloc(), &drmModeAtomicFree}
+    {
+        if (!request)
+        {
+            BOOST_THROW_EXCEPTION((std::system_error{ENOMEM, std::system_category(), "Failed to allocate atomic request"}));
+        }
+    }
+
+    void add(uint32_t object_id, mgk::ObjectProperties const& properties, char const* name, uint64_t value)
+    {
+        if (auto const ret = drmModeAtomicAddProperty(request.get(), object_id, properties.id_for(name), value); ret < 0)
+        {
+            BOOST_THROW_EXCEPTION((std::system_error{-ret, std::system_category(), "Failed to add property to atomic request"}));
+        }
+    }
+
+    operator drmModeAtomicReq*() const
+    {
+        return request.get();
+    }
+
+private:
+    std::unique_ptr<drmModeAtomicReq, decltype(&drmModeAtomicFree)> const request;
+};
+
+class mgg::AtomicKMSOutput::PropertyBlob
+{
+public:
+    PropertyBlob(int drm_fd, void const* data, size_t size)
+        : drm_fd{drm_fd}
+    {
+        if (auto const ret = drmModeCreatePropertyBlob(drm_fd, data, size, &id_); ret)
+        {
+            BOOST_THROW_EXCEPTION((std::system_error{-ret, std::system_category(), "Failed to create DRM property blob"}));
+        }
+    }
+
+    ~PropertyBlob()
+    {
+        /* The kernel keeps its own reference to blobs used in committed state */
+        drmModeDestroyPropertyBlob(drm_fd, id_);
+    }
+
+    PropertyBlob(PropertyBlob const&) = delete;
+    PropertyBlob& operator=(PropertyBlob const&) = delete;
+
+    auto id() const -> uint32_t
+    {
+        return id_;
+    }
+
+private:
+    int const drm_fd;
+    uint32_t id_;
+};
+
+namespace
+{
+/// Plane source coordinates are 16.16 fixed point
+auto to_fixed(float value) -> uint64_t
+{
+    return static_cast<uint64_t>(std::lround(value * 65536.0f));
+}
+
+/// CRTC_X and CRTC_Y are signed; the kernel takes them as sign-extended 64-bit values
+auto to_signed_property(int value) -> uint64_t
+{
+    return static_cast<uint64_t>(static_cast<int64_t>(value));
+}
+
+auto lowest_set_bit(uint32_t mask) -> int
+{
+    return mask ? __builtin_ctz(mask) : -1;
+}
+}
+
+mgg::AtomicKMSOutput::AtomicKMSOutput(
+    int drm_fd,
+    kms::DRMModeConnectorUPtr&& connector,
+    std::shared_ptr<PageFlipper> const& page_flipper)
+    : RealKMSOutput(drm_fd, std::move(connector), page_flipper)
+{
+}
+
+mgg::AtomicKMSOutput::~AtomicKMSOutput()
+{
+    /* The base class restores the saved CRTC with drmModeSetCrtc(), which leaves
+     * any other planes alone. Make sure none of our overlays outlive us.
+     */
+    if (!overlays_shown)
+        return;
+
+    try
+    {
+        AtomicRequest request;
+        add_overlays(request, {});
+        if (auto const ret = drmModeAtomicCommit(drm_fd_, request, 0, nullptr))
+        {
+            mir::log_warning("Failed to disable overlay planes: %s (%i)", strerror(-ret), -ret);
+        }
+    }
+    catch (std::exception const& e)
+    {
+        mir::log_warning("Failed to disable overlay planes: %s", e.what());
+    }
+}
+
+bool mgg::AtomicKMSOutput::set_crtc(FBHandle const& fb)
+{
+    std::lock_guard lg(power_mutex);
+
+    if (!ensure_planes())
+    {
+        mir::log_error("Output %s has no associated CRTC to set a framebuffer on",
+                       mgk::connector_name(connector).c_str());
+        return false;
+    }
+
+    auto const crtc_id = current_crtc->crtc_id;
+    PropertyBlob const mode{drm_fd_, &connector->modes[mode_index], sizeof(drmModeModeInfo)};
+
+    AtomicRequest request;
+    request.add(connector->connector_id, *connector_properties, "CRTC_ID", crtc_id);
+    request.add(crtc_id, *crtc_properties, "MODE_ID", mode.id());
+    request.add(crtc_id, *crtc_properties, "ACTIVE", power_mode == mir_power_mode_on);
+    add_scanout(request, fb);
+
+    if (auto const ret = drmModeAtomicCommit(
+            drm_fd_, request, DRM_MODE_ATOMIC_TEST_ONLY | DRM_MODE_ATOMIC_ALLOW_MODESET, nullptr))
+    {
+        mir::log_error("Output %s rejected CRTC configuration: %s (%i)",
+                       mgk::connector_name(connector).c_str(), strerror(-ret), -ret);
+        current_crtc = nullptr;
+        return false;
+    }
+
+    if (auto const ret = drmModeAtomicCommit(drm_fd_, request, DRM_MODE_ATOMIC_ALLOW_MODESET, nullptr))
+    {
+        mir::log_error("Failed to set CRTC: %s (%i)", strerror(-ret), -ret);
+        current_crtc = nullptr;
+        return false;
+    }
+
+    scanout_committed();
+    using_saved_crtc = false;
+    return true;
+}
+
+void mgg::AtomicKMSOutput::clear_crtc()
+{
+    std::lock_guard lg(power_mutex);
+
+    try
+    {
+        if (!ensure_planes())
+            return;
+    }
+    catch (...)
+    {
+        /* As for RealKMSOutput: without a CRTC the output can't be displaying anything */
+        return;
+    }
+
+    auto const crtc_id = current_crtc->crtc_id;
+
+    AtomicRequest request;
+    request.add(connector->connector_id, *connector_properties, "CRTC_ID", 0);
+    request.add(crtc_id, *crtc_properties, "MODE_ID", 0);
+    request.add(crtc_id, *crtc_properties, "ACTIVE", 0);
+    request.add(primary_plane->id, primary_plane->properties, "FB_ID", 0);
+    request.add(primary_plane->id, primary_plane->properties, "CRTC_ID", 0);
+    add_overlays(request, {});
+
+    if (auto const result = drmModeAtomicCommit(drm_fd_, request, DRM_MODE_ATOMIC_ALLOW_MODESET, nullptr))
+    {
+        if (result == -EACCES || result == -EPERM)
+        {
+            /* We don't have modesetting rights; see RealKMSOutput::clear_crtc() */
+            mir::log_info("Couldn't clear output %s (drmModeAtomicCommit: %s (%i))",
+                mgk::connector_name(connector).c_str(),
+                strerror(-result),
+                -result);
+        }
+        else
+        {
+            fatal_error("Couldn't clear output %s (drmModeAtomicCommit = %d)",
+                        mgk::connector_name(connector).c_str(), result);
+        }
+    }
+    else
+    {
+        overlays_shown = false;
+    }
+
+    current_crtc = nullptr;
+}
+
+bool mgg::AtomicKMSOutput::schedule_page_flip(FBHandle const& fb)
+{
+    std::unique_lock lg(power_mutex);
+    if (power_mode != mir_power_mode_on)
+        return true;
+    if (!current_crtc || !ensure_planes())
+    {
+        mir::log_error("Output %s has no associated CRTC to schedule page flips on",
+                       mgk::connector_name(connector).c_str());
+        return false;
+    }
+
+    /*
+     * An async flip may only change the primary plane's framebuffer. A legacy flip changes
+     * nothing else, so use one when that's all that needs to change.
+     */
+    bool const only_fb_changes =
+        !overlays_shown && pending_overlays.empty() && !gamma_pending && variable_refresh_applied == variable_refresh;
+    if (tearing && async_page_flips_supported && only_fb_changes &&
+        page_flipper->schedule_async_flip(current_crtc->crtc_id, fb, connector->connector_id))
+    {
+        return true;
+    }
+
+    AtomicRequest request;
+    add_scanout(request, fb);
+
+    if (!page_flipper->schedule_atomic_flip(current_crtc->crtc_id, request, connector->connector_id))
+        return false;
+
+    scanout_committed();
+    return true;
+}
+
+auto mgg::AtomicKMSOutput::overlay_plane_count() const -> size_t
+{
+    return overlay_planes.size();
+}
+
+bool mgg::AtomicKMSOutput::can_show_overlays(std::vector<KMSOverlay> const& overlays)
+{
+    if (overlays.size() > overlay_planes.size() || !assign_overlay_planes(overlays.size()))
+        return false;
+
+    std::lock_guard lg(power_mutex);
+    if (!current_crtc || power_mode != mir_power_mode_on)
+        return overlays.empty();
+
+    /* Check the overlays against the current state of the rest of the CRTC;
+     * the primary plane's framebuffer changes with each flip, but not its layout.
+     */
+    AtomicRequest request;
+    add_overlays(request, overlays);
+    return drmModeAtomicCommit(drm_fd_, request, DRM_MODE_ATOMIC_TEST_ONLY, nullptr) == 0;
+}
+
+void mgg::AtomicKMSOutput::set_overlays(std::vector<KMSOverlay> const& overlays)
+{
+    if (overlays.size() > overlay_planes.size())
+    {
+        BOOST_THROW_EXCEPTION(std::logic_error("More overlays than the output has overlay planes"));
+    }
+    pending_overlays = overlays;
+}
+
+void mgg::AtomicKMSOutput::set_power_mode(MirPowerMode mode)
+{
+    std::lock_guard lg(power_mutex);
+
+    if (power_mode == mode)
+        return;
+
+    power_mode = mode;
+
+    /* If we're not driving the CRTC the next set_crtc() picks up the new mode */
+    if (!current_crtc || using_saved_crtc || !ensure_planes())
+        return;
+
+    AtomicRequest request;
+    request.add(current_crtc->crtc_id, *crtc_properties, "ACTIVE", mode == mir_power_mode_on);
+    if (auto const ret = drmModeAtomicCommit(drm_fd_, request, DRM_MODE_ATOMIC_ALLOW_MODESET, nullptr))
+    {
+        mir::log_warning("Failed to set power mode of output %s: %s (%i)",
+                         mgk::connector_name(connector).c_str(), strerror(-ret), -ret);
+    }
+}
+
+void mgg::AtomicKMSOutput::set_gamma(mg::GammaCurves const& gamma)
+{
+    {
+        std::lock_guard lg(power_mutex);
+
+        if (!ensure_planes())
+        {
+            mir::log_warning("Output %s has no associated CRTC to set gamma on",
+                             mgk::connector_name(connector).c_str());
+            return;
+        }
+
+        if (gamma.red.size() != gamma.green.size() ||
+            gamma.green.size() != gamma.blue.size())
+        {
+            BOOST_THROW_EXCEPTION(
+                std::invalid_argument("set_gamma: mismatch gamma LUT sizes"));
+        }
+
+        if (crtc_properties->has_property("GAMMA_LUT") &&
+            (gamma.red.empty() || (*crtc_properties)["GAMMA_LUT_SIZE"] == gamma.red.size()))
+        {
+            /* Committing now could collide with a flip in progress; apply the
+             * ramp with the next frame (or mode set) instead.
+             */
+            if (gamma.red.empty())
+            {
+                pending_gamma.reset();
+            }
+            else
+            {
+                std::vector<drm_color_lut> lut(gamma.red.size());
+                for (size_t i = 0; i < lut.size(); ++i)
+                {
+                    lut[i].red = gamma.red[i];
+                    lut[i].green = gamma.green[i];
+                    lut[i].blue = gamma.blue[i];
+                }
+                pending_gamma = std::make_unique<PropertyBlob>(drm_fd_, lut.data(), lut.size() * sizeof(lut[0]));
+            }
+            gamma_pending = true;
+            return;
+        }
+    }
+
+    /* The driver doesn't support an atomic gamma ramp of this size */
+    RealKMSOutput::set_gamma(gamma);
+}
+
+bool mgg::AtomicKMSOutput::ensure_planes()
+{
+    if (!ensure_crtc())
+        return false;
+
+    if (planes_crtc_id == current_crtc->crtc_id)
+        return true;
+
+    auto const crtc_id = current_crtc->crtc_id;
+
+    kms::DRMModeResources resources{drm_fd_};
+    int crtc_index{0};
+    for (auto& crtc : resources.crtcs())
+    {
+        if (crtc->crtc_id == crtc_id)
+            break;
+        ++crtc_index;
+    }
+
+    crtc_properties.emplace(drm_fd_, crtc_id, DRM_MODE_OBJECT_CRTC);
+    connector_properties.emplace(drm_fd_, connector->connector_id, DRM_MODE_OBJECT_CONNECTOR);
+    primary_plane.reset();
+    overlay_planes.clear();
+
+    auto const zpos_of =
+        [this](kms::ObjectProperties const& properties) -> std::optional<ZPos>
+        {
+            if (!properties.has_property("zpos"))
+                return std::nullopt;
+
+            std::unique_ptr<drmModePropertyRes, decltype(&drmModeFreeProperty)> const property{
+                drmModeGetProperty(drm_fd_, properties.id_for("zpos")),
+                &drmModeFreeProperty};
+            if (!property)
+                return std::nullopt;
+
+            auto const value = properties["zpos"];
+            ZPos zpos{value, value, value, (property->flags & DRM_MODE_PROP_IMMUTABLE) != 0};
+            if (!zpos.immutable && (property->flags & DRM_MODE_PROP_RANGE) && property->count_values == 2)
+            {
+                zpos.min = property->values[0];
+                zpos.max = property->values[1];
+            }
+            return zpos;
+        };
+
+    kms::PlaneResources plane_resources{drm_fd_};
+    for (auto& plane : plane_resources.planes())
+    {
+        if (!(plane->possible_crtcs & (1u << crtc_index)))
+            continue;
+
+        kms::ObjectProperties properties{drm_fd_, plane->plane_id, DRM_MODE_OBJECT_PLANE};
+        auto const zpos = zpos_of(properties);
+        switch (properties["type"])
+        {
+        case DRM_PLANE_TYPE_PRIMARY:
+            if (!primary_plane)
+                primary_plane.emplace(plane->plane_id, std::move(properties), zpos);
+            break;
+
+        case DRM_PLANE_TYPE_OVERLAY:
+            /* Overlay planes can often be used with several CRTCs. Give each to the
+             * first CRTC it can be used with, so outputs never contend for a plane.
+             */
+            if (lowest_set_bit(plane->possible_crtcs) == crtc_index)
+                overlay_planes.emplace_back(plane->plane_id, std::move(properties), zpos);
+            break;
+
+        default:
+            break;
+        }
+    }
+
+    if (!primary_plane)
+    {
+        mir::log_error("Output %s has no primary plane for CRTC %u",
+                       mgk::connector_name(connector).c_str(), crtc_id);
+        overlay_planes.clear();
+        return false;
+    }
+
+    planes_crtc_id = crtc_id;
+    return true;
+}
+
+void mgg::AtomicKMSOutput::add_plane(
+    AtomicRequest& request,
+    Plane const& plane,
+    uint32_t fb,
+    geom::RectangleF const& source,
+    geom::Rectangle const& destination) const
+{
+    request.add(plane.id, plane.properties, "FB_ID", fb);
+    request.add(plane.id, plane.properties, "CRTC_ID", current_crtc->crtc_id);
+    request.add(plane.id, plane.properties, "SRC_X", to_fixed(source.top_left.x.as_value()));
+    request.add(plane.id, plane.properties, "SRC_Y", to_fixed(source.top_left.y.as_value()));
+    request.add(plane.id, plane.properties, "SRC_W", to_fixed(source.size.width.as_value()));
+    request.add(plane.id, plane.properties, "SRC_H", to_fixed(source.size.height.as_value()));
+    request.add(plane.id, plane.properties, "CRTC_X", to_signed_property(destination.top_left.x.as_int()));
+    request.add(plane.id, plane.properties, "CRTC_Y", to_signed_property(destination.top_left.y.as_int()));
+    request.add(plane.id, plane.properties, "CRTC_W", destination.size.width.as_uint32_t());
+    request.add(plane.id, plane.properties, "CRTC_H", destination.size.height.as_uint32_t());
+}
+
+auto mgg::AtomicKMSOutput::assign_overlay_planes(size_t overlay_count) const
+    -> std::optional<std::vector<PlaneAssignment>>
+{
+    std::vector<PlaneAssignment> assignments;
+
+    /* Overlays go bottom to top, each above the primary plane and the overlay before it.
+     * A plane with a fixed zpos can only be used where that falls in the stacking order.
+     */
+    std::optional<uint64_t> below;
+    if (primary_plane && primary_plane->zpos)
+        below = primary_plane->zpos->value;
+
+    // Try the planes the driver stacks lowest first, so there's room above them for the rest
+    std::vector<Plane const*> candidates;
+    for (auto const& plane : overlay_planes)
+        candidates.push_back(&plane);
+    std::ranges::stable_sort(
+        candidates,
+        std::less{},
+        [](Plane const* plane) { return plane->zpos ? plane->zpos->min : 0; });
+
+    for (auto const plane : candidates)
+    {
+        if (assignments.size() == overlay_count)
+            break;
+
+        if (!plane->zpos)
+        {
+            // The driver stacks it as it sees fit
+            assignments.push_back({plane, std::nullopt});
+        }
+        else if (plane->zpos->immutable)
+        {
+            if (below && plane->zpos->value <= *below)
+                continue;
+            assignments.push_back({plane, std::nullopt});
+            below = plane->zpos->value;
+        }
+        else
+        {
+            auto const zpos = std::max(below ? *below + 1 : plane->zpos->min, plane->zpos->min);
+            if (zpos > plane->zpos->max)
+                continue;
+            assignments.push_back({plane, zpos});
+            below = zpos;
+        }
+    }
+
+    if (assignments.size() < overlay_count)
+        return std::nullopt;
+    return assignments;
+}
+
+void mgg::AtomicKMSOutput::add_overlays(AtomicRequest& request, std::vector<KMSOverlay> const& overlays) const
+{
+    // If the overlays can't be stacked (can_show_overlays() would have refused them) show none
+    auto const assignments = assign_overlay_planes(overlays.size()).value_or(std::vector<PlaneAssignment>{});
+
+    for (auto const& plane : overlay_planes)
+    {
+        auto const assigned = std::ranges::find(assignments, &plane, &PlaneAssignment::plane);
+        if (assigned != assignments.end())
+        {
+            auto const& overlay = overlays[assigned - assignments.begin()];
+            add_plane(request, plane, *overlay.fb, overlay.source, overlay.destination);
+            if (assigned->zpos)
+            {
+                request.add(plane.id, plane.properties, "zpos", *assigned->zpos);
+            }
+        }
+        else
+        {
+            request.add(plane.id, plane.properties, "FB_ID", 0);
+            request.add(plane.id, plane.properties, "CRTC_ID", 0);
+        }
+    }
+}
+
+void mgg::AtomicKMSOutput::add_scanout(AtomicRequest& request, FBHandle const& fb) const
+{
+    auto const& mode = connector->modes[mode_index];
+    geom::Size const mode_size{mode.hdisplay, mode.vdisplay};
+
+    add_plane(
+        request,
+        *primary_plane,
+        fb,
+        geom::RectangleF{{fb_offset.dx.as_int(), fb_offset.dy.as_int()}, {mode.hdisplay, mode.vdisplay}},
+        {{0, 0}, mode_size});
+    add_overlays(request, pending_overlays);
+
+    if (gamma_pending)
+    {
+        request.add(current_crtc->crtc_id, *crtc_properties, "GAMMA_LUT", pending_gamma ? pending_gamma->id() : 0);
+    }
+
+    /* Toggling VRR doesn't need a modeset, so it can follow the flips */
+    if (crtc_properties->has_property("VRR_ENABLED"))
+    {
+        request.add(current_crtc->crtc_id, *crtc_properties, "VRR_ENABLED", variable_refresh);
+    }
+}
+
+void mgg::AtomicKMSOutput::scanout_committed()
+{
+    overlays_shown = !pending_overlays.empty();
+    gamma_pending = false;
+    pending_gamma.reset();
+    variable_refresh_applied = variable_refresh;
+}
@@ -0,0 +1,117 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_GRAPHICS_GBM_ATOMIC_KMS_OUTPUT_H_
+#define MIR_GRAPHICS_GBM_ATOMIC_KMS_OUTPUT_H_
+
+#include "real_kms_output.h"
+
+#include <optional>
+#include <vector>
+
+namespace mir
+{
+namespace graphics
+{
+namespace gbm
+{
+
+/**
+ * A KMSOutput driven through atomic modesetting
+ *
+ * The mode, CRTC, primary and overlay planes, gamma ramp and VRR state are applied together in a
+ * single drmModeAtomicCommit(), and new configurations are validated with a TEST_ONLY
+ * commit before they are applied.
+ *
+ * Requires the DRM_CLIENT_CAP_ATOMIC client capability to have been set on drm_fd.
+ */
+class AtomicKMSOutput : public RealKMSOutput
+{
+public:
+    AtomicKMSOutput(
+        int drm_fd,
+        kms::DRMModeConnectorUPtr&& connector,
+        std::shared_ptr<PageFlipper> const& page_flipper);
+    ~AtomicKMSOutput();
+
+    bool set_crtc(FBHandle const& fb) override;
+    void clear_crtc() override;
+    bool schedule_page_flip(FBHandle const& fb) override;
+
+    auto overlay_plane_count() const -> size_t override;
+    bool can_show_overlays(std::vector<KMSOverlay> const& overlays) override;
+    void set_overlays(std::vector<KMSOverlay> const& overlays) override;
+
+    void set_power_mode(MirPowerMode mode) override;
+    void set_gamma(GammaCurves const& gamma) override;
+
+private:
+    class AtomicRequest;
+    class PropertyBlob;
+
+    /// A plane's "zpos": where the driver stacks it relative to the CRTC's other planes
+    struct ZPos
+    {
+        uint64_t value;
+        uint64_t min;
+        uint64_t max;
+        bool immutable;
+    };
+
+    struct Plane
+    {
+        uint32_t id;
+        kms::ObjectProperties properties;
+        std::optional<ZPos> zpos;
+    };
+
+    /// An overlay plane to show a KMSOverlay on, and the zpos to set to stack it correctly (if any)
+    struct PlaneAssignment
+    {
+        Plane const* plane;
+        std::optional<uint64_t> zpos;
+    };
+
+    bool ensure_planes();
+    void add_plane(
+        AtomicRequest& request,
+        Plane const& plane,
+        uint32_t fb,
+        geometry::RectangleF const& source,
+        geometry::Rectangle const& destination) const;
+    auto assign_overlay_planes(size_t overlay_count) const -> std::optional<std::vector<PlaneAssignment>>;
+    void add_overlays(AtomicRequest& request, std::vector<KMSOverlay> const& overlays) const;
+    void add_scanout(AtomicRequest& request, FBHandle const& fb) const;
+    void scanout_committed();
+
+    uint32_t planes_crtc_id{0};
+    std::optional<kms::ObjectProperties> crtc_properties;
+    std::optional<kms::ObjectProperties> connector_properties;
+    std::optional<Plane> primary_plane;
+    std::vector<Plane> overlay_planes;
+
+    std::vector<KMSOverlay> pending_overlays;
+    bool overlays_shown{false};
+
+    bool gamma_pending{false};
+    std::unique_ptr<PropertyBlob> pending_gamma;
+};
+
+}
+}
+}
+
+#endif /* MIR_GRAPHICS_GBM_ATOMIC_KMS_OUTPUT_H_ */
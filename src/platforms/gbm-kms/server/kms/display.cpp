@@ -52,13 +52,17 @@
 #include <drm.h>
 #include <sys/ioctl.h>
 #include <sys/mman.h>
+#include <sys/stat.h>
 
 #include <stdexcept>
 #include <algorithm>
 #include <unordered_map>
+#include <map>
+#include <set>
 
 namespace mgg = mir::graphics::gbm;
 namespace mg = mir::graphics;
+namespace mgk = mir::graphics::kms;
 namespace geom = mir::geometry;
 
 namespace
@@ -388,6 +392,8 @@ void mgg::Display::configure_locked(
             std::vector<std::shared_ptr<KMSOutput>> kms_outputs;
             glm::mat2 transformation;
             geom::Size current_mode_resolution;
+            size_t group_size{0};
+            bool vrr_enabled{true};
 
             group.for_each_output(
                 [&](DisplayConfigurationOutput const& conf_output)
@@ -411,12 +417,19 @@ void mgg::Display::configure_locked(
                     transformation = conf_output.transformation();
                     if (conf_output.current_mode_index < conf_output.modes.size())
                         current_mode_resolution = conf_output.modes[conf_output.current_mode_index].size;
+
+                    ++group_size;
+                    vrr_enabled = vrr_enabled && conf_output.vrr_enabled && conf_output.vrr_capable;
                 });
 
+            /* Clones flip together, so one output can't follow the client's frame rate */
+            bool const allow_vrr = vrr_enabled && group_size == 1;
+
             if (comp)
             {
-                display_sinks[group_idx++]->set_transformation(transformation,
-                                                                 bounding_rect);
+                display_sinks[group_idx]->set_transformation(transformation,
+                                                             bounding_rect);
+                display_sinks[group_idx++]->allow_variable_refresh(allow_vrr);
             }
             else
             {
@@ -428,6 +441,7 @@ void mgg::Display::configure_locked(
                     kms_outputs,
                     bounding_rect,
                     transformation);
+                db->allow_variable_refresh(allow_vrr);
 
                 display_buffers_new.push_back(std::move(db));
             }
@@ -471,11 +485,110 @@ auto gbm_create_device_checked(mir::Fd fd) -> std::shared_ptr<struct gbm_device>
 }
 }
 
+namespace
+{
+auto formats_of_planes(mir::Fd const& drm_fd) -> std::map<uint32_t, std::vector<uint64_t>>
+{
+    std::map<uint32_t, std::set<uint64_t>> formats;
+
+    try
+    {
+        // The platform enabled DRM_CLIENT_CAP_UNIVERSAL_PLANES, so this includes the primary planes
+        mgk::PlaneResources const resources{drm_fd};
+        for (auto const& plane : resources.planes())
+        {
+            mgk::ObjectProperties const properties{drm_fd, plane};
+            auto const type = properties["type"];
+            if (type != DRM_PLANE_TYPE_PRIMARY && type != DRM_PLANE_TYPE_OVERLAY)
+                continue;
+
+            std::unique_ptr<drmModePropertyBlobRes, decltype(&drmModeFreePropertyBlob)> blob{
+                properties.has_property("IN_FORMATS") ?
+                    drmModeGetPropertyBlob(drm_fd, properties["IN_FORMATS"]) :
+                    nullptr,
+                &drmModeFreePropertyBlob};
+
+            if (!blob)
+            {
+                // The plane doesn't tell us its modifiers, so takes buffers with an implicit one
+                for (auto i = 0u; i < plane->count_formats; ++i)
+                {
+                    formats[plane->formats[i]].insert(DRM_FORMAT_MOD_INVALID);
+                }
+                continue;
+            }
+
+            /* The blob lists the formats, then modifiers with a bitmask of which
+             * of (up to 64 of) those formats, starting at offset, they apply to.
+             */
+            auto const data = static_cast<char const*>(blob->data);
+            auto const header = reinterpret_cast<drm_format_modifier_blob const*>(data);
+            auto const fourccs = reinterpret_cast<uint32_t const*>(data + header->formats_offset);
+            auto const modifiers = reinterpret_cast<drm_format_modifier const*>(data + header->modifiers_offset);
+            for (auto i = 0u; i < header->count_modifiers; ++i)
+            {
+                for (auto bit = 0u; bit < 64; ++bit)
+                {
+                    auto const index = modifiers[i].offset + bit;
+                    if ((modifiers[i].formats & (1ull << bit)) && index < header->count_formats)
+                    {
+                        formats[fourccs[index]].insert(modifiers[i].modifier);
+                    }
+                }
+            }
+        }
+    }
+    catch (std::exception const& error)
+    {
+        mir::log_info("Cannot list the planes' scanout formats: %s", error.what());
+        return {};
+    }
+
+    std::map<uint32_t, std::vector<uint64_t>> result;
+    for (auto const& [format, modifiers] : formats)
+    {
+        result.emplace(format, std::vector<uint64_t>{modifiers.begin(), modifiers.end()});
+    }
+    return result;
+}
+}
+
 mgg::GBMDisplayProvider::GBMDisplayProvider(
     mir::Fd drm_fd)
     : fd{std::move(drm_fd)},
-      gbm{gbm_create_device_checked(fd)}
+      gbm{gbm_create_device_checked(fd)},
+      plane_formats{formats_of_planes(fd)}
+{
+}
+
+auto mgg::GBMDisplayProvider::scanout_formats() const -> std::vector<DRMFormat>
 {
+    std::vector<DRMFormat> formats;
+    for (auto const& [format, _] : plane_formats)
+    {
+        formats.emplace_back(format);
+    }
+    return formats;
+}
+
+auto mgg::GBMDisplayProvider::scanout_modifiers_for_format(DRMFormat format) const -> std::vector<uint64_t>
+{
+    if (auto const modifiers = plane_formats.find(format); modifiers != plane_formats.end())
+    {
+        return modifiers->second;
+    }
+    return {};
+}
+
+auto mgg::GBMDisplayProvider::scanout_device() const -> dev_t
+{
+    struct stat info;
+    if (fstat(fd, &info))
+    {
+        BOOST_THROW_EXCEPTION((
+            std::system_error{errno, std::system_category(), "Failed to query DRM device number"}));
+    }
+    return info.st_rdev;
 }
 
 auto mgg::GBMDisplayProvider::on_this_sink(mg::DisplaySink& sink) const -> bool
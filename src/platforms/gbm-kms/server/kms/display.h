@@ -27,6 +27,7 @@
 #include "mir/graphics/platform.h"
 
 #include <atomic>
+#include <map>
 #include <mutex>
 #include <vector>
 
@@ -114,9 +115,15 @@ public:
 
     auto gbm_device() const -> std::shared_ptr<struct gbm_device> override;
 
+    auto scanout_formats() const -> std::vector<DRMFormat> override;
+    auto scanout_modifiers_for_format(DRMFormat format) const -> std::vector<uint64_t> override;
+    auto scanout_device() const -> dev_t override;
+
 private:
     mir::Fd const fd;
     std::shared_ptr<struct gbm_device> const gbm;
+    /// The modifiers each format can be scanned out with, on any of the device's planes
+    std::map<uint32_t, std::vector<uint64_t>> const plane_formats;
 };
 
 }
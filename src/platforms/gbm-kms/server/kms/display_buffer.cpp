@@ -43,6 +43,7 @@
 #include <stdexcept>
 #include <chrono>
 #include <algorithm>
+#include <span>
 
 namespace mg = mir::graphics;
 namespace mgg = mir::graphics::gbm;
@@ -61,11 +62,15 @@ mgg::DisplaySink::DisplaySink(
       outputs(outputs),
       area(area),
       transform{transformation},
-      needs_set_crtc{false},
-      page_flips_pending{false}
+      needs_set_crtc{false}
 {
     listener->report_successful_setup_of_native_resources();
 
+    for (auto const& output : outputs)
+    {
+        scanouts.push_back(Scanout{output});
+    }
+
     // If any of the outputs have a CRTC mismatch, we will want to set all of them
     // so that they're all showing the same buffer.
     bool has_crtc_mismatch = false;
@@ -89,16 +94,21 @@ mgg::DisplaySink::DisplaySink(
         auto mapping = initial_fb->map_writeable();
         ::memset(mapping->data(), 24, mapping->len());
 
-        visible_fb = std::move(initial_fb);
-        for (auto &output: outputs) {
-            output->set_crtc(*visible_fb);
+        for (auto& scanout : scanouts) {
+            scanout.output->set_crtc(*initial_fb);
+            scanout.visible_fb = initial_fb;
         }
         listener->report_successful_drm_mode_set_crtc_on_construction();
     }
     listener->report_successful_display_construction();
 }
 
-mgg::DisplaySink::~DisplaySink() = default;
+mgg::DisplaySink::~DisplaySink()
+{
+    // Any clone still catching up is done within a refresh
+    if (catch_up_thread.joinable())
+        catch_up_thread.join();
+}
 
 geom::Rectangle mgg::DisplaySink::view_area() const
 {
@@ -118,30 +128,117 @@ void mgg::DisplaySink::set_transformation(glm::mat2 const& t, geometry::Rectangl
 
 bool mgg::DisplaySink::overlay(std::vector<DisplayElement> const& renderable_list)
 {
-    // TODO: implement more than the most basic case.
-    if (renderable_list.size() != 1)
+    // The bottom element fills the primary plane, any others go on overlay planes above it
+    if (renderable_list.empty())
     {
         return false;
     }
 
-    if (renderable_list[0].screen_positon != view_area())
+    auto fb = primary_plane_fb(renderable_list.front());
+    if (!fb)
     {
         return false;
     }
 
-    if (renderable_list[0].source_position.top_left != geom::PointF {0,0} ||
-        renderable_list[0].source_position.size.width.as_value() != view_area().size.width.as_int() ||
-        renderable_list[0].source_position.size.height.as_value() != view_area().size.height.as_int())
+    auto overlays = overlays_for({renderable_list.begin() + 1, renderable_list.end()});
+    if (!overlays)
     {
         return false;
     }
 
-    if (auto fb = std::dynamic_pointer_cast<graphics::FBHandle>(renderable_list[0].buffer))
+    next_swap = std::move(fb);
+    next_swap_is_client_buffer = true;
+    next_overlays = std::move(*overlays);
+    // Only a lone fullscreen client can flip without waiting for vblank; overlays stay in sync
+    next_swap_tears = next_overlays.empty() && renderable_list.front().tearing_allowed;
+    return true;
+}
+
+auto mgg::DisplaySink::overlay_above_next_image(std::vector<DisplayElement> const& elements) -> size_t
+{
+    next_overlays.clear();
+
+    size_t planes{elements.size()};
+    for (auto const& output : outputs)
+    {
+        planes = std::min(planes, output->overlay_plane_count());
+    }
+
+    // Every element shown on a plane is one fewer to composite, so try for as many as possible
+    for (auto count = planes; count > 0; --count)
+    {
+        if (auto overlays = overlays_for({elements.end() - count, elements.end()}))
+        {
+            next_overlays = std::move(*overlays);
+            return count;
+        }
+    }
+    return 0;
+}
+
+auto mgg::DisplaySink::primary_plane_fb(DisplayElement const& element) const -> std::shared_ptr<FBHandle const>
+{
+    if (element.screen_positon != view_area())
+    {
+        return nullptr;
+    }
+
+    if (element.source_position.top_left != geom::PointF {0,0} ||
+        element.source_position.size.width.as_value() != view_area().size.width.as_int() ||
+        element.source_position.size.height.as_value() != view_area().size.height.as_int())
+    {
+        return nullptr;
+    }
+
+    return std::dynamic_pointer_cast<graphics::FBHandle>(element.buffer);
+}
+
+auto mgg::DisplaySink::overlays_for(std::span<DisplayElement const> elements) const
+    -> std::optional<std::vector<KMSOverlay>>
+{
+    std::vector<KMSOverlay> overlays;
+    if (elements.empty())
+    {
+        return overlays;
+    }
+
+    // Planes show buffers upright, so can't follow a rotated or reflected output
+    if (transform != glm::mat2{1})
     {
-        next_swap = std::move(fb);
-        return true;
+        return std::nullopt;
     }
-    return false;
+
+    for (auto const& element : elements)
+    {
+        auto fb = std::dynamic_pointer_cast<graphics::FBHandle>(element.buffer);
+        if (!fb || !view_area().contains(element.screen_positon))
+        {
+            return std::nullopt;
+        }
+
+        // Plane scaling support varies between drivers, so only show buffers as they are
+        geom::RectangleF const buffer_area{{0, 0}, {fb->size().width.as_int(), fb->size().height.as_int()}};
+        if (element.source_position.size.width.as_value() != element.screen_positon.size.width.as_int() ||
+            element.source_position.size.height.as_value() != element.screen_positon.size.height.as_int() ||
+            !buffer_area.contains(element.source_position))
+        {
+            return std::nullopt;
+        }
+
+        overlays.push_back(KMSOverlay{
+            std::move(fb),
+            {as_point(element.screen_positon.top_left - view_area().top_left), element.screen_positon.size},
+            element.source_position});
+    }
+
+    for (auto const& output : outputs)
+    {
+        if (output->overlay_plane_count() < overlays.size() || !output->can_show_overlays(overlays))
+        {
+            return std::nullopt;
+        }
+    }
+    return overlays;
 }
 
 void mgg::DisplaySink::for_each_display_sink(std::function<void(graphics::DisplaySink&)> const& f)
@@ -169,13 +266,23 @@ void mgg::DisplaySink::set_crtc(FBHandle const& forced_frame)
 
 void mgg::DisplaySink::post()
 {
+    std::unique_lock lock{scanout_mutex};
+
+    budget = std::nullopt;
+
     /*
-     * We might not have waited for the previous frame to page flip yet.
-     * This is good because it maximizes the time available to spend rendering
-     * each frame. Just remember wait_for_page_flip() must be called at some
-     * point before the next schedule_page_flip().
+     * In clone mode the outputs other than the pacing one flip on their own
+     * vblanks, so we might not have waited for them to flip yet. Those that
+     * have are ready for this frame; the others will show a later one.
      */
-    wait_for_page_flip();
+    for (auto& scanout : scanouts)
+    {
+        if (!scanout.catching_up && scanout.flip_pending && scanout.output->page_flip_completed())
+            wait_for_page_flip(scanout);
+    }
+
+    // We only know how this frame is presented if we wait for it below
+    presentation = std::nullopt;
 
     if (!next_swap)
     {
@@ -186,15 +293,40 @@ void mgg::DisplaySink::post()
     /*
      * Otherwise, pull the next frame into the pending slot
      */
-    scheduled_fb = std::move(next_swap);
+    auto const fb = std::move(next_swap);
     next_swap = nullptr;
+    auto const overlays = std::move(next_overlays);
+    next_overlays.clear();
+    scheduled_is_client_buffer = next_swap_is_client_buffer;
+    scheduled_tears = next_swap_tears;
+
+    /*
+     * A fullscreen client drives the refresh rate when it's scanned out directly;
+     * composited frames stay at the mode's fixed rate.
+     */
+    bool const variable_refresh = variable_refresh_allowed && scheduled_is_client_buffer;
+
+    // Outputs still catching up flip to this frame once they're ready
+    latest_fb = fb;
+    latest_overlays = overlays;
+    latest_variable_refresh = variable_refresh;
 
     /*
      * Try to schedule a page flip as first preference to avoid tearing.
      * [will complete in a background thread]
      */
-    if (!needs_set_crtc && !schedule_page_flip(*scheduled_fb))
-        needs_set_crtc = true;
+    if (!needs_set_crtc)
+    {
+        bool scheduled{false};
+        for (auto& scanout : scanouts)
+        {
+            // Outputs still flipping to an earlier frame get this one once they're done (below)
+            if (!scanout.flip_pending && schedule_page_flip(scanout, fb, overlays, variable_refresh))
+                scheduled = true;
+        }
+        if (!scheduled)
+            needs_set_crtc = true;
+    }
 
     /*
      * Fallback blitting: Not pretty, since it may tear. VirtualBox seems
@@ -202,98 +334,215 @@ void mgg::DisplaySink::post()
      */
     if (needs_set_crtc)
     {
-        set_crtc(*scheduled_fb);
+        // Outputs still flipping to an earlier frame would otherwise flip over this one
+        catch_up_done.wait(lock, [this] { return !catch_up_running; });
+        for (auto& scanout : scanouts)
+        {
+            wait_for_page_flip(scanout);
+        }
+
+        for (auto& scanout : scanouts)
+        {
+            scanout.output->set_overlays(overlays);
+        }
+        set_crtc(*fb);
         // SetCrtc is immediate, so the FB is now visible and we have nothing pending
-        visible_fb = std::move(scheduled_fb);
-        scheduled_fb = nullptr;
+        for (auto& scanout : scanouts)
+        {
+            scanout.visible_fb = fb;
+            scanout.visible_overlays = overlays;
+        }
+
+        // ...but not in step with the display, nor with a timestamp from it
+        presentation = FramePresentation{
+            Frame{0, time::PosixTimestamp::now(CLOCK_MONOTONIC)},
+            false,
+            false,
+            false,
+            scheduled_is_client_buffer};
 
         needs_set_crtc = false;
     }
 
-    using namespace std::chrono_literals;  // For operator""ms()
-
-    // Predicted worst case render time for the next frame...
-    auto predicted_render_time = 50ms;
+    /*
+     * Wait for the pacing output to flip, making us double-buffered (noticeably
+     * less laggy than triple buffering). Waiting for every output would have
+     * the compositor run at the pace of the slowest.
+     */
+    auto& pacing = pacing_scanout();
+    bool const paced_to_refresh = pacing.flip_pending;
+    // The pacing output is always waited on here, never caught up, so others can be meanwhile
+    lock.unlock();
+    auto const flipped = wait_for_page_flip(pacing);
+    lock.lock();
+    if (flipped)
+    {
+        // The kernel timestamps the flip completion event, from the vblank unless the flip tore
+        presentation = FramePresentation{*flipped, !scheduled_tears, true, true, scheduled_is_client_buffer};
+    }
 
-    if (holding_client_buffers)
+    /*
+     * Any output that was still flipping to an earlier frame has had most of
+     * a refresh to finish, so is likely ready for this one now. It flips to it
+     * on its own vblank; we don't wait for that. One that's still not done
+     * skips this frame and is caught up to the latest when it is, rather than
+     * blocking us.
+     */
+    bool left_behind{false};
+    for (auto& scanout : scanouts)
     {
-        /*
-         * For composited frames we defer wait_for_page_flip till just before
-         * the next frame, but not for bypass frames. Deferring the flip of
-         * bypass frames would increase the time we held
-         * visible_bypass_frame unacceptably, resulting in client stuttering
-         * unless we allocate more buffers (which I'm trying to avoid).
-         * Also, bypass does not need the deferred page flip because it has
-         * no compositing/rendering step for which to save time for.
-         */
-        wait_for_page_flip();
+        if (scanout.catching_up || scanout.scheduled_fb == fb || scanout.visible_fb == fb)
+            continue;
 
-        // It's very likely the next frame will be bypassed like this one so
-        // we only need time for kernel page flip scheduling...
-        predicted_render_time = 5ms;
+        if (!scanout.flip_pending || scanout.output->page_flip_completed())
+        {
+            wait_for_page_flip(scanout);
+            if (!schedule_page_flip(scanout, fb, overlays, variable_refresh))
+                needs_set_crtc = true;
+        }
+        else
+        {
+            scanout.catching_up = true;
+            left_behind = true;
+        }
     }
-    else
-    {
-        /*
-         * Not in clone mode? We can afford to wait for the page flip then,
-         * making us double-buffered (noticeably less laggy than the triple
-         * buffering that clone mode requires).
-         */
-        if (outputs.size() == 1)
-            wait_for_page_flip();
 
-        /*
-         * TODO: If you're optimistic about your GPU performance and/or
-         *       measure it carefully you may wish to set predicted_render_time
-         *       to a lower value here for lower latency.
-         *
-         *predicted_render_time = 9ms; // e.g. about the same as Weston
-         */
+    if (left_behind && !catch_up_running)
+    {
+        // A previous catch_up() has finished with the scanouts, so this doesn't wait on it
+        if (catch_up_thread.joinable())
+            catch_up_thread.join();
+        catch_up_running = true;
+        catch_up_thread = std::thread{[this] { catch_up(); }};
     }
 
-    recommend_sleep = 0ms;
-    if (outputs.size() == 1)
+    /*
+     * The next frame is due one refresh from now. The compositor measures how
+     * long it takes to render and uses this to start as late as it safely can.
+     *
+     * With variable refresh or tearing there's no fixed deadline: the next frame
+     * should be presented as soon as the client provides it.
+     */
+    if (paced_to_refresh && !variable_refresh && !scheduled_tears)
     {
-        auto const& output = outputs.front();
-        auto const min_frame_interval = 1000ms / output->max_refresh_rate();
-        if (predicted_render_time < min_frame_interval)
-            recommend_sleep = min_frame_interval - predicted_render_time;
+        auto const refresh_rate = pacing.output->max_refresh_rate();
+        if (refresh_rate > 0)
+            budget = std::chrono::nanoseconds{std::chrono::seconds{1}} / refresh_rate;
     }
 }
 
+void mgg::DisplaySink::allow_variable_refresh(bool allowed)
+{
+    variable_refresh_allowed = allowed;
+}
+
 std::chrono::milliseconds mgg::DisplaySink::recommended_sleep() const
 {
-    return recommend_sleep;
+    return std::chrono::milliseconds::zero();
 }
 
-bool mgg::DisplaySink::schedule_page_flip(FBHandle const& bufobj)
+auto mgg::DisplaySink::frame_budget() const -> std::optional<std::chrono::nanoseconds>
+{
+    return budget;
+}
+
+auto mgg::DisplaySink::last_presentation() const -> std::optional<FramePresentation>
+{
+    return presentation;
+}
+
+bool mgg::DisplaySink::schedule_page_flip(
+    Scanout& scanout,
+    std::shared_ptr<FBHandle const> const& fb,
+    std::vector<KMSOverlay> const& overlays,
+    bool variable_refresh)
 {
     /*
      * Schedule the current front buffer object for display. Note that
      * the page flip is asynchronous and synchronized with vertical refresh.
      */
-    for (auto& output : outputs)
+    scanout.output->set_overlays(overlays);
+    scanout.output->set_variable_refresh(variable_refresh);
+    scanout.output->set_tearing(scheduled_tears);
+    if (!scanout.output->schedule_page_flip(*fb))
     {
-        if (output->schedule_page_flip(bufobj))
-            page_flips_pending = true;
+        return false;
     }
 
-    return page_flips_pending;
+    scanout.scheduled_fb = fb;
+    scanout.scheduled_overlays = overlays;
+    scanout.flip_pending = true;
+    return true;
+}
+
+auto mgg::DisplaySink::wait_for_page_flip(Scanout& scanout) -> std::optional<Frame>
+{
+    if (!scanout.flip_pending)
+    {
+        return std::nullopt;
+    }
+
+    auto const frame = scanout.output->wait_for_page_flip();
+
+    // The previously-scheduled FB has been page-flipped, and is now visible
+    scanout.visible_fb = std::move(scanout.scheduled_fb);
+    scanout.scheduled_fb = nullptr;
+    scanout.visible_overlays = std::move(scanout.scheduled_overlays);
+    scanout.scheduled_overlays.clear();
+    scanout.flip_pending = false;
+
+    return frame;
 }
 
 void mgg::DisplaySink::wait_for_page_flip()
 {
-    if (page_flips_pending)
+    std::unique_lock lock{scanout_mutex};
+    catch_up_done.wait(lock, [this] { return !catch_up_running; });
+    for (auto& scanout : scanouts)
+    {
+        wait_for_page_flip(scanout);
+    }
+}
+
+void mgg::DisplaySink::catch_up()
+{
+    std::unique_lock lock{scanout_mutex};
+    for (;;)
     {
-        for (auto& output : outputs)
-            output->wait_for_page_flip();
+        auto const lagging = std::find_if(
+            scanouts.begin(),
+            scanouts.end(),
+            [](Scanout const& scanout) { return scanout.catching_up; });
+        if (lagging == scanouts.end())
+            break;
 
-        // The previously-scheduled FB has been page-flipped, and is now visible
-        visible_fb = std::move(scheduled_fb);
-        scheduled_fb = nullptr;
+        // Nothing else touches a scanout while it's catching up, so post() needn't wait for its flip
+        lock.unlock();
+        wait_for_page_flip(*lagging);
+        lock.lock();
 
-        page_flips_pending = false;
+        if (lagging->visible_fb != latest_fb &&
+            !schedule_page_flip(*lagging, latest_fb, latest_overlays, latest_variable_refresh))
+        {
+            needs_set_crtc = true;
+        }
+        lagging->catching_up = false;
     }
+
+    catch_up_running = false;
+    lock.unlock();
+    catch_up_done.notify_all();
+}
+
+auto mgg::DisplaySink::pacing_scanout() -> Scanout&
+{
+    return *std::max_element(
+        scanouts.begin(),
+        scanouts.end(),
+        [](Scanout const& a, Scanout const& b)
+        {
+            return a.output->max_refresh_rate() < b.output->max_refresh_rate();
+        });
 }
 
 void mgg::DisplaySink::schedule_set_crtc()
@@ -313,20 +562,24 @@ auto mgg::DisplaySink::gbm_device() const -> std::shared_ptr<struct gbm_device>
 
 void mir::graphics::gbm::DisplaySink::set_next_image(std::unique_ptr<Framebuffer> content)
 {
-    std::vector<DisplayElement> const single_buffer = {
-        DisplayElement {
-            view_area(),
-            geom::RectangleF{
-                {0, 0},
-                {view_area().size.width.as_value(), view_area().size.height.as_value()}},
-            std::move(content)
-        }
+    DisplayElement const image{
+        view_area(),
+        geom::RectangleF{
+            {0, 0},
+            {view_area().size.width.as_value(), view_area().size.height.as_value()}},
+        std::move(content)
     };
-    if (!overlay(single_buffer))
+    // Any overlays from overlay_above_next_image() stay above this image
+    auto fb = primary_plane_fb(image);
+    if (!fb)
     {
         // Oh, oh! We should be *guaranteed* to “overlay” a single Framebuffer; this is likely a programming error
         BOOST_THROW_EXCEPTION((std::runtime_error{"Failed to post buffer to display"}));
     }
+    next_swap = std::move(fb);
+    // ...but it's our own composited image, rather than a client's buffer
+    next_swap_is_client_buffer = false;
+    next_swap_tears = false;
 }
 
 auto mgg::DisplaySink::maybe_create_allocator(DisplayAllocator::Tag const& type_tag)
@@ -24,10 +24,16 @@
 #include "mir/graphics/platform.h"
 #include "platform_common.h"
 #include "kms_framebuffer.h"
+#include "kms_output.h"
 
 #include <vector>
 #include <memory>
 #include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <thread>
 
 namespace mir
 {
@@ -41,7 +47,6 @@ namespace gbm
 {
 
 class Platform;
-class KMSOutput;
 
 class DisplaySink : public graphics::DisplaySink,
                       public graphics::DisplaySyncGroup
@@ -62,15 +67,25 @@ public:
     void set_next_image(std::unique_ptr<Framebuffer> content) override;
 
     bool overlay(std::vector<DisplayElement> const& renderlist) override;
+    auto overlay_above_next_image(std::vector<DisplayElement> const& elements) -> size_t override;
 
     void for_each_display_sink(
         std::function<void(graphics::DisplaySink&)> const& f) override;
     void post() override;
     std::chrono::milliseconds recommended_sleep() const override;
+    auto frame_budget() const -> std::optional<std::chrono::nanoseconds> override;
+    auto last_presentation() const -> std::optional<FramePresentation> override;
 
     glm::mat2 transformation() const override;
 
     void set_transformation(glm::mat2 const& t, geometry::Rectangle const& a);
+    /**
+     * Let the outputs vary their refresh rate while a client buffer is scanned out
+     *
+     * The frames are then flipped as soon as they are posted, rather than paced
+     * to a fixed refresh rate.
+     */
+    void allow_variable_refresh(bool allowed);
     void schedule_set_crtc();
     void wait_for_page_flip();
 
@@ -82,12 +97,39 @@ protected:
     auto maybe_create_allocator(DisplayAllocator::Tag const& type_tag) -> DisplayAllocator* override;
 
 private:
-    bool schedule_page_flip(FBHandle const& bufobj);
+    /// What's submitted to, and shown on, one of the outputs. In clone mode each flips on its own vblank.
+    struct Scanout
+    {
+        std::shared_ptr<KMSOutput> output;
+        std::shared_ptr<FBHandle const> scheduled_fb{nullptr}; //< Frame submitted to the output, not yet on-screen
+        std::shared_ptr<FBHandle const> visible_fb{nullptr};   //< Frame currently onscreen
+        // ...and the same for the framebuffers on overlay planes above each frame
+        std::vector<KMSOverlay> scheduled_overlays;
+        std::vector<KMSOverlay> visible_overlays;
+        bool flip_pending{false};
+        bool catching_up{false};    //< Left flipping to an earlier frame; catch_up() owns it until it's flipped to the latest
+    };
+
+    /// Schedule a flip of scanout's output to fb; it must not already have a flip pending
+    bool schedule_page_flip(
+        Scanout& scanout,
+        std::shared_ptr<FBHandle const> const& fb,
+        std::vector<KMSOverlay> const& overlays,
+        bool variable_refresh);
+    /// Wait for the flip on scanout, if any, to complete
+    auto wait_for_page_flip(Scanout& scanout) -> std::optional<Frame>;
     void set_crtc(FBHandle const&);
+    /// The output that paces the frames we post: the one that refreshes fastest
+    auto pacing_scanout() -> Scanout&;
+    /// Flip the scanouts left catching up to the latest frame as each completes its pending flip
+    void catch_up();
+
+    /// The framebuffer to scan out on the primary plane, if element can be
+    auto primary_plane_fb(DisplayElement const& element) const -> std::shared_ptr<FBHandle const>;
+    /// The overlay planes to show elements (bottom to top) with, if every output can
+    auto overlays_for(std::span<DisplayElement const> elements) const -> std::optional<std::vector<KMSOverlay>>;
 
     std::shared_ptr<struct gbm_device> const gbm;
-    bool holding_client_buffers{false};
-    std::shared_ptr<FBHandle const> bypass_bufobj{nullptr};
     std::shared_ptr<DisplayReport> const listener;
 
     std::vector<std::shared_ptr<KMSOutput>> outputs;
@@ -98,15 +140,39 @@ private:
     // Framebuffer handling
     // KMS does not take a reference to submitted framebuffers; if you destroy a framebuffer while
     // it's in use, KMS treat that as submitting a null framebuffer and turn off the display.
+    // So each output's scanout holds the framebuffers it's using.
     std::shared_ptr<FBHandle const> next_swap{nullptr};    //< Next frame to submit to the hardware
-    std::shared_ptr<FBHandle const> scheduled_fb{nullptr}; //< Frame currently submitted to the hardware, not yet on-screen
-    std::shared_ptr<FBHandle const> visible_fb{nullptr};   //< Frame currently onscreen
+    std::vector<KMSOverlay> next_overlays;                 //< ...and the overlays above it
+    std::vector<Scanout> scanouts;
+
+    /*
+     * A clone still flipping to an earlier frame when we post can't take the new one yet.
+     * Rather than have the compositor wait for it, catch_up() flips it to the latest frame
+     * on its own thread, so it isn't left showing a stale frame if nothing more is posted.
+     */
+    std::mutex scanout_mutex;                               //< Guards scanouts, latest_* and catch_up_running
+    std::condition_variable catch_up_done;
+    std::thread catch_up_thread;
+    bool catch_up_running{false};
+    std::shared_ptr<FBHandle const> latest_fb{nullptr};    //< The most recently posted frame...
+    std::vector<KMSOverlay> latest_overlays;               //< ...its overlays...
+    bool latest_variable_refresh{false};                   //< ...and whether it may vary the refresh rate
+
+    // Whether the next and most recently scheduled frames are client buffers we're scanning out directly
+    bool next_swap_is_client_buffer{false};
+    bool scheduled_is_client_buffer{false};
+
+    // Whether the next and most recently scheduled frames may be flipped without waiting for vblank
+    bool next_swap_tears{false};
+    bool scheduled_tears{false};
+
+    bool variable_refresh_allowed{false};
 
     geometry::Rectangle area;
     glm::mat2 transform;
     std::atomic<bool> needs_set_crtc;
-    std::chrono::milliseconds recommend_sleep{0};
-    bool page_flips_pending;
+    std::optional<std::chrono::nanoseconds> budget;
+    std::optional<FramePresentation> presentation;
 };
 
 }
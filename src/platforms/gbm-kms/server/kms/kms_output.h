@@ -20,6 +20,7 @@
 #include "mir/geometry/size.h"
 #include "mir/geometry/point.h"
 #include "mir/geometry/displacement.h"
+#include "mir/geometry/rectangle.h"
 #include "mir/graphics/display_configuration.h"
 #include "mir/graphics/frame.h"
 #include "mir/graphics/dmabuf_buffer.h"
@@ -28,6 +29,10 @@
 
 #include <gbm.h>
 
+#include <memory>
+#include <optional>
+#include <vector>
+
 namespace mir
 {
 namespace graphics
@@ -38,6 +43,16 @@ class FBHandle;
 namespace gbm
 {
 
+/// A framebuffer to show on an overlay plane, above an output's primary plane
+struct KMSOverlay
+{
+    std::shared_ptr<FBHandle const> fb;
+    /// Where to show it, relative to the top-left of the output
+    geometry::Rectangle destination;
+    /// The part of fb to show, in pixels
+    geometry::RectangleF source;
+};
+
 class KMSOutput
 {
 public:
@@ -70,7 +85,41 @@ public:
     virtual bool has_crtc_mismatch() = 0;
     virtual void clear_crtc() = 0;
     virtual bool schedule_page_flip(FBHandle const& fb) = 0;
-    virtual void wait_for_page_flip() = 0;
+
+    /**
+     * Wait for the flip scheduled by schedule_page_flip() to complete.
+     *
+     * \return The frame the flip completed on, or nullopt if the output is
+     *          not displaying anything (e.g. it is powered off).
+     */
+    virtual auto wait_for_page_flip() -> std::optional<Frame> = 0;
+
+    /**
+     * Check, without blocking, whether the flip scheduled by schedule_page_flip()
+     * has completed. Once it has, wait_for_page_flip() returns immediately.
+     */
+    virtual bool page_flip_completed() = 0;
+
+    /**
+     * The number of overlay planes that can be shown above the primary plane.
+     */
+    virtual auto overlay_plane_count() const -> size_t = 0;
+
+    /**
+     * Check whether the hardware can show these overlays above the primary plane.
+     *
+     * \param overlays The overlays, bottom to top.
+     */
+    virtual bool can_show_overlays(std::vector<KMSOverlay> const& overlays) = 0;
+
+    /**
+     * Show these overlays above the primary plane, from the next
+     * schedule_page_flip() or set_crtc() on. Overlay planes not needed
+     * are disabled.
+     *
+     * \param overlays The overlays, bottom to top.
+     */
+    virtual void set_overlays(std::vector<KMSOverlay> const& overlays) = 0;
 
     virtual bool set_cursor(gbm_bo* buffer) = 0;
     virtual void move_cursor(geometry::Point destination) = 0;
@@ -80,6 +129,22 @@ public:
     virtual void set_power_mode(MirPowerMode mode) = 0;
     virtual void set_gamma(GammaCurves const& gamma) = 0;
 
+    /**
+     * Let the output vary its refresh rate to follow the flips, from the
+     * next schedule_page_flip() or set_crtc() on.
+     *
+     * Has no effect on outputs that are not VRR capable.
+     */
+    virtual void set_variable_refresh(bool enabled) = 0;
+
+    /**
+     * Let the flips from the next schedule_page_flip() on happen as soon as
+     * possible, rather than at the next vblank. The new frame may then tear.
+     *
+     * Outputs whose driver can't flip asynchronously keep flipping at vblank.
+     */
+    virtual void set_tearing(bool allowed) = 0;
+
     /**
      * Re-probe the hardware state of this connector.
      *
@@ -25,6 +25,7 @@
 #include <xf86drmMode.h>
 #include <chrono>
 #include <cstring>
+#include <poll.h>
 
 namespace mg = mir::graphics;
 namespace mgg = mir::graphics::gbm;
@@ -62,6 +63,22 @@ mgg::KMSPageFlipper::KMSPageFlipper(
 bool mgg::KMSPageFlipper::schedule_flip(uint32_t crtc_id,
                                         uint32_t fb_id,
                                         uint32_t connector_id)
+{
+    return schedule_flip(crtc_id, fb_id, connector_id, DRM_MODE_PAGE_FLIP_EVENT);
+}
+
+bool mgg::KMSPageFlipper::schedule_async_flip(uint32_t crtc_id,
+                                              uint32_t fb_id,
+                                              uint32_t connector_id)
+{
+    /* The kernel still sends the flip event, so wait_for_flip() works as usual */
+    return schedule_flip(crtc_id, fb_id, connector_id, DRM_MODE_PAGE_FLIP_EVENT | DRM_MODE_PAGE_FLIP_ASYNC);
+}
+
+bool mgg::KMSPageFlipper::schedule_flip(uint32_t crtc_id,
+                                        uint32_t fb_id,
+                                        uint32_t connector_id,
+                                        uint32_t flags)
 {
     std::unique_lock lock{pf_mutex};
 
@@ -77,7 +94,7 @@ bool mgg::KMSPageFlipper::schedule_flip(uint32_t crtc_id,
      * apparently valid.
      */
     auto ret = drmModePageFlip(drm_fd, crtc_id, fb_id,
-                               DRM_MODE_PAGE_FLIP_EVENT,
+                               flags,
                                &pending_page_flips[crtc_id]);
 
     if (ret)
@@ -86,6 +103,31 @@ bool mgg::KMSPageFlipper::schedule_flip(uint32_t crtc_id,
     return (ret == 0);
 }
 
+bool mgg::KMSPageFlipper::schedule_atomic_flip(uint32_t crtc_id,
+                                               drmModeAtomicReq* request,
+                                               uint32_t connector_id)
+{
+    std::unique_lock lock{pf_mutex};
+
+    if (pending_page_flips.find(crtc_id) != pending_page_flips.end())
+        BOOST_THROW_EXCEPTION(std::logic_error("Page flip for crtc_id is already scheduled"));
+
+    pending_page_flips[crtc_id] = PageFlipEventData{crtc_id, connector_id, this};
+
+    /*
+     * The kernel sends an event for each CRTC in the commit, carrying the
+     * same user data, so this only handles a request for a single CRTC.
+     */
+    auto ret = drmModeAtomicCommit(drm_fd, request,
+                                   DRM_MODE_ATOMIC_NONBLOCK | DRM_MODE_PAGE_FLIP_EVENT,
+                                   &pending_page_flips[crtc_id]);
+
+    if (ret)
+        pending_page_flips.erase(crtc_id);
+
+    return (ret == 0);
+}
+
 mg::Frame mgg::KMSPageFlipper::wait_for_flip(uint32_t crtc_id)
 {
     drmEventContext evctx;
@@ -160,6 +202,30 @@ mg::Frame mgg::KMSPageFlipper::wait_for_flip(uint32_t crtc_id)
     return completed_page_flips[crtc_id];
 }
 
+bool mgg::KMSPageFlipper::flip_completed(uint32_t crtc_id)
+{
+    drmEventContext evctx;
+    memset(&evctx, 0, sizeof evctx);
+    evctx.version = 2;  // We only support the old v2 page_flip_handler
+    evctx.page_flip_handler = &page_flip_handler;
+
+    static std::thread::id const invalid_tid;
+
+    std::unique_lock lock{pf_mutex};
+
+    /* If there's a worker it's handling the events, and will notice ours */
+    if (page_flip_is_done(crtc_id) || worker_tid != invalid_tid)
+        return page_flip_is_done(crtc_id);
+
+    pollfd pfd{drm_fd, POLLIN, 0};
+    if (poll(&pfd, 1, 0) > 0)
+    {
+        drmHandleEvent(drm_fd, &evctx);
+    }
+
+    return page_flip_is_done(crtc_id);
+}
+
 std::thread::id mgg::KMSPageFlipper::debug_get_worker_tid()
 {
     std::unique_lock lock{pf_mutex};
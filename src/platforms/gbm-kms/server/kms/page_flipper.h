@@ -20,6 +20,8 @@
 #include "mir/graphics/frame.h"
 #include <cstdint>
 
+#include <xf86drmMode.h>
+
 namespace mir
 {
 namespace graphics
@@ -33,7 +35,22 @@ public:
     virtual ~PageFlipper() {}
 
     virtual bool schedule_flip(uint32_t crtc_id, uint32_t fb_id, uint32_t connector_id) = 0;
+    /**
+     * As schedule_flip(), but the flip happens as soon as possible rather than at the next
+     * vblank, so the new frame may tear
+     */
+    virtual bool schedule_async_flip(uint32_t crtc_id, uint32_t fb_id, uint32_t connector_id) = 0;
+    /**
+     * Commit an atomic request that flips crtc_id; wait_for_flip() waits for it as for schedule_flip()
+     */
+    virtual bool schedule_atomic_flip(uint32_t crtc_id, drmModeAtomicReq* request, uint32_t connector_id) = 0;
     virtual Frame wait_for_flip(uint32_t crtc_id) = 0;
+    /**
+     * Handle any flip events that have arrived, without blocking
+     *
+     * \return Whether crtc_id has no flip pending, so wait_for_flip() would return immediately
+     */
+    virtual bool flip_completed(uint32_t crtc_id) = 0;
 
 protected:
     PageFlipper() = default;
@@ -40,6 +40,9 @@
 #include "mir/log.h"
 
 #include <fcntl.h>
+#include <xf86drm.h>
+#include <cerrno>
+#include <cstring>
 #include <boost/exception/all.hpp>
 
 namespace mg = mir::graphics;
@@ -59,7 +62,13 @@ auto master_fd_for_device(mir::udev::Device const& device, mir::ConsoleServices&
     {
         BOOST_THROW_EXCEPTION((std::runtime_error{"Failed to acquire DRM fd"}));
     }
-    
+
+    // Expose primary and cursor planes as well as overlays, for scanout formats and atomic modesetting
+    if (drmSetClientCap(drm_fd, DRM_CLIENT_CAP_UNIVERSAL_PLANES, 1))
+    {
+        mir::log_info("DRM device does not support universal planes: %s", strerror(errno));
+    }
+
     return std::make_tuple(std::move(device_handle), std::move(drm_fd));
 }
 
@@ -338,18 +347,21 @@ auto maybe_make_dmabuf_provider(
 
 mgg::RenderingPlatform::RenderingPlatform(
     mir::udev::Device const& device,
-    std::vector<std::shared_ptr<mg::DisplayPlatform>> const& platforms)
-    : RenderingPlatform(gbm_device_for_udev_device(device, platforms))
+    std::vector<std::shared_ptr<mg::DisplayPlatform>> const& platforms,
+    bool upload_shm_at_commit)
+    : RenderingPlatform(gbm_device_for_udev_device(device, platforms), upload_shm_at_commit)
 {
 }
 
 mgg::RenderingPlatform::RenderingPlatform(
-    std::variant<std::shared_ptr<mg::GBMDisplayProvider>, std::shared_ptr<gbm_device>> hw)
+    std::variant<std::shared_ptr<mg::GBMDisplayProvider>, std::shared_ptr<gbm_device>> hw,
+    bool upload_shm_at_commit)
     : device{std::visit(gbm_device_from_hw{}, hw)},
       bound_display{std::visit(display_provider_or_nothing{}, hw)},
       share_ctx{std::make_unique<SurfacelessEGLContext>(initialise_egl(dpy_for_gbm_device(device.get()), 1, 4))},
       egl_delegate{std::make_shared<mg::common::EGLContextExecutor>(share_ctx->make_share_context())},
-      dmabuf_provider{maybe_make_dmabuf_provider(device, share_ctx->egl_display(), std::make_shared<mg::EGLExtensions>(), egl_delegate)}
+      dmabuf_provider{maybe_make_dmabuf_provider(device, share_ctx->egl_display(), std::make_shared<mg::EGLExtensions>(), egl_delegate)},
+      upload_shm_at_commit{upload_shm_at_commit}
 {
 }
 
@@ -361,7 +373,9 @@ mir::UniqueModulePtr<mg::GraphicBufferAllocator> mgg::RenderingPlatform::create_
     return make_module_ptr<mgg::BufferAllocator>(
         std::make_unique<SurfacelessEGLContext>(share_ctx->egl_display(), static_cast<EGLContext>(*share_ctx)),
         egl_delegate,
-        dmabuf_provider);
+        dmabuf_provider,
+        bound_display,
+        upload_shm_at_commit);
 }
 
 auto mgg::RenderingPlatform::maybe_create_provider(
@@ -87,9 +87,14 @@ private:
 class RenderingPlatform : public graphics::RenderingPlatform
 {
 public:
+    /**
+     * \param upload_shm_at_commit  Whether to upload client SHM buffers to GL textures as they're committed,
+     *                              rather than waiting for the renderer to need them
+     */
     RenderingPlatform(
         udev::Device const& device,
-        std::vector<std::shared_ptr<graphics::DisplayPlatform>> const& platforms);
+        std::vector<std::shared_ptr<graphics::DisplayPlatform>> const& platforms,
+        bool upload_shm_at_commit);
 
     ~RenderingPlatform() override;
 
@@ -102,13 +107,15 @@ protected:
 
 private:
     RenderingPlatform(
-        std::variant<std::shared_ptr<GBMDisplayProvider>, std::shared_ptr<gbm_device>> hw);
+        std::variant<std::shared_ptr<GBMDisplayProvider>, std::shared_ptr<gbm_device>> hw,
+        bool upload_shm_at_commit);
     
     std::shared_ptr<gbm_device> const device;                   ///< gbm_device this platform is created on, always valid.
     std::shared_ptr<GBMDisplayProvider> const bound_display;    ///< Associated Display, if any (nullptr is valid)
     std::unique_ptr<SurfacelessEGLContext> const share_ctx;
     std::shared_ptr<common::EGLContextExecutor> const egl_delegate;
     std::shared_ptr<DMABufEGLProvider> const dmabuf_provider;
+    bool const upload_shm_at_commit;
 };
 }
 }
@@ -78,12 +78,14 @@ mir::UniqueModulePtr<mg::DisplayPlatform> create_display_platform(
 auto create_rendering_platform(
     mg::SupportedDevice const& device,
     std::vector<std::shared_ptr<mg::DisplayPlatform>> const& platforms,
-    mo::Option const&,
+    mo::Option const& options,
     mir::EmergencyCleanupRegistry&) -> mir::UniqueModulePtr<mg::RenderingPlatform>
 {
     mir::assert_entry_point_signature<mg::CreateRenderPlatform>(&create_rendering_platform);
 
-    return mir::make_module_ptr<mgg::RenderingPlatform>(*device.device, platforms);
+    // The software renderer maps SHM buffers rather than binding them, so has no use for an upload
+    auto const upload_shm_at_commit = options.get(mo::renderer_opt, "gl") != std::string{"software"};
+    return mir::make_module_ptr<mgg::RenderingPlatform>(*device.device, platforms, upload_shm_at_commit);
 }
 
 void add_graphics_platform_options(boost::program_options::options_description& config)
@@ -218,12 +218,13 @@ bool mgg::compatible(mgg::RealKMSDisplayConfiguration const& conf1, mgg::RealKMS
             {
                 auto clone = conf2.outputs[i].first;
 
-                // ignore difference in orientation, scale factor, form factor, subpixel arrangement
+                // ignore difference in orientation, scale factor, form factor, subpixel arrangement, VRR
                 clone.orientation = conf1.outputs[i].first.orientation;
                 clone.subpixel_arrangement = conf1.outputs[i].first.subpixel_arrangement;
                 clone.scale = conf1.outputs[i].first.scale;
                 clone.form_factor = conf1.outputs[i].first.form_factor;
                 clone.custom_logical_size = conf1.outputs[i].first.custom_logical_size;
+                clone.vrr_enabled = conf1.outputs[i].first.vrr_enabled;
                 compatible &= (conf1.outputs[i].first == clone);
             }
             else
@@ -24,6 +24,7 @@
 #include <string.h> // strcmp
 
 #include <boost/throw_exception.hpp>
+#include <stdexcept>
 #include <system_error>
 #include <xf86drm.h>
 #include <xf86drmMode.h>
@@ -77,6 +78,9 @@ mgg::RealKMSOutput::RealKMSOutput(
             saved_crtc = *resources.crtc(encoder->crtc_id);
         }
     }
+
+    uint64_t async_page_flips = 0;
+    async_page_flips_supported = drmGetCap(drm_fd_, DRM_CAP_ASYNC_PAGE_FLIP, &async_page_flips) == 0 && async_page_flips;
 }
 
 mgg::RealKMSOutput::~RealKMSOutput()
@@ -167,6 +171,9 @@ bool mgg::RealKMSOutput::set_crtc(FBHandle const& fb)
     }
 
     using_saved_crtc = false;
+    /* The CRTC may have changed; make sure it has our VRR setting */
+    variable_refresh_applied.reset();
+    apply_variable_refresh();
     return true;
 }
 
@@ -237,23 +244,63 @@ bool mgg::RealKMSOutput::schedule_page_flip(FBHandle const& fb)
                        mgk::connector_name(connector).c_str());
         return false;
     }
+    apply_variable_refresh();
+
+    /* Drivers can refuse to flip asynchronously (e.g. if the buffer's layout changed), so fall back to vsync */
+    if (tearing && async_page_flips_supported &&
+        page_flipper->schedule_async_flip(current_crtc->crtc_id, fb, connector->connector_id))
+    {
+        return true;
+    }
+
     return page_flipper->schedule_flip(
         current_crtc->crtc_id,
         fb,
         connector->connector_id);
 }
 
-void mgg::RealKMSOutput::wait_for_page_flip()
+auto mgg::RealKMSOutput::wait_for_page_flip() -> std::optional<Frame>
 {
     std::unique_lock lg(power_mutex);
     if (power_mode != mir_power_mode_on)
-        return;
+        return std::nullopt;
     if (!current_crtc)
     {
         fatal_error("Output %s has no associated CRTC to wait on",
                    mgk::connector_name(connector).c_str());
     }
-    page_flipper->wait_for_flip(current_crtc->crtc_id);
+    return page_flipper->wait_for_flip(current_crtc->crtc_id);
+}
+
+bool mgg::RealKMSOutput::page_flip_completed()
+{
+    std::unique_lock lg(power_mutex);
+    /* As for wait_for_page_flip(): nothing is flipping on an output that is off */
+    if (power_mode != mir_power_mode_on || !current_crtc)
+        return true;
+    return page_flipper->flip_completed(current_crtc->crtc_id);
+}
+
+auto mgg::RealKMSOutput::overlay_plane_count() const -> size_t
+{
+    /* drmModeSetPlane() takes effect independently of drmModePageFlip(), so
+     * overlay planes driven through the legacy API would not change in step
+     * with the primary plane. Only offer them where the update is atomic.
+     */
+    return 0;
+}
+
+bool mgg::RealKMSOutput::can_show_overlays(std::vector<KMSOverlay> const& overlays)
+{
+    return overlays.empty();
+}
+
+void mgg::RealKMSOutput::set_overlays(std::vector<KMSOverlay> const& overlays)
+{
+    if (!overlays.empty())
+    {
+        BOOST_THROW_EXCEPTION(std::logic_error("Output has no overlay planes"));
+    }
 }
 
 bool mgg::RealKMSOutput::set_cursor(gbm_bo* buffer)
@@ -389,6 +436,41 @@ void mgg::RealKMSOutput::set_gamma(mg::GammaCurves const& gamma)
     // TODO: return bool in future? Then do what with it?
 }
 
+void mgg::RealKMSOutput::set_variable_refresh(bool enabled)
+{
+    variable_refresh = enabled;
+}
+
+void mgg::RealKMSOutput::set_tearing(bool allowed)
+{
+    tearing = allowed;
+}
+
+void mgg::RealKMSOutput::apply_variable_refresh()
+{
+    if (variable_refresh_applied == variable_refresh)
+        return;
+
+    /* VRR_ENABLED is not an atomic-only property, so this works without atomic modesetting */
+    mgk::ObjectProperties crtc_props{drm_fd_, current_crtc->crtc_id, DRM_MODE_OBJECT_CRTC};
+    if (!crtc_props.has_property("VRR_ENABLED"))
+    {
+        variable_refresh_applied = variable_refresh;
+        return;
+    }
+
+    if (auto const ret = drmModeObjectSetProperty(
+            drm_fd_, current_crtc->crtc_id, DRM_MODE_OBJECT_CRTC, crtc_props.id_for("VRR_ENABLED"), variable_refresh))
+    {
+        mir::log_warning("Failed to %s variable refresh on output %s: %s (%i)",
+                         variable_refresh ? "enable" : "disable",
+                         mgk::connector_name(connector).c_str(), strerror(-ret), -ret);
+    }
+
+    /* Don't retry every frame if the driver refuses */
+    variable_refresh_applied = variable_refresh;
+}
+
 void mgg::RealKMSOutput::refresh_hardware_state()
 {
     connector = kms::get_connector(drm_fd_, connector->connector_id);
@@ -522,6 +604,14 @@ std::vector<uint8_t> edid_for_connector(int drm_fd, uint32_t connector_id)
 
     return edid;
 }
+
+bool connector_is_vrr_capable(int drm_fd, uint32_t connector_id)
+{
+    mgk::ObjectProperties connector_props{
+        drm_fd, connector_id, DRM_MODE_OBJECT_CONNECTOR};
+
+    return connector_props.has_property("vrr_capable") && connector_props["vrr_capable"];
+}
 }
 
 void mgg::RealKMSOutput::update_from_hardware_state(
@@ -539,11 +629,13 @@ void mgg::RealKMSOutput::update_from_hardware_state(
                                         mir_pixel_format_xrgb_8888};
 
     std::vector<uint8_t> edid;
+    bool vrr_capable{false};
     if (connected) {
         /* Only ask for the EDID on connected outputs. There's obviously no monitor EDID
          * when there is no monitor connected!
          */
         edid = edid_for_connector(drm_fd_, connector->connector_id);
+        vrr_capable = connector_is_vrr_capable(drm_fd_, connector->connector_id);
     }
 
     drmModeModeInfo current_mode_info = drmModeModeInfo();
@@ -600,6 +692,7 @@ void mgg::RealKMSOutput::update_from_hardware_state(
     output.subpixel_arrangement = kms_subpixel_to_mir_subpixel(connector->subpixel);
     output.gamma = gamma;
     output.edid = edid;
+    output.vrr_capable = vrr_capable;
 }
 
 int mgg::RealKMSOutput::drm_fd() const
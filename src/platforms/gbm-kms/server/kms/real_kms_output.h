@@ -52,7 +52,12 @@ public:
     bool has_crtc_mismatch() override;
     void clear_crtc() override;
     bool schedule_page_flip(FBHandle const& fb) override;
-    void wait_for_page_flip() override;
+    auto wait_for_page_flip() -> std::optional<Frame> override;
+    bool page_flip_completed() override;
+
+    auto overlay_plane_count() const -> size_t override;
+    bool can_show_overlays(std::vector<KMSOverlay> const& overlays) override;
+    void set_overlays(std::vector<KMSOverlay> const& overlays) override;
 
     bool set_cursor(gbm_bo* buffer) override;
     void move_cursor(geometry::Point destination) override;
@@ -61,15 +66,18 @@ public:
 
     void set_power_mode(MirPowerMode mode) override;
     void set_gamma(GammaCurves const& gamma) override;
+    void set_variable_refresh(bool enabled) override;
+    void set_tearing(bool allowed) override;
 
     void refresh_hardware_state() override;
     void update_from_hardware_state(DisplayConfigurationOutput& output) const override;
 
     int drm_fd() const override;
 
-private:
+protected:
     bool ensure_crtc();
     void restore_saved_crtc();
+    void apply_variable_refresh();
 
     int const drm_fd_;
     std::shared_ptr<PageFlipper> const page_flipper;
@@ -85,6 +93,12 @@ private:
     MirPowerMode power_mode;
     int dpms_enum_id;
 
+    bool variable_refresh{false};
+    std::optional<bool> variable_refresh_applied;
+
+    bool tearing{false};
+    bool async_page_flips_supported{false};
+
     std::mutex power_mutex;
 };
 
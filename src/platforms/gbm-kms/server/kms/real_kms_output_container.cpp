@@ -17,15 +17,44 @@
 #include <algorithm>
 #include "real_kms_output_container.h"
 #include "real_kms_output.h"
+#include "atomic_kms_output.h"
 #include "kms-utils/drm_mode_resources.h"
+#include "mir/log.h"
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <xf86drm.h>
 
 namespace mgg = mir::graphics::gbm;
 
+namespace
+{
+auto enable_atomic_modesetting(int drm_fd) -> bool
+{
+    if (getenv("MIR_GBM_KMS_DISABLE_ATOMIC") != nullptr)
+    {
+        mir::log_info("Atomic modesetting disabled by MIR_GBM_KMS_DISABLE_ATOMIC");
+        return false;
+    }
+
+    if (drmSetClientCap(drm_fd, DRM_CLIENT_CAP_ATOMIC, 1))
+    {
+        mir::log_info("Not using atomic modesetting: not supported by driver (%s)", strerror(errno));
+        return false;
+    }
+
+    mir::log_info("Using atomic modesetting");
+    return true;
+}
+}
+
 mgg::RealKMSOutputContainer::RealKMSOutputContainer(
     mir::Fd drm_fd,
     std::shared_ptr<PageFlipper> page_flipper)
     : drm_fd{std::move(drm_fd)},
-      page_flipper{std::move(page_flipper)}
+      page_flipper{std::move(page_flipper)},
+      atomic{enable_atomic_modesetting(this->drm_fd)}
 {
 }
 
@@ -64,6 +93,13 @@ void mgg::RealKMSOutputContainer::update_from_hardware_state()
             new_outputs.push_back(*existing_output);
             new_outputs.back()->refresh_hardware_state();
         }
+        else if (atomic)
+        {
+            new_outputs.push_back(std::make_shared<AtomicKMSOutput>(
+                drm_fd,
+                std::move(connector),
+                page_flipper));
+        }
         else
         {
             new_outputs.push_back(std::make_shared<RealKMSOutput>(
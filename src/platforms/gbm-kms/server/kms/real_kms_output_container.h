@@ -44,6 +44,8 @@ private:
     mir::Fd const drm_fd;
     std::vector<std::shared_ptr<KMSOutput>> outputs;
     std::shared_ptr<PageFlipper> const page_flipper;
+    /// Whether the driver accepted DRM_CLIENT_CAP_ATOMIC, so outputs can be AtomicKMSOutputs
+    bool const atomic;
 };
 
 }
@@ -159,10 +159,13 @@ private:
 mge::BufferAllocator::BufferAllocator(
     EGLDisplay dpy,
     EGLContext share_with,
-    std::shared_ptr<DMABufEGLProvider> dmabuf_provider)
+    std::shared_ptr<DMABufEGLProvider> dmabuf_provider,
+    bool upload_shm_at_commit)
     : ctx{std::make_unique<SurfacelessEGLContext>(dpy, share_with)},
       egl_delegate{
           std::make_shared<mgc::EGLContextExecutor>(ctx->make_share_context())},
+      shm_textures{std::make_shared<mgc::ShmTextureCache>(egl_delegate)},
+      upload_shm_at_commit{upload_shm_at_commit},
       egl_extensions(std::make_shared<mg::EGLExtensions>()),
       dmabuf_provider{std::move(dmabuf_provider)}
 {
@@ -238,7 +241,8 @@ void mge::BufferAllocator::bind_display(wl_display* display, std::shared_ptr<Exe
                 std::unique_ptr<LinuxDmaBufUnstable, std::function<void(LinuxDmaBufUnstable * )>>(
                     new LinuxDmaBufUnstable{
                         display,
-                        dmabuf_provider
+                        dmabuf_provider,
+                        nullptr
                     },
                     [wayland_executor](LinuxDmaBufUnstable* global)
                     {
@@ -315,14 +319,19 @@ std::shared_ptr<mg::Buffer> mge::BufferAllocator::buffer_from_resource(
 
 auto mge::BufferAllocator::buffer_from_shm(
     std::shared_ptr<renderer::software::RWMappableBuffer> data,
+    std::optional<geometry::Rectangles> const& damage,
     std::function<void()>&& on_consumed,
     std::function<void()>&& on_release) -> std::shared_ptr<Buffer>
 {
+    auto texture = shm_textures->texture_for(data);
     return std::make_shared<mgc::NotifyingMappableBackedShmBuffer>(
         std::move(data),
         egl_delegate,
         std::move(on_consumed),
-        std::move(on_release));
+        std::move(on_release),
+        std::move(texture),
+        damage,
+        upload_shm_at_commit);
 }
 
 auto mge::BufferAllocator::shared_egl_context() -> EGLContext
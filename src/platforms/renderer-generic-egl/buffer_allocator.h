@@ -43,6 +43,7 @@ struct EGLExtensions;
 namespace common
 {
 class EGLContextExecutor;
+class ShmTextureCache;
 }
 
 namespace egl::generic
@@ -54,7 +55,11 @@ class BufferAllocator:
     public graphics::GraphicBufferAllocator
 {
 public:
-    BufferAllocator(EGLDisplay dpy, EGLContext share_with, std::shared_ptr<DMABufEGLProvider> dmabuf_provider);
+    BufferAllocator(
+        EGLDisplay dpy,
+        EGLContext share_with,
+        std::shared_ptr<DMABufEGLProvider> dmabuf_provider,
+        bool upload_shm_at_commit);
     ~BufferAllocator() override;
     
     std::shared_ptr<Buffer> alloc_software_buffer(geometry::Size size, MirPixelFormat) override;
@@ -68,6 +73,7 @@ public:
         std::function<void()>&& on_release) -> std::shared_ptr<Buffer> override;
     auto buffer_from_shm(
         std::shared_ptr<renderer::software::RWMappableBuffer> data,
+        std::optional<geometry::Rectangles> const& damage,
         std::function<void()>&& on_consumed,
         std::function<void()>&& on_release) -> std::shared_ptr<Buffer> override;
 
@@ -75,6 +81,8 @@ public:
 private:
     std::unique_ptr<renderer::gl::Context> const ctx;
     std::shared_ptr<common::EGLContextExecutor> const egl_delegate;
+    std::shared_ptr<common::ShmTextureCache> const shm_textures;
+    bool const upload_shm_at_commit;
     std::shared_ptr<Executor> wayland_executor;
     std::unique_ptr<LinuxDmaBufUnstable, std::function<void(LinuxDmaBufUnstable*)>> dmabuf_extension;
     std::shared_ptr<EGLExtensions> const egl_extensions;
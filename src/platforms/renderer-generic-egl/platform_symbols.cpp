@@ -27,6 +27,8 @@
 #include "mir/graphics/egl_error.h"
 #include "mir/graphics/gl_config.h"
 #include "mir/graphics/egl_logger.h"
+#include "mir/options/option.h"
+#include "mir/options/configuration.h"
 
 #include <EGL/egl.h>
 #include <GLES2/gl2.h>
@@ -38,12 +40,14 @@ namespace mge = mg::egl::generic;
 auto create_rendering_platform(
     mg::SupportedDevice const&,
     std::vector<std::shared_ptr<mg::DisplayPlatform>> const& displays,
-    mo::Option const&,
+    mo::Option const& options,
     mir::EmergencyCleanupRegistry&) -> mir::UniqueModulePtr<mg::RenderingPlatform>
 {
    mir::assert_entry_point_signature<mg::CreateRenderPlatform>(&create_rendering_platform);
 
-    return mir::make_module_ptr<mge::RenderingPlatform>(displays);
+    // The software renderer maps SHM buffers rather than binding them, so has no use for an upload
+    auto const upload_shm_at_commit = options.get(mo::renderer_opt, "gl") != std::string{"software"};
+    return mir::make_module_ptr<mge::RenderingPlatform>(displays, upload_shm_at_commit);
 }
 
 void add_graphics_platform_options(boost::program_options::options_description&)
@@ -196,12 +196,14 @@ auto maybe_make_dmabuf_provider(
 }
 }
 
-mge::RenderingPlatform::RenderingPlatform(std::vector<std::shared_ptr<DisplayPlatform>> const& displays)
-    : RenderingPlatform(egl_display_from_platforms(displays))
+mge::RenderingPlatform::RenderingPlatform(
+    std::vector<std::shared_ptr<DisplayPlatform>> const& displays,
+    bool upload_shm_at_commit)
+    : RenderingPlatform(egl_display_from_platforms(displays), upload_shm_at_commit)
 {
 }
 
-mge::RenderingPlatform::RenderingPlatform(std::tuple<EGLDisplay, bool> display)
+mge::RenderingPlatform::RenderingPlatform(std::tuple<EGLDisplay, bool> display, bool upload_shm_at_commit)
     : dpy{std::get<0>(display)},
       owns_dpy{std::get<1>(display)},
       ctx{std::make_unique<SurfacelessEGLContext>(dpy)},
@@ -209,7 +211,8 @@ mge::RenderingPlatform::RenderingPlatform(std::tuple<EGLDisplay, bool> display)
           maybe_make_dmabuf_provider(
               dpy,
               std::make_shared<mg::EGLExtensions>(),
-              std::make_shared<mgc::EGLContextExecutor>(ctx->make_share_context()))}
+              std::make_shared<mgc::EGLContextExecutor>(ctx->make_share_context()))},
+      upload_shm_at_commit{upload_shm_at_commit}
 {
 }
 
@@ -224,7 +227,11 @@ mge::RenderingPlatform::~RenderingPlatform()
 auto mge::RenderingPlatform::create_buffer_allocator(
     mg::Display const& /*output*/) -> mir::UniqueModulePtr<mg::GraphicBufferAllocator>
 {
-    return make_module_ptr<mge::BufferAllocator>(dpy, static_cast<EGLContext>(*ctx), dmabuf_provider);
+    return make_module_ptr<mge::BufferAllocator>(
+        dpy,
+        static_cast<EGLContext>(*ctx),
+        dmabuf_provider,
+        upload_shm_at_commit);
 }
 
 auto mge::RenderingPlatform::maybe_create_provider(RenderingProvider::Tag const& tag)
@@ -35,7 +35,11 @@ namespace graphics::egl::generic
 class RenderingPlatform : public graphics::RenderingPlatform
 {
 public:
-    explicit RenderingPlatform(std::vector<std::shared_ptr<DisplayPlatform>> const& displays);
+    /**
+     * \param upload_shm_at_commit  Whether to upload client SHM buffers to GL textures as they're committed,
+     *                              rather than waiting for the renderer to need them
+     */
+    RenderingPlatform(std::vector<std::shared_ptr<DisplayPlatform>> const& displays, bool upload_shm_at_commit);
 
     ~RenderingPlatform();
 
@@ -47,12 +51,13 @@ protected:
         RenderingProvider::Tag const& type_tag) -> std::shared_ptr<RenderingProvider> override;
 
 private:
-    explicit RenderingPlatform(std::tuple<EGLDisplay, bool> dpy);
+    RenderingPlatform(std::tuple<EGLDisplay, bool> dpy, bool upload_shm_at_commit);
 
     EGLDisplay const dpy;
     bool const owns_dpy;
     std::unique_ptr<renderer::gl::Context> const ctx;
     std::shared_ptr<DMABufEGLProvider> const dmabuf_provider;
+    bool const upload_shm_at_commit;
 };
 
 }
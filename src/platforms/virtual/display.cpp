@@ -26,6 +26,11 @@ namespace mgv = mir::graphics::virt;
 
 namespace
 {
+auto is_shown(mg::DisplayConfigurationOutput const& output) -> bool
+{
+    return output.connected && output.used && output.power_mode == mir_power_mode_on;
+}
+
 auto build_configuration(std::vector<mgv::VirtualOutputConfig> const& output_sizes)
 -> std::unique_ptr<mgv::DisplayConfiguration>
 {
@@ -38,13 +43,22 @@ auto build_configuration(std::vector<mgv::VirtualOutputConfig> const& output_siz
 }
 }
 
-mgv::Display::Display(std::vector<VirtualOutputConfig> const& output_sizes)
-    : display_configuration{build_configuration(output_sizes)}
+mgv::Display::Display(
+    std::vector<VirtualOutputConfig> const& output_sizes,
+    std::shared_ptr<DisplayReport> const& report)
+    : report{report},
+      display_configuration{build_configuration(output_sizes)}
 {
+    create_display_sinks();
 }
 
-void mgv::Display::for_each_display_sync_group(std::function<void(DisplaySyncGroup &)> const&)
+void mgv::Display::for_each_display_sync_group(std::function<void(DisplaySyncGroup &)> const& f)
 {
+    std::lock_guard lock{mutex};
+    for (auto const& sink : display_sinks)
+    {
+        f(*sink);
+    }
 }
 
 std::unique_ptr<mg::DisplayConfiguration> mgv::Display::configuration() const
@@ -55,7 +69,24 @@ std::unique_ptr<mg::DisplayConfiguration> mgv::Display::configuration() const
 
 bool mgv::Display::apply_if_configuration_preserves_display_buffers(mir::graphics::DisplayConfiguration const& conf)
 {
-    configure(conf);
+    auto const& new_conf = dynamic_cast<DisplayConfiguration const&>(conf);
+
+    std::lock_guard lock{mutex};
+    if (!only_moves_outputs(new_conf))
+    {
+        return false;
+    }
+
+    display_configuration = new_conf.clone();
+    auto sink = display_sinks.begin();
+    display_configuration->for_each_output(
+        [&](mg::DisplayConfigurationOutput const& output)
+        {
+            if (is_shown(output))
+            {
+                (*sink++)->set_placement(output);
+            }
+        });
     return true;
 }
 
@@ -65,6 +96,36 @@ void mgv::Display::configure(mir::graphics::DisplayConfiguration const& conf)
 
     std::lock_guard lock{mutex};
     display_configuration = new_conf.clone();
+    create_display_sinks();
+}
+
+auto mgv::Display::only_moves_outputs(mir::graphics::DisplayConfiguration const& conf) const -> bool
+{
+    auto sink = display_sinks.begin();
+    bool compatible{true};
+    conf.for_each_output(
+        [&](mg::DisplayConfigurationOutput const& output)
+        {
+            if (is_shown(output))
+            {
+                compatible = compatible && sink != display_sinks.end() && (*sink++)->has_mode_of(output);
+            }
+        });
+    return compatible && sink == display_sinks.end();
+}
+
+void mgv::Display::create_display_sinks()
+{
+    // Each output has its own simulated refresh clock, so is a DisplaySyncGroup of its own
+    display_sinks.clear();
+    display_configuration->for_each_output(
+        [this](mg::DisplayConfigurationOutput const& output)
+        {
+            if (is_shown(output))
+            {
+                display_sinks.push_back(std::make_unique<DisplaySink>(output, report));
+            }
+        });
 }
 
 void mgv::Display::register_configuration_change_handler(
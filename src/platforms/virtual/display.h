@@ -18,8 +18,13 @@
 #define MIR_GRAPHICS_VIRT_DISPLAY_H_
 
 #include "platform.h"
+#include "display_sink.h"
 #include <mir/graphics/display.h>
 
+#include <memory>
+#include <mutex>
+#include <vector>
+
 namespace mir
 {
 namespace graphics
@@ -30,7 +35,7 @@ namespace virt
 class Display : public mir::graphics::Display
 {
 public:
-    explicit Display(std::vector<VirtualOutputConfig> const& output_sizes);
+    Display(std::vector<VirtualOutputConfig> const& output_sizes, std::shared_ptr<DisplayReport> const& report);
     void for_each_display_sync_group(std::function<void(DisplaySyncGroup &)> const& f) override;
     std::unique_ptr<mir::graphics::DisplayConfiguration> configuration() const override;
     bool apply_if_configuration_preserves_display_buffers(mir::graphics::DisplayConfiguration const& conf) override;
@@ -43,8 +48,15 @@ public:
     std::shared_ptr<Cursor> create_hardware_cursor() override;
 
 private:
+    /// Whether conf can be applied without replacing any DisplaySinks
+    auto only_moves_outputs(mir::graphics::DisplayConfiguration const& conf) const -> bool;
+    void create_display_sinks();
+
+    std::shared_ptr<DisplayReport> const report;
     std::mutex mutable mutex;
     std::shared_ptr<DisplayConfiguration> display_configuration;
+    /// One for each output that's in use, in the order of display_configuration's outputs
+    std::vector<std::unique_ptr<DisplaySink>> display_sinks;
 };
 }
 }
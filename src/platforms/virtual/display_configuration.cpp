@@ -27,8 +27,8 @@ mg::DisplayConfigurationOutput mgv::DisplayConfiguration::build_output(mgv::Virt
     if (config.sizes.size() == 0)
         BOOST_THROW_EXCEPTION(std::runtime_error("An output must be specified with at least one size"));
     std::vector<DisplayConfigurationMode> configuration_modes;
-    for (auto size : config.sizes)
-        configuration_modes.push_back({size, 60.0});
+    for (size_t mode = 0; mode != config.sizes.size(); ++mode)
+        configuration_modes.push_back({config.sizes[mode], config.refresh_rate(mode)});
 
     last_output_id++;
     return  DisplayConfigurationOutput{
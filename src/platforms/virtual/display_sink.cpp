@@ -0,0 +1,271 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "display_sink.h"
+
+#include <mir/graphics/display_report.h>
+#include <mir/graphics/drm_formats.h>
+#include <mir/renderer/sw/pixel_source.h>
+
+#include <boost/throw_exception.hpp>
+
+#include <stdexcept>
+#include <vector>
+
+namespace mg = mir::graphics;
+namespace mgv = mir::graphics::virt;
+namespace mrs = mir::renderer::software;
+namespace geom = mir::geometry;
+
+namespace
+{
+auto current_mode(mg::DisplayConfigurationOutput const& output) -> mg::DisplayConfigurationMode const&
+{
+    if (output.current_mode_index >= output.modes.size())
+    {
+        BOOST_THROW_EXCEPTION((std::logic_error{"Virtual output has no current mode"}));
+    }
+    return output.modes[output.current_mode_index];
+}
+
+auto refresh_period_of(mg::DisplayConfigurationOutput const& output) -> std::chrono::nanoseconds
+{
+    return std::chrono::nanoseconds{static_cast<int64_t>(1e9 / current_mode(output).vrefresh_hz)};
+}
+
+/// Pixels in CPU memory, drawn into as a frame, then "shown" until the next frame is posted
+struct Pixels
+{
+    Pixels(geom::Size size, MirPixelFormat format)
+        : size{size},
+          format{format},
+          stride{size.width.as_int() * MIR_BYTES_PER_PIXEL(format)},
+          data{std::make_unique<unsigned char[]>(stride.as_uint32_t() * size.height.as_uint32_t())}
+    {
+    }
+
+    geom::Size const size;
+    MirPixelFormat const format;
+    geom::Stride const stride;
+    std::unique_ptr<unsigned char[]> const data;
+    /// The alloc_fb() call this was last handed out by, or 0 if it never has been
+    uint64_t drawn_serial{0};
+};
+
+class Mapping : public mrs::Mapping<unsigned char>
+{
+public:
+    explicit Mapping(std::shared_ptr<Pixels> pixels)
+        : pixels{std::move(pixels)}
+    {
+    }
+
+    auto format() const -> MirPixelFormat override { return pixels->format; }
+    auto stride() const -> geom::Stride override { return pixels->stride; }
+    auto size() const -> geom::Size override { return pixels->size; }
+    auto data() -> unsigned char* override { return pixels->data.get(); }
+    auto len() const -> size_t override { return pixels->stride.as_uint32_t() * pixels->size.height.as_uint32_t(); }
+
+private:
+    std::shared_ptr<Pixels> const pixels;
+};
+
+class FB : public mg::CPUAddressableDisplayAllocator::MappableFB
+{
+public:
+    FB(std::shared_ptr<Pixels> pixels, int age)
+        : pixels{std::move(pixels)},
+          age{age}
+    {
+    }
+
+    auto map_writeable() -> std::unique_ptr<mrs::Mapping<unsigned char>> override
+    {
+        return std::make_unique<Mapping>(pixels);
+    }
+
+    auto format() const -> MirPixelFormat override { return pixels->format; }
+    auto stride() const -> geom::Stride override { return pixels->stride; }
+    auto size() const -> geom::Size override { return pixels->size; }
+    auto buffer_age() const -> int override { return age; }
+
+private:
+    std::shared_ptr<Pixels> const pixels;
+    int const age;
+};
+}
+
+/**
+ * Hands out framebuffers in CPU memory, reusing those no longer drawn to or shown
+ *
+ * As with a real swapchain, a reused framebuffer still holds the frame it was
+ * last drawn with, so renderers need only repaint what has changed since.
+ */
+class mgv::DisplaySink::Allocator : public mg::CPUAddressableDisplayAllocator
+{
+public:
+    explicit Allocator(geom::Size size)
+        : size{size}
+    {
+    }
+
+    auto supported_formats() const -> std::vector<DRMFormat> override
+    {
+        return {
+            DRMFormat::from_mir_format(mir_pixel_format_xrgb_8888),
+            DRMFormat::from_mir_format(mir_pixel_format_argb_8888)};
+    }
+
+    auto alloc_fb(DRMFormat format) -> std::unique_ptr<MappableFB> override
+    {
+        auto const mir_format = format.as_mir_format().value_or(mir_pixel_format_invalid);
+        if (mir_format != mir_pixel_format_xrgb_8888 && mir_format != mir_pixel_format_argb_8888)
+        {
+            BOOST_THROW_EXCEPTION((std::runtime_error{std::string{"Unsupported framebuffer format: "} + format.name()}));
+        }
+
+        ++serial;
+
+        // Nothing else holds a reference to a framebuffer that's neither being drawn to nor shown
+        std::shared_ptr<Pixels> reused;
+        for (auto const& candidate : framebuffers)
+        {
+            if (candidate.use_count() == 1 && candidate->format == mir_format &&
+                (!reused || candidate->drawn_serial > reused->drawn_serial))
+            {
+                reused = candidate;
+            }
+        }
+
+        if (!reused)
+        {
+            reused = framebuffers.emplace_back(std::make_shared<Pixels>(size, mir_format));
+        }
+
+        auto const age = reused->drawn_serial ? static_cast<int>(serial - reused->drawn_serial) : 0;
+        reused->drawn_serial = serial;
+        return std::make_unique<FB>(reused, age);
+    }
+
+    auto output_size() const -> geom::Size override
+    {
+        return size;
+    }
+
+private:
+    geom::Size const size;
+    uint64_t serial{0};
+    std::vector<std::shared_ptr<Pixels>> framebuffers;
+};
+
+mgv::DisplaySink::DisplaySink(
+    DisplayConfigurationOutput const& output,
+    std::shared_ptr<DisplayReport> const& report)
+    : output_id{output.id},
+      mode_size{current_mode(output).size},
+      refresh_period{refresh_period_of(output)},
+      report{report},
+      allocator{std::make_unique<Allocator>(mode_size)},
+      area{output.extents()},
+      transform{output.transformation()},
+      clock_start{time::PosixTimestamp::now(CLOCK_MONOTONIC)}
+{
+}
+
+mgv::DisplaySink::~DisplaySink() = default;
+
+auto mgv::DisplaySink::view_area() const -> geom::Rectangle
+{
+    std::lock_guard lock{mutex};
+    return area;
+}
+
+bool mgv::DisplaySink::overlay(std::vector<DisplayElement> const&)
+{
+    return false;
+}
+
+void mgv::DisplaySink::set_next_image(std::unique_ptr<Framebuffer> content)
+{
+    next_image = std::move(content);
+}
+
+auto mgv::DisplaySink::transformation() const -> glm::mat2
+{
+    std::lock_guard lock{mutex};
+    return transform;
+}
+
+void mgv::DisplaySink::for_each_display_sink(std::function<void(graphics::DisplaySink&)> const& f)
+{
+    f(*this);
+}
+
+void mgv::DisplaySink::post()
+{
+    // Wait for the next simulated vblank, as page-flipping would
+    auto const now = time::PosixTimestamp::now(clock_start.clock_id);
+    auto const msc = (now - clock_start) / refresh_period + 1;
+    auto const vblank = clock_start + msc * refresh_period;
+    time::sleep_until(vblank);
+
+    if (next_image)
+    {
+        visible_image = std::move(next_image);
+    }
+
+    Frame const frame{msc, vblank};
+    report->report_vsync(output_id.as_value(), frame);
+    presentation = FramePresentation{frame, true, false, false, false};
+}
+
+auto mgv::DisplaySink::recommended_sleep() const -> std::chrono::milliseconds
+{
+    return std::chrono::milliseconds::zero();
+}
+
+auto mgv::DisplaySink::frame_budget() const -> std::optional<std::chrono::nanoseconds>
+{
+    return refresh_period;
+}
+
+auto mgv::DisplaySink::last_presentation() const -> std::optional<FramePresentation>
+{
+    return presentation;
+}
+
+auto mgv::DisplaySink::has_mode_of(DisplayConfigurationOutput const& output) const -> bool
+{
+    return output.id == output_id &&
+           current_mode(output).size == mode_size &&
+           refresh_period_of(output) == refresh_period;
+}
+
+void mgv::DisplaySink::set_placement(DisplayConfigurationOutput const& output)
+{
+    std::lock_guard lock{mutex};
+    area = output.extents();
+    transform = output.transformation();
+}
+
+auto mgv::DisplaySink::maybe_create_allocator(DisplayAllocator::Tag const& type_tag) -> DisplayAllocator*
+{
+    if (dynamic_cast<CPUAddressableDisplayAllocator::Tag const*>(&type_tag))
+    {
+        return allocator.get();
+    }
+    return nullptr;
+}
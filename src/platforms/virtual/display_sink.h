@@ -0,0 +1,96 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_GRAPHICS_VIRT_DISPLAY_SINK_H_
+#define MIR_GRAPHICS_VIRT_DISPLAY_SINK_H_
+
+#include <mir/graphics/display_sink.h>
+#include <mir/graphics/display.h>
+#include <mir/graphics/display_configuration.h>
+#include <mir/graphics/frame.h>
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <optional>
+
+namespace mir
+{
+namespace graphics
+{
+class DisplayReport;
+
+namespace virt
+{
+
+/**
+ * An output with nothing to show its frames on
+ *
+ * Frames are composited into CPU memory, and "shown" on a simulated refresh
+ * clock running at the output's mode's refresh rate: post() returns at the
+ * next simulated vblank, as it would on real hardware.
+ */
+class DisplaySink : public graphics::DisplaySink,
+                    public graphics::DisplaySyncGroup
+{
+public:
+    DisplaySink(DisplayConfigurationOutput const& output, std::shared_ptr<DisplayReport> const& report);
+    ~DisplaySink() override;
+
+    auto view_area() const -> geometry::Rectangle override;
+    bool overlay(std::vector<DisplayElement> const& renderlist) override;
+    void set_next_image(std::unique_ptr<Framebuffer> content) override;
+    auto transformation() const -> glm::mat2 override;
+
+    void for_each_display_sink(std::function<void(graphics::DisplaySink&)> const& f) override;
+    void post() override;
+    auto recommended_sleep() const -> std::chrono::milliseconds override;
+    auto frame_budget() const -> std::optional<std::chrono::nanoseconds> override;
+    auto last_presentation() const -> std::optional<FramePresentation> override;
+
+    /// Whether \a output can be applied with set_placement(), rather than needing a new DisplaySink
+    auto has_mode_of(DisplayConfigurationOutput const& output) const -> bool;
+    /// Move the output in the virtual screen space, or rotate it
+    void set_placement(DisplayConfigurationOutput const& output);
+
+protected:
+    auto maybe_create_allocator(DisplayAllocator::Tag const& type_tag) -> DisplayAllocator* override;
+
+private:
+    class Allocator;
+
+    DisplayConfigurationOutputId const output_id;
+    geometry::Size const mode_size;
+    std::chrono::nanoseconds const refresh_period;
+    std::shared_ptr<DisplayReport> const report;
+    std::unique_ptr<Allocator> const allocator;
+
+    std::mutex mutable mutex;
+    geometry::Rectangle area;
+    glm::mat2 transform;
+
+    /// When the simulated refresh clock was started; vblank n happens refresh_period * n later
+    time::PosixTimestamp const clock_start;
+    std::unique_ptr<Framebuffer> next_image;
+    std::unique_ptr<Framebuffer> visible_image;
+    std::optional<FramePresentation> presentation;
+};
+
+}
+}
+}
+
+#endif // MIR_GRAPHICS_VIRT_DISPLAY_SINK_H_
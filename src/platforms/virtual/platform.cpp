@@ -22,11 +22,41 @@
 #include "options_parsing_helpers.h"
 #include <drm_fourcc.h>
 
+#include <boost/throw_exception.hpp>
+
+#include <algorithm>
+#include <optional>
+#include <stdexcept>
+
 namespace mg = mir::graphics;
 namespace mgv = mir::graphics::virt;
 namespace geom = mir::geometry;
 using namespace std::literals;
 
+namespace
+{
+auto parse_refresh_rate(std::string const& str) -> double
+{
+    try
+    {
+        size_t num_end = 0;
+        double const value = std::stod(str, &num_end);
+        if (num_end != str.size())
+            BOOST_THROW_EXCEPTION(std::runtime_error("Refresh rate \"" + str + "\" is not a valid number"));
+        if (value <= 0.0)
+            BOOST_THROW_EXCEPTION(std::runtime_error("Refresh rate must be greater than zero"));
+        return value;
+    }
+    catch (std::invalid_argument const&)
+    {
+        BOOST_THROW_EXCEPTION(std::runtime_error("Refresh rate \"" + str + "\" is not a valid number"));
+    }
+    catch (std::out_of_range const&)
+    {
+        BOOST_THROW_EXCEPTION(std::runtime_error("Refresh rate \"" + str + "\" is out of range"));
+    }
+}
+}
 
 mgv::Platform::Platform(
     std::shared_ptr<mg::DisplayReport> const& report,
@@ -44,7 +74,7 @@ mir::UniqueModulePtr<mg::Display> mgv::Platform::create_display(
     std::shared_ptr<DisplayConfigurationPolicy> const&,
     std::shared_ptr<GLConfig> const&)
 {
-    return mir::make_module_ptr<mgv::Display>(outputs);
+    return mir::make_module_ptr<mgv::Display>(outputs, report);
 }
 
 auto mgv::Platform::maybe_create_provider(DisplayProvider::Tag const& type_tag) -> std::shared_ptr<DisplayProvider>
@@ -62,15 +92,26 @@ auto mgv::Platform::parse_output_sizes(std::vector<std::string> virtual_outputs)
     for (auto const& output : virtual_outputs)
     {
         std::vector<geom::Size > sizes;
+        std::vector<std::optional<double>> rates;
         for (int start = 0, end; start - 1 < (int)output.size(); start = end + 1)
         {
             end = output.find(':', start);
             if (end == (int)std::string::npos)
                 end = output.size();
-            sizes.push_back(common::parse_size(output.substr(start, end - start)));
+            auto const mode = output.substr(start, end - start);
+            auto const at = mode.find('@'); // "@" between size and refresh rate
+            sizes.push_back(common::parse_size(mode.substr(0, at)));
+            rates.push_back(at == std::string::npos ? std::nullopt : std::optional{parse_refresh_rate(mode.substr(at + 1))});
+        }
+
+        std::vector<double> refresh_rates;
+        if (std::any_of(rates.begin(), rates.end(), [](auto const& rate) { return rate.has_value(); }))
+        {
+            for (auto const& rate : rates)
+                refresh_rates.push_back(rate.value_or(VirtualOutputConfig::default_refresh_rate));
         }
 
-        configs.push_back(VirtualOutputConfig(std::move(sizes)));
+        configs.push_back(VirtualOutputConfig(std::move(sizes), std::move(refresh_rates)));
     }
     return configs;
 }
\ No newline at end of file
@@ -31,16 +31,28 @@ namespace virt
 
 struct VirtualOutputConfig
 {
-    VirtualOutputConfig(std::vector<geometry::Size> sizes)
-        : sizes{sizes}
+    VirtualOutputConfig(std::vector<geometry::Size> sizes, std::vector<double> refresh_rates = {})
+        : sizes{sizes},
+          refresh_rates{refresh_rates}
     {
     }
 
     bool operator==(VirtualOutputConfig const& output) const
     {
-        return sizes == output.sizes;
+        return sizes == output.sizes && refresh_rates == output.refresh_rates;
     }
+
+    /// The refresh rate, in Hz, of the mode with the size sizes[mode]
+    auto refresh_rate(size_t mode) const -> double
+    {
+        return mode < refresh_rates.size() ? refresh_rates[mode] : default_refresh_rate;
+    }
+
+    static double constexpr default_refresh_rate{60.0};
+
     std::vector<geometry::Size> sizes;
+    /// Refresh rates of the corresponding sizes; sizes without one refresh at default_refresh_rate
+    std::vector<double> refresh_rates;
 };
 
 class Platform : public graphics::DisplayPlatform
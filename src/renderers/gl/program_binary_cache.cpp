@@ -0,0 +1,220 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define MIR_LOG_COMPONENT "GLRenderer"
+
+#include "program_binary_cache.h"
+
+#include "mir/fd.h"
+#include "mir/log.h"
+
+#include <cerrno>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <sstream>
+
+#include <stdlib.h>
+#include <unistd.h>
+
+namespace mrg = mir::renderer::gl;
+namespace fs = std::filesystem;
+
+namespace
+{
+/*
+ * File layout, in native byte order:
+ *   magic
+ *   uint32_t key length, key
+ *   uint32_t binary format
+ *   uint64_t binary length, binary
+ */
+char const magic[] = "mir-program-binary-1";
+
+template<typename T>
+auto read_value(std::istream& in) -> std::optional<T>
+{
+    T value;
+    if (!in.read(reinterpret_cast<char*>(&value), sizeof value))
+        return std::nullopt;
+    return value;
+}
+
+template<typename T>
+void write_value(std::ostream& out, T value)
+{
+    out.write(reinterpret_cast<char const*>(&value), sizeof value);
+}
+
+/// The binary stored in `in` for key, if that's what it holds
+auto read_binary(std::istream& in, std::string const& key) -> std::optional<mrg::ProgramBinaryCache::Binary>
+{
+    char file_magic[sizeof magic];
+    if (!in.read(file_magic, sizeof file_magic) || std::string{file_magic, sizeof file_magic} != std::string{magic, sizeof magic})
+    {
+        return std::nullopt;
+    }
+
+    auto const key_length = read_value<uint32_t>(in);
+    if (!key_length || *key_length != key.size())
+    {
+        return std::nullopt;
+    }
+    std::string file_key(*key_length, '\0');
+    if (!in.read(file_key.data(), file_key.size()) || file_key != key)
+    {
+        return std::nullopt;
+    }
+
+    auto const format = read_value<uint32_t>(in);
+    auto const length = read_value<uint64_t>(in);
+    if (!format || !length)
+    {
+        return std::nullopt;
+    }
+
+    // The binary runs to the end of the file; don't trust a length that says otherwise
+    auto const start = in.tellg();
+    if (!in.seekg(0, std::ios::end))
+    {
+        return std::nullopt;
+    }
+    auto const remaining = static_cast<uint64_t>(in.tellg() - start);
+    if (*length != remaining || !in.seekg(start))
+    {
+        return std::nullopt;
+    }
+
+    mrg::ProgramBinaryCache::Binary binary{*format, std::vector<char>(*length)};
+    if (!in.read(binary.data.data(), binary.data.size()))
+    {
+        return std::nullopt;
+    }
+    return binary;
+}
+
+auto write_all(int fd, std::string const& contents) -> bool
+{
+    auto remaining = contents.size();
+    auto data = contents.data();
+    while (remaining > 0)
+    {
+        auto const written = write(fd, data, remaining);
+        if (written < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+        data += written;
+        remaining -= written;
+    }
+    return true;
+}
+}
+
+mrg::ProgramBinaryCache::ProgramBinaryCache(fs::path directory)
+    : directory{std::move(directory)}
+{
+    std::error_code error;
+    fs::create_directories(this->directory, error);
+    if (error)
+    {
+        mir::log_debug("Failed to create shader cache directory %s: %s",
+                       this->directory.c_str(), error.message().c_str());
+    }
+}
+
+auto mrg::ProgramBinaryCache::default_directory() -> std::optional<fs::path>
+{
+    if (auto const cache_home = getenv("XDG_CACHE_HOME"))
+    {
+        return fs::path{cache_home} / "mir" / "shaders";
+    }
+    if (auto const home = getenv("HOME"))
+    {
+        return fs::path{home} / ".cache" / "mir" / "shaders";
+    }
+    return std::nullopt;
+}
+
+auto mrg::ProgramBinaryCache::path_for(std::string const& key) const -> fs::path
+{
+    // The key is checked on load, so a collision only costs a recompile
+    std::ostringstream name;
+    name << std::hex << std::setw(16) << std::setfill('0') << std::hash<std::string>{}(key) << ".bin";
+    return directory / name.str();
+}
+
+auto mrg::ProgramBinaryCache::load(std::string const& key) const -> std::optional<Binary>
+{
+    auto const path = path_for(key);
+    std::ifstream in{path, std::ios::binary};
+    if (!in)
+    {
+        return std::nullopt;
+    }
+
+    auto binary = read_binary(in, key);
+    if (!binary)
+    {
+        // Corrupt, or left by a colliding key; either way it's no use, so don't keep reading it
+        in.close();
+        std::error_code ignored;
+        fs::remove(path, ignored);
+    }
+    return binary;
+}
+
+void mrg::ProgramBinaryCache::store(std::string const& key, Binary const& binary) const
+{
+    auto const path = path_for(key);
+
+    // Write to a temporary file and rename it into place, so readers never see a partial binary
+    auto temporary = (path.string() + ".XXXXXX");
+    mir::Fd const fd{mkstemp(temporary.data())};
+    if (fd < 0)
+    {
+        mir::log_debug("Failed to create shader cache file in %s", directory.c_str());
+        return;
+    }
+
+    std::ostringstream out;
+    out.write(magic, sizeof magic);
+    write_value<uint32_t>(out, key.size());
+    out.write(key.data(), key.size());
+    write_value<uint32_t>(out, binary.format);
+    write_value<uint64_t>(out, binary.data.size());
+    out.write(binary.data.data(), binary.data.size());
+
+    // Through the descriptor mkstemp() opened, so we can't write to anything else that took the name since
+    if (!write_all(fd, out.str()))
+    {
+        mir::log_debug("Failed to write shader cache file %s", temporary.c_str());
+        std::error_code ignored;
+        fs::remove(temporary, ignored);
+        return;
+    }
+
+    std::error_code error;
+    fs::rename(temporary, path, error);
+    if (error)
+    {
+        mir::log_debug("Failed to update shader cache file %s: %s", path.c_str(), error.message().c_str());
+        fs::remove(temporary, error);
+    }
+}
@@ -0,0 +1,71 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_RENDERER_GL_PROGRAM_BINARY_CACHE_H_
+#define MIR_RENDERER_GL_PROGRAM_BINARY_CACHE_H_
+
+#include <GLES2/gl2.h>
+
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace mir
+{
+namespace renderer
+{
+namespace gl
+{
+
+/**
+ * Linked GL programs, as returned by glGetProgramBinaryOES(), saved on disk
+ *
+ * Each binary is stored under a key that must identify everything it depends
+ * on: the driver and its version as well as the shader sources. A binary is
+ * only returned for exactly the key it was stored with.
+ */
+class ProgramBinaryCache
+{
+public:
+    struct Binary
+    {
+        GLenum format;
+        std::vector<char> data;
+    };
+
+    /// \param directory    Where to keep the binaries; this is created if it doesn't exist
+    explicit ProgramBinaryCache(std::filesystem::path directory);
+
+    /// $XDG_CACHE_HOME/mir/shaders, or ~/.cache/mir/shaders; nullopt if neither variable is set
+    static auto default_directory() -> std::optional<std::filesystem::path>;
+
+    /// A file that doesn't hold a valid binary for key is removed
+    auto load(std::string const& key) const -> std::optional<Binary>;
+    /// Failure to store is not an error; the program will just be compiled again next time
+    void store(std::string const& key, Binary const& binary) const;
+
+private:
+    auto path_for(std::string const& key) const -> std::filesystem::path;
+
+    std::filesystem::path const directory;
+};
+
+}
+}
+}
+
+#endif // MIR_RENDERER_GL_PROGRAM_BINARY_CACHE_H_
@@ -16,6 +16,7 @@
 #define MIR_LOG_COMPONENT "GLRenderer"
 
 #include "renderer.h"
+#include "program_binary_cache.h"
 #include "mir/compositor/buffer_stream.h"
 #include "mir/graphics/renderable.h"
 #include "mir/graphics/buffer.h"
@@ -34,11 +35,17 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <EGL/egl.h>
+#include <GLES2/gl2ext.h>
 
 #include <boost/throw_exception.hpp>
+#include <array>
 #include <stdexcept>
 #include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <limits>
 #include <sstream>
+#include <utility>
 #include <mutex>
 
 namespace mg = mir::graphics;
@@ -123,7 +130,7 @@ class mrg::Renderer::ProgramFactory : public mir::graphics::gl::ProgramFactory
 public:
     // NOTE: This must be called with a current GL context
     ProgramFactory()
-        : vertex_shader{compile_shader(GL_VERTEX_SHADER, vertex_shader_src)}
+        : binaries{ProgramBinaries::create()}
     {
     }
 
@@ -183,22 +190,153 @@ public:
         // GL shader compilation is *not* threadsafe, and requires external synchronisation
         std::lock_guard lock{compilation_mutex};
 
-        ShaderHandle const opaque_shader{
-            compile_shader(GL_FRAGMENT_SHADER, opaque_fragment.str().c_str())};
-        ShaderHandle const alpha_shader{
-            compile_shader(GL_FRAGMENT_SHADER, alpha_fragment.str().c_str())};
+        auto opaque_program = load_or_link(opaque_fragment.str());
+        auto alpha_program = load_or_link(alpha_fragment.str());
 
         programs.emplace_back(id, std::make_unique<::Program>(
-            link_shader(vertex_shader, opaque_shader),
-            link_shader(vertex_shader, alpha_shader)));
+            std::move(opaque_program),
+            std::move(alpha_program)));
 
         return *programs.back().second;
-
-        // We delete opaque_shader and alpha_shader here. This is fine; it only marks them
-        // for deletion. GL will only delete them once the GL Program they're linked in is destroyed.
     }
 
 private:
+    /**
+     * Linked programs saved to (and restored from) disk with GL_OES_get_program_binary
+     *
+     * Binaries are only valid for the driver that produced them, so they are keyed
+     * by the GL vendor, renderer and version strings as well as the shader sources.
+     */
+    class ProgramBinaries
+    {
+    public:
+        // NOTE: This must be called with a current GL context
+        static auto create() -> std::unique_ptr<ProgramBinaries>
+        {
+            auto const extensions = reinterpret_cast<char const*>(glGetString(GL_EXTENSIONS));
+            if (!extensions || !strstr(extensions, "GL_OES_get_program_binary"))
+            {
+                return nullptr;
+            }
+
+            GLint formats{0};
+            glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS_OES, &formats);
+            auto const get_program_binary = reinterpret_cast<PFNGLGETPROGRAMBINARYOESPROC>(
+                eglGetProcAddress("glGetProgramBinaryOES"));
+            auto const program_binary = reinterpret_cast<PFNGLPROGRAMBINARYOESPROC>(
+                eglGetProcAddress("glProgramBinaryOES"));
+            auto const directory = ProgramBinaryCache::default_directory();
+            if (formats <= 0 || !get_program_binary || !program_binary || !directory)
+            {
+                return nullptr;
+            }
+
+            std::string driver;
+            for (auto const name : {GL_VENDOR, GL_RENDERER, GL_VERSION, GL_SHADING_LANGUAGE_VERSION})
+            {
+                auto const value = reinterpret_cast<char const*>(glGetString(name));
+                driver += value ? value : "";
+                driver += '\n';
+            }
+
+            return std::unique_ptr<ProgramBinaries>{
+                new ProgramBinaries{*directory, std::move(driver), get_program_binary, program_binary}};
+        }
+
+        auto key_for(std::string const& fragment_src) const -> std::string
+        {
+            return driver + vertex_shader_src + fragment_src;
+        }
+
+        /// The program stored under \a key, or nullopt if there is none or the driver rejects it
+        auto load(std::string const& key) const -> std::optional<ProgramHandle>
+        {
+            auto const binary = cache.load(key);
+            if (!binary)
+            {
+                return std::nullopt;
+            }
+
+            ProgramHandle program{glCreateProgram()};
+            program_binary(program, binary->format, binary->data.data(), static_cast<GLint>(binary->data.size()));
+            GLint ok;
+            glGetProgramiv(program, GL_LINK_STATUS, &ok);
+            if (!ok)
+            {
+                // Most likely a driver update the version strings didn't reflect
+                mir::log_debug("Cached GL program binary rejected; recompiling");
+                return std::nullopt;
+            }
+            return program;
+        }
+
+        void store(std::string const& key, GLuint program) const
+        {
+            GLint length{0};
+            glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH_OES, &length);
+            if (length <= 0)
+            {
+                return;
+            }
+
+            ProgramBinaryCache::Binary binary{0, std::vector<char>(length)};
+            GLsizei written{0};
+            get_program_binary(program, length, &written, &binary.format, binary.data.data());
+            if (written <= 0)
+            {
+                return;
+            }
+            binary.data.resize(written);
+            cache.store(key, binary);
+        }
+
+    private:
+        ProgramBinaries(
+            std::filesystem::path const& directory,
+            std::string driver,
+            PFNGLGETPROGRAMBINARYOESPROC get_program_binary,
+            PFNGLPROGRAMBINARYOESPROC program_binary)
+            : cache{directory},
+              driver{std::move(driver)},
+              get_program_binary{get_program_binary},
+              program_binary{program_binary}
+        {
+        }
+
+        ProgramBinaryCache const cache;
+        std::string const driver;
+        PFNGLGETPROGRAMBINARYOESPROC const get_program_binary;
+        PFNGLPROGRAMBINARYOESPROC const program_binary;
+    };
+
+    // NOTE: This must be called with compilation_mutex held
+    auto load_or_link(std::string const& fragment_src) -> ProgramHandle
+    {
+        auto const key = binaries ? binaries->key_for(fragment_src) : std::string{};
+        if (binaries)
+        {
+            if (auto program = binaries->load(key))
+            {
+                return std::move(*program);
+            }
+        }
+
+        if (!vertex_shader)
+        {
+            vertex_shader.emplace(compile_shader(GL_VERTEX_SHADER, vertex_shader_src));
+        }
+        ShaderHandle const fragment_shader{compile_shader(GL_FRAGMENT_SHADER, fragment_src.c_str())};
+        auto program = link_shader(*vertex_shader, fragment_shader);
+        if (binaries)
+        {
+            binaries->store(key, program);
+        }
+        return program;
+
+        // We delete fragment_shader here. This is fine; it only marks it for deletion.
+        // GL will only delete it once the GL Program it's linked in is destroyed.
+    }
+
     static GLuint compile_shader(GLenum type, GLchar const* src)
     {
         GLuint id = glCreateShader(type);
@@ -246,12 +384,149 @@ private:
         return program;
     }
 
-    ShaderHandle const vertex_shader;
+    std::unique_ptr<ProgramBinaries> const binaries;
+    /// Only compiled once a program isn't found in the binary cache
+    std::optional<ShaderHandle> vertex_shader;
     std::vector<std::pair<void const*, std::unique_ptr<::Program>>> programs;
     // GL requires us to synchronise multi-threaded access to the shader APIs.
     std::mutex compilation_mutex;
 };
 
+/**
+ * Times each frame on the GPU with GL_EXT_disjoint_timer_query
+ *
+ * Results become available a frame or more after the frame is submitted, so
+ * queries are recycled from a small pool; frames are simply not timed while
+ * every query is still waiting on the GPU.
+ *
+ * Timing is always on where the extension is available: it costs a query
+ * begin/end per frame and a non-blocking poll for the oldest result, which
+ * isn't worth an option to avoid.
+ */
+class mrg::Renderer::GPUTimer
+{
+public:
+    // NOTE: This must be called with a current GL context
+    static auto create() -> std::unique_ptr<GPUTimer>
+    {
+        auto const extensions = reinterpret_cast<char const*>(glGetString(GL_EXTENSIONS));
+        if (!extensions || !strstr(extensions, "GL_EXT_disjoint_timer_query"))
+        {
+            return nullptr;
+        }
+
+        auto const gen_queries = reinterpret_cast<PFNGLGENQUERIESEXTPROC>(
+            eglGetProcAddress("glGenQueriesEXT"));
+        auto const delete_queries = reinterpret_cast<PFNGLDELETEQUERIESEXTPROC>(
+            eglGetProcAddress("glDeleteQueriesEXT"));
+        auto const begin_query = reinterpret_cast<PFNGLBEGINQUERYEXTPROC>(
+            eglGetProcAddress("glBeginQueryEXT"));
+        auto const end_query = reinterpret_cast<PFNGLENDQUERYEXTPROC>(
+            eglGetProcAddress("glEndQueryEXT"));
+        auto const get_query_object_uiv = reinterpret_cast<PFNGLGETQUERYOBJECTUIVEXTPROC>(
+            eglGetProcAddress("glGetQueryObjectuivEXT"));
+        auto const get_query_object_ui64v = reinterpret_cast<PFNGLGETQUERYOBJECTUI64VEXTPROC>(
+            eglGetProcAddress("glGetQueryObjectui64vEXT"));
+        if (!gen_queries || !delete_queries || !begin_query || !end_query ||
+            !get_query_object_uiv || !get_query_object_ui64v)
+        {
+            return nullptr;
+        }
+
+        return std::unique_ptr<GPUTimer>{new GPUTimer{
+            gen_queries, delete_queries, begin_query, end_query, get_query_object_uiv, get_query_object_ui64v}};
+    }
+
+    ~GPUTimer()
+    {
+        delete_queries(queries.size(), queries.data());
+    }
+
+    /// Collect the result of the oldest frame if the GPU has finished it, then start timing a new one
+    void begin_frame()
+    {
+        if (!pending.empty())
+        {
+            GLuint available{GL_FALSE};
+            get_query_object_uiv(pending.front(), GL_QUERY_RESULT_AVAILABLE_EXT, &available);
+            if (available)
+            {
+                GLuint64 elapsed_ns{0};
+                get_query_object_ui64v(pending.front(), GL_QUERY_RESULT_EXT, &elapsed_ns);
+
+                // A disjoint event (such as a GPU frequency change) makes all pending results meaningless
+                GLint disjoint{GL_FALSE};
+                glGetIntegerv(GL_GPU_DISJOINT_EXT, &disjoint);
+                if (disjoint)
+                {
+                    idle.insert(idle.end(), pending.begin(), pending.end());
+                    pending.clear();
+                }
+                else
+                {
+                    completed = std::chrono::nanoseconds{elapsed_ns};
+                    idle.push_back(pending.front());
+                    pending.pop_front();
+                }
+            }
+        }
+
+        if (!idle.empty())
+        {
+            active = idle.back();
+            idle.pop_back();
+            begin_query(GL_TIME_ELAPSED_EXT, *active);
+        }
+    }
+
+    void end_frame()
+    {
+        if (active)
+        {
+            end_query(GL_TIME_ELAPSED_EXT);
+            pending.push_back(*active);
+            active.reset();
+        }
+    }
+
+    auto take_completed() -> std::optional<std::chrono::nanoseconds>
+    {
+        return std::exchange(completed, std::nullopt);
+    }
+
+private:
+    GPUTimer(
+        PFNGLGENQUERIESEXTPROC gen_queries,
+        PFNGLDELETEQUERIESEXTPROC delete_queries,
+        PFNGLBEGINQUERYEXTPROC begin_query,
+        PFNGLENDQUERYEXTPROC end_query,
+        PFNGLGETQUERYOBJECTUIVEXTPROC get_query_object_uiv,
+        PFNGLGETQUERYOBJECTUI64VEXTPROC get_query_object_ui64v)
+        : delete_queries{delete_queries},
+          begin_query{begin_query},
+          end_query{end_query},
+          get_query_object_uiv{get_query_object_uiv},
+          get_query_object_ui64v{get_query_object_ui64v}
+    {
+        gen_queries(queries.size(), queries.data());
+        idle.assign(queries.begin(), queries.end());
+    }
+
+    PFNGLDELETEQUERIESEXTPROC const delete_queries;
+    PFNGLBEGINQUERYEXTPROC const begin_query;
+    PFNGLENDQUERYEXTPROC const end_query;
+    PFNGLGETQUERYOBJECTUIVEXTPROC const get_query_object_uiv;
+    PFNGLGETQUERYOBJECTUI64VEXTPROC const get_query_object_ui64v;
+
+    /// Enough for the frames a driver typically queues, plus the one being rendered
+    std::array<GLuint, 4> queries;
+    std::vector<GLuint> idle;
+    /// Ended, but not yet read back; oldest first
+    std::deque<GLuint> pending;
+    std::optional<GLuint> active;
+    std::optional<std::chrono::nanoseconds> completed;
+};
+
 mrg::Renderer::Program::Program(GLuint program_id)
 {
     id = program_id;
@@ -287,6 +562,7 @@ mrg::Renderer::Renderer(
     : output_surface{make_output_current(std::move(output))},
       clear_color{0.0f, 0.0f, 0.0f, 1.0f},
       program_factory{std::make_unique<ProgramFactory>()},
+      gpu_timer{GPUTimer::create()},
       display_transform(1),
       gl_interface{std::move(gl_interface)}
 {
@@ -337,11 +613,16 @@ mrg::Renderer::Renderer(
     mir::log_info("GL framebuffer bits: RGBA=%d%d%d%d, depth=%d, stencil=%d",
                   rbits, gbits, bbits, abits, dbits, sbits);
 
+    glGenBuffers(1, &vertex_buffer);
     glBindBuffer(GL_ARRAY_BUFFER, 0);
 }
 
 mrg::Renderer::~Renderer()
 {
+    if (vertex_buffer)
+    {
+        glDeleteBuffers(1, &vertex_buffer);
+    }
 }
 
 void mrg::Renderer::tessellate(std::vector<mgl::Primitive>& primitives,
@@ -356,16 +637,93 @@ auto mrg::Renderer::render(mg::RenderableList const& renderables) const -> std::
     output_surface->make_current();
     output_surface->bind();
 
+    if (gpu_timer)
+    {
+        gpu_timer->begin_frame();
+    }
+
+    auto const repaint_area = area_to_repaint();
+    if (repaint_area)
+    {
+        damage_scissor = to_window_coords(*repaint_area);
+        glEnable(GL_SCISSOR_TEST);
+        glScissor(
+            damage_scissor->top_left.x.as_int(),
+            damage_scissor->top_left.y.as_int(),
+            damage_scissor->size.width.as_int(),
+            damage_scissor->size.height.as_int());
+    }
+    else
+    {
+        damage_scissor.reset();
+    }
+
     glClearColor(clear_color[0], clear_color[1], clear_color[2], clear_color[3]);
     glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
     glClear(GL_COLOR_BUFFER_BIT);
 
     ++frameno;
+    current_program = nullptr;
+    current_blend.reset();
+
+    batches.clear();
+    frame_primitives.clear();
+    frame_vertices.clear();
     for (auto const& r : renderables)
     {
-        draw(*r);
+        if (repaint_area && !repaint_area->overlaps(r->screen_position()))
+        {
+            // Nothing this renderable covers needs repainting
+            continue;
+        }
+
+        primitives.clear();
+        tessellate(primitives, *r);
+        batches.push_back({r.get(), frame_primitives.size(), primitives.size(), static_cast<GLint>(frame_vertices.size())});
+        for (auto const& p : primitives)
+        {
+            frame_primitives.push_back(p);
+            frame_vertices.insert(frame_vertices.end(), p.vertices, p.vertices + p.nvertices);
+        }
+    }
+
+    if (!frame_vertices.empty())
+    {
+        // Respecifying the whole buffer lets the driver allocate new storage rather than wait for last frame's draws
+        glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer);
+        glBufferData(
+            GL_ARRAY_BUFFER,
+            frame_vertices.size() * sizeof(mgl::Vertex),
+            frame_vertices.data(),
+            GL_STREAM_DRAW);
+    }
+
+    for (auto const& batch : batches)
+    {
+        draw(
+            *batch.renderable,
+            std::span{frame_primitives}.subspan(batch.first_primitive, batch.primitive_count),
+            batch.first_vertex);
+    }
+
+    if (current_program)
+    {
+        glDisableVertexAttribArray(current_program->texcoord_attr);
+        glDisableVertexAttribArray(current_program->position_attr);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    if (damage_scissor)
+    {
+        glDisable(GL_SCISSOR_TEST);
+    }
+
+    if (gpu_timer)
+    {
+        gpu_timer->end_frame();
     }
 
+    output_surface->set_damage(damage_scissor);
     auto output = output_surface->commit();
 
     // Report any GL errors after commit, to catch any *during* commit
@@ -375,22 +733,35 @@ auto mrg::Renderer::render(mg::RenderableList const& renderables) const -> std::
     return output;
 }
 
-void mrg::Renderer::draw(mg::Renderable const& renderable) const
+void mrg::Renderer::draw(
+    mg::Renderable const& renderable,
+    std::span<mgl::Primitive const> primitives,
+    GLint first_vertex) const
 {
     auto const clip_area = renderable.clip_area();
     if (clip_area)
     {
-        glEnable(GL_SCISSOR_TEST);
-        glScissor(
-            clip_area.value().top_left.x.as_int() -
+        geom::Rectangle scissor{
+            {clip_area.value().top_left.x.as_int() -
                 viewport.top_left.x.as_int(),
-            viewport.top_left.y.as_int() +
+             viewport.top_left.y.as_int() +
                 viewport.size.height.as_int() -
                 clip_area.value().top_left.y.as_int() -
-                clip_area.value().size.height.as_int(),
-            clip_area.value().size.width.as_int(), 
-            clip_area.value().size.height.as_int()
-        );
+                clip_area.value().size.height.as_int()},
+            clip_area.value().size};
+
+        if (damage_scissor)
+        {
+            // We must not draw outside the damaged area, either
+            scissor = intersection_of(scissor, *damage_scissor);
+        }
+
+        glEnable(GL_SCISSOR_TEST);
+        glScissor(
+            scissor.top_left.x.as_int(),
+            scissor.top_left.y.as_int(),
+            scissor.size.width.as_int(),
+            scissor.size.height.as_int());
     }
 
     auto const texture = gl_interface->as_texture(renderable.buffer());
@@ -408,23 +779,7 @@ void mrg::Renderer::draw(mg::Renderable const& renderable) const
                 return &family.opaque;
         }(renderable.alpha() < 1.0f);
 
-    glUseProgram(prog->id);
-    if (prog->last_used_frameno != frameno)
-    {   // Avoid reloading the screen-global uniforms on every renderable
-        // TODO: We actually only need to bind these *once*, right? Not once per frame?
-        prog->last_used_frameno = frameno;
-        for (auto i = 0u; i < prog->tex_uniforms.size(); ++i)
-        {
-            if (prog->tex_uniforms[i] != -1)
-            {
-                glUniform1i(prog->tex_uniforms[i], i);
-            }
-        }
-        glUniformMatrix4fv(prog->display_transform_uniform, 1, GL_FALSE,
-                           glm::value_ptr(display_transform));
-        glUniformMatrix4fv(prog->screen_to_gl_coords_uniform, 1, GL_FALSE,
-                           glm::value_ptr(screen_to_gl_coords));
-    }
+    use_program(*prog);
 
     glActiveTexture(GL_TEXTURE0);
 
@@ -448,90 +803,235 @@ void mrg::Renderer::draw(mg::Renderable const& renderable) const
         };
     }
 
-    glUniformMatrix4fv(prog->transform_uniform, 1, GL_FALSE,
-                       glm::value_ptr(transform));
+    // Most renderables share a transformation, so it rarely needs uploading again
+    if (prog->transform_value != transform)
+    {
+        prog->transform_value = transform;
+        glUniformMatrix4fv(prog->transform_uniform, 1, GL_FALSE,
+                           glm::value_ptr(transform));
+    }
 
-    if (prog->alpha_uniform >= 0)
+    if (prog->alpha_uniform >= 0 && prog->alpha_value != renderable.alpha())
+    {
+        prog->alpha_value = renderable.alpha();
         glUniform1f(prog->alpha_uniform, renderable.alpha());
-
-    glEnableVertexAttribArray(prog->position_attr);
-    glEnableVertexAttribArray(prog->texcoord_attr);
-
-    primitives.clear();
-    tessellate(primitives, renderable);
+    }
 
     // if we fail to load the texture, we need to carry on (part of lp:1629275)
     try
     {
-        typedef struct  // Represents parameters of glBlendFuncSeparate()
-        {
-            GLenum src_rgb, dst_rgb, src_alpha, dst_alpha;
-        } BlendSeparate;
-
-        BlendSeparate client_blend;
-
         // These renderable method names could be better (see LP: #1236224)
         if (renderable.shaped())  // Client is RGBA:
         {
-            client_blend = {GL_ONE, GL_ONE_MINUS_SRC_ALPHA,
-                            GL_ONE, GL_ONE_MINUS_SRC_ALPHA};
+            set_blend_state({GL_ONE, GL_ONE_MINUS_SRC_ALPHA,
+                             GL_ONE, GL_ONE_MINUS_SRC_ALPHA, 1.0f});
         }
         else if (renderable.alpha() == 1.0f)  // RGBX and no window translucency:
         {
-            client_blend = {GL_ONE,  GL_ZERO,
-                            GL_ZERO, GL_ONE};  // Avoid using src_alpha!
+            set_blend_state({GL_ONE,  GL_ZERO,
+                             GL_ZERO, GL_ONE, 1.0f});  // Avoid using src_alpha!
         }
         else
         {   // Client is RGBX but we also have window translucency.
             // The texture alpha channel is possibly uninitialized so we must be
             // careful and avoid using SRC_ALPHA (LP: #1423462).
-            client_blend = {GL_ONE,  GL_ONE_MINUS_CONSTANT_ALPHA,
-                            GL_ZERO, GL_ONE};
-            glBlendColor(0.0f, 0.0f, 0.0f, renderable.alpha());
+            set_blend_state({GL_ONE,  GL_ONE_MINUS_CONSTANT_ALPHA,
+                             GL_ZERO, GL_ONE, renderable.alpha()});
         }
 
+        texture->bind();
+
         for (auto const& p : primitives)
         {
-            BlendSeparate blend;
+            glDrawArrays(p.type, first_vertex, p.nvertices);
+            first_vertex += p.nvertices;
+        }
 
-            blend = client_blend;
-            texture->bind();
+        // We're done with the texture for now
+        texture->add_syncpoint();
+    }
+    catch (std::exception const& ex)
+    {
+        report_exception();
+    }
 
-            glVertexAttribPointer(prog->position_attr, 3, GL_FLOAT,
-                                  GL_FALSE, sizeof(mgl::Vertex),
-                                  &p.vertices[0].position);
-            glVertexAttribPointer(prog->texcoord_attr, 2, GL_FLOAT,
-                                  GL_FALSE, sizeof(mgl::Vertex),
-                                  &p.vertices[0].texcoord);
+    if (renderable.clip_area())
+    {
+        if (damage_scissor)
+        {
+            glScissor(
+                damage_scissor->top_left.x.as_int(),
+                damage_scissor->top_left.y.as_int(),
+                damage_scissor->size.width.as_int(),
+                damage_scissor->size.height.as_int());
+        }
+        else
+        {
+            glDisable(GL_SCISSOR_TEST);
+        }
+    }
+}
 
-            if (blend.dst_rgb == GL_ZERO)
-            {
-                glDisable(GL_BLEND);
-            }
-            else
+void mrg::Renderer::use_program(Program const& prog) const
+{
+    if (&prog == current_program)
+    {
+        return;
+    }
+
+    if (current_program)
+    {
+        glDisableVertexAttribArray(current_program->texcoord_attr);
+        glDisableVertexAttribArray(current_program->position_attr);
+    }
+
+    glUseProgram(prog.id);
+    if (prog.last_used_frameno != frameno)
+    {   // Avoid reloading the screen-global uniforms on every renderable
+        // TODO: We actually only need to bind these *once*, right? Not once per frame?
+        prog.last_used_frameno = frameno;
+        for (auto i = 0u; i < prog.tex_uniforms.size(); ++i)
+        {
+            if (prog.tex_uniforms[i] != -1)
             {
-                glEnable(GL_BLEND);
-                glBlendFuncSeparate(blend.src_rgb,   blend.dst_rgb,
-                                    blend.src_alpha, blend.dst_alpha);
+                glUniform1i(prog.tex_uniforms[i], i);
             }
+        }
+        glUniformMatrix4fv(prog.display_transform_uniform, 1, GL_FALSE,
+                           glm::value_ptr(display_transform));
+        glUniformMatrix4fv(prog.screen_to_gl_coords_uniform, 1, GL_FALSE,
+                           glm::value_ptr(screen_to_gl_coords));
+        prog.transform_value.reset();
+        prog.alpha_value.reset();
+    }
+
+    glEnableVertexAttribArray(prog.position_attr);
+    glEnableVertexAttribArray(prog.texcoord_attr);
+    glVertexAttribPointer(prog.position_attr, 3, GL_FLOAT,
+                          GL_FALSE, sizeof(mgl::Vertex),
+                          reinterpret_cast<GLvoid const*>(offsetof(mgl::Vertex, position)));
+    glVertexAttribPointer(prog.texcoord_attr, 2, GL_FLOAT,
+                          GL_FALSE, sizeof(mgl::Vertex),
+                          reinterpret_cast<GLvoid const*>(offsetof(mgl::Vertex, texcoord)));
+
+    current_program = &prog;
+}
 
-            glDrawArrays(p.type, 0, p.nvertices);
+void mrg::Renderer::set_blend_state(BlendState const& blend) const
+{
+    if (blend == current_blend)
+    {
+        return;
+    }
 
-            // We're done with the texture for now
-            texture->add_syncpoint();
+    if (blend.dst_rgb == GL_ZERO)
+    {
+        if (!current_blend || current_blend->dst_rgb != GL_ZERO)
+        {
+            glDisable(GL_BLEND);
         }
     }
-    catch (std::exception const& ex)
+    else
     {
-        report_exception();
+        if (!current_blend || current_blend->dst_rgb == GL_ZERO)
+        {
+            glEnable(GL_BLEND);
+        }
+        glBlendFuncSeparate(blend.src_rgb,   blend.dst_rgb,
+                            blend.src_alpha, blend.dst_alpha);
+        if (blend.dst_rgb == GL_ONE_MINUS_CONSTANT_ALPHA)
+        {
+            glBlendColor(0.0f, 0.0f, 0.0f, blend.constant_alpha);
+        }
     }
 
-    glDisableVertexAttribArray(prog->texcoord_attr);
-    glDisableVertexAttribArray(prog->position_attr);
-    if (renderable.clip_area())
+    current_blend = blend;
+}
+
+void mrg::Renderer::set_damage(geom::Rectangles const& damage)
+{
+    pending_damage = damage;
+}
+
+auto mrg::Renderer::area_to_repaint() const -> std::optional<geom::Rectangle>
+{
+    /* Enough to cover triple-buffering plus one frame in flight; anything
+     * older than this gets a full repaint.
+     */
+    size_t const max_tracked_age = 4;
+
+    std::optional<geom::Rectangles> damage;
+    std::swap(damage, pending_damage);
+
+    /* A full repaint (say, for a new output transform) leaves every older buffer
+     * out of date too, so it has to be recorded as damaging the whole viewport.
+     */
+    auto const full_repaint = std::exchange(full_repaint_required, false);
+    damage_history.push_front(damage && !full_repaint ? *damage : geom::Rectangles{viewport});
+    if (damage_history.size() > max_tracked_age)
     {
-        glDisable(GL_SCISSOR_TEST);
+        damage_history.pop_back();
+    }
+
+    if (!damage || full_repaint)
+    {
+        return std::nullopt;
     }
+
+    /* The back buffer holds the frame from buffer_age() frames ago, so to bring it up
+     * to date we need to repaint everything damaged since then, as well as this frame's
+     * damage.
+     */
+    auto const age = output_surface->buffer_age();
+    if (age <= 0 || static_cast<size_t>(age) > damage_history.size())
+    {
+        return std::nullopt;
+    }
+
+    geom::Rectangles accumulated;
+    for (auto i = 0; i < age; ++i)
+    {
+        for (auto const& rect : damage_history[i])
+        {
+            accumulated.add(rect);
+        }
+    }
+
+    auto const area = intersection_of(accumulated.bounding_rectangle(), viewport);
+    if (area == viewport)
+    {
+        return std::nullopt;
+    }
+    return area;
+}
+
+auto mrg::Renderer::to_window_coords(geom::Rectangle const& area) const -> geom::Rectangle
+{
+    auto const to_clip_coords = display_transform * screen_to_gl_coords;
+
+    float left{std::numeric_limits<float>::max()}, bottom{std::numeric_limits<float>::max()};
+    float right{std::numeric_limits<float>::lowest()}, top{std::numeric_limits<float>::lowest()};
+    for (auto const& corner : {area.top_left, area.top_right(), area.bottom_left(), area.bottom_right()})
+    {
+        auto const clip = to_clip_coords * glm::vec4{corner.x.as_int(), corner.y.as_int(), 0.0f, 1.0f};
+        auto const x = gl_viewport.top_left.x.as_int() +
+            (clip.x / clip.w + 1.0f) / 2.0f * gl_viewport.size.width.as_int();
+        auto const y = gl_viewport.top_left.y.as_int() +
+            (clip.y / clip.w + 1.0f) / 2.0f * gl_viewport.size.height.as_int();
+        left = std::min(left, x);
+        right = std::max(right, x);
+        bottom = std::min(bottom, y);
+        top = std::max(top, y);
+    }
+
+    /* Round outwards, and pad by a pixel so that texture filtering at the edge of the
+     * damaged area can't pull in stale pixels when the output is scaled.
+     */
+    int const x0 = std::floor(left) - 1;
+    int const y0 = std::floor(bottom) - 1;
+    int const x1 = std::ceil(right) + 1;
+    int const y1 = std::ceil(top) + 1;
+    return geom::Rectangle{{x0, y0}, {x1 - x0, y1 - y0}};
 }
 
 void mrg::Renderer::set_viewport(geometry::Rectangle const& rect)
@@ -574,6 +1074,7 @@ void mrg::Renderer::set_viewport(geometry::Rectangle const& rect)
                       0.0f});
 
     viewport = rect;
+    full_repaint_required = true;
     update_gl_viewport();
 }
 
@@ -608,6 +1109,7 @@ void mrg::Renderer::update_gl_viewport()
         GLint offset_y = (output_height - reduced_height) / 2;
 
         glViewport(offset_x, offset_y, reduced_width, reduced_height);
+        gl_viewport = geom::Rectangle{{offset_x, offset_y}, {reduced_width, reduced_height}};
     }
 }
 
@@ -634,6 +1136,7 @@ void mrg::Renderer::set_output_transform(glm::mat2 const& t)
     if (new_display_transform != display_transform)
     {
         display_transform = new_display_transform;
+        full_repaint_required = true;
         update_gl_viewport();
     }
 }
@@ -642,3 +1145,8 @@ void mrg::Renderer::suspend()
 {
     output_surface->release_current();
 }
+
+auto mrg::Renderer::completed_gpu_time() -> std::optional<std::chrono::nanoseconds>
+{
+    return gpu_timer ? gpu_timer->take_completed() : std::nullopt;
+}
@@ -19,11 +19,16 @@
 
 #include <mir/renderer/renderer.h>
 #include <mir/geometry/rectangle.h>
+#include <mir/geometry/rectangles.h>
 #include <mir/graphics/buffer_id.h>
 #include <mir/graphics/renderable.h>
 #include <mir/gl/primitive.h>
 
 #include <GLES2/gl2.h>
+#include <chrono>
+#include <deque>
+#include <optional>
+#include <span>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
@@ -46,10 +51,12 @@ public:
     // These are called with a valid GL context:
     void set_viewport(geometry::Rectangle const& rect) override;
     void set_output_transform(glm::mat2 const&) override;
+    void set_damage(geometry::Rectangles const& damage) override;
     auto render(graphics::RenderableList const&) const -> std::unique_ptr<graphics::Framebuffer> override;
 
     // This is called _without_ a GL context:
     void suspend() override;
+    auto completed_gpu_time() -> std::optional<std::chrono::nanoseconds> override;
 
     struct Program
     {
@@ -67,6 +74,9 @@ public:
         GLint screen_to_gl_coords_uniform = -1;
         GLint alpha_uniform = -1;
         mutable long long last_used_frameno = 0;
+        /// The values of the per-renderable uniforms, as last set this frame
+        mutable std::optional<glm::mat4> transform_value;
+        mutable std::optional<GLfloat> alpha_value;
 
         Program(GLuint program_id);
     };
@@ -97,17 +107,75 @@ protected:
 
     mutable long long frameno = 0;
 
-    virtual void draw(graphics::Renderable const& renderable) const;
+    /**
+     * Draw a renderable, as tessellated into \a primitives
+     *
+     * The primitives' vertices are already in the frame's vertex buffer,
+     * starting at \a first_vertex.
+     */
+    virtual void draw(
+        graphics::Renderable const& renderable,
+        std::span<mir::gl::Primitive const> primitives,
+        GLint first_vertex) const;
 
 private:
+    /// Parameters of glBlendFuncSeparate() and glBlendColor(); dst_rgb == GL_ZERO means blending is disabled
+    struct BlendState
+    {
+        GLenum src_rgb, dst_rgb, src_alpha, dst_alpha;
+        GLfloat constant_alpha;
+
+        auto operator==(BlendState const&) const -> bool = default;
+    };
+
     void update_gl_viewport();
+    /// Make \a program current, if it isn't already, with the frame's vertex buffer as its attributes
+    void use_program(Program const& program) const;
+    void set_blend_state(BlendState const& blend) const;
+
+    /// The area of the viewport that needs repainting this frame, or nullopt for all of it
+    auto area_to_repaint() const -> std::optional<geometry::Rectangle>;
+    /// Bounds of \a area, in screen coordinates, after transformation to GL window coordinates
+    auto to_window_coords(geometry::Rectangle const& area) const -> geometry::Rectangle;
 
     class ProgramFactory;
     std::unique_ptr<ProgramFactory> const program_factory;
+    /// Measures how long the GPU spends on each render(); null if the driver can't
+    class GPUTimer;
+    std::unique_ptr<GPUTimer> const gpu_timer;
     geometry::Rectangle viewport;
+    geometry::Rectangle gl_viewport;
     glm::mat4 screen_to_gl_coords;
     glm::mat4 display_transform;
     std::vector<mir::gl::Primitive> mutable primitives;
+
+    /*
+     * Everything drawn in a frame is tessellated before any of it is drawn, so
+     * that the vertices go to the GPU in one upload, to a buffer object that is
+     * reused every frame.
+     */
+    struct Batch
+    {
+        graphics::Renderable const* renderable;
+        size_t first_primitive;
+        size_t primitive_count;
+        GLint first_vertex;
+    };
+    GLuint vertex_buffer{0};
+    std::vector<mir::gl::Primitive> mutable frame_primitives;
+    std::vector<mir::gl::Vertex> mutable frame_vertices;
+    std::vector<Batch> mutable batches;
+
+    /// GL state as last set this frame, so draw() only makes the GL calls that change it
+    Program const mutable* current_program{nullptr};
+    std::optional<BlendState> mutable current_blend;
+
+    std::optional<geometry::Rectangles> mutable pending_damage;
+    /// Damage of the most recent frames, newest first, for use with OutputSurface::buffer_age()
+    std::deque<geometry::Rectangles> mutable damage_history;
+    bool mutable full_repaint_required{true};
+    /// Scissor box (in GL window coordinates) restricting this frame to the damaged area
+    std::optional<geometry::Rectangle> mutable damage_scissor;
     std::shared_ptr<graphics::GLRenderingProvider> const gl_interface;
 };
 
@@ -0,0 +1,216 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "pixel_kernels.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define MIR_SOFTWARE_RENDERER_SSE2
+#elif defined(__ARM_NEON) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#include <arm_neon.h>
+#define MIR_SOFTWARE_RENDERER_NEON
+#endif
+
+namespace mrs = mir::renderer::software;
+
+namespace
+{
+/// Multiply each channel of pixel by factor/255, rounding to nearest
+inline auto scale_pixel(uint32_t pixel, uint32_t factor) -> uint32_t
+{
+    // Two channels at a time, with a byte of headroom each
+    auto red_blue = (pixel & 0x00ff00ffu) * factor + 0x00800080u;
+    red_blue = ((red_blue + ((red_blue >> 8) & 0x00ff00ffu)) >> 8) & 0x00ff00ffu;
+    auto alpha_green = ((pixel >> 8) & 0x00ff00ffu) * factor + 0x00800080u;
+    alpha_green = (alpha_green + ((alpha_green >> 8) & 0x00ff00ffu)) & 0xff00ff00u;
+    return red_blue | alpha_green;
+}
+
+inline auto blend_pixel(uint32_t dest, uint32_t source, uint32_t alpha, bool source_opaque) -> uint32_t
+{
+    if (source_opaque)
+    {
+        source |= 0xff000000u;
+    }
+    if (alpha != 255)
+    {
+        source = scale_pixel(source, alpha);
+    }
+    // Premultiplied colour channels never exceed alpha, so the sum can't overflow into the next channel
+    return source + scale_pixel(dest, 255 - (source >> 24));
+}
+
+/// Interpolate each channel from a (at weight 0) to b (at weight 256)
+inline auto lerp_pixel(uint32_t a, uint32_t b, uint32_t weight) -> uint32_t
+{
+    auto const red_blue = ((a & 0x00ff00ffu) * (256 - weight) + (b & 0x00ff00ffu) * weight) >> 8;
+    auto const alpha_green = ((a >> 8) & 0x00ff00ffu) * (256 - weight) + ((b >> 8) & 0x00ff00ffu) * weight;
+    return (red_blue & 0x00ff00ffu) | (alpha_green & 0xff00ff00u);
+}
+
+#if defined(MIR_SOFTWARE_RENDERER_SSE2)
+/// Divide each 16-bit lane (a product of two bytes) by 255, rounding to nearest
+inline auto div255(__m128i x) -> __m128i
+{
+    x = _mm_add_epi16(x, _mm_set1_epi16(128));
+    return _mm_srli_epi16(_mm_add_epi16(x, _mm_srli_epi16(x, 8)), 8);
+}
+
+/// Spread the alpha of each of the two pixels in pixels, unpacked to 16-bit lanes, to all its lanes
+inline auto alpha_of(__m128i pixels) -> __m128i
+{
+    return _mm_shufflehi_epi16(
+        _mm_shufflelo_epi16(pixels, _MM_SHUFFLE(3, 3, 3, 3)),
+        _MM_SHUFFLE(3, 3, 3, 3));
+}
+#elif defined(MIR_SOFTWARE_RENDERER_NEON)
+/// Divide each 16-bit lane (a product of two bytes) by 255, rounding to nearest
+inline auto div255(uint16x8_t x) -> uint8x8_t
+{
+    return vraddhn_u16(x, vrshrq_n_u16(x, 8));
+}
+#endif
+}
+
+void mrs::fill_pixels(uint32_t* dest, uint32_t colour, size_t n)
+{
+    std::fill_n(dest, n, colour);
+}
+
+void mrs::copy_pixels(uint32_t* dest, uint32_t const* source, size_t n)
+{
+    ::memcpy(dest, source, n * sizeof(*dest));
+}
+
+void mrs::blend_pixels(uint32_t* dest, uint32_t const* source, size_t n, uint8_t alpha, bool source_opaque)
+{
+    size_t i = 0;
+
+#if defined(MIR_SOFTWARE_RENDERER_SSE2)
+    auto const zero = _mm_setzero_si128();
+    auto const opaque_mask = _mm_set1_epi32(source_opaque ? static_cast<int>(0xff000000u) : 0);
+    auto const fade = _mm_set1_epi16(alpha);
+    auto const max = _mm_set1_epi16(255);
+
+    // Four pixels at a time, two in each half
+    for (; i + 4 <= n; i += 4)
+    {
+        auto const s = _mm_or_si128(_mm_loadu_si128(reinterpret_cast<__m128i const*>(source + i)), opaque_mask);
+        auto const d = _mm_loadu_si128(reinterpret_cast<__m128i const*>(dest + i));
+
+        auto s_lo = _mm_unpacklo_epi8(s, zero);
+        auto s_hi = _mm_unpackhi_epi8(s, zero);
+        if (alpha != 255)
+        {
+            s_lo = div255(_mm_mullo_epi16(s_lo, fade));
+            s_hi = div255(_mm_mullo_epi16(s_hi, fade));
+        }
+
+        auto const d_lo = div255(_mm_mullo_epi16(_mm_unpacklo_epi8(d, zero), _mm_sub_epi16(max, alpha_of(s_lo))));
+        auto const d_hi = div255(_mm_mullo_epi16(_mm_unpackhi_epi8(d, zero), _mm_sub_epi16(max, alpha_of(s_hi))));
+
+        _mm_storeu_si128(
+            reinterpret_cast<__m128i*>(dest + i),
+            _mm_packus_epi16(_mm_add_epi16(s_lo, d_lo), _mm_add_epi16(s_hi, d_hi)));
+    }
+#elif defined(MIR_SOFTWARE_RENDERER_NEON)
+    auto const fade = vdup_n_u8(alpha);
+
+    // Eight pixels at a time, split into planes of blue, green, red and alpha
+    for (; i + 8 <= n; i += 8)
+    {
+        auto s = vld4_u8(reinterpret_cast<uint8_t const*>(source + i));
+        auto d = vld4_u8(reinterpret_cast<uint8_t const*>(dest + i));
+
+        if (source_opaque)
+        {
+            s.val[3] = vdup_n_u8(255);
+        }
+        if (alpha != 255)
+        {
+            for (auto& channel : s.val)
+            {
+                channel = div255(vmull_u8(channel, fade));
+            }
+        }
+
+        auto const inverse_alpha = vmvn_u8(s.val[3]);
+        for (auto c = 0; c != 4; ++c)
+        {
+            d.val[c] = vqadd_u8(s.val[c], div255(vmull_u8(d.val[c], inverse_alpha)));
+        }
+
+        vst4_u8(reinterpret_cast<uint8_t*>(dest + i), d);
+    }
+#endif
+
+    for (; i != n; ++i)
+    {
+        dest[i] = blend_pixel(dest[i], source[i], alpha, source_opaque);
+    }
+}
+
+void mrs::swap_red_blue(uint32_t* pixels, size_t n)
+{
+    for (size_t i = 0; i != n; ++i)
+    {
+        auto const pixel = pixels[i];
+        pixels[i] = (pixel & 0xff00ff00u) | ((pixel & 0x000000ffu) << 16) | ((pixel >> 16) & 0x000000ffu);
+    }
+}
+
+void mrs::sample_bilinear(
+    uint32_t* dest,
+    size_t n,
+    unsigned char const* pixels,
+    int stride,
+    int width,
+    int height,
+    float u,
+    float v,
+    float du,
+    float dv,
+    bool source_opaque)
+{
+    auto const opaque_mask = source_opaque ? 0xff000000u : 0u;
+    for (size_t i = 0; i != n; ++i, u += du, v += dv)
+    {
+        if (u < 0.0f || v < 0.0f || u >= width || v >= height)
+        {
+            dest[i] = 0;
+            continue;
+        }
+
+        // Texel centres are at half-integers; interpolate between the four nearest
+        auto const x = u - 0.5f, y = v - 0.5f;
+        auto const left = std::floor(x), top = std::floor(y);
+        auto const x_weight = static_cast<uint32_t>((x - left) * 256.0f);
+        auto const y_weight = static_cast<uint32_t>((y - top) * 256.0f);
+        auto const x0 = std::max(static_cast<int>(left), 0), x1 = std::min(static_cast<int>(left) + 1, width - 1);
+        auto const y0 = std::max(static_cast<int>(top), 0), y1 = std::min(static_cast<int>(top) + 1, height - 1);
+
+        auto const upper = reinterpret_cast<uint32_t const*>(pixels + y0 * stride);
+        auto const lower = reinterpret_cast<uint32_t const*>(pixels + y1 * stride);
+        dest[i] = lerp_pixel(
+            lerp_pixel(upper[x0], upper[x1], x_weight),
+            lerp_pixel(lower[x0], lower[x1], x_weight),
+            y_weight) | opaque_mask;
+    }
+}
@@ -0,0 +1,82 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_RENDERER_SOFTWARE_PIXEL_KERNELS_H_
+#define MIR_RENDERER_SOFTWARE_PIXEL_KERNELS_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace mir
+{
+namespace renderer
+{
+namespace software
+{
+/*
+ * Row operations on 32bpp pixels in the native-endian 0xAARRGGBB layout of
+ * ARGB8888 and XRGB8888. Colours are premultiplied by their alpha, as
+ * Wayland clients' are.
+ *
+ * These use SSE2 on x86-64 and NEON on AArch64, both of which every CPU of
+ * those architectures has, and plain C++ elsewhere.
+ */
+
+/// Set \a n pixels at \a dest to \a colour
+void fill_pixels(uint32_t* dest, uint32_t colour, size_t n);
+
+/// Copy \a n pixels from \a source to \a dest
+void copy_pixels(uint32_t* dest, uint32_t const* source, size_t n);
+
+/**
+ * Composite \a n pixels of \a source over \a dest
+ *
+ * Each source pixel is first faded by \a alpha (255 being unchanged). If
+ * \a source_opaque the source's alpha channel is ignored and taken to be 255,
+ * as for XRGB8888.
+ */
+void blend_pixels(uint32_t* dest, uint32_t const* source, size_t n, uint8_t alpha, bool source_opaque);
+
+/// Swap the red and blue channels of \a n pixels, converting between ABGR8888 and ARGB8888
+void swap_red_blue(uint32_t* pixels, size_t n);
+
+/**
+ * Sample \a n pixels from an image by bilinear filtering, as GL_LINEAR does
+ *
+ * Sample i is at texel coordinates (\a u + i × \a du, \a v + i × \a dv), in units where texel (x, y)
+ * covers [x, x + 1) × [y, y + 1). Samples outside the image are transparent; within it, texels beyond
+ * the edges repeat the edge, as with GL_CLAMP_TO_EDGE. If \a source_opaque the alpha channel of samples
+ * within the image is taken to be 255, as for XRGB8888.
+ *
+ * This is plain C++ on all architectures; it's only used for scaled or rotated buffers.
+ */
+void sample_bilinear(
+    uint32_t* dest,
+    size_t n,
+    unsigned char const* pixels,
+    int stride,
+    int width,
+    int height,
+    float u,
+    float v,
+    float du,
+    float dv,
+    bool source_opaque);
+}
+}
+}
+
+#endif // MIR_RENDERER_SOFTWARE_PIXEL_KERNELS_H_
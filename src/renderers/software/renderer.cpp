@@ -0,0 +1,497 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "renderer.h"
+#include "pixel_kernels.h"
+
+#include "mir/executor.h"
+#include "mir/graphics/buffer.h"
+#include "mir/graphics/platform.h"
+#include "mir/log.h"
+#include "mir/renderer/sw/pixel_source.h"
+
+#include <boost/throw_exception.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <exception>
+#include <latch>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+namespace mrs = mir::renderer::software;
+namespace mg = mir::graphics;
+namespace geom = mir::geometry;
+
+namespace
+{
+uint32_t const opaque_black = 0xff000000u;
+
+/// Rows each thread composites at least, so that small repaints are not spread thinly across threads
+int const min_rows_per_band = 32;
+
+auto band_count_for(int rows) -> int
+{
+    static int const max_bands = std::clamp(static_cast<int>(std::thread::hardware_concurrency()), 1, 8);
+    return std::clamp(rows / min_rows_per_band, 1, max_bands);
+}
+
+/// Smallest whole-pixel rectangle containing all of points
+auto bounds_of(std::initializer_list<glm::vec2> points) -> geom::Rectangle
+{
+    glm::vec2 low{std::numeric_limits<float>::max()}, high{std::numeric_limits<float>::lowest()};
+    for (auto const& point : points)
+    {
+        low = glm::min(low, point);
+        high = glm::max(high, point);
+    }
+    geom::Point const top_left{static_cast<int>(std::floor(low.x)), static_cast<int>(std::floor(low.y))};
+    geom::Point const bottom_right{static_cast<int>(std::ceil(high.x)), static_cast<int>(std::ceil(high.y))};
+    return {top_left, as_size(bottom_right - top_left)};
+}
+
+auto corners_of(geom::Rectangle const& rect) -> std::array<glm::vec2, 4>
+{
+    auto const left = rect.left().as_value(), top = rect.top().as_value();
+    auto const right = rect.right().as_value(), bottom = rect.bottom().as_value();
+    return {glm::vec2{left, top}, glm::vec2{right, top}, glm::vec2{left, bottom}, glm::vec2{right, bottom}};
+}
+
+auto is_empty(geom::Rectangle const& rect) -> bool
+{
+    return rect.size.width.as_int() <= 0 || rect.size.height.as_int() <= 0;
+}
+
+/// Whether transform is the identity, give or take rounding error
+auto is_identity(glm::mat2 const& transform) -> bool
+{
+    auto const error = transform - glm::mat2{1};
+    return glm::all(glm::lessThan(glm::abs(error[0]), glm::vec2{1e-5f})) &&
+           glm::all(glm::lessThan(glm::abs(error[1]), glm::vec2{1e-5f}));
+}
+}
+
+/// A renderable, mapped for reading, and where its pixels land in the framebuffer
+class mrs::Renderer::Layer
+{
+public:
+    /// \throws std::exception if the renderable's buffer can't be mapped, or is in a format we don't handle
+    Layer(mg::Renderable const& renderable, Renderer const& renderer, geom::Rectangle const& repaint_area)
+        : buffer{as_read_mappable_buffer(renderable.buffer())},
+          mapping{buffer->map_readable()},
+          pixels{mapping->data()},
+          stride{mapping->stride().as_int()},
+          size{mapping->size()},
+          alpha{static_cast<uint8_t>(std::lround(std::clamp(renderable.alpha(), 0.0f, 1.0f) * 255))}
+    {
+        switch (mapping->format())
+        {
+        case mir_pixel_format_argb_8888:
+            source_opaque = !renderable.shaped();
+            break;
+        case mir_pixel_format_xrgb_8888:
+            break;
+        case mir_pixel_format_abgr_8888:
+            source_opaque = !renderable.shaped();
+            swap_red_blue = true;
+            break;
+        case mir_pixel_format_xbgr_8888:
+            swap_red_blue = true;
+            break;
+        default:
+            BOOST_THROW_EXCEPTION((std::runtime_error{
+                "Unsupported pixel format " + std::to_string(mapping->format())}));
+        }
+
+        auto const position = renderable.screen_position();
+        if (is_empty(position) || size.width.as_int() <= 0 || size.height.as_int() <= 0)
+        {
+            return;
+        }
+
+        // Like the GL renderer, we apply the 2D part of the renderable's transformation about its centre
+        glm::mat2 const transformation{renderable.transformation()};
+        if (glm::determinant(transformation) == 0.0f)
+        {
+            return;
+        }
+        glm::vec2 const centre{
+            position.left().as_value() + position.size.width.as_value() / 2.0f,
+            position.top().as_value() + position.size.height.as_value() / 2.0f};
+        glm::vec2 const top_left{position.left().as_value(), position.top().as_value()};
+        glm::mat2 const texels_per_pixel{
+            size.width.as_value() / static_cast<float>(position.size.width.as_value()), 0.0f,
+            0.0f, size.height.as_value() / static_cast<float>(position.size.height.as_value())};
+
+        // texel = texels_per_pixel * (inverse(transformation) * (screen - centre) + centre - top_left)
+        auto const untransform = glm::inverse(transformation);
+        texel_from_framebuffer = texels_per_pixel * untransform * renderer.screen_from_framebuffer;
+        texel_offset = texels_per_pixel * (
+            untransform * (
+                renderer.screen_centre - centre -
+                renderer.screen_from_framebuffer * renderer.framebuffer_centre) +
+            centre - top_left);
+
+        auto const corners = corners_of(position);
+        auto screen_bounds = bounds_of({
+            transformation * (corners[0] - centre) + centre,
+            transformation * (corners[1] - centre) + centre,
+            transformation * (corners[2] - centre) + centre,
+            transformation * (corners[3] - centre) + centre});
+        if (auto const clip = renderable.clip_area())
+        {
+            screen_bounds = intersection_of(screen_bounds, *clip);
+        }
+        bounds = intersection_of(
+            intersection_of(renderer.to_framebuffer_coords(screen_bounds), renderer.content_area),
+            repaint_area);
+
+        // The common case: each framebuffer pixel is a texel, so whole rows can be blended at once
+        auto const offset = glm::round(texel_offset);
+        if (is_identity(texel_from_framebuffer) &&
+            glm::all(glm::lessThan(glm::abs(texel_offset - offset), glm::vec2{1e-3f})))
+        {
+            direct_offset = glm::ivec2{offset};
+            bounds = intersection_of(bounds, geom::Rectangle{{-direct_offset->x, -direct_offset->y}, size});
+        }
+    }
+
+    /// The framebuffer pixels this layer may cover
+    auto covers() const -> geom::Rectangle const&
+    {
+        return bounds;
+    }
+
+    /**
+     * Composite this layer onto the span of framebuffer row \a y from \a x to \a x + \a width
+     *
+     * \param dest      The framebuffer pixel (\a x, \a y)
+     * \param scratch   Working space for this thread
+     */
+    void draw_span(uint32_t* dest, int x, int y, int width, std::vector<uint32_t>& scratch) const
+    {
+        uint32_t const* source;
+        auto opaque = source_opaque;
+
+        if (direct_offset)
+        {
+            source = reinterpret_cast<uint32_t const*>(pixels + (y + direct_offset->y) * stride) + x + direct_offset->x;
+            if (swap_red_blue)
+            {
+                scratch.assign(source, source + width);
+                software::swap_red_blue(scratch.data(), width);
+                source = scratch.data();
+            }
+        }
+        else
+        {
+            // Filter as the GL renderer's textures do, leaving transparent any pixel outside the buffer
+            scratch.resize(width);
+            auto const step = texel_from_framebuffer[0];
+            auto const texel = texel_from_framebuffer * glm::vec2{x + 0.5f, y + 0.5f} + texel_offset;
+            sample_bilinear(
+                scratch.data(), width,
+                pixels, stride, size.width.as_int(), size.height.as_int(),
+                texel.x, texel.y, step.x, step.y,
+                source_opaque);
+            if (swap_red_blue)
+            {
+                software::swap_red_blue(scratch.data(), width);
+            }
+            source = scratch.data();
+            opaque = false;
+        }
+
+        if (opaque && alpha == 255)
+        {
+            copy_pixels(dest, source, width);
+        }
+        else
+        {
+            blend_pixels(dest, source, width, alpha, opaque);
+        }
+    }
+
+private:
+    std::shared_ptr<ReadMappableBuffer> buffer;
+    std::unique_ptr<Mapping<unsigned char const>> mapping;
+    unsigned char const* pixels;
+    int stride;
+    geom::Size size;
+    uint8_t alpha;
+    bool source_opaque{true};
+    bool swap_red_blue{false};
+
+    geom::Rectangle bounds;
+    /// Maps framebuffer pixel centres to texels: texel = texel_from_framebuffer * pixel + texel_offset
+    glm::mat2 texel_from_framebuffer{1};
+    glm::vec2 texel_offset{0, 0};
+    /// Set when texel = pixel + direct_offset exactly
+    std::optional<glm::ivec2> direct_offset;
+};
+
+mrs::Renderer::Renderer(mg::CPUAddressableDisplayAllocator& allocator, mg::DRMFormat format)
+    : allocator{allocator},
+      format{format},
+      output_size{allocator.output_size()},
+      viewport{{0, 0}, output_size}
+{
+    update_framebuffer_transform();
+}
+
+mrs::Renderer::~Renderer() = default;
+
+auto mrs::Renderer::supported_formats() -> std::vector<mg::DRMFormat>
+{
+    return {
+        mg::DRMFormat::from_mir_format(mir_pixel_format_xrgb_8888),
+        mg::DRMFormat::from_mir_format(mir_pixel_format_argb_8888)};
+}
+
+void mrs::Renderer::set_viewport(geom::Rectangle const& rect)
+{
+    if (rect == viewport)
+        return;
+
+    viewport = rect;
+    update_framebuffer_transform();
+}
+
+void mrs::Renderer::set_output_transform(glm::mat2 const& t)
+{
+    if (t == output_transform)
+        return;
+
+    output_transform = t;
+    update_framebuffer_transform();
+}
+
+void mrs::Renderer::set_damage(geom::Rectangles const& damage)
+{
+    pending_damage = damage;
+}
+
+void mrs::Renderer::suspend()
+{
+}
+
+auto mrs::Renderer::render(mg::RenderableList const& renderables) const -> std::unique_ptr<mg::Framebuffer>
+{
+    auto fb = allocator.alloc_fb(format);
+
+    auto const area = area_to_repaint(fb->buffer_age());
+    if (is_empty(area))
+    {
+        return fb;
+    }
+
+    std::vector<Layer> layers;
+    layers.reserve(renderables.size());
+    for (auto const& renderable : renderables)
+    {
+        try
+        {
+            Layer layer{*renderable, *this, area};
+            if (!is_empty(layer.covers()))
+            {
+                layers.push_back(std::move(layer));
+            }
+        }
+        catch (std::exception const& error)
+        {
+            if (!std::exchange(warned_unmappable, true))
+            {
+                mir::log_warning("Software renderer skipping a buffer it cannot draw: %s", error.what());
+            }
+        }
+    }
+
+    auto const mapping = fb->map_writeable();
+    auto const framebuffer = mapping->data();
+    auto const stride = mapping->stride().as_int();
+
+    auto const composite_rows =
+        [&](int top, int bottom)
+        {
+            std::vector<uint32_t> scratch;
+            for (auto y = top; y != bottom; ++y)
+            {
+                auto const row = reinterpret_cast<uint32_t*>(framebuffer + y * stride);
+                fill_pixels(row + area.left().as_int(), opaque_black, area.size.width.as_int());
+
+                // Bottom to top
+                for (auto const& layer : layers)
+                {
+                    auto const& covers = layer.covers();
+                    if (y < covers.top().as_int() || y >= covers.bottom().as_int())
+                    {
+                        continue;
+                    }
+                    auto const left = covers.left().as_int();
+                    layer.draw_span(row + left, left, y, covers.size.width.as_int(), scratch);
+                }
+            }
+        };
+
+    // Split the rows to repaint into bands, and composite each on its own thread
+    auto const top = area.top().as_int();
+    auto const rows = area.size.height.as_int();
+    auto const bands = band_count_for(rows);
+    std::latch bands_done{bands - 1};
+    // The bands use this frame's locals, so every one must finish before we leave, even if another fails
+    std::vector<std::exception_ptr> band_failures(bands);
+    for (auto band = 1; band < bands; ++band)
+    {
+        mir::thread_pool_executor.spawn(
+            [&, band]()
+            {
+                try
+                {
+                    composite_rows(top + rows * band / bands, top + rows * (band + 1) / bands);
+                }
+                catch (...)
+                {
+                    band_failures[band] = std::current_exception();
+                }
+                bands_done.count_down();
+            });
+    }
+    try
+    {
+        composite_rows(top, top + rows / bands);
+    }
+    catch (...)
+    {
+        band_failures[0] = std::current_exception();
+    }
+    bands_done.wait();
+
+    for (auto const& failure : band_failures)
+    {
+        if (failure)
+        {
+            std::rethrow_exception(failure);
+        }
+    }
+
+    return fb;
+}
+
+void mrs::Renderer::update_framebuffer_transform()
+{
+    auto const viewport_width = viewport.size.width.as_value();
+    auto const viewport_height = viewport.size.height.as_value();
+    auto const transformed = glm::abs(output_transform * glm::vec2{viewport_width, viewport_height});
+
+    /*
+     * Letterboxing: as the GL renderer does, keep pixels square by drawing black
+     * bars where the viewport's aspect ratio doesn't match the output's.
+     */
+    auto const output_width = output_size.width.as_int();
+    auto const output_height = output_size.height.as_int();
+    auto content_width = output_width, content_height = output_height;
+    if (transformed.x > 0.0f && transformed.y > 0.0f)
+    {
+        if (transformed.x * output_height >= output_width * transformed.y)
+            content_height = output_width * transformed.y / transformed.x;
+        else
+            content_width = output_height * transformed.x / transformed.y;
+    }
+    content_area = geom::Rectangle{
+        {(output_width - content_width) / 2, (output_height - content_height) / 2},
+        {content_width, content_height}};
+
+    framebuffer_centre = {
+        content_area.left().as_int() + content_width / 2.0f,
+        content_area.top().as_int() + content_height / 2.0f};
+    screen_centre = {
+        viewport.left().as_int() + viewport_width / 2.0f,
+        viewport.top().as_int() + viewport_height / 2.0f};
+
+    // Framebuffer pixels to [-1, 1], through the inverse of the output transform, out to screen coordinates
+    glm::mat2 const to_normalised{2.0f / std::max(content_width, 1), 0.0f, 0.0f, 2.0f / std::max(content_height, 1)};
+    glm::mat2 const to_screen{viewport_width / 2.0f, 0.0f, 0.0f, viewport_height / 2.0f};
+    screen_from_framebuffer = to_screen * glm::inverse(output_transform) * to_normalised;
+
+    full_repaint_required = true;
+}
+
+auto mrs::Renderer::to_framebuffer_coords(geom::Rectangle const& area) const -> geom::Rectangle
+{
+    auto const framebuffer_from_screen = glm::inverse(screen_from_framebuffer);
+    auto const corners = corners_of(area);
+    auto const bounds = bounds_of({
+        framebuffer_from_screen * (corners[0] - screen_centre) + framebuffer_centre,
+        framebuffer_from_screen * (corners[1] - screen_centre) + framebuffer_centre,
+        framebuffer_from_screen * (corners[2] - screen_centre) + framebuffer_centre,
+        framebuffer_from_screen * (corners[3] - screen_centre) + framebuffer_centre});
+    return intersection_of(bounds, geom::Rectangle{{0, 0}, output_size});
+}
+
+auto mrs::Renderer::area_to_repaint(int age) const -> geom::Rectangle
+{
+    /* Enough to cover triple-buffering plus one frame in flight; anything
+     * older than this gets a full repaint.
+     */
+    size_t const max_tracked_age = 4;
+
+    std::optional<geom::Rectangles> damage;
+    std::swap(damage, pending_damage);
+
+    /* A full repaint changes the whole framebuffer, so the other framebuffers
+     * need the whole of it repainting too when they next come round.
+     */
+    auto const full_repaint = std::exchange(full_repaint_required, false);
+    damage_history.push_front(damage && !full_repaint ? *damage : geom::Rectangles{viewport});
+    if (damage_history.size() > max_tracked_age)
+    {
+        damage_history.pop_back();
+    }
+
+    geom::Rectangle const whole_framebuffer{{0, 0}, output_size};
+    if (!damage || full_repaint || age <= 0 || static_cast<size_t>(age) > damage_history.size())
+    {
+        return whole_framebuffer;
+    }
+
+    /* The framebuffer holds the frame from age frames ago, so to bring it up to
+     * date we need to repaint everything damaged since then, as well as this
+     * frame's damage.
+     */
+    geom::Rectangles accumulated;
+    for (auto i = 0; i < age; ++i)
+    {
+        for (auto const& rect : damage_history[i])
+        {
+            accumulated.add(rect);
+        }
+    }
+
+    auto const area = intersection_of(accumulated.bounding_rectangle(), viewport);
+    if (is_empty(area))
+    {
+        return {};
+    }
+    if (area == viewport)
+    {
+        // Including any letterboxing, which may have moved since this framebuffer was drawn
+        return whole_framebuffer;
+    }
+    return to_framebuffer_coords(area);
+}
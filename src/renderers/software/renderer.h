@@ -0,0 +1,96 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_RENDERER_SOFTWARE_RENDERER_H_
+#define MIR_RENDERER_SOFTWARE_RENDERER_H_
+
+#include <mir/renderer/renderer.h>
+#include <mir/geometry/rectangle.h>
+#include <mir/geometry/rectangles.h>
+#include <mir/graphics/drm_formats.h>
+
+#include <deque>
+#include <optional>
+#include <vector>
+
+namespace mir
+{
+namespace graphics { class CPUAddressableDisplayAllocator; }
+namespace renderer
+{
+namespace software
+{
+
+/**
+ * Composites CPU-mappable buffers straight into a display's dumb buffers
+ *
+ * This needs no GL at all, so suits machines whose only GL would be a software
+ * rasteriser. Client buffers that can't be mapped (such as dmabufs) are not drawn.
+ */
+class Renderer : public renderer::Renderer
+{
+public:
+    /// \param allocator    Must support ARGB8888 or XRGB8888, and outlive the Renderer
+    Renderer(graphics::CPUAddressableDisplayAllocator& allocator, graphics::DRMFormat format);
+    ~Renderer() override;
+
+    void set_viewport(geometry::Rectangle const& rect) override;
+    void set_output_transform(glm::mat2 const&) override;
+    void set_damage(geometry::Rectangles const& damage) override;
+    auto render(graphics::RenderableList const&) const -> std::unique_ptr<graphics::Framebuffer> override;
+    void suspend() override;
+
+    /// The formats, in order of preference, that we can render into
+    static auto supported_formats() -> std::vector<graphics::DRMFormat>;
+
+private:
+    class Layer;
+
+    /// The area of a framebuffer of age \a age, in framebuffer pixels, that needs repainting this frame
+    auto area_to_repaint(int age) const -> geometry::Rectangle;
+    /// Bounds, in framebuffer pixels, of \a area in screen coordinates
+    auto to_framebuffer_coords(geometry::Rectangle const& area) const -> geometry::Rectangle;
+    void update_framebuffer_transform();
+
+    graphics::CPUAddressableDisplayAllocator& allocator;
+    graphics::DRMFormat const format;
+    geometry::Size const output_size;
+
+    geometry::Rectangle viewport;
+    glm::mat2 output_transform{1};
+
+    /*
+     * Screen coordinates, s, and framebuffer pixel coordinates, f, are related by
+     * s = screen_from_framebuffer * (f - framebuffer_centre) + screen_centre
+     */
+    glm::mat2 screen_from_framebuffer{1};
+    glm::vec2 framebuffer_centre{0, 0};
+    glm::vec2 screen_centre{0, 0};
+    /// The part of the framebuffer the viewport is drawn to; the rest is letterboxing
+    geometry::Rectangle content_area;
+
+    std::optional<geometry::Rectangles> mutable pending_damage;
+    /// Damage of the most recent frames, newest first, for use with MappableFB::buffer_age()
+    std::deque<geometry::Rectangles> mutable damage_history;
+    bool mutable full_repaint_required{true};
+    bool mutable warned_unmappable{false};
+};
+
+}
+}
+}
+
+#endif // MIR_RENDERER_SOFTWARE_RENDERER_H_
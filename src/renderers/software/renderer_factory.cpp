@@ -0,0 +1,62 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "renderer_factory.h"
+#include "renderer.h"
+#include "mir/graphics/display_sink.h"
+#include "mir/graphics/platform.h"
+#include "mir/renderer/gl/gl_surface.h"
+
+#include <algorithm>
+
+namespace mrs = mir::renderer::software;
+namespace mg = mir::graphics;
+
+mrs::RendererFactory::RendererFactory(std::shared_ptr<renderer::RendererFactory> fallback)
+    : fallback{std::move(fallback)}
+{
+}
+
+auto mrs::RendererFactory::create_renderer_for(
+    std::unique_ptr<mg::gl::OutputSurface> output_surface,
+    std::shared_ptr<mg::GLRenderingProvider> gl_provider) const -> std::unique_ptr<mir::renderer::Renderer>
+{
+    return fallback->create_renderer_for(std::move(output_surface), std::move(gl_provider));
+}
+
+auto mrs::RendererFactory::create_renderer_for_sink(mg::DisplaySink& sink) const
+    -> std::unique_ptr<mir::renderer::Renderer>
+{
+    auto const allocator = sink.acquire_compatible_allocator<mg::CPUAddressableDisplayAllocator>();
+    if (!allocator)
+    {
+        return nullptr;
+    }
+
+    auto const available = allocator->supported_formats();
+    for (auto const format : Renderer::supported_formats())
+    {
+        auto const matches = [format](mg::DRMFormat const& candidate)
+            {
+                return static_cast<uint32_t>(candidate) == static_cast<uint32_t>(format);
+            };
+        if (std::any_of(available.begin(), available.end(), matches))
+        {
+            return std::make_unique<Renderer>(*allocator, format);
+        }
+    }
+    return nullptr;
+}
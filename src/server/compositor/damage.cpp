@@ -0,0 +1,160 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "damage.h"
+#include "mir/graphics/buffer.h"
+
+#include <algorithm>
+
+namespace mc = mir::compositor;
+namespace mg = mir::graphics;
+namespace geom = mir::geometry;
+
+namespace
+{
+auto element_from(mg::Renderable const& renderable) -> mc::DamageTracker::Element
+{
+    auto extent = renderable.screen_position();
+    if (auto const clip = renderable.clip_area())
+    {
+        extent = intersection_of(extent, *clip);
+    }
+
+    auto const buffer = renderable.buffer();
+
+    return {
+        renderable.id(),
+        extent,
+        renderable.alpha(),
+        renderable.shaped(),
+        buffer ? buffer->id() : mg::BufferID{}};
+}
+
+auto find(std::vector<mc::DamageTracker::Element> const& elements, mg::Renderable::ID id)
+    -> std::vector<mc::DamageTracker::Element>::const_iterator
+{
+    return std::find_if(
+        elements.begin(),
+        elements.end(),
+        [id](auto const& element) { return element.id == id; });
+}
+
+void add_damage(geom::Rectangles& damage, geom::Rectangle const& rect, geom::Rectangle const& area)
+{
+    auto const clipped = intersection_of(rect, area);
+    if (clipped.size.width > geom::Width{0} && clipped.size.height > geom::Height{0})
+    {
+        damage.add(clipped);
+    }
+}
+}
+
+auto mc::DamageTracker::damage_for(mg::RenderableList const& renderables, geom::Rectangle const& area)
+    -> geom::Rectangles
+{
+    static glm::mat4 const identity(1);
+
+    bool everything_damaged = !last_area || *last_area != area;
+
+    std::vector<Element> frame;
+    frame.reserve(renderables.size());
+    for (auto const& renderable : renderables)
+    {
+        if (renderable->transformation() != identity)
+        {
+            // Weirdly transformed; we can't cheaply tell what it covers
+            everything_damaged = true;
+        }
+        frame.push_back(element_from(*renderable));
+    }
+
+    geom::Rectangles damage;
+    if (everything_damaged)
+    {
+        damage.add(area);
+    }
+    else
+    {
+        for (auto i = 0u; i != frame.size(); ++i)
+        {
+            auto const& now = frame[i];
+            auto const then = find(last_frame, now.id);
+            if (then == last_frame.end())
+            {
+                add_damage(damage, now.extent, area);
+            }
+            else if (then->extent != now.extent || then->alpha != now.alpha || then->shaped != now.shaped)
+            {
+                add_damage(damage, then->extent, area);
+                add_damage(damage, now.extent, area);
+            }
+            else if (then->buffer != now.buffer)
+            {
+                if (auto const client_damage = renderables[i]->damage_since(then->buffer))
+                {
+                    for (auto const& rect : *client_damage)
+                    {
+                        add_damage(damage, intersection_of(rect, now.extent), area);
+                    }
+                }
+                else
+                {
+                    add_damage(damage, now.extent, area);
+                }
+            }
+        }
+
+        std::vector<Element const*> survivors_then, survivors_now;
+        for (auto const& then : last_frame)
+        {
+            if (find(frame, then.id) == frame.end())
+            {
+                add_damage(damage, then.extent, area);
+            }
+            else
+            {
+                survivors_then.push_back(&then);
+            }
+        }
+        for (auto const& now : frame)
+        {
+            if (find(last_frame, now.id) != last_frame.end())
+            {
+                survivors_now.push_back(&now);
+            }
+        }
+
+        // Anything that has changed place in the stacking order may now be drawn differently
+        for (auto i = 0u; i != survivors_now.size(); ++i)
+        {
+            if (survivors_then[i]->id != survivors_now[i]->id)
+            {
+                add_damage(damage, survivors_then[i]->extent, area);
+                add_damage(damage, survivors_now[i]->extent, area);
+            }
+        }
+    }
+
+    last_area = area;
+    last_frame = std::move(frame);
+    return damage;
+}
+
+void mc::DamageTracker::reset()
+{
+    last_area.reset();
+    last_frame.clear();
+}
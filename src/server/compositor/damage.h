@@ -0,0 +1,69 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_COMPOSITOR_DAMAGE_H_
+#define MIR_COMPOSITOR_DAMAGE_H_
+
+#include "mir/geometry/rectangle.h"
+#include "mir/geometry/rectangles.h"
+#include "mir/graphics/buffer_id.h"
+#include "mir/graphics/renderable.h"
+
+#include <optional>
+#include <vector>
+
+namespace mir
+{
+namespace compositor
+{
+
+/**
+ * Tracks what was drawn in the previous frame, so that the next frame can be
+ * limited to the areas that have changed.
+ */
+class DamageTracker
+{
+public:
+    /**
+     * The parts of \a area that differ between the last frame passed to
+     * damage_for() and \a renderables.
+     *
+     * \a renderables then becomes the last frame.
+     */
+    auto damage_for(graphics::RenderableList const& renderables, geometry::Rectangle const& area)
+        -> geometry::Rectangles;
+
+    /// Forget the last frame, so the next call to damage_for() reports the whole area
+    void reset();
+
+    struct Element
+    {
+        graphics::Renderable::ID id;
+        geometry::Rectangle extent;
+        float alpha;
+        bool shaped;
+        graphics::BufferID buffer;
+    };
+
+private:
+    std::optional<geometry::Rectangle> last_area;
+    std::vector<Element> last_frame;
+};
+
+} // namespace compositor
+} // namespace mir
+
+#endif // MIR_COMPOSITOR_DAMAGE_H_
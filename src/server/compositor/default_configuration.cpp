@@ -23,6 +23,7 @@
 #include "mir/executor.h"
 #include "multi_threaded_compositor.h"
 #include "gl/renderer_factory.h"
+#include "software/renderer_factory.h"
 #include "basic_screen_shooter.h"
 #include "null_screen_shooter.h"
 #include "mir/main_loop.h"
@@ -98,9 +99,20 @@ mir::DefaultServerConfiguration::the_compositor()
 std::shared_ptr<mir::renderer::RendererFactory> mir::DefaultServerConfiguration::the_renderer_factory()
 {
     return renderer_factory(
-        []()
+        [this]() -> std::shared_ptr<mir::renderer::RendererFactory>
         {
-            return std::make_shared<mir::renderer::gl::RendererFactory>();
+            auto gl_factory = std::make_shared<mir::renderer::gl::RendererFactory>();
+
+            auto const renderer = the_options()->get<std::string>(options::renderer_opt);
+            if (renderer == "software")
+            {
+                return std::make_shared<mir::renderer::software::RendererFactory>(std::move(gl_factory));
+            }
+            else if (renderer != "gl")
+            {
+                BOOST_THROW_EXCEPTION((std::runtime_error{"Unknown renderer: " + renderer}));
+            }
+            return gl_factory;
         });
 }
 
@@ -27,6 +27,8 @@
 #include "mir/renderer/renderer.h"
 #include "occlusion.h"
 
+#include <algorithm>
+
 namespace mc = mir::compositor;
 namespace mg = mir::graphics;
 
@@ -40,6 +42,10 @@ mc::DefaultDisplayBufferCompositor::DefaultDisplayBufferCompositor(
     fb_adaptor{gl_provider.make_framebuffer_provider(display_sink)},
     report(report)
 {
+    auto const& area = display_sink.view_area();
+    report->added_display(area.size.width.as_int(), area.size.height.as_int(),
+                          area.top_left.x.as_int(), area.top_left.y.as_int(),
+                          this);
 }
 
 bool mc::DefaultDisplayBufferCompositor::composite(mc::SceneElementSequence&& scene_elements)
@@ -74,11 +80,20 @@ bool mc::DefaultDisplayBufferCompositor::composite(mc::SceneElementSequence&& sc
      */
     scene_elements.clear();  // Those in use are still in renderable_list
 
+    static glm::mat4 const identity(1);
+
     std::vector<mg::DisplayElement> framebuffers;
     framebuffers.reserve(renderable_list.size());
 
-    for (auto const& renderable : renderable_list)
+    // Collect from the top down: the topmost may be shown directly even if those below them can't be
+    for (auto r = renderable_list.rbegin(); r != renderable_list.rend(); ++r)
     {
+        auto const& renderable = *r;
+        if (renderable->alpha() < 1.0f || renderable->transformation() != identity)
+        {
+            // Only the renderer can fade or transform a buffer
+            break;
+        }
         auto fb = fb_adaptor->buffer_to_framebuffer(renderable->buffer());
         if (!fb)
         {
@@ -104,24 +119,42 @@ bool mc::DefaultDisplayBufferCompositor::composite(mc::SceneElementSequence&& sc
         framebuffers.emplace_back(mg::DisplayElement{
             renderable->screen_position(),
             geometry::RectangleF{source_origin, source_size},
-            std::move(fb)
+            std::move(fb),
+            renderable->tearing_allowed()
         });
     }
+    std::reverse(framebuffers.begin(), framebuffers.end());
 
     if (framebuffers.size() == renderable_list.size() && display_sink.overlay(framebuffers))
     {
         report->renderables_in_frame(this, renderable_list);
         renderer->suspend();
+        // The renderer's output no longer reflects what's on screen
+        damage.reset();
     }
     else
     {
+        // The display may still show the topmost renderables itself, leaving only those below to composite
+        auto const overlaid = framebuffers.empty() ? 0 : display_sink.overlay_above_next_image(framebuffers);
+        mg::RenderableList below_overlays;
+        if (overlaid)
+        {
+            below_overlays.assign(renderable_list.begin(), renderable_list.end() - overlaid);
+        }
+        auto const& composited = overlaid ? below_overlays : renderable_list;
+
         renderer->set_output_transform(display_sink.transformation());
         renderer->set_viewport(view_area);
+        renderer->set_damage(damage.damage_for(composited, view_area));
 
-        display_sink.set_next_image(renderer->render(renderable_list));
+        display_sink.set_next_image(renderer->render(composited));
 
         report->renderables_in_frame(this, renderable_list);
         report->rendered_frame(this);
+        if (auto const gpu_time = renderer->completed_gpu_time())
+        {
+            report->rendered_frame_on_gpu(this, *gpu_time);
+        }
 
         /*
          * This is used for the 'early release' optimization to release buffers
@@ -140,3 +173,8 @@ bool mc::DefaultDisplayBufferCompositor::composite(mc::SceneElementSequence&& sc
     report->finished_frame(this);
     return true;
 }
+
+void mc::DefaultDisplayBufferCompositor::frame_posted(std::optional<std::chrono::nanoseconds> refresh_period)
+{
+    report->posted_frame(this, refresh_period);
+}
@@ -19,6 +19,7 @@
 
 #include "mir/compositor/display_buffer_compositor.h"
 #include "mir/graphics/platform.h"
+#include "damage.h"
 #include <memory>
 
 namespace mir
@@ -50,6 +51,7 @@ public:
         std::shared_ptr<compositor::CompositorReport> const& report);
 
     bool composite(SceneElementSequence&& scene_sequence) override;
+    void frame_posted(std::optional<std::chrono::nanoseconds> refresh_period) override;
 
 private:
     graphics::DisplaySink& display_sink;
@@ -57,6 +59,7 @@ private:
     std::unique_ptr<graphics::RenderingProvider::FramebufferProvider> const fb_adaptor;
     std::shared_ptr<compositor::CompositorReport> const report;
     bool completed_first_render = false;
+    DamageTracker damage;
 };
 
 }
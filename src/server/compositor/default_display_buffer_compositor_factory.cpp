@@ -79,7 +79,15 @@ mc::DefaultDisplayBufferCompositorFactory::create_compositor_for(
     }
 
     auto const chosen_allocator = best_provider.second;
-    
+
+    // Renderers that draw straight into the display's buffers need no GL surface
+    if (auto renderer = renderer_factory->create_renderer_for_sink(display_sink))
+    {
+        renderer->set_viewport(display_sink.view_area());
+        return std::make_unique<DefaultDisplayBufferCompositor>(
+            display_sink, *chosen_allocator, std::move(renderer), report);
+    }
+
     auto output_surface = chosen_allocator->surface_for_sink(
         display_sink, *gl_config);
     auto renderer = renderer_factory->create_renderer_for(std::move(output_surface), chosen_allocator);
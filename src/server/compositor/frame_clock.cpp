@@ -0,0 +1,88 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/compositor/frame_clock.h"
+
+namespace mc = mir::compositor;
+
+namespace
+{
+thread_local std::shared_ptr<mc::FrameClock> this_thread_clock;
+}
+
+auto mc::FrameClock::for_this_thread() -> std::shared_ptr<FrameClock>
+{
+    return this_thread_clock;
+}
+
+void mc::FrameClock::set_for_this_thread(std::shared_ptr<FrameClock> const& clock)
+{
+    this_thread_clock = clock;
+}
+
+void mc::FrameClock::spawn(std::function<void()>&& work)
+{
+    std::lock_guard lock{mutex};
+    queued.push_back(std::move(work));
+}
+
+void mc::FrameClock::frame_presented(
+    time::Timestamp when,
+    std::optional<std::chrono::nanoseconds> interval,
+    std::optional<graphics::FramePresentation> const& presentation)
+{
+    std::unique_lock lock{mutex};
+    last_presented = when;
+    refresh_interval = interval;
+    this->presentation = presentation;
+    auto const ready = std::move(queued);
+    queued.clear();
+    lock.unlock();
+
+    for (auto const& work : ready)
+    {
+        work();
+    }
+}
+
+auto mc::FrameClock::last_presentation() const -> std::optional<graphics::FramePresentation>
+{
+    std::lock_guard lock{mutex};
+    return presentation;
+}
+
+auto mc::FrameClock::refresh() const -> std::optional<std::chrono::nanoseconds>
+{
+    std::lock_guard lock{mutex};
+    return refresh_interval;
+}
+
+auto mc::FrameClock::next_frame_after(time::Timestamp now) const -> std::optional<time::Timestamp>
+{
+    std::lock_guard lock{mutex};
+    if (!last_presented || !refresh_interval || *refresh_interval <= std::chrono::nanoseconds::zero())
+    {
+        return std::nullopt;
+    }
+
+    if (now < *last_presented)
+    {
+        return *last_presented;
+    }
+
+    auto const frames_since = (now - *last_presented) / *refresh_interval;
+    return *last_presented + (frames_since + 1) * *refresh_interval;
+}
@@ -0,0 +1,110 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "frame_scheduler.h"
+
+#include <algorithm>
+
+namespace mc = mir::compositor;
+
+using namespace std::chrono_literals;
+
+namespace
+{
+/// Until we've seen this many frames we don't trust the estimate and don't sleep at all
+std::size_t const min_samples = 8;
+
+/// Which percentile of recent frame times we plan for
+std::size_t const percentile = 95;
+
+/// Headroom for the work between rendering and the frame being scheduled for display
+auto const safety_margin = 1ms;
+
+/// How quickly we return to the estimate after backing off for a missed frame
+auto const backoff_decay = 50us;
+}
+
+void mc::FrameScheduler::frame_started(Clock::time_point when)
+{
+    started = when;
+}
+
+void mc::FrameScheduler::frame_rendered(Clock::time_point when)
+{
+    if (!started)
+    {
+        return;
+    }
+
+    samples[next_sample] = when - *started;
+    next_sample = (next_sample + 1) % max_samples;
+    sample_count = std::min(sample_count + 1, max_samples);
+}
+
+void mc::FrameScheduler::frame_posted(Clock::time_point when, std::optional<std::chrono::nanoseconds> new_budget)
+{
+    auto const sleep = recommended_sleep();
+
+    /* We can only tell whether we were late if this frame started when we
+     * planned, rather than (say) after the compositor had been idle.
+     */
+    if (started && last_posted && budget && sleep && *started - *last_posted <= *sleep + *budget / 4)
+    {
+        if (when - *last_posted > *budget * 3 / 2)
+        {
+            // We missed the deadline; start earlier until we have evidence it's safe not to
+            backoff = std::min(backoff + *budget / 8, *budget);
+        }
+        else
+        {
+            backoff = std::max(backoff - backoff_decay, std::chrono::nanoseconds::zero());
+        }
+    }
+
+    started.reset();
+    last_posted = when;
+    budget = new_budget;
+}
+
+auto mc::FrameScheduler::recommended_sleep() const -> std::optional<std::chrono::nanoseconds>
+{
+    if (!budget)
+    {
+        return std::nullopt;
+    }
+
+    if (sample_count < min_samples)
+    {
+        return std::chrono::nanoseconds::zero();
+    }
+
+    auto const sleep = *budget - predicted_render_time() - safety_margin - backoff;
+    return std::max(sleep, std::chrono::nanoseconds::zero());
+}
+
+auto mc::FrameScheduler::predicted_render_time() const -> std::chrono::nanoseconds
+{
+    if (sample_count == 0)
+    {
+        return std::chrono::nanoseconds::zero();
+    }
+
+    std::array<std::chrono::nanoseconds, max_samples> sorted;
+    auto const end = std::copy_n(samples.begin(), sample_count, sorted.begin());
+    auto const nth = sorted.begin() + std::min(sample_count * percentile / 100, sample_count - 1);
+    std::nth_element(sorted.begin(), nth, end);
+    return *nth;
+}
@@ -0,0 +1,85 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_COMPOSITOR_FRAME_SCHEDULER_H_
+#define MIR_COMPOSITOR_FRAME_SCHEDULER_H_
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <optional>
+
+namespace mir
+{
+namespace compositor
+{
+
+/**
+ * Decides how long the compositor can sleep after posting a frame before it
+ * needs to start on the next one.
+ *
+ * Starting as late as possible minimises the time between sampling the scene
+ * (and the input that changed it) and the result reaching the screen. So we
+ * keep a rolling window of how long compositing has actually taken and aim to
+ * finish a safety margin ahead of the deadline given by the display. If we
+ * notice we've missed a deadline anyway, we back off and start earlier.
+ */
+class FrameScheduler
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    /// Compositing of a frame started at \a when
+    void frame_started(Clock::time_point when);
+
+    /// The frame is complete and about to be posted at \a when
+    void frame_rendered(Clock::time_point when);
+
+    /**
+     * The frame was posted, and post() returned at \a when
+     *
+     * \param [in] budget   How long the display allows, from post() returning,
+     *                      before the next frame must be submitted; nullopt if
+     *                      the display doesn't pace frames.
+     */
+    void frame_posted(Clock::time_point when, std::optional<std::chrono::nanoseconds> budget);
+
+    /**
+     * How long to sleep, from the last frame being posted, before starting the next frame.
+     *
+     * This is nullopt if the display did not give a budget for the last frame.
+     */
+    auto recommended_sleep() const -> std::optional<std::chrono::nanoseconds>;
+
+    /// The (high percentile) estimate of how long a frame takes to composite
+    auto predicted_render_time() const -> std::chrono::nanoseconds;
+
+private:
+    static std::size_t constexpr max_samples = 64;
+    std::array<std::chrono::nanoseconds, max_samples> samples;
+    std::size_t sample_count{0};
+    std::size_t next_sample{0};
+
+    std::optional<Clock::time_point> started;
+    std::optional<Clock::time_point> last_posted;
+    std::optional<std::chrono::nanoseconds> budget;
+    std::chrono::nanoseconds backoff{0};
+};
+
+}
+}
+
+#endif // MIR_COMPOSITOR_FRAME_SCHEDULER_H_
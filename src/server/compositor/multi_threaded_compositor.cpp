@@ -15,6 +15,8 @@
  */
 
 #include "multi_threaded_compositor.h"
+#include "frame_scheduler.h"
+#include "mir/compositor/frame_clock.h"
 #include "mir/graphics/display.h"
 #include "mir/graphics/display_sink.h"
 #include "mir/compositor/display_buffer_compositor.h"
@@ -34,6 +36,7 @@
 #include <thread>
 #include <chrono>
 #include <condition_variable>
+#include <optional>
 #include <boost/throw_exception.hpp>
 
 using namespace std::literals::chrono_literals;
@@ -87,14 +90,21 @@ public:
         {
             compositors.emplace_back(
                 std::make_tuple(&sink, compositor_factory->create_compositor_for(sink)));
-
-            auto const& r = sink.view_area();
-            auto const comp_id = std::get<1>(compositors.back()).get();
-            report->added_display(r.size.width.as_int(), r.size.height.as_int(),
-                                  r.top_left.x.as_int(), r.top_left.y.as_int(),
-                                  CompositorReport::SubCompositorId{comp_id});
         });
 
+        /*
+         * Anything waiting on our frames (such as client frame callbacks) needs to run
+         * even if we stop before presenting another frame.
+         */
+        auto const frame_clock = std::make_shared<FrameClock>();
+        auto const clock_registration = mir::raii::paired_calls(
+            [&frame_clock]{ FrameClock::set_for_this_thread(frame_clock); },
+            [&frame_clock]
+            {
+                FrameClock::set_for_this_thread(nullptr);
+                frame_clock->frame_presented(std::chrono::steady_clock::now(), std::nullopt);
+            });
+
         //Appease TSan, avoid destructor and this thread accessing the same shared_ptr instance
         auto const disp_listener = display_listener;
         auto display_registration = mir::raii::paired_calls(
@@ -116,6 +126,10 @@ public:
 
         started.set_value();
 
+        // Those compositors that composited the frame being posted
+        std::vector<mc::DisplayBufferCompositor*> composited;
+        composited.reserve(compositors.size());
+
         try
         {
             std::unique_lock lock{run_mutex};
@@ -141,27 +155,44 @@ public:
                     not_posted_yet = false;
                     lock.unlock();
 
-                    bool needs_post = false;
+                    scheduler.frame_started(FrameScheduler::Clock::now());
+
+                    composited.clear();
                     for (auto& tuple : compositors)
                     {
                         auto& compositor = std::get<1>(tuple);
                         if (compositor->composite(scene->scene_elements_for(compositor.get())))
-                            needs_post = true;
+                            composited.push_back(compositor.get());
                     }
 
                     // We can skip the post if none of the compositors ended up compositing
-                    if (needs_post)
+                    std::optional<std::chrono::nanoseconds> scheduled_sleep;
+                    if (!composited.empty())
+                    {
+                        scheduler.frame_rendered(FrameScheduler::Clock::now());
                         group.post();
+                        auto const posted = FrameScheduler::Clock::now();
+                        auto const budget = group.frame_budget();
+                        for (auto const compositor : composited)
+                            compositor->frame_posted(budget);
+                        scheduler.frame_posted(posted, budget);
+                        // Without a presentation from the group, clients are told their frames were discarded
+                        frame_clock->frame_presented(posted, budget, group.last_presentation());
+                        scheduled_sleep = scheduler.recommended_sleep();
+                    }
 
                     /*
-                     * "Predictive bypass" optimization: If the last frame was
-                     * bypassed/overlayed or you simply have a fast GPU, it is
-                     * beneficial to sleep for most of the next frame. This reduces
-                     * the latency between snapshotting the scene and post()
-                     * completing by almost a whole frame.
+                     * Sleeping for as much of the next frame as we can reduces the
+                     * latency between snapshotting the scene and post() completing
+                     * by up to a whole frame. Where the display tells us its
+                     * deadline we use our measured render times to decide how long
+                     * that is; otherwise we take the display's recommendation.
                      */
-                    auto delay = force_sleep >= std::chrono::milliseconds::zero() ?
-                                 force_sleep : group.recommended_sleep();
+                    std::chrono::nanoseconds delay = group.recommended_sleep();
+                    if (force_sleep >= std::chrono::milliseconds::zero())
+                        delay = force_sleep;
+                    else if (scheduled_sleep)
+                        delay = *scheduled_sleep;
                     std::this_thread::sleep_for(delay);
 
                     lock.lock();
@@ -257,6 +288,7 @@ private:
     bool running;
     int frames_scheduled;
     std::chrono::milliseconds force_sleep{-1};
+    FrameScheduler scheduler;
     std::mutex run_mutex;
     std::condition_variable run_cv;
     std::shared_ptr<DisplayListener> const display_listener;
@@ -27,6 +27,19 @@ using namespace mir::compositor;
 
 namespace
 {
+/// Remove \a hole from \a region, splitting any rectangles it partly covers
+void subtract(std::vector<Rectangle>& region, Rectangle const& hole)
+{
+    std::vector<Rectangle> remaining;
+    for (auto const& r : region)
+    {
+        auto const pieces = difference_of(r, hole);
+        remaining.insert(remaining.end(), pieces.begin(), pieces.end());
+    }
+
+    region = std::move(remaining);
+}
+
 bool renderable_is_occluded(
     Renderable const& renderable, 
     Rectangle const& area,
@@ -39,23 +52,33 @@ bool renderable_is_occluded(
         return false;  // Weirdly transformed. Assume never occluded.
 
     auto const& window = renderable.screen_position();
-    auto const& clipped_window = intersection_of(window, area);
+    auto clipped_window = intersection_of(window, area);
+    if (auto const clip = renderable.clip_area())
+        clipped_window = intersection_of(clipped_window, *clip);
 
     if (clipped_window == empty)
         return true;  // Not in the area; definitely occluded.
 
-    bool occluded = false;
+    // Occluded if nothing is left once everything opaque in front of it is taken away
+    std::vector<Rectangle> uncovered{clipped_window};
     for (auto const& r : coverage)
     {
-        if (r.contains(clipped_window))
-        {
-            occluded = true;
+        subtract(uncovered, r);
+        if (uncovered.empty())
             break;
-        }
     }
 
-    if (!occluded && renderable.alpha() == 1.0f && !renderable.shaped())
-        coverage.push_back(clipped_window);
+    bool const occluded = uncovered.empty();
+
+    if (!occluded && renderable.alpha() == 1.0f)
+    {
+        for (auto const& opaque : renderable.opaque_region())
+        {
+            auto const covered = intersection_of(opaque, clipped_window);
+            if (covered != empty)
+                coverage.push_back(covered);
+        }
+    }
 
     return occluded;
 }
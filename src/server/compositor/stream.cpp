@@ -19,6 +19,7 @@
 #include "dropping_schedule.h"
 #include "mir/graphics/buffer.h"
 #include <boost/throw_exception.hpp>
+#include <algorithm>
 #include <math.h>
 
 #include <cmath>
@@ -41,19 +42,51 @@ mc::Stream::Stream(
     latest_buffer_size(size),
     pf(pf),
     first_frame_posted(false),
-    frame_callback{[](auto){}}
+    frame_callback{[](auto, auto){}}
 {
 }
 
 mc::Stream::~Stream() = default;
 
-void mc::Stream::submit_buffer(std::shared_ptr<mg::Buffer> const& buffer)
+namespace
+{
+/* A client submitting faster than we composite can get this far ahead
+ * of the compositor before we stop tracking its damage precisely.
+ */
+size_t const max_damage_history = 16;
+}
+
+void mc::Stream::submit_buffer(std::shared_ptr<mg::Buffer> const& buffer, geom::Rectangles const& damage)
 {
     if (!buffer)
         BOOST_THROW_EXCEPTION(std::invalid_argument("cannot submit null buffer"));
 
+    geom::Rectangle const extent{{}, buffer->size()};
+    geom::Rectangles buffer_damage;
     {
         std::lock_guard lk(mutex);
+        if (!first_frame_posted || buffer->size() != latest_buffer_size)
+        {
+            buffer_damage.add(extent);
+        }
+        else
+        {
+            for (auto const& rect : damage)
+            {
+                auto const clipped = intersection_of(rect, extent);
+                if (clipped.size.width > geom::Width{0} && clipped.size.height > geom::Height{0})
+                {
+                    buffer_damage.add(clipped);
+                }
+            }
+        }
+
+        damage_history.emplace_back(buffer->id(), buffer_damage);
+        if (damage_history.size() > max_damage_history)
+        {
+            damage_history.pop_front();
+        }
+
         pf = buffer->pixel_format();
         latest_buffer_size = buffer->size();
         schedule->schedule(buffer);
@@ -61,7 +94,7 @@ void mc::Stream::submit_buffer(std::shared_ptr<mg::Buffer> const& buffer)
     }
     {
         std::lock_guard lock{callback_mutex};
-        frame_callback(buffer->size());
+        frame_callback(buffer->size(), buffer_damage);
     }
 }
 
@@ -78,7 +111,7 @@ MirPixelFormat mc::Stream::pixel_format() const
 }
 
 void mc::Stream::set_frame_posted_callback(
-    std::function<void(geometry::Size const&)> const& callback)
+    std::function<void(geometry::Size const&, geometry::Rectangles const&)> const& callback)
 {
     std::lock_guard lock{callback_mutex};
     frame_callback = callback;
@@ -164,3 +197,30 @@ void mc::Stream::set_scale(float scale)
     std::lock_guard lk(mutex);
     scale_ = scale;
 }
+
+auto mc::Stream::damage_between(mg::BufferID from, mg::BufferID to) const -> std::optional<geom::Rectangles>
+{
+    std::lock_guard lk(mutex);
+
+    auto const newest = std::find_if(
+        damage_history.rbegin(),
+        damage_history.rend(),
+        [to](auto const& entry) { return entry.first == to; });
+
+    geom::Rectangles damage;
+    for (auto entry = newest; entry != damage_history.rend(); ++entry)
+    {
+        if (entry->first == from)
+        {
+            return damage;
+        }
+
+        for (auto const& rect : entry->second)
+        {
+            damage.add(rect);
+        }
+    }
+
+    // We don't know what the client has changed since `from`
+    return std::nullopt;
+}
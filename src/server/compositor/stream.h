@@ -22,6 +22,7 @@
 #include "multi_monitor_arbiter.h"
 
 #include <atomic>
+#include <deque>
 #include <mutex>
 #include <memory>
 #include <set>
@@ -38,11 +39,13 @@ public:
     Stream(geometry::Size sz, MirPixelFormat format);
     ~Stream();
 
-    void submit_buffer(std::shared_ptr<graphics::Buffer> const& buffer) override;
+    void submit_buffer(
+        std::shared_ptr<graphics::Buffer> const& buffer,
+        geometry::Rectangles const& damage) override;
     void with_most_recent_buffer_do(std::function<void(graphics::Buffer&)> const& exec) override;
     MirPixelFormat pixel_format() const override;
     void set_frame_posted_callback(
-        std::function<void(geometry::Size const&)> const& callback) override;
+        std::function<void(geometry::Size const&, geometry::Rectangles const&)> const& callback) override;
     std::shared_ptr<graphics::Buffer>
         lock_compositor_buffer(void const* user_id) override;
     geometry::Size stream_size() override;
@@ -52,6 +55,8 @@ public:
     void drop_old_buffers() override;
     bool has_submitted_buffer() const override;
     void set_scale(float scale) override;
+    auto damage_between(graphics::BufferID from, graphics::BufferID to) const
+        -> std::optional<geometry::Rectangles> override;
 
 private:
     enum class ScheduleMode;
@@ -65,9 +70,11 @@ private:
     float scale_{1.0f};
     MirPixelFormat pf;
     std::atomic<bool> first_frame_posted;
+    /// Damage of the most recently submitted buffers, oldest first
+    std::deque<std::pair<graphics::BufferID, geometry::Rectangles>> damage_history;
 
     std::mutex callback_mutex;
-    std::function<void(geometry::Size const&)> frame_callback;
+    std::function<void(geometry::Size const&, geometry::Rectangles const&)> frame_callback;
 };
 }
 }
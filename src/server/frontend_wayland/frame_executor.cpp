@@ -17,8 +17,12 @@
 #include "frame_executor.h"
 
 #include <mir/main_loop.h>
+#include <mir/time/clock.h>
 
+#include <algorithm>
+#include <iterator>
 #include <mutex>
+#include <optional>
 #include <vector>
 
 namespace mf = mir::frontend;
@@ -26,33 +30,59 @@ namespace mf = mir::frontend;
 namespace
 {
 auto const delay = std::chrono::milliseconds{16};
+
+// Callbacks due this close together are run together, rather than setting the alarm again
+auto const slack = std::chrono::milliseconds{1};
 }
 
 struct mf::FrameExecutor::Callbacks
 {
+    explicit Callbacks(std::shared_ptr<mir::time::Clock> const& clock)
+        : clock{clock}
+    {
+    }
+
+    std::shared_ptr<mir::time::Clock> const clock;
     std::mutex mutex;
-    std::vector<std::function<void()>> queued;
+    std::vector<std::pair<mir::time::Timestamp, std::function<void()>>> queued;
+    /// Guarded by mutex: the executor may be destroyed while (or by) the alarm's callback runs
+    mir::time::Alarm* alarm{nullptr};
 };
 
-mf::FrameExecutor::FrameExecutor(time::AlarmFactory& alarm_factory)
-    : callbacks{std::make_shared<Callbacks>()},
+mf::FrameExecutor::FrameExecutor(time::AlarmFactory& alarm_factory, std::shared_ptr<time::Clock> const& clock)
+    : callbacks{std::make_shared<Callbacks>(clock)},
       alarm{alarm_factory.create_alarm([weak_callbacks = std::weak_ptr<Callbacks>{callbacks}]()
           {
               fire_callbacks(weak_callbacks);
           })}
 {
+    callbacks->alarm = alarm.get();
+}
+
+mf::FrameExecutor::~FrameExecutor()
+{
+    std::lock_guard lock{callbacks->mutex};
+    callbacks->alarm = nullptr;
 }
 
 void mf::FrameExecutor::spawn(std::function<void()>&& work)
 {
-    std::unique_lock lock{callbacks->mutex};
-    bool const needs_alarm = callbacks->queued.empty();
-    callbacks->queued.push_back(std::move(work));
-    lock.unlock();
+    spawn_at(callbacks->clock->now() + delay, std::move(work));
+}
+
+void mf::FrameExecutor::spawn_at(time::Timestamp when, std::function<void()>&& work)
+{
+    // The alarm is set under the lock, so concurrent spawns can't leave it set for the later one
+    std::lock_guard lock{callbacks->mutex};
+    bool const needs_alarm = std::all_of(
+        callbacks->queued.begin(),
+        callbacks->queued.end(),
+        [when](auto const& entry) { return when < entry.first; });
+    callbacks->queued.emplace_back(when, std::move(work));
 
     if (needs_alarm)
     {
-        alarm->reschedule_in(delay);
+        alarm->reschedule_for(when);
     }
 }
 
@@ -60,14 +90,39 @@ void mf::FrameExecutor::fire_callbacks(std::weak_ptr<Callbacks> const& weak_call
 {
     if (auto const callbacks = weak_callbacks.lock())
     {
+        auto const due = callbacks->clock->now() + slack;
+
         std::unique_lock lock{callbacks->mutex};
-        auto const queued = std::move(callbacks->queued);
-        callbacks->queued.clear();
+        auto const first_pending = std::stable_partition(
+            callbacks->queued.begin(),
+            callbacks->queued.end(),
+            [due](auto const& entry) { return entry.first <= due; });
+        std::vector<std::pair<time::Timestamp, std::function<void()>>> ready{
+            std::make_move_iterator(callbacks->queued.begin()),
+            std::make_move_iterator(first_pending)};
+        callbacks->queued.erase(callbacks->queued.begin(), first_pending);
         lock.unlock();
 
-        for (auto const& callback : queued)
+        for (auto const& entry : ready)
+        {
+            entry.second();
+        }
+
+        // Set the alarm for whatever is left, including anything spawned while the callbacks ran
+        lock.lock();
+        std::optional<time::Timestamp> next;
+        for (auto const& entry : callbacks->queued)
+        {
+            if (!next || entry.first < *next)
+            {
+                next = entry.first;
+            }
+        }
+
+        // A callback may have destroyed the executor, and with it the alarm
+        if (next && callbacks->alarm)
         {
-            callback();
+            callbacks->alarm->reschedule_for(*next);
         }
     }
 }
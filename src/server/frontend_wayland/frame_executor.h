@@ -18,6 +18,7 @@
 #define MIR_FRONTEND_FRAME_CALLBACK_EXECUTOR_H
 
 #include <mir/executor.h>
+#include <mir/time/types.h>
 
 #include <memory>
 
@@ -27,6 +28,7 @@ namespace time
 {
 class Alarm;
 class AlarmFactory;
+class Clock;
 }
 
 namespace frontend
@@ -36,12 +38,17 @@ namespace frontend
 class FrameExecutor : public Executor
 {
 public:
-    explicit FrameExecutor(time::AlarmFactory& alarm_factory);
+    FrameExecutor(time::AlarmFactory& alarm_factory, std::shared_ptr<time::Clock> const& clock);
+    ~FrameExecutor();
 
     // This can be called from any thread. Given callback is run on the main loop thread. The wayland executor is NOT
     // automatically used.
+    // As we don't know when the next frame will be, the callback is run after a typical refresh interval.
     void spawn(std::function<void()>&& work) override;
 
+    // As spawn(), but the callback is run at the given time (typically the next refresh of the relevant output).
+    void spawn_at(time::Timestamp when, std::function<void()>&& work);
+
 private:
     struct Callbacks;
 
@@ -0,0 +1,207 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "presentation_time.h"
+
+#include "wl_surface.h"
+
+#include <ctime>
+
+namespace mf = mir::frontend;
+namespace mg = mir::graphics;
+namespace mw = mir::wayland;
+
+namespace
+{
+/// The clock all our presentation timestamps are in. It's the clock KMS uses, if the driver allows.
+clockid_t const presentation_clock{CLOCK_MONOTONIC};
+
+auto in_presentation_clock(mir::time::PosixTimestamp const& timestamp) -> std::chrono::nanoseconds
+{
+    if (timestamp.clock_id == presentation_clock)
+    {
+        return timestamp.nanoseconds;
+    }
+
+    // Some drivers only timestamp with CLOCK_REALTIME; translate by the current offset between the clocks
+    auto const offset =
+        mir::time::PosixTimestamp::now(presentation_clock).nanoseconds -
+        mir::time::PosixTimestamp::now(timestamp.clock_id).nanoseconds;
+    return timestamp.nanoseconds + offset;
+}
+
+class Presentation : public mw::Presentation
+{
+public:
+    Presentation(wl_resource* new_resource)
+        : mw::Presentation{new_resource, Version<1>()}
+    {
+        send_clock_id_event(presentation_clock);
+    }
+
+private:
+    void feedback(wl_resource* surface, wl_resource* callback) override;
+};
+
+class PresentationFeedback : public mw::PresentationFeedback, public mf::PendingPresentationFeedback::Feedback
+{
+public:
+    PresentationFeedback(wl_resource* new_resource)
+        : mw::PresentationFeedback{new_resource, Version<1>()}
+    {
+    }
+
+    auto destroyed_flag() const -> std::shared_ptr<bool const> override
+    {
+        return mw::PresentationFeedback::destroyed_flag();
+    }
+
+    void presented(mg::FramePresentation const& presentation, std::optional<std::chrono::nanoseconds> refresh) override;
+    void discarded() override;
+};
+
+class PresentationGlobal : public mw::Presentation::Global
+{
+public:
+    PresentationGlobal(wl_display* display)
+        : Global{display, Version<1>()}
+    {
+    }
+
+private:
+    void bind(wl_resource* new_resource) override
+    {
+        new Presentation{new_resource};
+    }
+};
+
+void Presentation::feedback(wl_resource* surface, wl_resource* callback)
+{
+    auto const feedback = new PresentationFeedback{callback};
+    mf::WlSurface::from(surface)->add_presentation_feedback(mw::make_weak<mf::PendingPresentationFeedback::Feedback>(feedback));
+}
+
+void PresentationFeedback::presented(
+    mg::FramePresentation const& presentation,
+    std::optional<std::chrono::nanoseconds> refresh)
+{
+    auto const since_epoch = in_presentation_clock(presentation.frame.ust);
+    auto const seconds = std::chrono::duration_cast<std::chrono::seconds>(since_epoch);
+    auto const nanoseconds = since_epoch - seconds;
+    auto const sec = static_cast<uint64_t>(seconds.count());
+    auto const seq = static_cast<uint64_t>(presentation.frame.msc);
+
+    uint32_t flags = 0;
+    if (presentation.vsync)
+        flags |= mw::PresentationFeedback::Kind::vsync;
+    if (presentation.hw_clock)
+        flags |= mw::PresentationFeedback::Kind::hw_clock;
+    if (presentation.hw_completion)
+        flags |= mw::PresentationFeedback::Kind::hw_completion;
+    if (presentation.zero_copy)
+        flags |= mw::PresentationFeedback::Kind::zero_copy;
+
+    send_presented_event(
+        sec >> 32,
+        sec & 0xffffffff,
+        nanoseconds.count(),
+        refresh ? refresh->count() : 0,
+        seq >> 32,
+        seq & 0xffffffff,
+        flags);
+    destroy_and_delete();
+}
+
+void PresentationFeedback::discarded()
+{
+    send_discarded_event();
+    destroy_and_delete();
+}
+}
+
+auto mf::create_presentation_time(wl_display* display) -> std::shared_ptr<mw::Presentation::Global>
+{
+    return std::make_shared<PresentationGlobal>(display);
+}
+
+mf::PendingPresentationFeedback::PendingPresentationFeedback(std::vector<mw::Weak<Feedback>> feedbacks)
+    : feedbacks{std::move(feedbacks)}
+{
+}
+
+auto mf::PendingPresentationFeedback::claim() -> bool
+{
+    return !claimed.exchange(true);
+}
+
+void mf::PendingPresentationFeedback::send(
+    std::optional<mg::FramePresentation> const& presentation,
+    std::optional<std::chrono::nanoseconds> refresh)
+{
+    for (auto const& feedback : feedbacks)
+    {
+        if (!feedback)
+        {
+            continue;
+        }
+
+        if (presentation)
+        {
+            feedback.value().presented(*presentation, refresh);
+        }
+        else
+        {
+            feedback.value().discarded();
+        }
+    }
+}
+
+mf::SurfacePresentationFeedback::~SurfacePresentationFeedback()
+{
+    discard_unpresented();
+}
+
+auto mf::SurfacePresentationFeedback::commit(
+    bool attaches_buffer,
+    bool has_content,
+    std::vector<mw::Weak<PendingPresentationFeedback::Feedback>> const& feedbacks)
+    -> std::shared_ptr<PendingPresentationFeedback>
+{
+    // A new buffer supersedes the last one, so if that hasn't been presented yet it never will be
+    if (attaches_buffer)
+    {
+        discard_unpresented();
+    }
+
+    if (attaches_buffer && has_content && !feedbacks.empty())
+    {
+        unpresented = std::make_shared<PendingPresentationFeedback>(feedbacks);
+        return unpresented;
+    }
+
+    // Without new content there's nothing for this feedback to report on
+    PendingPresentationFeedback{feedbacks}.send(std::nullopt, std::nullopt);
+    return nullptr;
+}
+
+void mf::SurfacePresentationFeedback::discard_unpresented()
+{
+    if (unpresented && unpresented->claim())
+    {
+        unpresented->send(std::nullopt, std::nullopt);
+    }
+    unpresented.reset();
+}
@@ -0,0 +1,117 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_FRONTEND_PRESENTATION_TIME_H_
+#define MIR_FRONTEND_PRESENTATION_TIME_H_
+
+#include "presentation-time_wrapper.h"
+#include "mir/graphics/frame.h"
+#include "mir/wayland/weak.h"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <optional>
+#include <vector>
+
+namespace mir
+{
+namespace frontend
+{
+auto create_presentation_time(wl_display* display) -> std::shared_ptr<wayland::Presentation::Global>;
+
+/**
+ * The wp_presentation feedback requested for one content update of a surface
+ *
+ * The feedback is claimed either by the compositor that consumes the update's buffer (which sends presented once
+ * its frame is on screen) or by the surface's next content update (which sends discarded), whichever is first.
+ */
+class PendingPresentationFeedback
+{
+public:
+    /// A wp_presentation_feedback object, as we need it here
+    class Feedback
+    {
+    public:
+        virtual ~Feedback() = default;
+        virtual auto destroyed_flag() const -> std::shared_ptr<bool const> = 0;
+
+        /**
+         * Send the presented event for \a presentation, and destroy the feedback
+         *
+         * \param [in] refresh  The interval until the output's next refresh, if it is constant and known
+         */
+        virtual void presented(
+            graphics::FramePresentation const& presentation,
+            std::optional<std::chrono::nanoseconds> refresh) = 0;
+
+        /// Send the discarded event, and destroy the feedback
+        virtual void discarded() = 0;
+    };
+
+    PendingPresentationFeedback(std::vector<wayland::Weak<Feedback>> feedbacks);
+
+    /// \return true if the caller is now responsible for sending the feedback
+    auto claim() -> bool;
+
+    /**
+     * Send each feedback that still exists presented, or discarded if there's no \a presentation
+     *
+     * Must be called on the Wayland thread
+     */
+    void send(std::optional<graphics::FramePresentation> const& presentation, std::optional<std::chrono::nanoseconds> refresh);
+
+private:
+    std::atomic<bool> claimed{false};
+    std::vector<wayland::Weak<Feedback>> const feedbacks;
+};
+
+/**
+ * The presentation feedback of a surface's content updates
+ *
+ * Must be used on the Wayland thread
+ */
+class SurfacePresentationFeedback
+{
+public:
+    SurfacePresentationFeedback() = default;
+    /// Any feedback not yet claimed is discarded
+    ~SurfacePresentationFeedback();
+
+    /**
+     * A content update requesting \a feedbacks was committed
+     *
+     * \param [in] attaches_buffer   The update attaches a buffer (or removes the surface's buffer), so any
+     *                               buffer we're still waiting to present never will be
+     * \param [in] has_content       There's a new buffer for a compositor to present
+     * \return                       The feedback for a compositor consuming the new buffer to claim, if any
+     */
+    auto commit(
+        bool attaches_buffer,
+        bool has_content,
+        std::vector<wayland::Weak<PendingPresentationFeedback::Feedback>> const& feedbacks)
+        -> std::shared_ptr<PendingPresentationFeedback>;
+
+private:
+    void discard_unpresented();
+
+    /// Presentation feedback for the buffer last submitted, until a compositor consumes it
+    std::shared_ptr<PendingPresentationFeedback> unpresented;
+};
+}
+}
+
+#endif // MIR_FRONTEND_PRESENTATION_TIME_H_
@@ -202,13 +202,18 @@ auto ErrorNotifyingRWMappableBuffer::map_writeable() -> std::unique_ptr<mrs::Map
 
 auto mf::ShmBuffer::data() -> std::shared_ptr<mrs::RWMappableBuffer>
 {
-    return std::make_shared<ErrorNotifyingRWMappableBuffer>(
-        wayland::make_weak<mf::ShmBuffer>(this),
-        wayland_executor,
-        data_,
-        size_,
-        stride_,
-        format_.as_mir_format().value());
+    // Each commit of this buffer gets the same object, so the graphics platform can tell it's the same buffer
+    if (!mappable)
+    {
+        mappable = std::make_shared<ErrorNotifyingRWMappableBuffer>(
+            wayland::make_weak<mf::ShmBuffer>(this),
+            wayland_executor,
+            data_,
+            size_,
+            stride_,
+            format_.as_mir_format().value());
+    }
+    return mappable;
 }
 
 auto mf::ShmBuffer::from(wl_resource* resource) -> ShmBuffer*
@@ -67,6 +67,7 @@ private:
     geometry::Size const size_;
     geometry::Stride const stride_;
     graphics::DRMFormat const format_;
+    std::shared_ptr<renderer::software::RWMappableBuffer> mappable;  ///< What data() returns, once created
 };
 
 class ShmPool : public wayland::ShmPool
@@ -39,6 +39,8 @@
 #include "wlr_screencopy_v1.h"
 #include "primary_selection_v1.h"
 #include "session_lock_v1.h"
+#include "presentation_time.h"
+#include "tearing_control_v1.h"
 
 #include "mir/graphics/platform.h"
 #include "mir/options/default_configuration.h"
@@ -207,6 +209,14 @@ std::vector<ExtensionBuilder> const internal_extension_builders = {
                 *ctx.seat,
                 ctx.output_manager);
         }),
+    make_extension_builder<mw::Presentation>([](auto const& ctx)
+        {
+            return mf::create_presentation_time(ctx.display);
+        }),
+    make_extension_builder<mw::TearingControlManagerV1>([](auto const& ctx)
+        {
+            return mf::create_tearing_control_manager_v1(ctx.display);
+        }),
 };
 
 ExtensionBuilder const xwayland_builder {
@@ -305,7 +315,8 @@ auto mf::get_standard_extensions() -> std::vector<std::string>
         mw::XdgOutputManagerV1::interface_name,
         mw::TextInputManagerV1::interface_name,
         mw::TextInputManagerV2::interface_name,
-        mw::TextInputManagerV3::interface_name};
+        mw::TextInputManagerV3::interface_name,
+        mw::Presentation::interface_name};
 }
 
 auto mf::get_supported_extensions() -> std::vector<std::string>
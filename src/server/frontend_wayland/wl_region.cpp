@@ -16,8 +16,6 @@
 
 #include "wl_region.h"
 
-#include <mir/log.h>
-
 namespace mf = mir::frontend;
 namespace geom = mir::geometry;
 namespace mw = mir::wayland;
@@ -47,9 +45,13 @@ void mf::WlRegion::add(int32_t x, int32_t y, int32_t width, int32_t height)
 
 void mf::WlRegion::subtract(int32_t x, int32_t y, int32_t width, int32_t height)
 {
-    (void)x;
-    (void)y;
-    (void)width;
-    (void)height;
-    log_warning("WlRegion::subtract not implemented. ignoring.");
+    geom::Rectangle const hole{{x, y}, {width, height}};
+
+    std::vector<geom::Rectangle> remaining;
+    for (auto const& rect : rects)
+    {
+        auto const pieces = difference_of(rect, hole);
+        remaining.insert(end(remaining), begin(pieces), end(pieces));
+    }
+    rects = std::move(remaining);
 }
@@ -22,6 +22,8 @@
 #include "wl_region.h"
 #include "shm.h"
 #include "resource_lifetime_tracker.h"
+#include "frame_executor.h"
+#include "presentation_time.h"
 
 #include "wayland_wrapper.h"
 
@@ -33,21 +35,51 @@
 #include "mir/scene/session.h"
 #include "mir/frontend/wayland.h"
 #include "mir/compositor/buffer_stream.h"
+#include "mir/compositor/frame_clock.h"
 #include "mir/executor.h"
 #include "mir/graphics/graphic_buffer_allocator.h"
 #include "mir/scene/surface.h"
 #include "mir/shell/surface_specification.h"
 #include "mir/log.h"
 
+#include <algorithm>
 #include <chrono>
+#include <cstdint>
 #include <boost/throw_exception.hpp>
 #include <wayland-server-protocol.h>
 
+namespace mc = mir::compositor;
+namespace mg = mir::graphics;
 namespace mf = mir::frontend;
 namespace geom = mir::geometry;
 namespace mw = mir::wayland;
 namespace msh = mir::shell;
 
+namespace
+{
+// Clients commonly damage "everything" with INT32_MAX sized rectangles, which would overflow
+// as soon as we offset or scale them. No buffer is anywhere near this big.
+auto const max_damage_coordinate = std::int64_t{1} << 16;
+
+auto clamped_damage(int32_t x, int32_t y, int32_t width, int32_t height) -> geom::Rectangle
+{
+    auto const clamp = [](std::int64_t value)
+        {
+            return static_cast<int>(std::clamp(value, -max_damage_coordinate, max_damage_coordinate));
+        };
+
+    auto const left = clamp(x);
+    auto const top = clamp(y);
+    auto const right = clamp(std::int64_t{x} + std::max(width, 0));
+    auto const bottom = clamp(std::int64_t{y} + std::max(height, 0));
+
+    return {{left, top}, {right - left, bottom - top}};
+}
+
+// Beyond this many rectangles, the damage accumulated for an SHM buffer is tracked as its bounding rectangle
+auto const max_shm_damage_rectangles = 16u;
+}
+
 mf::WlSurfaceState::Callback::Callback(wl_resource* new_resource)
     : mw::Callback{new_resource, Version<1>()}
 {
@@ -67,10 +99,23 @@ void mf::WlSurfaceState::update_from(WlSurfaceState const& source)
     if (source.input_shape)
         input_shape = source.input_shape;
 
+    if (source.opaque_region)
+        opaque_region = source.opaque_region;
+
+    if (source.tearing)
+        tearing = source.tearing;
+
     frame_callbacks.insert(end(frame_callbacks),
                            begin(source.frame_callbacks),
                            end(source.frame_callbacks));
 
+    presentation_feedbacks.insert(end(presentation_feedbacks),
+                                  begin(source.presentation_feedbacks),
+                                  end(source.presentation_feedbacks));
+
+    surface_damage.insert(end(surface_damage), begin(source.surface_damage), end(source.surface_damage));
+    buffer_damage.insert(end(buffer_damage), begin(source.buffer_damage), end(source.buffer_damage));
+
     if (source.surface_data_invalidated)
         surface_data_invalidated = true;
 }
@@ -79,13 +124,15 @@ bool mf::WlSurfaceState::surface_data_needs_refresh() const
 {
     return offset ||
            input_shape ||
+           opaque_region ||
+           tearing ||
            surface_data_invalidated;
 }
 
 mf::WlSurface::WlSurface(
     wl_resource* new_resource,
     std::shared_ptr<Executor> const& wayland_executor,
-    std::shared_ptr<Executor> const& frame_callback_executor,
+    std::shared_ptr<FrameExecutor> const& frame_callback_executor,
     std::shared_ptr<graphics::GraphicBufferAllocator> const& allocator)
     : Surface(new_resource, Version<4>()),
         session{client->client_session()},
@@ -107,6 +154,8 @@ mf::WlSurface::~WlSurface()
     // all bases and non-variant members have already been destroyed."
     try
     {
+        PendingPresentationFeedback{std::move(pending.presentation_feedbacks)}.send(std::nullopt, std::nullopt);
+
         // Destroy the buffer stream first, as surface_destroyed() may throw
         session->destroy_buffer_stream(stream);
         role->surface_destroyed();
@@ -211,7 +260,7 @@ void mf::WlSurface::populate_surface_data(std::vector<shell::StreamSpecification
 {
     geometry::Displacement offset = parent_offset + offset_;
 
-    buffer_streams.push_back(msh::StreamSpecification{stream, offset, {}});
+    buffer_streams.push_back(msh::StreamSpecification{stream, offset, {}, opaque_region, tearing});
     geom::Rectangle surface_rect = {geom::Point{} + offset, buffer_size_.value_or(geom::Size{})};
     if (input_shape)
     {
@@ -263,6 +312,44 @@ void mf::WlSurface::send_frame_callbacks()
     frame_callbacks.clear();
 }
 
+auto mf::WlSurface::shm_damage_since_last_commit(
+    mw::Weak<ResourceLifetimeTracker> const& buffer,
+    geom::Rectangles const& damage) -> std::optional<geom::Rectangles>
+{
+    // Forget the buffers the client has destroyed
+    std::erase_if(shm_buffer_damage, [](auto const& entry) { return !entry.first; });
+
+    std::optional<geom::Rectangles> since_last_commit;
+    for (auto& [committed, accumulated] : shm_buffer_damage)
+    {
+        for (auto const& rect : damage)
+        {
+            accumulated.add(rect);
+        }
+        if (accumulated.size() > max_shm_damage_rectangles)
+        {
+            accumulated = {accumulated.bounding_rectangle()};
+        }
+
+        if (committed == buffer)
+        {
+            since_last_commit = std::move(accumulated);
+            accumulated.clear();
+        }
+    }
+
+    if (!since_last_commit)
+    {
+        shm_buffer_damage.emplace_back(buffer, geom::Rectangles{});
+    }
+    return since_last_commit;
+}
+
+void mf::WlSurface::add_presentation_feedback(mw::Weak<PendingPresentationFeedback::Feedback> const& feedback)
+{
+    pending.presentation_feedbacks.push_back(feedback);
+}
+
 void mf::WlSurface::attach(std::optional<wl_resource*> const& buffer, int32_t x, int32_t y)
 {
     if (x != 0 || y != 0)
@@ -275,20 +362,12 @@ void mf::WlSurface::attach(std::optional<wl_resource*> const& buffer, int32_t x,
 
 void mf::WlSurface::damage(int32_t x, int32_t y, int32_t width, int32_t height)
 {
-    (void)x;
-    (void)y;
-    (void)width;
-    (void)height;
-    // This isn't essential, but could enable optimizations
+    pending.surface_damage.push_back(clamped_damage(x, y, width, height));
 }
 
 void mf::WlSurface::damage_buffer(int32_t x, int32_t y, int32_t width, int32_t height)
 {
-    (void)x;
-    (void)y;
-    (void)width;
-    (void)height;
-    // This isn't essential, but could enable optimizations
+    pending.buffer_damage.push_back(clamped_damage(x, y, width, height));
 }
 
 void mf::WlSurface::frame(wl_resource* new_callback)
@@ -299,8 +378,17 @@ void mf::WlSurface::frame(wl_resource* new_callback)
 
 void mf::WlSurface::set_opaque_region(std::optional<wl_resource*> const& region)
 {
-    (void)region;
-    // This isn't essential, but could enable optimizations
+    // The compositor can skip drawing whatever is behind the opaque region
+    if (region)
+    {
+        auto shape = WlRegion::from(region.value())->rectangle_vector();
+        pending.opaque_region = decltype(pending.opaque_region)::value_type{std::move(shape)};
+    }
+    else
+    {
+        // A null region means nothing is known to be opaque
+        pending.opaque_region = decltype(pending.opaque_region)::value_type{};
+    }
 }
 
 void mf::WlSurface::set_input_region(std::optional<wl_resource*> const& region)
@@ -331,18 +419,71 @@ void mf::WlSurface::commit(WlSurfaceState const& state)
     if (state.input_shape)
         input_shape = state.input_shape.value();
 
+    if (state.opaque_region)
+        opaque_region = state.opaque_region.value();
+
+    if (state.tearing)
+        tearing = state.tearing.value();
+
     if (state.scale)
+    {
+        buffer_scale = state.scale.value();
         stream->set_scale(state.scale.value());
+    }
 
-    auto const executor_send_frame_callbacks = [executor = wayland_executor, weak_self = mw::make_weak(this)]()
+    auto const presentation_feedback = surface_presentation_feedback.commit(
+        state.buffer.has_value(),
+        state.buffer && state.buffer.value(),
+        state.presentation_feedbacks);
+
+    /* Frame callbacks tell the client when it's a good time to draw its next frame. So, when
+     * a compositor consumes our buffer we hold the callbacks until the frame it's compositing
+     * is presented, pacing the client to the refresh of the output it's being shown on.
+     * Presentation feedback is sent at the same time, with the details of that frame.
+     */
+    auto const executor_send_frame_callbacks =
+        [executor = wayland_executor, weak_self = mw::make_weak(this), presentation_feedback]()
         {
-            executor->spawn([weak_self]()
+            auto const clock = mc::FrameClock::for_this_thread();
+            // Other consumers (such as screencopy) don't present the buffer, so leave the feedback to a compositor
+            auto const presenting = clock && presentation_feedback && presentation_feedback->claim() ?
+                presentation_feedback : nullptr;
+            auto send = [executor, weak_self, weak_clock = std::weak_ptr{clock}, presenting]()
                 {
-                    if (weak_self)
+                    std::optional<mg::FramePresentation> presentation;
+                    std::optional<std::chrono::nanoseconds> refresh;
+                    if (auto const presenting_clock = weak_clock.lock())
                     {
-                        weak_self.value().send_frame_callbacks();
+                        presentation = presenting_clock->last_presentation();
+                        refresh = presenting_clock->refresh();
                     }
-                });
+
+                    executor->spawn([weak_self, weak_clock, presenting, presentation, refresh]()
+                        {
+                            if (presenting)
+                            {
+                                presenting->send(presentation, refresh);
+                            }
+
+                            if (weak_self)
+                            {
+                                if (!weak_clock.expired())
+                                {
+                                    weak_self.value().frame_clock = weak_clock;
+                                }
+                                weak_self.value().send_frame_callbacks();
+                            }
+                        });
+                };
+
+            if (clock)
+            {
+                clock->spawn(std::move(send));
+            }
+            else
+            {
+                send();
+            }
         };
 
     if (state.buffer)
@@ -369,10 +510,25 @@ void mf::WlSurface::commit(WlSurfaceState const& state)
                 };
             std::shared_ptr<graphics::Buffer> mir_buffer;
 
+            // The stream wants damage in buffer coordinates. We don't yet support buffer transforms,
+            // so surface coordinates only differ from buffer coordinates by the buffer scale.
+            geom::Rectangles damage;
+            for (auto const& rect : state.buffer_damage)
+            {
+                damage.add(rect);
+            }
+            for (auto const& rect : state.surface_damage)
+            {
+                damage.add({
+                    as_point(as_displacement(rect.top_left) * buffer_scale),
+                    rect.size * buffer_scale});
+            }
+
             if (auto const shm_buffer = ShmBuffer::from(weak_buffer.value()))
             {
                 mir_buffer = allocator->buffer_from_shm(
                     shm_buffer->data(),
+                    shm_damage_since_last_commit(weak_buffer, damage),
                     std::move(executor_send_frame_callbacks),
                     std::move(release_buffer));
                 tracepoint(
@@ -394,7 +550,7 @@ void mf::WlSurface::commit(WlSurfaceState const& state)
                     mir_buffer->id().as_value());
             }
 
-            stream->submit_buffer(mir_buffer);
+            stream->submit_buffer(mir_buffer, damage);
             auto const new_buffer_size = stream->stream_size();
 
             if (std::make_optional(new_buffer_size) != buffer_size_)
@@ -407,7 +563,17 @@ void mf::WlSurface::commit(WlSurfaceState const& state)
     }
     else
     {
-        frame_callback_executor->spawn(std::move(executor_send_frame_callbacks));
+        // Without a buffer there's nothing for the compositor to consume, so time the callbacks
+        // for the next refresh of the output we were last presented on (if we know it)
+        auto const clock = frame_clock.lock();
+        if (auto const next_frame = clock ? clock->next_frame_after(std::chrono::steady_clock::now()) : std::nullopt)
+        {
+            frame_callback_executor->spawn_at(*next_frame, std::move(executor_send_frame_callbacks));
+        }
+        else
+        {
+            frame_callback_executor->spawn(std::move(executor_send_frame_callbacks));
+        }
     }
 
     for (WlSubsurface* child: children)
@@ -427,11 +593,26 @@ void mf::WlSurface::commit()
     if (pending.input_shape && *pending.input_shape == input_shape)
         pending.input_shape = std::nullopt;
 
+    if (pending.opaque_region && *pending.opaque_region == opaque_region)
+        pending.opaque_region = std::nullopt;
+
+    if (pending.tearing && *pending.tearing == tearing)
+        pending.tearing = std::nullopt;
+
     // order is important
     auto const state = std::move(pending);
     pending = WlSurfaceState();
     role->commit(state);
 
+    // A fullscreen surface's buffers could be scanned out, so the allocator may steer it towards formats that can be
+    auto const surface = scene_surface();
+    auto const fullscreen = surface && surface.value() && surface.value()->state() == mir_window_state_fullscreen;
+    if (fullscreen != scanout_candidate)
+    {
+        scanout_candidate = fullscreen;
+        allocator->set_scanout_candidate(resource, scanout_candidate);
+    }
+
     if (scene_surface_created_callbacks.size())
     {
         if (auto const surface = scene_surface(); surface && surface.value())
@@ -18,6 +18,8 @@
 #define MIR_FRONTEND_WL_SURFACE_H
 
 #include "wayland_wrapper.h"
+#include "presentation_time.h"
+#include "tearing-control-v1_wrapper.h"
 #include "mir/wayland/weak.h"
 
 #include "wl_surface_role.h"
@@ -26,9 +28,11 @@
 #include "mir/geometry/size.h"
 #include "mir/geometry/point.h"
 #include "mir/geometry/rectangle.h"
+#include "mir/geometry/rectangles.h"
 
 #include <vector>
 #include <map>
+#include <memory>
 
 namespace mir
 {
@@ -49,9 +53,11 @@ struct StreamSpecification;
 namespace compositor
 {
 class BufferStream;
+class FrameClock;
 }
 namespace frontend
 {
+class FrameExecutor;
 class WlSurface;
 class WlSubsurface;
 class ResourceLifetimeTracker;
@@ -79,7 +85,12 @@ struct WlSurfaceState
     std::optional<int> scale;
     std::optional<geometry::Displacement> offset;
     std::optional<std::optional<std::vector<geometry::Rectangle>>> input_shape;
+    std::optional<std::optional<std::vector<geometry::Rectangle>>> opaque_region;
+    std::optional<bool> tearing; ///< Whether new content may be shown as soon as it's ready, even if that tears
     std::vector<wayland::Weak<Callback>> frame_callbacks;
+    std::vector<wayland::Weak<PendingPresentationFeedback::Feedback>> presentation_feedbacks;
+    std::vector<geometry::Rectangle> surface_damage; ///< In surface-local coordinates
+    std::vector<geometry::Rectangle> buffer_damage; ///< In buffer coordinates
 
 private:
     // only set to true if invalidate_surface_data() is called
@@ -107,7 +118,7 @@ class WlSurface : public wayland::Surface
 public:
     WlSurface(wl_resource* new_resource,
               std::shared_ptr<mir::Executor> const& wayland_executor,
-              std::shared_ptr<mir::Executor> const& frame_callback_executor,
+              std::shared_ptr<FrameExecutor> const& frame_callback_executor,
               std::shared_ptr<graphics::GraphicBufferAllocator> const& allocator);
 
     ~WlSurface();
@@ -137,6 +148,12 @@ public:
                                geometry::Displacement const& parent_offset) const;
     void commit(WlSurfaceState const& state);
     auto confine_pointer_state() const -> MirPointerConfinementState;
+    /// Request wp_presentation feedback for the pending content update
+    void add_presentation_feedback(wayland::Weak<PendingPresentationFeedback::Feedback> const& feedback);
+    /// The wp_tearing_control_v1 extending this surface, if any
+    auto tearing_control() const -> wayland::Weak<wayland::TearingControlV1> const& { return tearing_control_; }
+    void set_tearing_control(wayland::Weak<wayland::TearingControlV1> const& control) { tearing_control_ = control; }
+    void set_pending_tearing(bool allowed) { pending.tearing = allowed; }
 
     std::shared_ptr<scene::Session> const session;
     std::shared_ptr<compositor::BufferStream> const stream;
@@ -146,7 +163,7 @@ public:
 private:
     std::shared_ptr<mir::graphics::GraphicBufferAllocator> const allocator;
     std::shared_ptr<mir::Executor> const wayland_executor;
-    std::shared_ptr<mir::Executor> const frame_callback_executor;
+    std::shared_ptr<FrameExecutor> const frame_callback_executor;
 
     NullWlSurfaceRole null_role;
     WlSurfaceRole* role;
@@ -155,11 +172,26 @@ private:
     WlSurfaceState pending;
     geometry::Displacement offset_;
     std::optional<geometry::Size> buffer_size_;
+    int buffer_scale{1};
+    /// The clock of the compositor that most recently presented our content, if any
+    std::weak_ptr<compositor::FrameClock> frame_clock;
     std::vector<wayland::Weak<WlSurfaceState::Callback>> frame_callbacks;
+    SurfacePresentationFeedback surface_presentation_feedback;
     std::optional<std::vector<mir::geometry::Rectangle>> input_shape;
+    std::optional<std::vector<mir::geometry::Rectangle>> opaque_region;
+    bool tearing{false};
+    wayland::Weak<wayland::TearingControlV1> tearing_control_;
+    /// Whether we last told the allocator our buffers could be scanned out
+    bool scanout_candidate{false};
     std::vector<SceneSurfaceCreatedCallback> scene_surface_created_callbacks;
+    /// The SHM buffers committed to this surface, each with the damage (in buffer coordinates) since its last commit
+    std::vector<std::pair<wayland::Weak<ResourceLifetimeTracker>, geometry::Rectangles>> shm_buffer_damage;
 
     void send_frame_callbacks();
+    /// The regions of an SHM buffer that changed since it was last committed to this surface, if it has been
+    auto shm_damage_since_last_commit(
+        wayland::Weak<ResourceLifetimeTracker> const& buffer,
+        geometry::Rectangles const& damage) -> std::optional<geometry::Rectangles>;
 
     void attach(std::optional<wl_resource*> const& buffer, int32_t x, int32_t y) override;
     void damage(int32_t x, int32_t y, int32_t width, int32_t height) override;
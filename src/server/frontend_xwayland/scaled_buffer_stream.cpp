@@ -25,12 +25,15 @@ mf::ScaledBufferStream::ScaledBufferStream(std::shared_ptr<compositor::BufferStr
 {
 }
 
-void mf::ScaledBufferStream::submit_buffer(std::shared_ptr<graphics::Buffer> const& buffer)
+void mf::ScaledBufferStream::submit_buffer(
+    std::shared_ptr<graphics::Buffer> const& buffer,
+    geometry::Rectangles const& damage)
 {
-    inner->submit_buffer(buffer);
+    inner->submit_buffer(buffer, damage);
 }
 
-void mf::ScaledBufferStream::set_frame_posted_callback(std::function<void(geometry::Size const&)> const& callback)
+void mf::ScaledBufferStream::set_frame_posted_callback(
+    std::function<void(geometry::Size const&, geometry::Rectangles const&)> const& callback)
 {
     // Does this need to be scaled? I don't ? think ? so? compositor::Stream seems to leave it unscaled.
     inner->set_frame_posted_callback(callback);
@@ -88,4 +91,9 @@ auto mf::ScaledBufferStream::framedropping() const -> bool
     return inner->framedropping();
 }
 
-
+auto mf::ScaledBufferStream::damage_between(graphics::BufferID from, graphics::BufferID to) const
+    -> std::optional<geometry::Rectangles>
+{
+    // Damage is in buffer coordinates, so is unaffected by our scale
+    return inner->damage_between(from, to);
+}
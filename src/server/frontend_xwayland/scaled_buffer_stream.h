@@ -35,8 +35,9 @@ public:
 
     /// Overrides from frontend::BufferStream
     /// @{
-    void submit_buffer(std::shared_ptr<graphics::Buffer> const& buffer);
-    void set_frame_posted_callback(std::function<void(geometry::Size const&)> const& callback);
+    void submit_buffer(std::shared_ptr<graphics::Buffer> const& buffer, geometry::Rectangles const& damage);
+    void set_frame_posted_callback(
+        std::function<void(geometry::Size const&, geometry::Rectangles const&)> const& callback);
     void with_most_recent_buffer_do(std::function<void(graphics::Buffer&)> const& exec);
     MirPixelFormat pixel_format() const;
     void allow_framedropping(bool allow);
@@ -51,6 +52,7 @@ public:
     void drop_old_buffers();
     auto has_submitted_buffer() const -> bool;
     auto framedropping() const -> bool;
+    auto damage_between(graphics::BufferID from, graphics::BufferID to) const -> std::optional<geometry::Rectangles>;
     /// @}
 
 private:
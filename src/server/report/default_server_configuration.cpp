@@ -18,6 +18,7 @@
 #include "mir/options/configuration.h"
 
 #include "reports.h"
+#include "frame_statistics_report.h"
 #include "lttng_report_factory.h"
 #include "logging_report_factory.h"
 #include "null_report_factory.h"
@@ -64,7 +65,12 @@ auto mir::DefaultServerConfiguration::the_compositor_report() -> std::shared_ptr
     return compositor_report(
         [this]()->std::shared_ptr<mc::CompositorReport>
         {
-            return report_factory(options::compositor_report_opt)->create_compositor_report();
+            // Shells can poll frame statistics whichever report is chosen; the log report logs them too
+            auto const logged = the_options()->get<std::string>(options::compositor_report_opt) == options::log_opt_value;
+            return std::make_shared<report::FrameStatisticsReport>(
+                report_factory(options::compositor_report_opt)->create_compositor_report(),
+                the_clock(),
+                logged ? the_logger() : nullptr);
         });
 }
 
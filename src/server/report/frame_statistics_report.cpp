@@ -0,0 +1,222 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "frame_statistics_report.h"
+#include "mir/logging/logger.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <string>
+
+namespace ml = mir::logging;
+namespace mr = mir::report;
+
+namespace
+{
+char const* const component = "compositor";
+auto const min_report_interval = std::chrono::seconds(1);
+
+/// "p50/p95/p99/max", in milliseconds
+auto format_percentiles(mir::compositor::CompositorReport::FrameTimePercentiles const& p) -> std::string
+{
+    std::string result;
+    for (auto const value : {p.p50, p.p95, p.p99, p.max})
+    {
+        long usec = std::chrono::duration_cast<std::chrono::microseconds>(value).count();
+        char ms[32];
+        snprintf(ms, sizeof ms, "%s%ld.%03ld", result.empty() ? "" : "/", usec / 1000, usec % 1000);
+        result += ms;
+    }
+    return result;
+}
+}
+
+mr::FrameStatisticsReport::FrameStatisticsReport(
+    std::shared_ptr<compositor::CompositorReport> const& next,
+    std::shared_ptr<time::Clock> const& clock,
+    std::shared_ptr<ml::Logger> const& logger)
+    : next{next},
+      clock{clock},
+      logger{logger},
+      last_report{clock->now()}
+{
+}
+
+void mr::FrameStatisticsReport::added_display(int width, int height, int x, int y, SubCompositorId id)
+{
+    next->added_display(width, height, x, y, id);
+
+    std::lock_guard lock(mutex);
+    instance[id].display_area = {{x, y}, {width, height}};
+}
+
+void mr::FrameStatisticsReport::began_frame(SubCompositorId id)
+{
+    next->began_frame(id);
+
+    std::lock_guard lock(mutex);
+    instance[id].start_of_frame = clock->now();
+}
+
+void mr::FrameStatisticsReport::renderables_in_frame(SubCompositorId id, graphics::RenderableList const& renderables)
+{
+    next->renderables_in_frame(id, renderables);
+}
+
+void mr::FrameStatisticsReport::rendered_frame(SubCompositorId id)
+{
+    next->rendered_frame(id);
+
+    std::lock_guard lock(mutex);
+    auto& inst = instance[id];
+    inst.render_times.add(clock->now() - inst.start_of_frame);
+}
+
+void mr::FrameStatisticsReport::finished_frame(SubCompositorId id)
+{
+    next->finished_frame(id);
+
+    std::lock_guard lock(mutex);
+    if (auto const t = clock->now(); t - last_report >= min_report_interval)
+    {
+        last_report = t;
+
+        for (auto& i : instance)
+            i.second.complete_interval(logger.get(), i.first);
+    }
+}
+
+void mr::FrameStatisticsReport::rendered_frame_on_gpu(SubCompositorId id, std::chrono::nanoseconds gpu_time)
+{
+    next->rendered_frame_on_gpu(id, gpu_time);
+}
+
+void mr::FrameStatisticsReport::posted_frame(SubCompositorId id, std::optional<std::chrono::nanoseconds> refresh_period)
+{
+    next->posted_frame(id, refresh_period);
+
+    std::lock_guard lock(mutex);
+    auto& inst = instance[id];
+
+    auto const t = clock->now();
+    ++inst.frames;
+
+    std::optional<TimePoint> due = last_scheduled;
+    if (last_scheduled)
+    {
+        inst.latencies.add(t - *last_scheduled);
+    }
+    if (inst.last_post)
+    {
+        due = due ? std::max(*due, *inst.last_post) : *inst.last_post;
+
+        /*
+         * After the compositor has been idle, the time since the previous post shows
+         * how long nothing changed rather than how smoothly frames followed each other.
+         * So only a frame due within a refresh of the previous post has an interval.
+         * (Without a fixed refresh period every frame has one.)
+         */
+        if (!refresh_period || *due - *inst.last_post <= *refresh_period)
+        {
+            inst.frame_intervals.add(t - *inst.last_post);
+        }
+    }
+
+    /*
+     * A frame is due once it's scheduled and the previous frame is out of the
+     * way, and should be posted on the next refresh; any more refreshes before
+     * it's posted are missed. (This is an estimate: we only see when post()
+     * returns, not when the display actually refreshed.)
+     */
+    if (due && refresh_period && *refresh_period > std::chrono::nanoseconds::zero())
+    {
+        auto const refreshes = (t - *due + *refresh_period / 2) / *refresh_period;
+        if (refreshes > 1)
+            inst.missed_vblanks += refreshes - 1;
+    }
+
+    inst.last_post = t;
+}
+
+void mr::FrameStatisticsReport::started()
+{
+    next->started();
+}
+
+void mr::FrameStatisticsReport::stopped()
+{
+    next->stopped();
+
+    std::lock_guard lock(mutex);
+    instance.clear();
+}
+
+void mr::FrameStatisticsReport::scheduled()
+{
+    next->scheduled();
+
+    std::lock_guard lock(mutex);
+    last_scheduled = clock->now();
+}
+
+auto mr::FrameStatisticsReport::frame_statistics() const -> std::vector<FrameStatistics>
+{
+    std::lock_guard lock(mutex);
+
+    std::vector<FrameStatistics> result;
+    for (auto const& i : instance)
+    {
+        if (i.second.last_reported_statistics)
+            result.push_back(*i.second.last_reported_statistics);
+    }
+    return result;
+}
+
+void mr::FrameStatisticsReport::Instance::complete_interval(ml::Logger* logger, SubCompositorId id)
+{
+    FrameStatistics const statistics{
+        display_area,
+        frames,
+        frame_intervals.percentiles(),
+        render_times.percentiles(),
+        latencies.percentiles(),
+        missed_vblanks};
+
+    if (logger && frames)
+    {
+        char msg[256];
+        snprintf(msg, sizeof msg, "Display %p p50/p95/p99/max: "
+                 "frame interval %s ms, "
+                 "render %s ms, "
+                 "latency %s ms, "
+                 "%ld missed vblanks",
+                 id,
+                 format_percentiles(statistics.frame_interval).c_str(),
+                 format_percentiles(statistics.render_time).c_str(),
+                 format_percentiles(statistics.latency).c_str(),
+                 missed_vblanks);
+
+        logger->log(ml::Severity::informational, msg, component);
+    }
+
+    last_reported_statistics = statistics;
+    frames = 0;
+    frame_intervals.clear();
+    render_times.clear();
+    latencies.clear();
+    missed_vblanks = 0;
+}
@@ -0,0 +1,103 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef MIR_REPORT_FRAME_STATISTICS_REPORT_H_
+#define MIR_REPORT_FRAME_STATISTICS_REPORT_H_
+
+#include "frame_time_histogram.h"
+
+#include "mir/compositor/compositor_report.h"
+#include "mir/time/clock.h"
+
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+
+namespace mir
+{
+namespace logging
+{
+class Logger;
+}
+namespace report
+{
+
+/**
+ * Gathers the frame statistics of each display, passing everything on to another report
+ *
+ * This is composed around whichever compositor report is configured, so shells can poll
+ * frame_statistics() however the server reports otherwise.
+ */
+class FrameStatisticsReport : public compositor::CompositorReport
+{
+public:
+    /**
+     * \param next      The report everything is also passed to
+     * \param clock     To time frames by
+     * \param logger    If not null, each reporting interval's statistics are logged here
+     */
+    FrameStatisticsReport(
+        std::shared_ptr<compositor::CompositorReport> const& next,
+        std::shared_ptr<time::Clock> const& clock,
+        std::shared_ptr<mir::logging::Logger> const& logger);
+
+    void added_display(int width, int height, int x, int y, SubCompositorId id) override;
+    void began_frame(SubCompositorId id) override;
+    void renderables_in_frame(SubCompositorId id, graphics::RenderableList const& renderables) override;
+    void rendered_frame(SubCompositorId id) override;
+    void finished_frame(SubCompositorId id) override;
+    void rendered_frame_on_gpu(SubCompositorId id, std::chrono::nanoseconds gpu_time) override;
+    void posted_frame(SubCompositorId id, std::optional<std::chrono::nanoseconds> refresh_period) override;
+    void started() override;
+    void stopped() override;
+    void scheduled() override;
+    auto frame_statistics() const -> std::vector<FrameStatistics> override;
+
+private:
+    std::shared_ptr<compositor::CompositorReport> const next;
+    std::shared_ptr<time::Clock> const clock;
+    std::shared_ptr<mir::logging::Logger> const logger;
+
+    typedef time::Timestamp TimePoint;
+
+    /// Distributions over the current reporting interval
+    struct Instance
+    {
+        geometry::Rectangle display_area;
+        TimePoint start_of_frame;
+        std::optional<TimePoint> last_post;
+        long frames = 0;
+        FrameTimeHistogram frame_intervals;
+        FrameTimeHistogram render_times;
+        FrameTimeHistogram latencies;
+        long missed_vblanks = 0;
+        std::optional<FrameStatistics> last_reported_statistics;
+
+        void complete_interval(mir::logging::Logger* logger, SubCompositorId id);
+    };
+
+    std::mutex mutable mutex; // Protects the following...
+    std::unordered_map<SubCompositorId, Instance> instance;
+    std::optional<TimePoint> last_scheduled;
+    TimePoint last_report;
+};
+
+} // namespace report
+} // namespace mir
+
+#endif // MIR_REPORT_FRAME_STATISTICS_REPORT_H_
@@ -0,0 +1,65 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "frame_time_histogram.h"
+
+#include <algorithm>
+
+namespace mr = mir::report;
+
+void mr::FrameTimeHistogram::add(std::chrono::nanoseconds sample)
+{
+    sample = std::max(sample, std::chrono::nanoseconds::zero());
+    auto const bucket = std::min(static_cast<size_t>(sample / bucket_width), bucket_count - 1);
+    ++buckets[bucket];
+    ++count;
+    max = std::max(max, sample);
+}
+
+void mr::FrameTimeHistogram::clear()
+{
+    buckets.fill(0);
+    count = 0;
+    max = std::chrono::nanoseconds::zero();
+}
+
+auto mr::FrameTimeHistogram::samples() const -> long
+{
+    return count;
+}
+
+auto mr::FrameTimeHistogram::percentiles() const -> compositor::CompositorReport::FrameTimePercentiles
+{
+    return {percentile(500), percentile(950), percentile(990), max};
+}
+
+auto mr::FrameTimeHistogram::percentile(long per_mille) const -> std::chrono::nanoseconds
+{
+    // The smallest sample with at least per_mille/1000 of the samples no greater than it
+    auto const rank = std::max((count * per_mille + 999) / 1000, 1L);
+
+    long seen = 0;
+    for (size_t i = 0; i != bucket_count; ++i)
+    {
+        seen += buckets[i];
+        if (seen >= rank)
+        {
+            // Report the top of the bucket, but never more than was actually seen
+            return std::min<std::chrono::nanoseconds>((i + 1) * bucket_width, max);
+        }
+    }
+    return max;
+}
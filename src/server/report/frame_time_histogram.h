@@ -0,0 +1,61 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_REPORT_FRAME_TIME_HISTOGRAM_H_
+#define MIR_REPORT_FRAME_TIME_HISTOGRAM_H_
+
+#include "mir/compositor/compositor_report.h"
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+
+namespace mir
+{
+namespace report
+{
+
+/**
+ * Counts of frame timings in fixed-width buckets, from which percentiles are read
+ *
+ * Percentiles are accurate to the bucket width. Samples longer than the
+ * histogram covers all land in the last bucket; the exact maximum is kept
+ * separately.
+ */
+class FrameTimeHistogram
+{
+public:
+    static std::chrono::microseconds constexpr bucket_width{100};
+    static size_t constexpr bucket_count{1000};
+
+    void add(std::chrono::nanoseconds sample);
+    void clear();
+
+    auto samples() const -> long;
+    auto percentiles() const -> compositor::CompositorReport::FrameTimePercentiles;
+
+private:
+    auto percentile(long per_mille) const -> std::chrono::nanoseconds;
+
+    std::array<uint32_t, bucket_count> buckets{};
+    long count{0};
+    std::chrono::nanoseconds max{0};
+};
+
+} // namespace report
+} // namespace mir
+
+#endif // MIR_REPORT_FRAME_TIME_HISTOGRAM_H_
@@ -92,6 +92,12 @@ void mrl::CompositorReport::Instance::log(ml::Logger& logger, SubCompositorId id
                 latency_sum - last_reported_latency_sum
             ).count();
 
+        long long dg =
+            std::chrono::duration_cast<std::chrono::microseconds>(
+                gpu_time_sum - last_reported_gpu_time_sum
+            ).count();
+        auto dgn = ngpu_frames - last_reported_ngpu_frames;
+
         long bypass_percent = dn ? (nbypassed - last_reported_bypassed) * 100L / dn : 0;
 
         // Keep everything premultiplied by 1000 to guarantee accuracy
@@ -101,9 +107,19 @@ void mrl::CompositorReport::Instance::log(ml::Logger& logger, SubCompositorId id
         long avg_latency_usec = dn ? dl / dn : 0;
         long dt_msec = dt / 1000L;
 
-        char msg[128];
+        // GPU times arrive only from renderers that measure them
+        char gpu_msg[32] = "";
+        if (dgn)
+        {
+            long avg_gpu_time_usec = dg / dgn;
+            snprintf(gpu_msg, sizeof gpu_msg, " (GPU %ld.%03ld ms)",
+                     avg_gpu_time_usec / 1000,
+                     avg_gpu_time_usec % 1000);
+        }
+
+        char msg[192];
         snprintf(msg, sizeof msg, "Display %p averaged %ld.%03ld FPS, "
-                 "%ld.%03ld ms/frame, "
+                 "%ld.%03ld ms/frame%s, "
                  "latency %ld.%03ld ms, "
                  "%ld frames over %ld.%03ld sec, "
                  "%ld%% bypassed",
@@ -112,6 +128,7 @@ void mrl::CompositorReport::Instance::log(ml::Logger& logger, SubCompositorId id
                  frames_per_1000sec % 1000,
                  avg_render_time_usec / 1000,
                  avg_render_time_usec % 1000,
+                 gpu_msg,
                  avg_latency_usec / 1000,
                  avg_latency_usec % 1000,
                  dn,
@@ -126,7 +143,9 @@ void mrl::CompositorReport::Instance::log(ml::Logger& logger, SubCompositorId id
     last_reported_total_time_sum = total_time_sum;
     last_reported_render_time_sum = render_time_sum;
     last_reported_latency_sum = latency_sum;
+    last_reported_gpu_time_sum = gpu_time_sum;
     last_reported_nframes = nframes;
+    last_reported_ngpu_frames = ngpu_frames;
     last_reported_bypassed = nbypassed;
 }
 
@@ -164,6 +183,18 @@ void mrl::CompositorReport::finished_frame(SubCompositorId id)
     inst.prev_bypassed = inst.bypassed;
 }
 
+void mrl::CompositorReport::rendered_frame_on_gpu(SubCompositorId id, std::chrono::nanoseconds gpu_time)
+{
+    std::lock_guard lock(mutex);
+    auto& inst = instance[id];
+    inst.gpu_time_sum += gpu_time;
+    inst.ngpu_frames++;
+}
+
+void mrl::CompositorReport::posted_frame(SubCompositorId, std::optional<std::chrono::nanoseconds>)
+{
+}
+
 void mrl::CompositorReport::started()
 {
     logger->log(ml::Severity::informational, "Started", component);
@@ -182,3 +213,9 @@ void mrl::CompositorReport::scheduled()
     std::lock_guard lock(mutex);
     last_scheduled = now();
 }
+
+auto mrl::CompositorReport::frame_statistics() const -> std::vector<FrameStatistics>
+{
+    // FrameStatisticsReport gathers (and logs) these whichever report is used
+    return {};
+}
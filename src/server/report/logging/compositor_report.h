@@ -45,9 +45,12 @@ public:
     void renderables_in_frame(SubCompositorId id, graphics::RenderableList const& renderables) override;
     void rendered_frame(SubCompositorId id) override;
     void finished_frame(SubCompositorId id) override;
+    void rendered_frame_on_gpu(SubCompositorId id, std::chrono::nanoseconds gpu_time) override;
+    void posted_frame(SubCompositorId id, std::optional<std::chrono::nanoseconds> refresh_period) override;
     void started() override;
     void stopped() override;
     void scheduled() override;
+    auto frame_statistics() const -> std::vector<FrameStatistics> override;
 
 private:
     std::shared_ptr<mir::logging::Logger> const logger;
@@ -63,7 +66,9 @@ private:
         TimePoint total_time_sum;
         TimePoint render_time_sum;
         TimePoint latency_sum;
+        std::chrono::nanoseconds gpu_time_sum{0};
         long nframes = 0;
+        long ngpu_frames = 0;
         long nbypassed = 0;
         bool bypassed = true;
         bool prev_bypassed = false;
@@ -71,7 +76,9 @@ private:
         TimePoint last_reported_total_time_sum;
         TimePoint last_reported_render_time_sum;
         TimePoint last_reported_latency_sum;
+        std::chrono::nanoseconds last_reported_gpu_time_sum{0};
         long last_reported_nframes = 0;
+        long last_reported_ngpu_frames = 0;
         long last_reported_bypassed = 0;
 
         void log(mir::logging::Logger& logger, SubCompositorId id);
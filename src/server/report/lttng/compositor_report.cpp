@@ -60,3 +60,20 @@ void mir::report::lttng::CompositorReport::finished_frame(SubCompositorId id)
 {
     mir_tracepoint(mir_server_compositor, finished_frame, id);
 }
+
+void mir::report::lttng::CompositorReport::rendered_frame_on_gpu(SubCompositorId id, std::chrono::nanoseconds gpu_time)
+{
+    mir_tracepoint(mir_server_compositor, rendered_frame_on_gpu, id, gpu_time.count());
+}
+
+void mir::report::lttng::CompositorReport::posted_frame(
+    SubCompositorId id, std::optional<std::chrono::nanoseconds> refresh_period)
+{
+    mir_tracepoint(mir_server_compositor, posted_frame, id, refresh_period.value_or(std::chrono::nanoseconds::zero()).count());
+}
+
+auto mir::report::lttng::CompositorReport::frame_statistics() const -> std::vector<FrameStatistics>
+{
+    // Tracing tools compute these from the tracepoints themselves
+    return {};
+}
@@ -78,6 +78,26 @@ TRACEPOINT_EVENT_INSTANCE(
     TP_ARGS(void const*, id)
 )
 
+TRACEPOINT_EVENT(
+    mir_server_compositor,
+    rendered_frame_on_gpu,
+    TP_ARGS(void const*, id, int64_t, gpu_time_ns),
+    TP_FIELDS(
+        ctf_integer_hex(uintptr_t, id, (uintptr_t)(id))
+        ctf_integer(int64_t, gpu_time_ns, gpu_time_ns)
+    )
+)
+
+TRACEPOINT_EVENT(
+    mir_server_compositor,
+    posted_frame,
+    TP_ARGS(void const*, id, int64_t, refresh_period_ns),
+    TP_FIELDS(
+        ctf_integer_hex(uintptr_t, id, (uintptr_t)(id))
+        ctf_integer(int64_t, refresh_period_ns, refresh_period_ns)
+    )
+)
+
 TRACEPOINT_EVENT(
     mir_server_compositor,
     buffers_in_frame,
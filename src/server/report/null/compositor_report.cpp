@@ -38,6 +38,14 @@ void mrn::CompositorReport::finished_frame(SubCompositorId)
 {
 }
 
+void mrn::CompositorReport::rendered_frame_on_gpu(SubCompositorId, std::chrono::nanoseconds)
+{
+}
+
+void mrn::CompositorReport::posted_frame(SubCompositorId, std::optional<std::chrono::nanoseconds>)
+{
+}
+
 void mrn::CompositorReport::started()
 {
 }
@@ -49,3 +57,8 @@ void mrn::CompositorReport::stopped()
 void mrn::CompositorReport::scheduled()
 {
 }
+
+auto mrn::CompositorReport::frame_statistics() const -> std::vector<FrameStatistics>
+{
+    return {};
+}
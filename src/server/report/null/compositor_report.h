@@ -34,9 +34,12 @@ public:
     void renderables_in_frame(SubCompositorId id, graphics::RenderableList const& renderables) override;
     void rendered_frame(SubCompositorId id) override;
     void finished_frame(SubCompositorId id) override;
+    void rendered_frame_on_gpu(SubCompositorId id, std::chrono::nanoseconds gpu_time) override;
+    void posted_frame(SubCompositorId id, std::optional<std::chrono::nanoseconds> refresh_period) override;
     void started() override;
     void stopped() override;
     void scheduled() override;
+    auto frame_statistics() const -> std::vector<FrameStatistics> override;
 };
 
 } // namespace compositor
@@ -43,6 +43,21 @@ namespace msh = mir::shell;
 namespace mg = mir::graphics;
 namespace mev = mir::events;
 namespace mc = mir::compositor;
+namespace geom = mir::geometry;
+
+namespace
+{
+// The scene shares the opaque region with every snapshot, rather than copying it each frame
+auto shared_opaque_region(std::optional<std::vector<geom::Rectangle>> const& region)
+    -> std::shared_ptr<std::vector<geom::Rectangle> const>
+{
+    if (!region)
+    {
+        return nullptr;
+    }
+    return std::make_shared<std::vector<geom::Rectangle> const>(*region);
+}
+}
 
 ms::ApplicationSession::ApplicationSession(
     std::shared_ptr<msh::SurfaceStack> const& surface_stack,
@@ -102,7 +117,12 @@ auto ms::ApplicationSession::create_surface(
     std::list<StreamInfo> streams;
     for (auto& stream : params.streams.value())
     {
-        streams.push_back({std::dynamic_pointer_cast<mc::BufferStream>(stream.stream.lock()), stream.displacement, stream.size});
+        streams.push_back({
+            std::dynamic_pointer_cast<mc::BufferStream>(stream.stream.lock()),
+            stream.displacement,
+            stream.size,
+            shared_opaque_region(stream.opaque_region),
+            stream.tearing_allowed});
     }
 
     auto surface = surface_factory->create_surface(session, wayland_surface, streams, params);
@@ -318,7 +338,12 @@ void ms::ApplicationSession::configure_streams(
     for (auto& stream : streams)
     {
         if (auto const s = std::dynamic_pointer_cast<mc::BufferStream>(stream.stream.lock()))
-            list.emplace_back(ms::StreamInfo{s, stream.displacement, stream.size});
+            list.emplace_back(ms::StreamInfo{
+                s,
+                stream.displacement,
+                stream.size,
+                shared_opaque_region(stream.opaque_region),
+                stream.tearing_allowed});
     }
     surface.set_streams(list); 
 }
@@ -15,6 +15,7 @@
  */
 
 #include "basic_surface.h"
+#include "recycling_pool.h"
 #include "mir/compositor/buffer_stream.h"
 #include "mir/frontend/event_sink.h"
 #include "mir/graphics/buffer.h"
@@ -31,6 +32,7 @@
 
 #include <stdexcept>
 #include <algorithm>
+#include <cmath>
 
 namespace mc = mir::compositor;
 namespace ms = mir::scene;
@@ -138,6 +140,11 @@ public:
     {
         for_each_observer(&SurfaceObserver::application_id_set_to, surf, application_id);
     }
+
+    void input_region_set_to(Surface const* surf, std::vector<geom::Rectangle> const& region) override
+    {
+        for_each_observer(&SurfaceObserver::input_region_set_to, surf, region);
+    }
 };
 
 namespace
@@ -152,6 +159,30 @@ std::shared_ptr<mc::BufferStream> default_stream(std::list<ms::StreamInfo> const
         return layers.front().stream;
 }
 
+/// Map \a damage, in the coordinates of a buffer of \a buffer_size, onto \a destination, rounding outwards
+auto map_damage(geom::Rectangles const& damage, geom::Size const& buffer_size, geom::Rectangle const& destination)
+    -> geom::Rectangles
+{
+    geom::Rectangles mapped;
+    if (buffer_size.width <= geom::Width{0} || buffer_size.height <= geom::Height{0})
+    {
+        return mapped;
+    }
+
+    auto const x_scale = destination.size.width.as_int() / static_cast<float>(buffer_size.width.as_int());
+    auto const y_scale = destination.size.height.as_int() / static_cast<float>(buffer_size.height.as_int());
+    for (auto const& rect : damage)
+    {
+        int const left = std::floor(rect.left().as_int() * x_scale);
+        int const top = std::floor(rect.top().as_int() * y_scale);
+        int const right = std::ceil(rect.right().as_int() * x_scale);
+        int const bottom = std::ceil(rect.bottom().as_int() * y_scale);
+        mapped.add(intersection_of(
+            geom::Rectangle{destination.top_left + geom::Displacement{left, top}, {right - left, bottom - top}},
+            destination));
+    }
+    return mapped;
+}
 }
 
 ms::BasicSurface::BasicSurface(
@@ -178,6 +209,7 @@ ms::BasicSurface::BasicSurface(
         }
     },
     observers(std::make_shared<Multiplexer>()),
+    snapshot_pool{std::make_shared<RecyclingPool>()},
     session_{session},
     surface_buffer_stream(default_stream(layers)),
     report(report),
@@ -274,7 +306,15 @@ std::shared_ptr<mf::BufferStream> ms::BasicSurface::primary_buffer_stream() cons
 
 void ms::BasicSurface::set_input_region(std::vector<geom::Rectangle> const& input_rectangles)
 {
-    synchronised_state.lock()->custom_input_rectangles = input_rectangles;
+    auto state = synchronised_state.lock();
+    if (state->custom_input_rectangles != input_rectangles)
+    {
+        state->custom_input_rectangles = input_rectangles;
+
+        state.drop();
+
+        observers->input_region_set_to(this, input_rectangles);
+    }
 }
 
 std::vector<geom::Rectangle> ms::BasicSurface::get_input_region() const
@@ -683,6 +723,8 @@ public:
         std::optional<geom::Rectangle> const& clip_area,
         glm::mat4 const& transform,
         float alpha,
+        std::shared_ptr<std::vector<geom::Rectangle> const> const& opaque_region,
+        bool tearing_allowed,
         mg::Renderable::ID id)
     : underlying_buffer_stream{stream},
       compositor_id{compositor_id},
@@ -690,6 +732,8 @@ public:
       screen_position_(position),
       clip_area_(clip_area),
       transformation_(transform),
+      opaque_region_(opaque_region),
+      tearing_allowed_(tearing_allowed),
       id_(id)
     {
     }
@@ -720,8 +764,51 @@ public:
     bool shaped() const override
     { return mg::contains_alpha(underlying_buffer_stream->pixel_format()); }
 
+    auto opaque_region() const -> geom::Rectangles override
+    {
+        if (!shaped())
+        {
+            return {screen_position_};
+        }
+        if (!opaque_region_)
+        {
+            return {};
+        }
+
+        // The client has told us which parts of its (otherwise translucent) buffer are opaque
+        geom::Rectangles region;
+        for (auto const& rect : *opaque_region_)
+        {
+            auto const on_screen = intersection_of(
+                geom::Rectangle{screen_position_.top_left + as_displacement(rect.top_left), rect.size},
+                screen_position_);
+            if (on_screen.size.width > geom::Width{0} && on_screen.size.height > geom::Height{0})
+            {
+                region.add(on_screen);
+            }
+        }
+        return region;
+    }
+
+    bool tearing_allowed() const override
+    { return tearing_allowed_; }
+
     mg::Renderable::ID id() const override
     { return id_; }
+
+    auto damage_since(mg::BufferID previous) const -> std::optional<geom::Rectangles> override
+    {
+        auto const current = buffer();
+        if (!current)
+        {
+            return std::nullopt;
+        }
+        if (auto const damage = underlying_buffer_stream->damage_between(previous, current->id()))
+        {
+            return map_damage(*damage, current->size(), screen_position_);
+        }
+        return std::nullopt;
+    }
 private:
     std::shared_ptr<mc::BufferStream> const underlying_buffer_stream;
     std::shared_ptr<mg::Buffer> mutable compositor_buffer;
@@ -730,6 +817,8 @@ private:
     geom::Rectangle const screen_position_;
     std::optional<geom::Rectangle> const clip_area_;
     glm::mat4 const transformation_;
+    std::shared_ptr<std::vector<geom::Rectangle> const> const opaque_region_;
+    bool const tearing_allowed_;
     mg::Renderable::ID const id_;
 };
 }
@@ -776,13 +865,19 @@ void ms::BasicSurface::set_streams(std::list<scene::StreamInfo> const& s)
 
 mg::RenderableList ms::BasicSurface::generate_renderables(mc::CompositorID id) const
 {
-    auto state = synchronised_state.lock();
     mg::RenderableList list;
-    
+    append_renderables(id, list);
+    return list;
+}
+
+void ms::BasicSurface::append_renderables(mc::CompositorID id, mg::RenderableList& renderables) const
+{
+    auto state = synchronised_state.lock();
+
     if (state->clip_area)
     {
         if (!state->surface_rect.overlaps(state->clip_area.value()))
-            return list;
+            return;
     }
 
     auto const content_top_left_ = content_top_left(*state);
@@ -797,14 +892,15 @@ mg::RenderableList ms::BasicSurface::generate_renderables(mc::CompositorID id) c
             else
                 size = info.stream->stream_size();
 
-            list.emplace_back(std::make_shared<SurfaceSnapshot>(
+            renderables.emplace_back(std::allocate_shared<SurfaceSnapshot>(
+                RecyclingAllocator<SurfaceSnapshot>{snapshot_pool},
                 info.stream, id,
                 geom::Rectangle{content_top_left_ + info.displacement, std::move(size)},
                 state->clip_area,
-                state->transformation_matrix, state->surface_alpha, info.stream.get()));
+                state->transformation_matrix, state->surface_alpha, info.opaque_region,
+                info.tearing_allowed, info.stream.get()));
         }
     }
-    return list;
 }
 
 void ms::BasicSurface::set_confine_pointer_state(MirPointerConfinementState state)
@@ -945,7 +1041,7 @@ void mir::scene::BasicSurface::clear_frame_posted_callbacks(State& state)
 {
     for (auto& layer : state.layers)
     {
-        layer.stream->set_frame_posted_callback([](auto){});
+        layer.stream->set_frame_posted_callback([](auto, auto){});
     }
 }
 
@@ -956,12 +1052,18 @@ void mir::scene::BasicSurface::update_frame_posted_callbacks(State& state)
         auto const position = geom::Point{} + state.margins.left + state.margins.top + layer.displacement;
         layer.stream->set_frame_posted_callback(
             [this, observers=std::weak_ptr{observers}, position, explicit_size=layer.size, stream=layer.stream.get()]
-                (auto const&)
+                (geom::Size const& buffer_size, geom::Rectangles const& damage)
             {
                 auto const logical_size = explicit_size ? explicit_size.value() : stream->stream_size();
+                geom::Rectangle const extent{position, logical_size};
+                auto const damaged = map_damage(damage, buffer_size, extent).bounding_rectangle();
                 if (auto const o = observers.lock())
                 {
-                    o->frame_posted(this, 1, geom::Rectangle{position, logical_size});
+                    /* Even with no damage the compositor needs to consume the new buffer
+                     * (to release the old one and fire frame callbacks), so report the whole
+                     * stream in that case.
+                     */
+                    o->frame_posted(this, 1, damaged.size == geom::Size{} ? extent : damaged);
                 }
             });
     }
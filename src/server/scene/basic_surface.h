@@ -49,6 +49,7 @@ class Surface;
 namespace scene
 {
 class SceneReport;
+class RecyclingPool;
 class CursorStreamImageAdapter;
 
 class BasicSurface : public Surface
@@ -112,6 +113,7 @@ public:
     bool visible() const override;
 
     graphics::RenderableList generate_renderables(compositor::CompositorID id) const override;
+    void append_renderables(compositor::CompositorID id, graphics::RenderableList& renderables) const override;
     int buffers_ready_for_compositor(void const* compositor_id) const override;
 
     MirWindowType type() const override;
@@ -224,6 +226,8 @@ private:
     mir::Synchronised<State> synchronised_state;
 
     std::shared_ptr<Multiplexer> const observers;
+    /// Recycles the memory of the snapshots we generate every frame
+    std::shared_ptr<RecyclingPool> const snapshot_pool;
     std::weak_ptr<Session> const session_;
     std::shared_ptr<compositor::BufferStream> const surface_buffer_stream;
     std::shared_ptr<SceneReport> const report;
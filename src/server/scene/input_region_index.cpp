@@ -0,0 +1,181 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "input_region_index.h"
+#include "mir/scene/surface.h"
+
+#include <algorithm>
+
+namespace ms = mir::scene;
+namespace geom = mir::geometry;
+
+namespace
+{
+/// Cells are 256x256 logical pixels: a typical window overlaps a handful of them
+int const cell_shift = 8;
+
+/// A surface overlapping more cells than this (e.g. a huge input region) isn't listed in each of them
+long const max_cells_per_surface = 256;
+
+auto cell_key(int x, int y) -> std::uint64_t
+{
+    return (std::uint64_t{static_cast<std::uint32_t>(x)} << 32) | static_cast<std::uint32_t>(y);
+}
+
+auto input_region_bounds(ms::Surface const& surface) -> geom::Rectangle
+{
+    auto const content = surface.input_bounds();
+    auto const region = surface.get_input_region();
+
+    if (region.empty())
+    {
+        return content;
+    }
+
+    auto top_left = region.front().top_left;
+    auto bottom_right = region.front().bottom_right();
+    for (auto const& rect : region)
+    {
+        top_left.x = std::min(top_left.x, rect.left());
+        top_left.y = std::min(top_left.y, rect.top());
+        bottom_right.x = std::max(bottom_right.x, rect.right());
+        bottom_right.y = std::max(bottom_right.y, rect.bottom());
+    }
+
+    // The input region is relative to the content
+    return geom::Rectangle{
+        top_left + as_displacement(content.top_left),
+        as_size(bottom_right - top_left)};
+}
+}
+
+void ms::InputRegionIndex::add(Surface const& surface)
+{
+    std::lock_guard lock{mutex};
+
+    auto const range = cells_covering(input_region_bounds(surface));
+    if (auto const existing = entries.find(&surface); existing != entries.end())
+    {
+        erase_locked(&surface, existing->second);
+    }
+    insert_locked(&surface, range);
+    entries[&surface] = range;
+}
+
+void ms::InputRegionIndex::update(Surface const& surface)
+{
+    std::lock_guard lock{mutex};
+
+    auto const existing = entries.find(&surface);
+    if (existing == entries.end())
+    {
+        return;
+    }
+
+    auto const range = cells_covering(input_region_bounds(surface));
+    if (range != existing->second)
+    {
+        erase_locked(&surface, existing->second);
+        insert_locked(&surface, range);
+        existing->second = range;
+    }
+}
+
+void ms::InputRegionIndex::remove(Surface const& surface)
+{
+    std::lock_guard lock{mutex};
+
+    if (auto const existing = entries.find(&surface); existing != entries.end())
+    {
+        erase_locked(&surface, existing->second);
+        entries.erase(existing);
+    }
+}
+
+void ms::InputRegionIndex::candidates_at(geometry::Point point, std::vector<Surface const*>& candidates) const
+{
+    std::lock_guard lock{mutex};
+
+    candidates.insert(candidates.end(), oversized.begin(), oversized.end());
+
+    auto const cell = cells.find(cell_key(point.x.as_int() >> cell_shift, point.y.as_int() >> cell_shift));
+    if (cell != cells.end())
+    {
+        candidates.insert(candidates.end(), cell->second.begin(), cell->second.end());
+    }
+}
+
+auto ms::InputRegionIndex::cells_covering(geometry::Rectangle const& bounds) -> CellRange
+{
+    if (bounds.size.width <= geom::Width{0} || bounds.size.height <= geom::Height{0})
+    {
+        return {};
+    }
+
+    // The right and bottom edges are outside the rectangle
+    return CellRange{
+        bounds.left().as_int() >> cell_shift,
+        bounds.top().as_int() >> cell_shift,
+        ((bounds.right().as_int() - 1) >> cell_shift) + 1,
+        ((bounds.bottom().as_int() - 1) >> cell_shift) + 1};
+}
+
+auto ms::InputRegionIndex::is_oversized(CellRange const& range) -> bool
+{
+    return long{range.right - range.left} * long{range.bottom - range.top} > max_cells_per_surface;
+}
+
+void ms::InputRegionIndex::insert_locked(Surface const* surface, CellRange const& range)
+{
+    if (is_oversized(range))
+    {
+        oversized.push_back(surface);
+        return;
+    }
+
+    for (auto x = range.left; x != range.right; ++x)
+    {
+        for (auto y = range.top; y != range.bottom; ++y)
+        {
+            cells[cell_key(x, y)].push_back(surface);
+        }
+    }
+}
+
+void ms::InputRegionIndex::erase_locked(Surface const* surface, CellRange const& range)
+{
+    if (is_oversized(range))
+    {
+        std::erase(oversized, surface);
+        return;
+    }
+
+    for (auto x = range.left; x != range.right; ++x)
+    {
+        for (auto y = range.top; y != range.bottom; ++y)
+        {
+            auto const cell = cells.find(cell_key(x, y));
+            if (cell != cells.end())
+            {
+                std::erase(cell->second, surface);
+                if (cell->second.empty())
+                {
+                    cells.erase(cell);
+                }
+            }
+        }
+    }
+}
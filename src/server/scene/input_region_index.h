@@ -0,0 +1,90 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_SCENE_INPUT_REGION_INDEX_H_
+#define MIR_SCENE_INPUT_REGION_INDEX_H_
+
+#include "mir/geometry/rectangle.h"
+
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace mir
+{
+namespace scene
+{
+class Surface;
+
+/**
+ * Where surfaces might accept input, so that hit-testing a point need only check the few
+ * surfaces near it.
+ *
+ * Space is divided into a grid of square cells and each surface is listed in the cells
+ * overlapped by the bounding rectangle of its input region. The index is conservative: a
+ * surface listed at a point need not accept input there (it may be hidden, clipped or have
+ * a hole in its input region), but a surface that accepts input at a point is listed there.
+ *
+ * The index does not observe surfaces itself: whoever adds a surface must update() it when
+ * its position, size or input region changes and remove() it before it is destroyed.
+ * All functions may be called from any thread.
+ */
+class InputRegionIndex
+{
+public:
+    InputRegionIndex() = default;
+
+    InputRegionIndex(InputRegionIndex const&) = delete;
+    auto operator=(InputRegionIndex const&) -> InputRegionIndex& = delete;
+
+    /// Start indexing surface at its current input region
+    void add(Surface const& surface);
+    /// Re-read the input region of surface (if it is indexed)
+    void update(Surface const& surface);
+    void remove(Surface const& surface);
+
+    /// Append the surfaces whose input region might contain point (in no particular order)
+    void candidates_at(geometry::Point point, std::vector<Surface const*>& candidates) const;
+
+private:
+    /// A range of cells [left, right) x [top, bottom)
+    struct CellRange
+    {
+        int left{0};
+        int top{0};
+        int right{0};
+        int bottom{0};
+
+        auto operator==(CellRange const& other) const -> bool = default;
+    };
+
+    static auto cells_covering(geometry::Rectangle const& bounds) -> CellRange;
+    static auto is_oversized(CellRange const& range) -> bool;
+
+    void insert_locked(Surface const* surface, CellRange const& range);
+    void erase_locked(Surface const* surface, CellRange const& range);
+
+    std::mutex mutable mutex;
+    std::unordered_map<Surface const*, CellRange> entries;
+    std::unordered_map<std::uint64_t, std::vector<Surface const*>> cells;
+    /// Surfaces covering too many cells to list in each of them, checked for every point
+    std::vector<Surface const*> oversized;
+};
+}
+}
+
+#endif // MIR_SCENE_INPUT_REGION_INDEX_H_
@@ -0,0 +1,80 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "recycling_pool.h"
+
+#include <algorithm>
+#include <new>
+
+namespace ms = mir::scene;
+
+namespace
+{
+auto block_size(std::size_t size) -> std::size_t
+{
+    // Free blocks are linked through their own storage
+    return std::max(size, sizeof(void*));
+}
+}
+
+ms::RecyclingPool::~RecyclingPool()
+{
+    for (auto const& list : free_lists)
+    {
+        for (auto block = list.head; block;)
+        {
+            auto const next = block->next;
+            ::operator delete(block);
+            block = next;
+        }
+    }
+}
+
+auto ms::RecyclingPool::allocate(std::size_t size) -> void*
+{
+    size = block_size(size);
+
+    {
+        std::lock_guard lock{mutex};
+        auto const list = std::find_if(
+            free_lists.begin(), free_lists.end(), [size](auto const& list) { return list.size == size; });
+
+        if (list == free_lists.end())
+        {
+            // We'll want somewhere to put this block when it is freed
+            free_lists.push_back(FreeList{size, nullptr});
+        }
+        else if (auto const block = list->head)
+        {
+            list->head = block->next;
+            return block;
+        }
+    }
+
+    return ::operator new(size);
+}
+
+void ms::RecyclingPool::deallocate(void* block, std::size_t size) noexcept
+{
+    size = block_size(size);
+
+    std::lock_guard lock{mutex};
+    auto const list = std::find_if(
+        free_lists.begin(), free_lists.end(), [size](auto const& list) { return list.size == size; });
+
+    // Every block we hand out has a free list (created by allocate())
+    list->head = new (block) FreeBlock{list->head};
+}
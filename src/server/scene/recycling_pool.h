@@ -0,0 +1,119 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_SCENE_RECYCLING_POOL_H_
+#define MIR_SCENE_RECYCLING_POOL_H_
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace mir
+{
+namespace scene
+{
+/**
+ * Memory for objects that are created and destroyed over and over again, such
+ * as the snapshots the scene hands to the compositors every frame.
+ *
+ * Freed blocks are kept for the next allocation of the same size instead of
+ * going back to the heap, so once the pool has grown to the peak number of
+ * live objects no further heap allocations are made. Blocks may be allocated
+ * and freed from any thread.
+ */
+class RecyclingPool
+{
+public:
+    RecyclingPool() = default;
+    ~RecyclingPool();
+
+    RecyclingPool(RecyclingPool const&) = delete;
+    auto operator=(RecyclingPool const&) -> RecyclingPool& = delete;
+
+    auto allocate(std::size_t size) -> void*;
+    void deallocate(void* block, std::size_t size) noexcept;
+
+private:
+    struct FreeBlock
+    {
+        FreeBlock* next;
+    };
+
+    struct FreeList
+    {
+        std::size_t size;
+        FreeBlock* head;
+    };
+
+    std::mutex mutex;
+    std::vector<FreeList> free_lists;
+};
+
+/**
+ * An allocator drawing from a RecyclingPool, for use with std::allocate_shared()
+ *
+ * Each allocator (and so each object allocated with it) keeps the pool alive.
+ */
+template<typename T>
+class RecyclingAllocator
+{
+public:
+    using value_type = T;
+
+    explicit RecyclingAllocator(std::shared_ptr<RecyclingPool> pool) :
+        pool{std::move(pool)}
+    {
+    }
+
+    template<typename U>
+    RecyclingAllocator(RecyclingAllocator<U> const& other) :
+        pool{other.pool}
+    {
+    }
+
+    auto allocate(std::size_t n) -> T*
+    {
+        static_assert(alignof(T) <= alignof(std::max_align_t), "RecyclingPool does not support over-aligned types");
+        return static_cast<T*>(pool->allocate(n * sizeof(T)));
+    }
+
+    void deallocate(T* p, std::size_t n) noexcept
+    {
+        pool->deallocate(p, n * sizeof(T));
+    }
+
+    template<typename U>
+    auto operator==(RecyclingAllocator<U> const& other) const -> bool
+    {
+        return pool == other.pool;
+    }
+
+    template<typename U>
+    auto operator!=(RecyclingAllocator<U> const& other) const -> bool
+    {
+        return pool != other.pool;
+    }
+
+private:
+    template<typename U> friend class RecyclingAllocator;
+
+    std::shared_ptr<RecyclingPool> pool;
+};
+}
+}
+
+#endif // MIR_SCENE_RECYCLING_POOL_H_
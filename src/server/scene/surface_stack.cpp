@@ -16,6 +16,7 @@
 
 #include "surface_stack.h"
 #include "rendering_tracker.h"
+#include "recycling_pool.h"
 #include "mir/scene/surface.h"
 #include "mir/scene/null_surface_observer.h"
 #include "mir/scene/scene_report.h"
@@ -46,14 +47,12 @@ class SurfaceSceneElement : public mc::SceneElement
 {
 public:
     SurfaceSceneElement(
-        std::string name,
         std::shared_ptr<mg::Renderable> const& renderable,
         std::shared_ptr<ms::RenderingTracker> const& tracker,
         mc::CompositorID id)
         : renderable_{renderable},
           tracker{tracker},
-          cid{id},
-          surface_name(name)
+          cid{id}
     {
     }
 
@@ -76,7 +75,6 @@ private:
     std::shared_ptr<mg::Renderable> const renderable_;
     std::shared_ptr<ms::RenderingTracker> const tracker;
     mc::CompositorID cid;
-    std::string const surface_name;
 };
 
 //note: something different than a 2D/HWC overlay
@@ -107,12 +105,13 @@ private:
 };
 
 /**
- * A SurfaceDepthLayerObserver must not outlive the SurfaceStack it was created for
+ * A StackedSurfaceObserver must not outlive the SurfaceStack it was created for
  */
-struct SurfaceDepthLayerObserver : ms::NullSurfaceObserver
+struct StackedSurfaceObserver : ms::NullSurfaceObserver
 {
-    SurfaceDepthLayerObserver(ms::SurfaceStack* stack)
-        : stack{stack}
+    StackedSurfaceObserver(ms::SurfaceStack* stack, ms::InputRegionIndex* input_regions)
+        : stack{stack},
+          input_regions{input_regions}
     {
     }
 
@@ -122,8 +121,24 @@ struct SurfaceDepthLayerObserver : ms::NullSurfaceObserver
         stack->raise(surface);
     }
 
+    void moved_to(ms::Surface const* surface, geom::Point const& /*top_left*/) override
+    {
+        input_regions->update(*surface);
+    }
+
+    void content_resized_to(ms::Surface const* surface, geom::Size const& /*content_size*/) override
+    {
+        input_regions->update(*surface);
+    }
+
+    void input_region_set_to(ms::Surface const* surface, std::vector<geom::Rectangle> const& /*region*/) override
+    {
+        input_regions->update(*surface);
+    }
+
 private:
     ms::SurfaceStack* stack;
+    ms::InputRegionIndex* input_regions;
 };
 
 }
@@ -131,72 +146,125 @@ private:
 ms::SurfaceStack::SurfaceStack(
     std::shared_ptr<SceneReport> const& report) :
     report{report},
+    state{std::make_shared<State const>()},
+    element_pool{std::make_shared<RecyclingPool>()},
     scene_changed{false},
-    surface_observer{std::make_shared<SurfaceDepthLayerObserver>(this)}
+    surface_observer{std::make_shared<StackedSurfaceObserver>(this, &input_regions)}
 {
 }
 
 ms::SurfaceStack::~SurfaceStack() noexcept(true)
 {
-    RecursiveWriteLock lg(guard);
-    for (auto const& layer : surface_layers)
+    std::lock_guard lock{update_mutex};
+    auto const current = current_state();
+    for (auto const& layer : current->surface_layers)
     {
-        for (auto const& surface : layer)
+        for (auto const& stacked : layer)
         {
-            surface->unregister_interest(*surface_observer);
+            stacked.surface->unregister_interest(*surface_observer);
         }
     }
 }
 
-mc::SceneElementSequence ms::SurfaceStack::scene_elements_for(mc::CompositorID id)
+auto ms::SurfaceStack::current_state() const -> std::shared_ptr<State const>
 {
-    RecursiveReadLock lg(guard);
+    std::lock_guard lock{state_mutex};
+    return state;
+}
+
+auto ms::SurfaceStack::copy_of_state() const -> std::shared_ptr<State>
+{
+    return std::make_shared<State>(*current_state());
+}
+
+void ms::SurfaceStack::publish(std::shared_ptr<State> next)
+{
+    next->stacking_positions.clear();
+    for (std::size_t layer = 0; layer != next->surface_layers.size(); ++layer)
+    {
+        for (std::size_t index = 0; index != next->surface_layers[layer].size(); ++index)
+        {
+            next->stacking_positions[next->surface_layers[layer][index].surface.get()] = {layer, index};
+        }
+    }
 
+    std::shared_ptr<State const> previous = std::move(next);
+    {
+        std::lock_guard lock{state_mutex};
+        std::swap(state, previous);
+    }
+    // The previous version (if no reader still holds it) is released here, outside the lock
+}
+
+mc::SceneElementSequence ms::SurfaceStack::scene_elements_for(mc::CompositorID id)
+{
     scene_changed = false;
+    auto const current = current_state();
+
+    // Each registered compositor has a list only it uses, which keeps its capacity from frame to frame
+    std::shared_ptr<mg::RenderableList> scratch;
+    {
+        std::lock_guard lock{scratch_mutex};
+        if (auto const found = renderable_scratch.find(id); found != renderable_scratch.end())
+        {
+            scratch = found->second;
+        }
+    }
+    mg::RenderableList unregistered_renderables;
+    auto& renderables = scratch ? *scratch : unregistered_renderables;
+
     mc::SceneElementSequence elements;
-    for (auto const& layer : surface_layers)
+    elements.reserve(element_count_hint.load(std::memory_order_relaxed));
+    for (auto const& layer : current->surface_layers)
     {
-        for (auto const& surface : layer)
+        for (auto const& stacked : layer)
         {
-            if (surface_can_be_shown(surface) && surface->visible())
+            if (surface_can_be_shown(*current, stacked.surface) && stacked.surface->visible())
             {
-                for (auto& renderable : surface->generate_renderables(id))
+                stacked.surface->append_renderables(id, renderables);
+                for (auto const& renderable : renderables)
                 {
                     elements.emplace_back(
-                        std::make_shared<SurfaceSceneElement>(
-                            surface->name(),
+                        std::allocate_shared<SurfaceSceneElement>(
+                            RecyclingAllocator<SurfaceSceneElement>{element_pool},
                             renderable,
-                            rendering_trackers[surface.get()],
+                            stacked.tracker,
                             id));
                 }
+                // Don't hold the snapshots (and any buffers they lock) beyond this frame
+                renderables.clear();
             }
         }
     }
-    for (auto const& renderable : overlays)
+    for (auto const& renderable : current->overlays)
     {
-        elements.emplace_back(std::make_shared<OverlaySceneElement>(renderable));
+        elements.emplace_back(
+            std::allocate_shared<OverlaySceneElement>(
+                RecyclingAllocator<OverlaySceneElement>{element_pool},
+                renderable));
     }
+
+    element_count_hint.store(elements.size(), std::memory_order_relaxed);
     return elements;
 }
 
 int ms::SurfaceStack::frames_pending(mc::CompositorID id) const
 {
-    RecursiveReadLock lg(guard);
-
     int result = scene_changed ? 1 : 0;
-    for (auto const& layer : surface_layers)
+    auto const current = current_state();
+
+    for (auto const& layer : current->surface_layers)
     {
-        for (auto const& surface : layer)
+        for (auto const& stacked : layer)
         {
-            if (surface_can_be_shown(surface) && surface->visible())
+            if (surface_can_be_shown(*current, stacked.surface) && stacked.surface->visible())
             {
-                auto const tracker = rendering_trackers.find(surface.get());
-                if (tracker != rendering_trackers.end() && tracker->second->is_exposed_in(id))
+                if (stacked.tracker->is_exposed_in(id))
                 {
                     // Note that we ask the surface and not a Renderable.
                     // This is because we don't want to waste time and resources
                     // on a snapshot till we're sure we need it...
-                    int ready = surface->buffers_ready_for_compositor(id);
+                    int ready = stacked.surface->buffers_ready_for_compositor(id);
                     if (ready > result)
                         result = ready;
                 }
@@ -208,28 +276,38 @@ int ms::SurfaceStack::frames_pending(mc::CompositorID id) const
 
 void ms::SurfaceStack::register_compositor(mc::CompositorID cid)
 {
-    RecursiveWriteLock lg(guard);
+    std::lock_guard lock{update_mutex};
 
     registered_compositors.insert(cid);
+    {
+        std::lock_guard scratch_lock{scratch_mutex};
+        renderable_scratch[cid] = std::make_shared<mg::RenderableList>();
+    }
 
-    update_rendering_tracker_compositors();
+    update_rendering_tracker_compositors(*current_state());
 }
 
 void ms::SurfaceStack::unregister_compositor(mc::CompositorID cid)
 {
-    RecursiveWriteLock lg(guard);
+    std::lock_guard lock{update_mutex};
 
     registered_compositors.erase(cid);
+    {
+        std::lock_guard scratch_lock{scratch_mutex};
+        renderable_scratch.erase(cid);
+    }
 
-    update_rendering_tracker_compositors();
+    update_rendering_tracker_compositors(*current_state());
 }
 
 void ms::SurfaceStack::add_input_visualization(
     std::shared_ptr<mg::Renderable> const& overlay)
 {
     {
-        RecursiveWriteLock lg(guard);
-        overlays.push_back(overlay);
+        std::lock_guard lock{update_mutex};
+        auto const next = copy_of_state();
+        next->overlays.push_back(overlay);
+        publish(next);
     }
     emit_scene_changed();
 }
@@ -239,13 +317,15 @@ void ms::SurfaceStack::remove_input_visualization(
 {
     auto overlay = weak_overlay.lock();
     {
-        RecursiveWriteLock lg(guard);
-        auto const p = std::find(overlays.begin(), overlays.end(), overlay);
-        if (p == overlays.end())
+        std::lock_guard lock{update_mutex};
+        auto const next = copy_of_state();
+        auto const p = std::find(next->overlays.begin(), next->overlays.end(), overlay);
+        if (p == next->overlays.end())
         {
             BOOST_THROW_EXCEPTION(std::runtime_error("Attempt to remove an overlay which was never added or which has been previously removed"));
         }
-        overlays.erase(p);
+        next->overlays.erase(p);
+        publish(next);
     }
     
     emit_scene_changed();
@@ -253,10 +333,7 @@ void ms::SurfaceStack::remove_input_visualization(
 
 void ms::SurfaceStack::emit_scene_changed()
 {
-    {
-        RecursiveWriteLock lg(guard);
-        scene_changed = true;
-    }
+    scene_changed = true;
     observers.scene_changed();
 }
 
@@ -265,10 +342,17 @@ void ms::SurfaceStack::add_surface(
     mi::InputReceptionMode input_mode)
 {
     {
-        RecursiveWriteLock lg(guard);
-        insert_surface_at_top_of_depth_layer(surface);
-        create_rendering_tracker_for(surface);
+        std::lock_guard lock{update_mutex};
+        auto const tracker = std::make_shared<RenderingTracker>(surface);
+        tracker->active_compositors(registered_compositors);
+
+        auto const next = copy_of_state();
+        insert_surface_at_top_of_depth_layer(*next, StackedSurface{surface, tracker});
+        publish(next);
+
         surface->register_interest(surface_observer, immediate_executor);
+        // After registering interest, so that any later change to the input region updates the index
+        input_regions.add(*surface);
     }
     surface->set_reception_mode(input_mode);
     observers.surface_added(surface);
@@ -282,17 +366,22 @@ void ms::SurfaceStack::remove_surface(std::weak_ptr<Surface> const& surface)
 
     bool found_surface = false;
     {
-        RecursiveWriteLock lg(guard);
+        std::lock_guard lock{update_mutex};
 
-        for (auto& layer : surface_layers)
+        auto const next = copy_of_state();
+        for (auto& layer : next->surface_layers)
         {
-            auto const surface = std::find(layer.begin(), layer.end(), keep_alive);
+            auto const surface = std::find_if(
+                layer.begin(),
+                layer.end(),
+                [&](auto const& stacked) { return stacked.surface == keep_alive; });
 
             if (surface != layer.end())
             {
                 layer.erase(surface);
-                rendering_trackers.erase(keep_alive.get());
+                publish(next);
                 keep_alive->unregister_interest(*surface_observer);
+                input_regions.remove(*keep_alive);
                 found_surface = true;
                 break;
             }
@@ -307,35 +396,39 @@ void ms::SurfaceStack::remove_surface(std::weak_ptr<Surface> const& surface)
     // TODO: error logging when surface not found
 }
 
-namespace
-{
-template <typename Container>
-struct InReverse {
-    Container& container;
-    auto begin() -> decltype(container.rbegin()) { return container.rbegin(); }
-    auto end() -> decltype(container.rend()) { return container.rend(); }
-};
-
-template <typename Container>
-InReverse<Container> in_reverse(Container& container) { return InReverse<Container>{container}; }
-}
-
 auto ms::SurfaceStack::surface_at(geometry::Point cursor) const
 -> std::shared_ptr<Surface>
 {
-    RecursiveReadLock lg(guard);
-    for (auto const& layer : in_reverse(surface_layers))
+    auto const current = current_state();
+
+    // Only the few surfaces whose input region might contain the cursor need checking...
+    std::vector<Surface const*> candidates;
+    input_regions.candidates_at(cursor, candidates);
+
+    // ...and we check them from the top of the stack down (ignoring any not in this version of the stack)
+    std::vector<StackingPosition> positions;
+    positions.reserve(candidates.size());
+    for (auto const candidate : candidates)
     {
-        for (auto const& surface : in_reverse(layer))
+        auto const position = current->stacking_positions.find(candidate);
+        if (position != current->stacking_positions.end())
         {
-            // TODO There's a lack of clarity about how the input area will
-            // TODO be maintained and whether this test will detect clicks on
-            // TODO decorations (it should) as these may be outside the area
-            // TODO known to the client.  But it works for now.
-            if (surface_can_be_shown(surface) && surface->input_area_contains(cursor))
-                    return surface;
+            positions.push_back(position->second);
         }
     }
+    std::sort(positions.begin(), positions.end(), std::greater<>{});
+
+    for (auto const& position : positions)
+    {
+        auto const& stacked = current->surface_layers[position.layer][position.index];
+
+        // TODO There's a lack of clarity about how the input area will
+        // TODO be maintained and whether this test will detect clicks on
+        // TODO decorations (it should) as these may be outside the area
+        // TODO known to the client.  But it works for now.
+        if (surface_can_be_shown(*current, stacked.surface) && stacked.surface->input_area_contains(cursor))
+            return stacked.surface;
+    }
 
     return {};
 }
@@ -350,23 +443,25 @@ void ms::SurfaceStack::raise(Surface const* surface)
     SurfaceSet affected_surfaces;
 
     {
-        RecursiveWriteLock ul(guard);
-        for (auto& layer : surface_layers)
+        std::lock_guard lock{update_mutex};
+        auto const next = copy_of_state();
+        for (auto& layer : next->surface_layers)
         {
             auto const p = std::find_if(
                 layer.begin(),
                 layer.end(),
                 [surface](auto const& i)
                     {
-                        return surface == i.get();
+                        return surface == i.surface.get();
                     });
 
             if (p != layer.end())
             {
-                std::shared_ptr<Surface> surface_shared = *p;
+                StackedSurface const stacked = *p;
                 layer.erase(p);
-                insert_surface_at_top_of_depth_layer(surface_shared);
-                affected_surfaces.insert(surface_shared);
+                insert_surface_at_top_of_depth_layer(*next, stacked);
+                affected_surfaces.insert(stacked.surface);
+                publish(next);
                 break;
             }
         }
@@ -392,18 +487,19 @@ void ms::SurfaceStack::raise(SurfaceSet const& ss)
 {
     bool surfaces_reordered{false};
     {
-        RecursiveWriteLock ul(guard);
-        for (auto& layer : surface_layers)
+        std::lock_guard lock{update_mutex};
+        auto const next = copy_of_state();
+        for (auto& layer : next->surface_layers)
         {
             auto const old_layer = layer;
 
             // Put all the surfaces to raise at the end of the list (preserving order)
             auto split = std::stable_partition(
                 begin(layer), end(layer),
-                [&](std::weak_ptr<Surface> const& s) { return !ss.count(s); });
+                [&](StackedSurface const& s) { return !ss.count(s.surface); });
 
             // Make a new vector with only the surfaces to raise
-            auto to_raise = std::vector<std::shared_ptr<Surface>>{split, layer.end()};
+            auto to_raise = std::vector<StackedSurface>{split, layer.end()};
 
             // Chop off the surfaces we are moving from the old vector (they are now only in to_raise)
             layer.erase(split, layer.end());
@@ -411,12 +507,17 @@ void ms::SurfaceStack::raise(SurfaceSet const& ss)
             // One by one insert to_raise surfaces into the surfaces vector at the correct position
             // It is important that to_raise is still in the original order
             for (auto const& surface : to_raise)
-                insert_surface_at_top_of_depth_layer(surface);
+                insert_surface_at_top_of_depth_layer(*next, surface);
 
             // Only set surfaces_reordered if the end result is different than before
             if (old_layer != layer)
                 surfaces_reordered = true;
         }
+
+        if (surfaces_reordered)
+        {
+            publish(next);
+        }
     }
 
     if (surfaces_reordered)
@@ -428,8 +529,9 @@ void ms::SurfaceStack::raise(SurfaceSet const& ss)
 void ms::SurfaceStack::swap_z_order(SurfaceSet const& first, SurfaceSet const& second)
 {
     {
-        RecursiveWriteLock ul(guard);
-        for (auto& layer : surface_layers)
+        std::lock_guard lock{update_mutex};
+        auto const next = copy_of_state();
+        for (auto& layer : next->surface_layers)
         {
             // The goal is to swap the first set with the second set such that their Z-order is swapped.
 
@@ -449,8 +551,8 @@ void ms::SurfaceStack::swap_z_order(SurfaceSet const& first, SurfaceSet const& s
                 }
 
                 // Find the start position and count how many we've found
-                bool in_first = first.count(*it) > 0;
-                bool in_second = second.contains(*it) > 0;
+                bool in_first = first.count(it->surface) > 0;
+                bool in_second = second.contains(it->surface) > 0;
                 if (in_first)
                 {
                     if (!num_first_found && !num_second_found)
@@ -473,16 +575,17 @@ void ms::SurfaceStack::swap_z_order(SurfaceSet const& first, SurfaceSet const& s
             // Finally, move the to_front items to the front of the group and the to_back to the back of the group
             auto const& to_front = first_to_front ? first : second;
             auto const& to_back = first_to_front ? second : first;
-            std::stable_sort(swap_begin, swap_end, [&](std::weak_ptr<Surface> const& s1, std::weak_ptr<Surface> const& s2)
+            std::stable_sort(swap_begin, swap_end, [&](StackedSurface const& s1, StackedSurface const& s2)
             {
-                if (to_front.count(s1))
-                    return to_front.count(s2) == 0;
-                else if (to_back.count(s1) || to_front.count(s2))
+                if (to_front.count(s1.surface))
+                    return to_front.count(s2.surface) == 0;
+                else if (to_back.count(s1.surface) || to_front.count(s2.surface))
                     return false;
                 else
-                    return to_back.count(s2) == 0;
+                    return to_back.count(s2.surface) == 0;
             });
         }
+        publish(next);
     }
 
     observers.surfaces_reordered(first);
@@ -493,19 +596,20 @@ void ms::SurfaceStack::send_to_back(const mir::scene::SurfaceSet &ss)
 {
     bool surfaces_reordered{false};
     {
-        RecursiveWriteLock ul(guard);
-        for (auto& layer : surface_layers)
+        std::lock_guard lock{update_mutex};
+        auto const next = copy_of_state();
+        for (auto& layer : next->surface_layers)
         {
             // Only reorder if "layer" contains at least one surface
             // in "ss" and the surface(s) are not already at the beginning
             auto it = layer.begin();
             for (; it != layer.end(); it++)
-                if (!ss.count(*it))
+                if (!ss.count(it->surface))
                     break;
 
             bool needs_reorder = false;
             for (; it != layer.end(); it++)
-                if (ss.count(*it))
+                if (ss.count(it->surface))
                     needs_reorder = true;
 
             if (needs_reorder)
@@ -513,10 +617,15 @@ void ms::SurfaceStack::send_to_back(const mir::scene::SurfaceSet &ss)
                 // "Back" in Z-order will be the front of the list.
                 std::stable_partition(
                     begin(layer), end(layer),
-                    [&](std::weak_ptr<Surface> const& s) { return ss.count(s); });
+                    [&](StackedSurface const& s) { return ss.count(s.surface); });
                 surfaces_reordered = true;
             }
         }
+
+        if (surfaces_reordered)
+        {
+            publish(next);
+        }
     }
 
     if (surfaces_reordered)
@@ -525,34 +634,28 @@ void ms::SurfaceStack::send_to_back(const mir::scene::SurfaceSet &ss)
     }
 }
 
-void ms::SurfaceStack::create_rendering_tracker_for(std::shared_ptr<Surface> const& surface)
+void ms::SurfaceStack::update_rendering_tracker_compositors(State const& state)
 {
-    auto const tracker = std::make_shared<RenderingTracker>(surface);
-
-    RecursiveWriteLock ul(guard);
-    tracker->active_compositors(registered_compositors);
-    rendering_trackers[surface.get()] = tracker;
-}
-
-void ms::SurfaceStack::update_rendering_tracker_compositors()
-{
-    RecursiveReadLock ul(guard);
-
-    for (auto const& pair : rendering_trackers)
-        pair.second->active_compositors(registered_compositors);
+    for (auto const& layer : state.surface_layers)
+    {
+        for (auto const& stacked : layer)
+        {
+            stacked.tracker->active_compositors(registered_compositors);
+        }
+    }
 }
 
-void ms::SurfaceStack::insert_surface_at_top_of_depth_layer(std::shared_ptr<Surface> const& surface)
+void ms::SurfaceStack::insert_surface_at_top_of_depth_layer(State& state, StackedSurface const& surface)
 {
-    unsigned int depth_index = mir_depth_layer_get_index(surface->depth_layer());
-    if (surface_layers.size() <= depth_index)
-        surface_layers.resize(depth_index + 1);
-    surface_layers[depth_index].push_back(surface);
+    unsigned int depth_index = mir_depth_layer_get_index(surface.surface->depth_layer());
+    if (state.surface_layers.size() <= depth_index)
+        state.surface_layers.resize(depth_index + 1);
+    state.surface_layers[depth_index].push_back(surface);
 }
 
-auto ms::SurfaceStack::surface_can_be_shown(std::shared_ptr<Surface> const& surface) const -> bool
+auto ms::SurfaceStack::surface_can_be_shown(State const& state, std::shared_ptr<Surface> const& surface) -> bool
 {
-    return screen_lock_handle.expired() || surface->visible_on_lock_screen();
+    return state.screen_lock_handle.expired() || surface->visible_on_lock_screen();
 }
 
 void ms::SurfaceStack::add_observer(std::shared_ptr<ms::Observer> const& observer)
@@ -560,12 +663,12 @@ void ms::SurfaceStack::add_observer(std::shared_ptr<ms::Observer> const& observe
     observers.add(observer);
 
     // Notify observer of existing surfaces
-    RecursiveReadLock lk(guard);
-    for (auto const& layer : surface_layers)
+    auto const current = current_state();
+    for (auto const& layer : current->surface_layers)
     {
-        for (auto const& surface : layer)
+        for (auto const& stacked : layer)
         {
-            observer->surface_exists(surface);
+            observer->surface_exists(stacked.surface);
         }
     }
 }
@@ -585,14 +688,14 @@ auto ms::SurfaceStack::stacking_order_of(SurfaceSet const& surfaces) const -> Su
 {
     SurfaceList result;
 
-    RecursiveReadLock lk(guard);
-    for (auto const& layer : surface_layers)
+    auto const current = current_state();
+    for (auto const& layer : current->surface_layers)
     {
-        for (auto const& surface : layer)
+        for (auto const& stacked : layer)
         {
-            if (surfaces.find(surface) != surfaces.end())
+            if (surfaces.find(stacked.surface) != surfaces.end())
             {
-                result.push_back(surface);
+                result.push_back(stacked.surface);
             }
         }
     }
@@ -652,11 +755,13 @@ auto ms::SurfaceStack::lock_screen() -> std::unique_ptr<mf::ScreenLockHandle>
     std::shared_ptr<SharedScreenLock> shared;
     bool is_new{false};
     {
-        RecursiveWriteLock lk(guard);
-        shared = screen_lock_handle.lock();
+        std::lock_guard lock{update_mutex};
+        shared = current_state()->screen_lock_handle.lock();
         if (!shared)
         {
-            screen_lock_handle = shared = std::make_shared<SharedScreenLock>(shared_from_this());
+            auto const next = copy_of_state();
+            next->screen_lock_handle = shared = std::make_shared<SharedScreenLock>(shared_from_this());
+            publish(next);
             is_new = true;
         }
     }
@@ -669,8 +774,7 @@ auto ms::SurfaceStack::lock_screen() -> std::unique_ptr<mf::ScreenLockHandle>
 
 auto ms::SurfaceStack::screen_is_locked() const -> bool
 {
-    RecursiveReadLock lk(guard);
-    return !screen_lock_handle.expired();
+    return !current_state()->screen_lock_handle.expired();
 }
 
 void ms::Observers::surface_added(std::shared_ptr<Surface> const& surface)
@@ -17,13 +17,13 @@
 #ifndef MIR_SCENE_SURFACE_STACK_H_
 #define MIR_SCENE_SURFACE_STACK_H_
 
+#include "input_region_index.h"
 #include "mir/shell/surface_stack.h"
 #include "mir/frontend/surface_stack.h"
 
 #include "mir/compositor/scene.h"
 #include "mir/scene/observer.h"
 #include "mir/input/scene.h"
-#include "mir/recursive_read_write_mutex.h"
 
 #include "mir/basic_observers.h"
 #include "mir/scene/surface_observer.h"
@@ -33,6 +33,7 @@
 #include <memory>
 #include <mutex>
 #include <set>
+#include <unordered_map>
 #include <vector>
 
 namespace mir
@@ -48,6 +49,7 @@ namespace scene
 class BasicSurface;
 class SceneReport;
 class RenderingTracker;
+class RecyclingPool;
 
 class Observers : public Observer, BasicObservers<Observer>
 {
@@ -115,35 +117,91 @@ public:
 private:
     SurfaceStack(const SurfaceStack&) = delete;
     SurfaceStack& operator=(const SurfaceStack&) = delete;
-    void create_rendering_tracker_for(std::shared_ptr<Surface> const&);
-    void update_rendering_tracker_compositors();
-    void insert_surface_at_top_of_depth_layer(std::shared_ptr<Surface> const& surface);
-    auto surface_can_be_shown(std::shared_ptr<Surface> const& surface) const -> bool;
 
     struct SharedScreenLock;
     struct BasicScreenLockHandle;
 
-    RecursiveReadWriteMutex mutable guard;
+    struct StackedSurface
+    {
+        std::shared_ptr<Surface> surface;
+        std::shared_ptr<RenderingTracker> tracker;
 
-    std::shared_ptr<SceneReport> const report;
+        auto operator==(StackedSurface const& other) const -> bool = default;
+    };
+
+    /// Where a surface is in State::surface_layers (greater positions are higher in the stack)
+    struct StackingPosition
+    {
+        std::size_t layer;
+        std::size_t index;
+
+        auto operator<=>(StackingPosition const& other) const = default;
+    };
 
     /**
-     * All surfaces managed by this class
+     * A version of the stack
      *
-     * Each depth layer is mapped to an index of the outer vector by mir_depth_layer_to_index()
-     * The outer vector starts out empty, and is expanded as needed to contain the highest layer encountered
-     * The inner vectors contain the list of surfaces on each layer (bottom to top)
+     * Once published a version is never modified: readers (the compositors and input) take a
+     * reference to the current version and never wait for writers to finish their work. Writers
+     * (serialized by update_mutex) copy the current version, modify the copy and publish it.
      */
-    std::vector<std::vector<std::shared_ptr<Surface>>> surface_layers;
-    std::map<Surface*,std::shared_ptr<RenderingTracker>> rendering_trackers;
+    struct State
+    {
+        /**
+         * All surfaces managed by this class
+         *
+         * Each depth layer is mapped to an index of the outer vector by mir_depth_layer_to_index()
+         * The outer vector starts out empty, and is expanded as needed to contain the highest layer encountered
+         * The inner vectors contain the list of surfaces on each layer (bottom to top)
+         */
+        std::vector<std::vector<StackedSurface>> surface_layers;
+
+        /// The position of each surface in surface_layers (maintained by publish())
+        std::unordered_map<Surface const*, StackingPosition> stacking_positions;
+
+        std::vector<std::shared_ptr<graphics::Renderable>> overlays;
+
+        /// If not expired the screen is locked (and only surfaces that appear on the lock screen should be shown)
+        std::weak_ptr<SharedScreenLock> screen_lock_handle;
+    };
+
+    auto current_state() const -> std::shared_ptr<State const>;
+    /// A copy of the current version, for a writer (holding update_mutex) to modify and publish()
+    auto copy_of_state() const -> std::shared_ptr<State>;
+    void publish(std::shared_ptr<State> next);
+
+    void update_rendering_tracker_compositors(State const& state);
+    static void insert_surface_at_top_of_depth_layer(State& state, StackedSurface const& surface);
+    static auto surface_can_be_shown(State const& state, std::shared_ptr<Surface> const& surface) -> bool;
+
+    std::shared_ptr<SceneReport> const report;
+
+    std::mutex update_mutex;
+    /// Only held to copy or replace the pointer to the current version (never while building one)
+    std::mutex mutable state_mutex;
+    std::shared_ptr<State const> state;
+
+    /// Only accessed by writers (holding update_mutex)
     std::set<compositor::CompositorID> registered_compositors;
-    
-    std::vector<std::shared_ptr<graphics::Renderable>> overlays;
+
+    /// Only held to look up or change the lists in renderable_scratch (never while one is used)
+    std::mutex scratch_mutex;
+    /**
+     * Per-compositor lists used while building each frame's scene elements
+     *
+     * Each is only used by its compositor, so keeps its capacity from frame to frame. These are
+     * written by readers, so are kept apart from the published (immutable) versions of the stack.
+     */
+    std::map<compositor::CompositorID, std::shared_ptr<std::vector<std::shared_ptr<graphics::Renderable>>>> renderable_scratch;
+    /// Recycles the memory of the scene elements we generate every frame
+    std::shared_ptr<RecyclingPool> const element_pool;
+    /// Where each surface accepts input (kept up to date by surface_observer)
+    InputRegionIndex input_regions;
 
     Observers observers;
-    /// If not expired the screen is locked (and only surfaces that appear on the lock screen should be shown)
-    std::weak_ptr<SharedScreenLock> screen_lock_handle;
     std::atomic<bool> scene_changed;
+    /// The number of elements in the last scene, to size the next one
+    std::atomic<std::size_t> element_count_hint{0};
     std::shared_ptr<SurfaceObserver> surface_observer;
 };
 
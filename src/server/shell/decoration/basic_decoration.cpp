@@ -26,6 +26,7 @@
 #include "mir/scene/surface.h"
 #include "mir/scene/session.h"
 #include "mir/scene/null_surface_observer.h"
+#include "mir/graphics/buffer.h"
 #include "mir/graphics/buffer_properties.h"
 #include "mir/compositor/buffer_stream.h"
 #include "mir/input/cursor_images.h"
@@ -418,6 +419,10 @@ void msd::BasicDecoration::update(
     for (auto const& pair : new_buffers)
     {
         if (pair.second)
-            pair.first->submit_buffer(pair.second.value());
+        {
+            // Decorations are redrawn from scratch, so the whole buffer is damaged
+            auto const& buffer = pair.second.value();
+            pair.first->submit_buffer(buffer, geom::Rectangles{geom::Rectangle{{}, buffer->size()}});
+        }
     }
 }
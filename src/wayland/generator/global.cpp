@@ -32,6 +32,7 @@ Emitter Global::declaration() const
         "public:",
         Emitter::layout(Lines{
             {"Global(", constructor_args(), ");"},
+            {"Global(wl_display* display, int version);"},
             empty_line,
             {"auto interface_name() const -> char const* override;"}
         }, true, true, Emitter::single_indent),
@@ -50,11 +51,17 @@ Emitter Global::implementation() const
     return EmptyLineList{
         Lines{
             {nmspace, "Global::Global(", constructor_args(), ")"},
+            {"    : Global{display, Thunks::supported_version}"},
+            Block{
+            }
+        },
+        Lines{
+            {nmspace, "Global::Global(wl_display* display, int version)"},
             {"    : wayland::Global{"},
             {"          wl_global_create("},
             {"              display,"},
             {"              &", wl_name, "_interface_data,"},
-            {"              Thunks::supported_version,"},
+            {"              std::min(version, Thunks::supported_version),"},
             {"              this,"},
             {"              &Thunks::bind_thunk)}"},
             Block{
@@ -58,6 +58,7 @@ Emitter impl_includes(std::string const& protocol_name)
     return Lines{
         {"#include \"", protocol_name, "_wrapper.h\""},
         empty_line,
+        "#include <algorithm>",
         "#include <boost/exception/diagnostic_information.hpp>",
         "#include <wayland-server-core.h>",
         empty_line,
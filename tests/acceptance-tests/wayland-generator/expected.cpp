@@ -6,6 +6,7 @@
 
 #include "protocol_wrapper.h"
 
+#include <algorithm>
 #include <boost/exception/diagnostic_information.hpp>
 #include <wayland-server-core.h>
 
@@ -229,11 +230,16 @@ void mw::Compositor::destroy_and_delete() const
 }
 
 mw::Compositor::Global::Global(wl_display* display, Version<4>)
+    : Global{display, Thunks::supported_version}
+{
+}
+
+mw::Compositor::Global::Global(wl_display* display, int version)
     : wayland::Global{
           wl_global_create(
               display,
               &wl_compositor_interface_data,
-              Thunks::supported_version,
+              std::min(version, Thunks::supported_version),
               this,
               &Thunks::bind_thunk)}
 {
@@ -550,11 +556,16 @@ uint32_t const mw::Shm::Format::yuv444;
 uint32_t const mw::Shm::Format::yvu444;
 
 mw::Shm::Global::Global(wl_display* display, Version<1>)
+    : Global{display, Thunks::supported_version}
+{
+}
+
+mw::Shm::Global::Global(wl_display* display, int version)
     : wayland::Global{
           wl_global_create(
               display,
               &wl_shm_interface_data,
-              Thunks::supported_version,
+              std::min(version, Thunks::supported_version),
               this,
               &Thunks::bind_thunk)}
 {
@@ -1426,11 +1437,16 @@ uint32_t const mw::DataDeviceManager::DndAction::move;
 uint32_t const mw::DataDeviceManager::DndAction::ask;
 
 mw::DataDeviceManager::Global::Global(wl_display* display, Version<3>)
+    : Global{display, Thunks::supported_version}
+{
+}
+
+mw::DataDeviceManager::Global::Global(wl_display* display, int version)
     : wayland::Global{
           wl_global_create(
               display,
               &wl_data_device_manager_interface_data,
-              Thunks::supported_version,
+              std::min(version, Thunks::supported_version),
               this,
               &Thunks::bind_thunk)}
 {
@@ -1559,11 +1575,16 @@ void mw::Shell::destroy_and_delete() const
 uint32_t const mw::Shell::Error::role;
 
 mw::Shell::Global::Global(wl_display* display, Version<1>)
+    : Global{display, Thunks::supported_version}
+{
+}
+
+mw::Shell::Global::Global(wl_display* display, int version)
     : wayland::Global{
           wl_global_create(
               display,
               &wl_shell_interface_data,
-              Thunks::supported_version,
+              std::min(version, Thunks::supported_version),
               this,
               &Thunks::bind_thunk)}
 {
@@ -2417,11 +2438,16 @@ uint32_t const mw::Seat::Capability::touch;
 uint32_t const mw::Seat::Error::missing_capability;
 
 mw::Seat::Global::Global(wl_display* display, Version<8>)
+    : Global{display, Thunks::supported_version}
+{
+}
+
+mw::Seat::Global::Global(wl_display* display, int version)
     : wayland::Global{
           wl_global_create(
               display,
               &wl_seat_interface_data,
-              Thunks::supported_version,
+              std::min(version, Thunks::supported_version),
               this,
               &Thunks::bind_thunk)}
 {
@@ -3283,11 +3309,16 @@ uint32_t const mw::Output::Mode::current;
 uint32_t const mw::Output::Mode::preferred;
 
 mw::Output::Global::Global(wl_display* display, Version<4>)
+    : Global{display, Thunks::supported_version}
+{
+}
+
+mw::Output::Global::Global(wl_display* display, int version)
     : wayland::Global{
           wl_global_create(
               display,
               &wl_output_interface_data,
-              Thunks::supported_version,
+              std::min(version, Thunks::supported_version),
               this,
               &Thunks::bind_thunk)}
 {
@@ -3541,11 +3572,16 @@ bool mw::Subcompositor::is_instance(wl_resource* resource)
 uint32_t const mw::Subcompositor::Error::bad_surface;
 
 mw::Subcompositor::Global::Global(wl_display* display, Version<1>)
+    : Global{display, Thunks::supported_version}
+{
+}
+
+mw::Subcompositor::Global::Global(wl_display* display, int version)
     : wayland::Global{
           wl_global_create(
               display,
               &wl_subcompositor_interface_data,
-              Thunks::supported_version,
+              std::min(version, Thunks::supported_version),
               this,
               &Thunks::bind_thunk)}
 {
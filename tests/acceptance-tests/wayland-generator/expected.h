@@ -87,6 +87,7 @@ public:
     {
     public:
         Global(wl_display* display, Version<4>);
+        Global(wl_display* display, int version);
 
         auto interface_name() const -> char const* override;
 
@@ -215,6 +216,7 @@ public:
     {
     public:
         Global(wl_display* display, Version<1>);
+        Global(wl_display* display, int version);
 
         auto interface_name() const -> char const* override;
 
@@ -412,6 +414,7 @@ public:
     {
     public:
         Global(wl_display* display, Version<3>);
+        Global(wl_display* display, int version);
 
         auto interface_name() const -> char const* override;
 
@@ -450,6 +453,7 @@ public:
     {
     public:
         Global(wl_display* display, Version<1>);
+        Global(wl_display* display, int version);
 
         auto interface_name() const -> char const* override;
 
@@ -610,6 +614,7 @@ public:
     {
     public:
         Global(wl_display* display, Version<8>);
+        Global(wl_display* display, int version);
 
         auto interface_name() const -> char const* override;
 
@@ -861,6 +866,7 @@ public:
     {
     public:
         Global(wl_display* display, Version<4>);
+        Global(wl_display* display, int version);
 
         auto interface_name() const -> char const* override;
 
@@ -914,6 +920,7 @@ public:
     {
     public:
         Global(wl_display* display, Version<1>);
+        Global(wl_display* display, int version);
 
         auto interface_name() const -> char const* override;
 
@@ -41,9 +41,14 @@ public:
                  void(compositor::CompositorReport::SubCompositorId));
     MOCK_METHOD1(finished_frame,
                  void(compositor::CompositorReport::SubCompositorId));
+    MOCK_METHOD2(rendered_frame_on_gpu,
+                 void(compositor::CompositorReport::SubCompositorId, std::chrono::nanoseconds));
+    MOCK_METHOD2(posted_frame,
+                 void(compositor::CompositorReport::SubCompositorId, std::optional<std::chrono::nanoseconds>));
     MOCK_METHOD0(started, void());
     MOCK_METHOD0(stopped, void());
     MOCK_METHOD0(scheduled, void());
+    MOCK_CONST_METHOD0(frame_statistics, std::vector<compositor::CompositorReport::FrameStatistics>());
 };
 
 } // namespace doubles
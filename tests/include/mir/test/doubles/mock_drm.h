@@ -25,6 +25,7 @@
 
 #include <xf86drm.h>
 #include <xf86drmMode.h>
+#include <optional>
 #include <unordered_map>
 
 namespace mir
@@ -51,6 +52,7 @@ public:
                        std::vector<uint32_t>& possible_encoder_ids,
                        geometry::Size const& physical_size,
                        drmModeSubPixel subpixel_arrangement = DRM_MODE_SUBPIXEL_UNKNOWN);
+    void add_plane(uint32_t id, uint32_t type, uint32_t possible_crtcs_mask);
 
     void prepare();
     void reset();
@@ -58,6 +60,30 @@ public:
     drmModeCrtc* find_crtc(uint32_t id);
     drmModeEncoder* find_encoder(uint32_t id);
     drmModeConnector* find_connector(uint32_t id);
+    drmModePlane* find_plane(uint32_t id);
+
+    drmModePlaneRes* plane_resources_ptr();
+    /**
+     * The atomic-modesetting properties of a CRTC, connector or plane
+     *
+     * Like the kernel, these are only exposed once atomic modesetting has been enabled
+     * (see MockDRM::enable_atomic()); until then every object has an empty property list.
+     */
+    drmModeObjectProperties* find_object_properties(uint32_t id, uint32_t type);
+    /**
+     * Change the value of one of an object's properties
+     *
+     * prepare() resets every property to its default, so call this after it.
+     */
+    void set_property_value(uint32_t id, char const* name, uint64_t value);
+
+    /**
+     * The fixed id of the named atomic property
+     *
+     * Ids are the same for every object (and every device), so tests can refer to them by name.
+     */
+    static uint32_t property_id(char const* name);
+    static drmModePropertyRes* find_property(uint32_t id);
 
     enum ModePreference {NormalMode, PreferredMode};
     static drmModeModeInfo create_mode(uint16_t hdisplay, uint16_t vdisplay,
@@ -65,18 +91,38 @@ public:
                                        ModePreference preferred);
 
     bool drm_setversion_called{false};
+    bool atomic_enabled{false};
 private:
+    struct ObjectProperties
+    {
+        uint32_t type;
+        std::vector<uint32_t> ids;
+        std::vector<uint64_t> values;
+        drmModeObjectProperties properties;
+    };
+    void add_object_properties(
+        uint32_t id,
+        uint32_t type,
+        std::vector<std::pair<char const*, uint64_t>> const& properties);
+
     int pipe_fds[2];
 
     drmModeRes resources;
     std::vector<drmModeCrtc> crtcs;
     std::vector<drmModeEncoder> encoders;
     std::vector<drmModeConnector> connectors;
+    std::vector<drmModePlane> planes;
 
     std::vector<uint32_t> crtc_ids;
     std::vector<uint32_t> encoder_ids;
     std::vector<uint32_t> connector_ids;
 
+    drmModePlaneRes plane_resources;
+    std::vector<uint32_t> plane_ids;
+    std::unordered_map<uint32_t, uint32_t> plane_types;
+    std::unordered_map<uint32_t, ObjectProperties> object_properties;
+    drmModeObjectProperties no_properties;
+
     std::vector<drmModeModeInfo> modes;
     std::vector<drmModeModeInfo> modes_empty;
     std::vector<uint32_t> connector_encoder_ids;
@@ -132,6 +178,16 @@ public:
     MOCK_METHOD2(drmModeGetProperty, drmModePropertyPtr(int fd, uint32_t propertyId));
     MOCK_METHOD1(drmModeFreeProperty, void(drmModePropertyPtr));
     MOCK_METHOD4(drmModeConnectorSetProperty, int(int fd, uint32_t connector_id, uint32_t property_id, uint64_t value));
+    MOCK_METHOD5(drmModeObjectSetProperty, int(int fd, uint32_t object_id, uint32_t object_type,
+                                               uint32_t property_id, uint64_t value));
+    MOCK_METHOD4(drmModeCreatePropertyBlob, int(int fd, void const* data, size_t size, uint32_t* id));
+    MOCK_METHOD2(drmModeDestroyPropertyBlob, int(int fd, uint32_t id));
+
+    MOCK_METHOD0(drmModeAtomicAlloc, drmModeAtomicReqPtr());
+    MOCK_METHOD1(drmModeAtomicFree, void(drmModeAtomicReqPtr req));
+    MOCK_METHOD4(drmModeAtomicAddProperty, int(drmModeAtomicReqPtr req, uint32_t object_id,
+                                               uint32_t property_id, uint64_t value));
+    MOCK_METHOD4(drmModeAtomicCommit, int(int fd, drmModeAtomicReqPtr req, uint32_t flags, void* user_data));
 
     MOCK_METHOD2(drmGetMagic, int(int fd, drm_magic_t *magic));
     MOCK_METHOD2(drmAuthMagic, int(int fd, drm_magic_t magic));
@@ -185,6 +241,44 @@ public:
         std::vector<uint32_t>& possible_encoder_ids,
         geometry::Size const& physical_size,
         drmModeSubPixel subpixel_arrangement = DRM_MODE_SUBPIXEL_UNKNOWN);
+    void add_plane(
+        char const* device,
+        uint32_t id,
+        uint32_t type,
+        uint32_t possible_crtcs_mask);
+
+    /**
+     * Make device support atomic modesetting
+     *
+     * drmSetClientCap(DRM_CLIENT_CAP_ATOMIC) fails on devices that haven't been enabled,
+     * so by default code under test takes the legacy modesetting paths.
+     */
+    void enable_atomic(char const* device);
+
+    /**
+     * Change the value of a property of an object on device (after prepare())
+     */
+    void set_property_value(
+        char const* device,
+        uint32_t object_id,
+        char const* property,
+        uint64_t value);
+
+    /**
+     * The value an atomic request sets for the named property of an object, if any
+     *
+     * The default drmModeAtomicAddProperty() records the properties added to a request;
+     * if a property is added more than once the last value wins, as in libdrm.
+     */
+    static auto atomic_property(
+        drmModeAtomicReqPtr request,
+        uint32_t object_id,
+        char const* property) -> std::optional<uint64_t>;
+
+    /**
+     * The contents of a property blob created with drmModeCreatePropertyBlob()
+     */
+    auto blob_data(uint32_t blob_id) const -> std::vector<uint8_t> const&;
 
     void prepare(char const* device);
     void reset(char const* device);
@@ -219,6 +313,8 @@ private:
 
     std::map<std::unique_ptr<char[]>, size_t, TransparentUPtrComparator> mmapings;
     drmModeObjectProperties empty_object_props;
+    std::unordered_map<uint32_t, std::vector<uint8_t>> blobs;
+    uint32_t next_blob_id{1};
     mir_test_framework::OpenHandlerHandle const open_interposer;
     mir_test_framework::MmapHandlerHandle const mmap_interposer;
     mir_test_framework::MunmapHandlerHandle const munmap_interposer;
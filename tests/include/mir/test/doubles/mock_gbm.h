@@ -72,6 +72,7 @@ public:
     MOCK_METHOD1(gbm_bo_get_stride, uint32_t(struct gbm_bo *bo));
     MOCK_METHOD1(gbm_bo_get_format, uint32_t(struct gbm_bo *bo));
     MOCK_METHOD1(gbm_bo_get_handle, union gbm_bo_handle(struct gbm_bo *bo));
+    MOCK_METHOD2(gbm_bo_get_handle_for_plane, union gbm_bo_handle(struct gbm_bo *bo, int plane));
     MOCK_METHOD3(gbm_bo_set_user_data, void(struct gbm_bo *bo, void *data,
                                             void (*destroy_user_data)(struct gbm_bo *, void *)));
     MOCK_METHOD1(gbm_bo_get_user_data, void*(struct gbm_bo *bo));
@@ -32,8 +32,10 @@ struct MockRenderer : public renderer::Renderer
 {
     MOCK_METHOD(void, set_viewport, (geometry::Rectangle const&));
     MOCK_METHOD(void, set_output_transform, (glm::mat2 const&));
+    MOCK_METHOD(void, set_damage, (geometry::Rectangles const&));
     MOCK_METHOD(std::unique_ptr<graphics::Framebuffer>, render, (graphics::RenderableList const&), (const override));
     MOCK_METHOD(void, suspend, ());
+    MOCK_METHOD(std::optional<std::chrono::nanoseconds>, completed_gpu_time, (), (override));
 
     ~MockRenderer() noexcept {}
 };
@@ -57,7 +57,7 @@ public:
     int buffers_ready_for_compositor(void const*) const override { return nready; }
 
     void drop_old_buffers() override {}
-    void submit_buffer(std::shared_ptr<graphics::Buffer> const& b) override
+    void submit_buffer(std::shared_ptr<graphics::Buffer> const& b, geometry::Rectangles const&) override
     {
         if (b) ++nready;
     }
@@ -66,9 +66,15 @@ public:
         fn(*stub_compositor_buffer);
     }
     MirPixelFormat pixel_format() const override { return mir_pixel_format_abgr_8888; }
-    void set_frame_posted_callback(std::function<void(geometry::Size const&)> const&) override {}
+    void set_frame_posted_callback(
+        std::function<void(geometry::Size const&, geometry::Rectangles const&)> const&) override {}
     bool has_submitted_buffer() const override { return true; }
     void set_scale(float) override {}
+    auto damage_between(graphics::BufferID, graphics::BufferID) const
+        -> std::optional<geometry::Rectangles> override
+    {
+        return std::nullopt;
+    }
 
     std::shared_ptr<graphics::Buffer> stub_compositor_buffer;
     int nready = 0;
@@ -214,7 +214,7 @@ std::chrono::milliseconds const default_delay{-1};
 
 TEST_F(SurfaceStackCompositor, composes_on_start_if_told_to_in_constructor_when_stack_has_at_least_one_surface)
 {
-    streams.front().stream->submit_buffer(stub_buffer);
+    streams.front().stream->submit_buffer(stub_buffer, {});
     stack.add_surface(stub_surface, mi::InputReceptionMode::normal);
 
     mc::MultiThreadedCompositor mt_compositor(
@@ -268,7 +268,7 @@ TEST_F(SurfaceStackCompositor, swapping_a_surface_that_has_been_added_triggers_a
     mt_compositor.start();
 
     stack.add_surface(stub_surface, mi::InputReceptionMode::normal);
-    stream->submit_buffer(stub_buffer);
+    stream->submit_buffer(stub_buffer, {});
 
     EXPECT_TRUE(stub_primary_db.has_posted_at_least(1, timeout));
     EXPECT_TRUE(stub_secondary_db.has_posted_at_least(1, timeout));
@@ -277,7 +277,7 @@ TEST_F(SurfaceStackCompositor, swapping_a_surface_that_has_been_added_triggers_a
 //test associated with lp:1290306, 1293896, 1294048, 1294051, 1294053
 TEST_F(SurfaceStackCompositor, compositor_runs_until_all_surfaces_buffers_are_consumed)
 {
-    std::function<void(mir::geometry::Size const&)> frame_callback;
+    std::function<void(mir::geometry::Size const&, mir::geometry::Rectangles const&)> frame_callback;
     ON_CALL(*mock_buffer_stream, buffers_ready_for_compositor(_))
         .WillByDefault(Return(5));
     EXPECT_CALL(*mock_buffer_stream, set_frame_posted_callback(_))
@@ -295,7 +295,7 @@ TEST_F(SurfaceStackCompositor, compositor_runs_until_all_surfaces_buffers_are_co
 
     stack.add_surface(stub_surface, mi::InputReceptionMode::normal);
     ASSERT_THAT(frame_callback, Ne(nullptr));
-    frame_callback({ 100, 100 });
+    frame_callback({ 100, 100 }, {});
 
     EXPECT_TRUE(stub_primary_db.has_posted_at_least(5, timeout));
     EXPECT_TRUE(stub_secondary_db.has_posted_at_least(5, timeout));
@@ -303,7 +303,7 @@ TEST_F(SurfaceStackCompositor, compositor_runs_until_all_surfaces_buffers_are_co
 
 TEST_F(SurfaceStackCompositor, bypassed_compositor_runs_until_all_surfaces_buffers_are_consumed)
 {
-    std::function<void(mir::geometry::Size const&)> frame_callback;
+    std::function<void(mir::geometry::Size const&, mir::geometry::Rectangles const&)> frame_callback;
     ON_CALL(*mock_buffer_stream, buffers_ready_for_compositor(_))
         .WillByDefault(Return(5));
     ON_CALL(*mock_buffer_stream, lock_compositor_buffer(_))
@@ -325,7 +325,7 @@ TEST_F(SurfaceStackCompositor, bypassed_compositor_runs_until_all_surfaces_buffe
 
     stack.add_surface(stub_surface, mi::InputReceptionMode::normal);
     ASSERT_THAT(frame_callback, Ne(nullptr));
-    frame_callback({ 100, 100 });
+    frame_callback({ 100, 100 }, {});
 
     EXPECT_TRUE(stub_primary_db.has_posted_at_least(5, timeout));
     EXPECT_TRUE(stub_secondary_db.has_posted_at_least(5, timeout));
@@ -342,7 +342,7 @@ TEST_F(SurfaceStackCompositor, an_empty_scene_retriggers)
     mt_compositor.start();
 
     stack.add_surface(stub_surface, mi::InputReceptionMode::normal);
-    streams.front().stream->submit_buffer(stub_buffer);
+    streams.front().stream->submit_buffer(stub_buffer, {});
 
     EXPECT_TRUE(stub_primary_db.has_posted_at_least(1, timeout));
     EXPECT_TRUE(stub_secondary_db.has_posted_at_least(1, timeout));
@@ -355,7 +355,7 @@ TEST_F(SurfaceStackCompositor, an_empty_scene_retriggers)
 
 TEST_F(SurfaceStackCompositor, moving_a_surface_triggers_composition)
 {
-    streams.front().stream->submit_buffer(stub_buffer);
+    streams.front().stream->submit_buffer(stub_buffer, {});
     stack.add_surface(stub_surface, mi::InputReceptionMode::normal);
 
     mc::MultiThreadedCompositor mt_compositor(
@@ -374,10 +374,10 @@ TEST_F(SurfaceStackCompositor, moving_a_surface_triggers_composition)
 
 TEST_F(SurfaceStackCompositor, removing_a_surface_triggers_composition)
 {
-    streams.front().stream->submit_buffer(stub_buffer);
+    streams.front().stream->submit_buffer(stub_buffer, {});
     stack.add_surface(stub_surface, mi::InputReceptionMode::normal);
 
-    other_streams.front().stream->submit_buffer(other_stub_buffer);
+    other_streams.front().stream->submit_buffer(other_stub_buffer, {});
     stack.add_surface(other_stub_surface, mi::InputReceptionMode::normal);
 
     mc::MultiThreadedCompositor mt_compositor(
@@ -397,7 +397,7 @@ TEST_F(SurfaceStackCompositor, removing_a_surface_triggers_composition)
 TEST_F(SurfaceStackCompositor, buffer_updates_trigger_composition)
 {
     stack.add_surface(stub_surface, mi::InputReceptionMode::normal);
-    streams.front().stream->submit_buffer(stub_buffer);
+    streams.front().stream->submit_buffer(stub_buffer, {});
 
     mc::MultiThreadedCompositor mt_compositor(
         mt::fake_shared(stub_display),
@@ -407,7 +407,7 @@ TEST_F(SurfaceStackCompositor, buffer_updates_trigger_composition)
         null_comp_report, default_delay, false);
 
     mt_compositor.start();
-    streams.front().stream->submit_buffer(stub_buffer);
+    streams.front().stream->submit_buffer(stub_buffer, {});
 
     EXPECT_TRUE(stub_primary_db.has_posted_at_least(1, timeout));
     EXPECT_TRUE(stub_secondary_db.has_posted_at_least(1, timeout));
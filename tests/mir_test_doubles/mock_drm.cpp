@@ -20,6 +20,8 @@
 #include "mir/geometry/size.h"
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <cstring>
 #include <stdexcept>
 #include <unistd.h>
 #include <dlfcn.h>
@@ -32,10 +34,72 @@ namespace geom = mir::geometry;
 namespace
 {
 mtd::MockDRM* global_mock = nullptr;
+
+char const* const atomic_property_names[] = {
+    "type",
+    "FB_ID",
+    "CRTC_ID",
+    "SRC_X",
+    "SRC_Y",
+    "SRC_W",
+    "SRC_H",
+    "CRTC_X",
+    "CRTC_Y",
+    "CRTC_W",
+    "CRTC_H",
+    "MODE_ID",
+    "ACTIVE",
+    "GAMMA_LUT",
+    "GAMMA_LUT_SIZE",
+    "VRR_ENABLED",
+    "vrr_capable",
+    "zpos"
+};
+uint32_t const first_property_id{1000};
+uint64_t const gamma_lut_size{256};
+uint64_t zpos_range[] = {0, 255};
+
+auto atomic_properties() -> std::vector<drmModePropertyRes>&
+{
+    static std::vector<drmModePropertyRes> properties =
+        []()
+        {
+            std::vector<drmModePropertyRes> properties;
+            for (auto const name : atomic_property_names)
+            {
+                drmModePropertyRes property = drmModePropertyRes();
+                property.prop_id = first_property_id + properties.size();
+                strncpy(property.name, name, sizeof(property.name) - 1);
+                if (!strcmp(name, "zpos"))
+                {
+                    property.flags = DRM_MODE_PROP_RANGE;
+                    property.count_values = 2;
+                    property.values = zpos_range;
+                }
+                properties.push_back(property);
+            }
+            return properties;
+        }();
+    return properties;
+}
 }
 
+/* libdrm's request type is opaque; this is all we need to record */
+struct _drmModeAtomicReq
+{
+    struct Property
+    {
+        uint32_t object_id;
+        uint32_t property_id;
+        uint64_t value;
+    };
+    std::vector<Property> properties;
+};
+
 mtd::FakeDRMResources::FakeDRMResources()
-    : pipe_fds{-1, -1}
+    : pipe_fds{-1, -1},
+      plane_resources(),
+      no_properties()
 {
     /* Use the read end of a pipe as the fake DRM fd */
     if (pipe(pipe_fds) < 0 || pipe_fds[0] < 0)
@@ -70,6 +134,14 @@ mtd::FakeDRMResources::FakeDRMResources()
                   modes, connector_encoder_ids,
                   geom::Size{121, 144});
 
+    add_plane(40, DRM_PLANE_TYPE_PRIMARY, 0x1);
+    add_plane(41, DRM_PLANE_TYPE_PRIMARY, 0x2);
+    add_plane(42, DRM_PLANE_TYPE_OVERLAY, 0x1);
+    add_plane(43, DRM_PLANE_TYPE_OVERLAY, 0x2);
+    add_plane(44, DRM_PLANE_TYPE_OVERLAY, all_crtcs_mask);
+    add_plane(45, DRM_PLANE_TYPE_CURSOR, 0x1);
+    add_plane(46, DRM_PLANE_TYPE_CURSOR, 0x2);
+
     prepare();
 }
 
@@ -97,6 +169,11 @@ drmModeRes* mtd::FakeDRMResources::resources_ptr()
     return &resources;
 }
 
+drmModePlaneRes* mtd::FakeDRMResources::plane_resources_ptr()
+{
+    return &plane_resources;
+}
+
 void mtd::FakeDRMResources::prepare()
 {
     resources.count_crtcs = crtcs.size();
@@ -113,6 +190,53 @@ void mtd::FakeDRMResources::prepare()
     for (auto const& connector: connectors)
         connector_ids.push_back(connector.connector_id);
     resources.connectors = connector_ids.data();
+
+    plane_ids.clear();
+    for (auto const& plane: planes)
+        plane_ids.push_back(plane.plane_id);
+    plane_resources.count_planes = plane_ids.size();
+    plane_resources.planes = plane_ids.data();
+
+    object_properties.clear();
+    for (auto const& crtc: crtcs)
+    {
+        add_object_properties(
+            crtc.crtc_id,
+            DRM_MODE_OBJECT_CRTC,
+            {{"MODE_ID", 0}, {"ACTIVE", 0}, {"GAMMA_LUT", 0}, {"GAMMA_LUT_SIZE", gamma_lut_size},
+             {"VRR_ENABLED", 0}});
+    }
+    for (auto const& connector: connectors)
+    {
+        add_object_properties(connector.connector_id, DRM_MODE_OBJECT_CONNECTOR, {{"CRTC_ID", 0}, {"vrr_capable", 0}});
+    }
+    for (auto const& plane: planes)
+    {
+        add_object_properties(
+            plane.plane_id,
+            DRM_MODE_OBJECT_PLANE,
+            {{"type", plane_types.at(plane.plane_id)}, {"FB_ID", 0}, {"CRTC_ID", 0},
+             {"SRC_X", 0}, {"SRC_Y", 0}, {"SRC_W", 0}, {"SRC_H", 0},
+             {"CRTC_X", 0}, {"CRTC_Y", 0}, {"CRTC_W", 0}, {"CRTC_H", 0}, {"zpos", 0}});
+    }
+}
+
+void mtd::FakeDRMResources::add_object_properties(
+    uint32_t id,
+    uint32_t type,
+    std::vector<std::pair<char const*, uint64_t>> const& properties)
+{
+    auto& object = object_properties[id];
+
+    object.type = type;
+    for (auto const& [name, value] : properties)
+    {
+        object.ids.push_back(property_id(name));
+        object.values.push_back(value);
+    }
+    object.properties.count_props = object.ids.size();
+    object.properties.props = object.ids.data();
+    object.properties.prop_values = object.values.data();
 }
 
 void mtd::FakeDRMResources::reset()
@@ -122,10 +246,16 @@ void mtd::FakeDRMResources::reset()
     crtcs.clear();
     encoders.clear();
     connectors.clear();
+    planes.clear();
 
     crtc_ids.clear();
     encoder_ids.clear();
     connector_ids.clear();
+
+    plane_resources = drmModePlaneRes();
+    plane_ids.clear();
+    plane_types.clear();
+    object_properties.clear();
 }
 
 void mtd::FakeDRMResources::add_crtc(uint32_t id, drmModeModeInfo mode)
@@ -176,6 +306,17 @@ void mtd::FakeDRMResources::add_connector(uint32_t connector_id,
     connectors.push_back(connector);
 }
 
+void mtd::FakeDRMResources::add_plane(uint32_t id, uint32_t type, uint32_t possible_crtcs_mask)
+{
+    drmModePlane plane = drmModePlane();
+
+    plane.plane_id = id;
+    plane.possible_crtcs = possible_crtcs_mask;
+
+    planes.push_back(plane);
+    plane_types[id] = type;
+}
+
 drmModeCrtc* mtd::FakeDRMResources::find_crtc(uint32_t id)
 {
     for (auto& crtc : crtcs)
@@ -206,6 +347,57 @@ drmModeConnector* mtd::FakeDRMResources::find_connector(uint32_t id)
     return nullptr;
 }
 
+drmModePlane* mtd::FakeDRMResources::find_plane(uint32_t id)
+{
+    for (auto& plane : planes)
+    {
+        if (plane.plane_id == id)
+            return &plane;
+    }
+    return nullptr;
+}
+
+drmModeObjectProperties* mtd::FakeDRMResources::find_object_properties(uint32_t id, uint32_t type)
+{
+    if (atomic_enabled)
+    {
+        auto const object = object_properties.find(id);
+        if (object != object_properties.end() && object->second.type == type)
+            return &object->second.properties;
+    }
+    return &no_properties;
+}
+
+void mtd::FakeDRMResources::set_property_value(uint32_t id, char const* name, uint64_t value)
+{
+    auto& object = object_properties.at(id);
+    auto const property = std::find(object.ids.begin(), object.ids.end(), property_id(name));
+    if (property == object.ids.end())
+    {
+        BOOST_THROW_EXCEPTION((std::logic_error{std::string{"Fake DRM object has no property called "} + name}));
+    }
+    object.values[property - object.ids.begin()] = value;
+}
+
+uint32_t mtd::FakeDRMResources::property_id(char const* name)
+{
+    for (auto const& property : atomic_properties())
+    {
+        if (!strcmp(property.name, name))
+            return property.prop_id;
+    }
+    BOOST_THROW_EXCEPTION((std::logic_error{std::string{"No fake DRM property called "} + name}));
+}
+
+drmModePropertyRes* mtd::FakeDRMResources::find_property(uint32_t id)
+{
+    for (auto& property : atomic_properties())
+    {
+        if (property.prop_id == id)
+            return &property;
+    }
+    return nullptr;
+}
 
 drmModeModeInfo mtd::FakeDRMResources::create_mode(uint16_t hdisplay, uint16_t vdisplay,
                                                    uint32_t clock, uint16_t htotal,
@@ -332,8 +524,83 @@ mtd::MockDRM::MockDRM()
                     return fd_to_drm.at(fd).find_connector(connector_id);
                 }));
 
+    ON_CALL(*this, drmModeGetPlaneResources(_))
+        .WillByDefault(
+            Invoke(
+                [this](int fd)
+                {
+                    return fd_to_drm.at(fd).plane_resources_ptr();
+                }));
+
+    ON_CALL(*this, drmModeGetPlane(_, _))
+        .WillByDefault(
+            Invoke(
+                [this](int fd, uint32_t plane_id)
+                {
+                    return fd_to_drm.at(fd).find_plane(plane_id);
+                }));
+
     ON_CALL(*this, drmModeObjectGetProperties(_, _, _))
-        .WillByDefault(Return(&empty_object_props));
+        .WillByDefault(
+            Invoke(
+                [this](int fd, uint32_t id, uint32_t type)
+                {
+                    auto const drm = fd_to_drm.find(fd);
+                    if (drm == fd_to_drm.end())
+                    {
+                        return &empty_object_props;
+                    }
+                    return drm->second.find_object_properties(id, type);
+                }));
+
+    ON_CALL(*this, drmModeGetProperty(_, _))
+        .WillByDefault(WithArg<1>(Invoke(&FakeDRMResources::find_property)));
+
+    ON_CALL(*this, drmSetClientCap(_, _, _))
+        .WillByDefault(Return(0));
+    ON_CALL(*this, drmSetClientCap(_, DRM_CLIENT_CAP_ATOMIC, _))
+        .WillByDefault(
+            Invoke(
+                [this](int fd, auto, auto)
+                {
+                    auto const drm = fd_to_drm.find(fd);
+                    if (drm == fd_to_drm.end() || !drm->second.atomic_enabled)
+                    {
+                        return -EOPNOTSUPP;
+                    }
+                    return 0;
+                }));
+
+    ON_CALL(*this, drmModeAtomicAlloc())
+        .WillByDefault(InvokeWithoutArgs([]() { return new _drmModeAtomicReq; }));
+    ON_CALL(*this, drmModeAtomicFree(_))
+        .WillByDefault(Invoke([](drmModeAtomicReqPtr request) { delete request; }));
+    ON_CALL(*this, drmModeAtomicAddProperty(_, _, _, _))
+        .WillByDefault(
+            Invoke(
+                [](drmModeAtomicReqPtr request, uint32_t object_id, uint32_t property_id, uint64_t value)
+                {
+                    request->properties.push_back({object_id, property_id, value});
+                    return static_cast<int>(request->properties.size());
+                }));
+
+    ON_CALL(*this, drmModeCreatePropertyBlob(_, _, _, _))
+        .WillByDefault(
+            Invoke(
+                [this](int, void const* data, size_t size, uint32_t* id)
+                {
+                    auto const bytes = static_cast<uint8_t const*>(data);
+                    *id = next_blob_id++;
+                    blobs[*id] = std::vector<uint8_t>(bytes, bytes + size);
+                    return 0;
+                }));
+    ON_CALL(*this, drmModeDestroyPropertyBlob(_, _))
+        .WillByDefault(
+            Invoke(
+                [this](int, uint32_t id)
+                {
+                    return blobs.erase(id) ? 0 : -ENOENT;
+                }));
 
     ON_CALL(*this, drmSetInterfaceVersion(_, _))
         .WillByDefault(
@@ -437,6 +704,50 @@ void mtd::MockDRM::add_encoder(
     fake_drms[device].add_encoder(encoder_id, crtc_id, possible_crtcs_mask);
 }
 
+void mtd::MockDRM::add_plane(
+    char const* device,
+    uint32_t id,
+    uint32_t type,
+    uint32_t possible_crtcs_mask)
+{
+    fake_drms[device].add_plane(id, type, possible_crtcs_mask);
+}
+
+void mtd::MockDRM::enable_atomic(char const* device)
+{
+    fake_drms[device].atomic_enabled = true;
+}
+
+void mtd::MockDRM::set_property_value(
+    char const* device,
+    uint32_t object_id,
+    char const* property,
+    uint64_t value)
+{
+    fake_drms[device].set_property_value(object_id, property, value);
+}
+
+auto mtd::MockDRM::atomic_property(
+    drmModeAtomicReqPtr request,
+    uint32_t object_id,
+    char const* property) -> std::optional<uint64_t>
+{
+    auto const property_id = FakeDRMResources::property_id(property);
+
+    std::optional<uint64_t> value;
+    for (auto const& set : request->properties)
+    {
+        if (set.object_id == object_id && set.property_id == property_id)
+            value = set.value;
+    }
+    return value;
+}
+
+auto mtd::MockDRM::blob_data(uint32_t blob_id) const -> std::vector<uint8_t> const&
+{
+    return blobs.at(blob_id);
+}
+
 void mtd::MockDRM::prepare(char const *device)
 {
     fake_drms[device].prepare();
@@ -669,6 +980,41 @@ int drmModeConnectorSetProperty(int fd, uint32_t connector_id, uint32_t property
     return global_mock->drmModeConnectorSetProperty(fd, connector_id, property_id, value);
 }
 
+int drmModeObjectSetProperty(int fd, uint32_t object_id, uint32_t object_type, uint32_t property_id, uint64_t value)
+{
+    return global_mock->drmModeObjectSetProperty(fd, object_id, object_type, property_id, value);
+}
+
+int drmModeCreatePropertyBlob(int fd, void const* data, size_t size, uint32_t* id)
+{
+    return global_mock->drmModeCreatePropertyBlob(fd, data, size, id);
+}
+
+int drmModeDestroyPropertyBlob(int fd, uint32_t id)
+{
+    return global_mock->drmModeDestroyPropertyBlob(fd, id);
+}
+
+drmModeAtomicReqPtr drmModeAtomicAlloc()
+{
+    return global_mock->drmModeAtomicAlloc();
+}
+
+void drmModeAtomicFree(drmModeAtomicReqPtr req)
+{
+    global_mock->drmModeAtomicFree(req);
+}
+
+int drmModeAtomicAddProperty(drmModeAtomicReqPtr req, uint32_t object_id, uint32_t property_id, uint64_t value)
+{
+    return global_mock->drmModeAtomicAddProperty(req, object_id, property_id, value);
+}
+
+int drmModeAtomicCommit(int fd, drmModeAtomicReqPtr req, uint32_t flags, void* user_data)
+{
+    return global_mock->drmModeAtomicCommit(fd, req, flags, user_data);
+}
+
 void drmModeFreeConnector(drmModeConnectorPtr ptr)
 {
     global_mock->drmModeFreeConnector(ptr);
@@ -452,6 +452,34 @@ TEST_F(StaticDisplayConfig, group_can_be_set)
     EXPECT_THAT(hdmi1.logical_group_id, Eq(mg::DisplayConfigurationLogicalGroupId{2}));
 }
 
+TEST_F(StaticDisplayConfig, vrr_can_be_enabled)
+{
+    std::istringstream stream{
+        "layouts:\n"
+        "  default:\n"
+        "    cards:\n"
+        "    - HDMI-A-1:\n"
+        "        vrr: enabled\n"};
+
+    sdc.load_config(stream, "");
+    sdc.apply_to(dc);
+
+    EXPECT_TRUE(hdmi1.vrr_enabled);
+    EXPECT_FALSE(vga1.vrr_enabled);
+}
+
+TEST_F(StaticDisplayConfig, ill_formed_vrr_causes_AbnormalExit)
+{
+    std::istringstream ill_formed{
+        "layouts:\n"
+        "  default:\n"
+        "    cards:\n"
+        "    - HDMI-A-1:\n"
+        "        vrr: sometimes\n"};
+
+    EXPECT_THROW((sdc.load_config(ill_formed, "")), mir::AbnormalExit);
+}
+
 TEST_F(StaticDisplayConfig, given_custom_attributes_when_they_are_not_added_they_are_not_applied)
 {
     std::istringstream stream{
@@ -394,6 +394,26 @@ TEST_F(WaylandExtensions, enable_can_enable_non_standard_extensions)
     EXPECT_THAT(*enumerator_client.interfaces, Contains(Eq(extension_to_enable)));
 }
 
+TEST_F(WaylandExtensions, tearing_control_is_supported_but_not_enabled_by_default)
+{
+    EXPECT_THAT(miral::WaylandExtensions::supported(), Contains(Eq(miral::WaylandExtensions::wp_tearing_control_manager_v1)));
+    EXPECT_THAT(miral::WaylandExtensions::recommended(), Not(Contains(Eq(miral::WaylandExtensions::wp_tearing_control_manager_v1))));
+}
+
+TEST_F(WaylandExtensions, enable_can_enable_tearing_control)
+{
+    miral::WaylandExtensions extensions;
+    extensions.enable(miral::WaylandExtensions::wp_tearing_control_manager_v1);
+    ClientGlobalEnumerator enumerator_client;
+
+    add_server_init(extensions);
+    start_server();
+
+    run_as_client(enumerator_client);
+
+    EXPECT_THAT(*enumerator_client.interfaces, Contains(Eq(miral::WaylandExtensions::wp_tearing_control_manager_v1)));
+}
+
 TEST_F(WaylandExtensions, enable_can_enable_bespoke_extension)
 {
     miral::WaylandExtensions extensions;
@@ -102,3 +102,21 @@ TEST_F(CompositorPerformance, regression_test_1563287)
     EXPECT_GE(compositor_fps, 0);
     EXPECT_GT(compositor_render_time, 0);
 }
+
+// SHM clients are uploaded to textures as they're composited, so any stall
+// waiting on the GPU after each upload shows up in ms/frame
+TEST_F(CompositorPerformance, render_time_with_several_shm_clients)
+{
+    spawn_clients({"mir_demo_client_wayland", "mir_demo_client_wayland",
+                   "mir_demo_client_wayland", "mir_demo_client_wayland",
+                   "mir_demo_client_wayland", "mir_demo_client_wayland"});
+    run_server_for(10s);
+
+    read_compositor_report();
+    RecordProperty("framerate", std::to_string(compositor_fps));
+    RecordProperty("render_time", std::to_string(compositor_render_time));
+    RecordProperty("server_renderer", server_renderer);
+    RecordProperty("server_mode", server_mode);
+    EXPECT_GE(compositor_fps, 0);
+    EXPECT_GT(compositor_render_time, 0);
+}
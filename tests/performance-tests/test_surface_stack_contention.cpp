@@ -0,0 +1,199 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/server/report/null_report_factory.h"
+#include "src/server/scene/surface_stack.h"
+#include "src/server/scene/basic_surface.h"
+#include "mir/compositor/scene_element.h"
+#include "mir/graphics/renderable.h"
+#include "mir/test/doubles/stub_buffer_stream.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace ms = mir::scene;
+namespace mr = mir::report;
+namespace mc = mir::compositor;
+namespace mg = mir::graphics;
+namespace mi = mir::input;
+namespace mtd = mir::test::doubles;
+namespace geom = mir::geometry;
+
+using namespace std::chrono_literals;
+using namespace testing;
+
+namespace
+{
+using FrameTimes = std::vector<std::chrono::nanoseconds>;
+
+auto percentile(FrameTimes times, double p) -> std::chrono::nanoseconds
+{
+    std::sort(times.begin(), times.end());
+    return times[static_cast<size_t>(p * (times.size() - 1))];
+}
+
+struct SurfaceStackContention : Test
+{
+    SurfaceStackContention()
+    {
+        for (auto i = 0; i != surface_count; ++i)
+        {
+            auto const surface = std::make_shared<ms::BasicSurface>(
+                nullptr /* session */,
+                mir::wayland::Weak<mir::frontend::WlSurface>{},
+                "surface",
+                geom::Rectangle{{(i % 10) * 100, (i / 10) * 100}, {200, 200}},
+                mir_pointer_unconfined,
+                std::list<ms::StreamInfo>{{std::make_shared<mtd::StubBufferStream>(), {}, {}}},
+                nullptr,
+                mr::null_scene_report());
+            surfaces.push_back(surface);
+            stack.add_surface(surface, mi::InputReceptionMode::normal);
+        }
+        stack.register_compositor(compositor_id);
+    }
+
+    ~SurfaceStackContention()
+    {
+        stack.unregister_compositor(compositor_id);
+        for (auto const& surface : surfaces)
+        {
+            stack.remove_surface(surface);
+        }
+    }
+
+    /// Time composing frames as fast as a compositor thread could, while \a contend() runs on other threads
+    template<typename Contention>
+    auto frame_times_while(Contention const& contend) -> FrameTimes
+    {
+        std::atomic<bool> done{false};
+        std::vector<std::thread> contenders;
+        for (auto i = 0; i != contender_count; ++i)
+        {
+            contenders.emplace_back([&, i] { contend(done, i); });
+        }
+
+        FrameTimes times;
+        times.reserve(frame_count);
+        for (auto i = 0; i != frame_count; ++i)
+        {
+            auto const start = std::chrono::steady_clock::now();
+            stack.frames_pending(compositor_id);
+            auto const elements = stack.scene_elements_for(compositor_id);
+            for (auto const& element : elements)
+            {
+                element->renderable()->buffer();
+                element->rendered();
+            }
+            times.push_back(std::chrono::steady_clock::now() - start);
+        }
+
+        done = true;
+        for (auto& contender : contenders)
+        {
+            contender.join();
+        }
+        return times;
+    }
+
+    /// Record how long frames took, and how much slower than an idle stack they were
+    void record(char const* scenario, FrameTimes const& times, FrameTimes const& idle)
+    {
+        auto const slowdown = [](std::chrono::nanoseconds slower, std::chrono::nanoseconds baseline)
+            {
+                return std::to_string(
+                    static_cast<double>(slower.count()) / std::max<std::chrono::nanoseconds::rep>(baseline.count(), 1));
+            };
+
+        RecordProperty(std::string{scenario} + "_p50_ns", std::to_string(percentile(times, 0.50).count()));
+        RecordProperty(std::string{scenario} + "_p99_ns", std::to_string(percentile(times, 0.99).count()));
+        RecordProperty(
+            std::string{scenario} + "_max_ns",
+            std::to_string(std::max_element(times.begin(), times.end())->count()));
+        RecordProperty(
+            std::string{scenario} + "_p50_slowdown",
+            slowdown(percentile(times, 0.50), percentile(idle, 0.50)));
+        RecordProperty(
+            std::string{scenario} + "_p99_slowdown",
+            slowdown(percentile(times, 0.99), percentile(idle, 0.99)));
+    }
+
+    static constexpr int surface_count = 60;
+    static constexpr int frame_count = 5000;
+    static constexpr int contender_count = 2;
+    /// Contenders work in bursts, so they don't simply starve the compositor of CPU time
+    static constexpr int burst_length = 20;
+    static constexpr std::chrono::microseconds burst_interval{200};
+
+    ms::SurfaceStack stack{mr::null_scene_report()};
+    std::vector<std::shared_ptr<ms::Surface>> surfaces;
+    mc::CompositorID const compositor_id{&stack};
+};
+}
+
+TEST_F(SurfaceStackContention, compositor_frame_times_under_concurrent_restacking)
+{
+    auto const idle = frame_times_while([](std::atomic<bool> const&, int) {});
+
+    auto const restacking = frame_times_while(
+        [this](std::atomic<bool> const& done, int seed)
+        {
+            std::mt19937 random{static_cast<unsigned>(seed)};
+            std::uniform_int_distribution<size_t> pick{0, surfaces.size() - 1};
+            while (!done)
+            {
+                // A window manager "raise storm"
+                for (auto i = 0; i != burst_length; ++i)
+                {
+                    stack.raise(surfaces[pick(random)]);
+                    stack.raise(ms::SurfaceSet{surfaces[pick(random)], surfaces[pick(random)]});
+                    stack.send_to_back(ms::SurfaceSet{surfaces[pick(random)]});
+                }
+                std::this_thread::sleep_for(burst_interval);
+            }
+        });
+
+    auto const input = frame_times_while(
+        [this](std::atomic<bool> const& done, int seed)
+        {
+            std::mt19937 random{static_cast<unsigned>(seed)};
+            std::uniform_int_distribution<int> coordinate{0, 1000};
+            while (!done)
+            {
+                for (auto i = 0; i != burst_length; ++i)
+                {
+                    stack.input_surface_at({coordinate(random), coordinate(random)});
+                }
+                std::this_thread::sleep_for(burst_interval);
+            }
+        });
+
+    /* Readers work on an immutable version of the stack, so contenders never hold up a frame;
+     * what slowdown remains is contenders competing for CPU time and cache. That depends on the
+     * machine and what else it is running, so this reports the numbers rather than judging them.
+     */
+    record("idle", idle, idle);
+    record("restacking", restacking, idle);
+    record("input", input, idle);
+}
@@ -0,0 +1,144 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/server/compositor/damage.h"
+#include "mir/geometry/rectangle.h"
+#include "mir/test/doubles/fake_renderable.h"
+#include "mir/test/doubles/stub_buffer.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include <memory>
+#include <optional>
+
+using namespace testing;
+using namespace mir::geometry;
+namespace mc = mir::compositor;
+namespace mg = mir::graphics;
+namespace mtd = mir::test::doubles;
+
+namespace
+{
+auto as_vector(Rectangles const& rectangles) -> std::vector<Rectangle>
+{
+    return {rectangles.begin(), rectangles.end()};
+}
+
+struct ClientDamagedRenderable : mtd::FakeRenderable
+{
+    using mtd::FakeRenderable::FakeRenderable;
+
+    auto damage_since(mg::BufferID) const -> std::optional<Rectangles> override
+    {
+        return client_damage;
+    }
+
+    std::optional<Rectangles> client_damage;
+};
+
+struct DamageTracker : public Test
+{
+    Rectangle const monitor_rect{{0, 0}, {1920, 1200}};
+    mc::DamageTracker tracker;
+};
+}
+
+TEST_F(DamageTracker, first_frame_damages_whole_area)
+{
+    auto window = std::make_shared<mtd::FakeRenderable>(12, 34, 56, 78);
+
+    EXPECT_THAT(as_vector(tracker.damage_for({window}, monitor_rect)), ElementsAre(monitor_rect));
+}
+
+TEST_F(DamageTracker, unchanged_frame_has_no_damage)
+{
+    auto window = std::make_shared<mtd::FakeRenderable>(12, 34, 56, 78);
+    tracker.damage_for({window}, monitor_rect);
+
+    EXPECT_THAT(as_vector(tracker.damage_for({window}, monitor_rect)), IsEmpty());
+}
+
+TEST_F(DamageTracker, new_buffer_damages_only_that_renderable)
+{
+    auto window = std::make_shared<mtd::FakeRenderable>(12, 34, 56, 78);
+    auto other = std::make_shared<mtd::FakeRenderable>(100, 100, 50, 50);
+    tracker.damage_for({window, other}, monitor_rect);
+
+    window->set_buffer(std::make_shared<mtd::StubBuffer>());
+
+    EXPECT_THAT(as_vector(tracker.damage_for({window, other}, monitor_rect)), ElementsAre(window->screen_position()));
+}
+
+TEST_F(DamageTracker, added_and_removed_renderables_are_damaged)
+{
+    auto window = std::make_shared<mtd::FakeRenderable>(12, 34, 56, 78);
+    auto other = std::make_shared<mtd::FakeRenderable>(100, 100, 50, 50);
+    tracker.damage_for({window}, monitor_rect);
+
+    EXPECT_THAT(as_vector(tracker.damage_for({other}, monitor_rect)),
+        UnorderedElementsAre(window->screen_position(), other->screen_position()));
+}
+
+TEST_F(DamageTracker, restacking_damages_restacked_renderables)
+{
+    auto window = std::make_shared<mtd::FakeRenderable>(12, 34, 56, 78);
+    auto other = std::make_shared<mtd::FakeRenderable>(20, 40, 50, 50);
+    tracker.damage_for({window, other}, monitor_rect);
+
+    auto const damage = as_vector(tracker.damage_for({other, window}, monitor_rect));
+
+    EXPECT_THAT(damage, Contains(window->screen_position()));
+    EXPECT_THAT(damage, Contains(other->screen_position()));
+}
+
+TEST_F(DamageTracker, damage_is_clipped_to_area)
+{
+    auto window = std::make_shared<mtd::FakeRenderable>(1900, 1100, 100, 200);
+    tracker.damage_for({}, monitor_rect);
+
+    EXPECT_THAT(as_vector(tracker.damage_for({window}, monitor_rect)), ElementsAre(Rectangle{{1900, 1100}, {20, 100}}));
+}
+
+TEST_F(DamageTracker, changed_area_damages_whole_area)
+{
+    auto window = std::make_shared<mtd::FakeRenderable>(12, 34, 56, 78);
+    Rectangle const new_monitor_rect{{0, 0}, {1280, 1024}};
+    tracker.damage_for({window}, monitor_rect);
+
+    EXPECT_THAT(as_vector(tracker.damage_for({window}, new_monitor_rect)), ElementsAre(new_monitor_rect));
+}
+
+TEST_F(DamageTracker, reset_damages_whole_area)
+{
+    auto window = std::make_shared<mtd::FakeRenderable>(12, 34, 56, 78);
+    tracker.damage_for({window}, monitor_rect);
+
+    tracker.reset();
+
+    EXPECT_THAT(as_vector(tracker.damage_for({window}, monitor_rect)), ElementsAre(monitor_rect));
+}
+
+TEST_F(DamageTracker, new_buffer_damages_only_what_the_client_damaged)
+{
+    auto window = std::make_shared<ClientDamagedRenderable>(12, 34, 56, 78);
+    tracker.damage_for({window}, monitor_rect);
+
+    window->set_buffer(std::make_shared<mtd::StubBuffer>());
+    window->client_damage = Rectangles{{{20, 40}, {5, 5}}, {{60, 100}, {100, 100}}};
+
+    EXPECT_THAT(as_vector(tracker.damage_for({window}, monitor_rect)),
+        UnorderedElementsAre(Rectangle{{20, 40}, {5, 5}}, Rectangle{{60, 100}, {8, 12}}));
+}
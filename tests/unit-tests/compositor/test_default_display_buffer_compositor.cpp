@@ -23,6 +23,7 @@
 #include "mir/test/fake_shared.h"
 #include "mir/test/doubles/mock_display_sink.h"
 #include "mir/test/doubles/fake_renderable.h"
+#include "mir/test/doubles/stub_buffer.h"
 #include "mir/test/doubles/mock_compositor_report.h"
 #include "mir/test/doubles/stub_scene_element.h"
 #include "mir/test/doubles/stub_gl_rendering_provider.h"
@@ -77,6 +78,33 @@ auto make_scene_elements(std::initializer_list<std::shared_ptr<mg::Renderable>>
     return elements;
 }
 
+// A GL provider that can show every buffer directly, as scan-out hardware might
+struct ScanoutGlRenderingProvider : mtd::StubGlRenderingProvider
+{
+    auto make_framebuffer_provider(mg::DisplaySink& /*sink*/)
+        -> std::unique_ptr<FramebufferProvider> override
+    {
+        class StubFramebufferProvider : public FramebufferProvider
+        {
+        public:
+            auto buffer_to_framebuffer(std::shared_ptr<mg::Buffer> buffer)
+                -> std::unique_ptr<mg::Framebuffer> override
+            {
+                class StubFramebuffer : public mg::Framebuffer
+                {
+                public:
+                    explicit StubFramebuffer(geom::Size size) : size_{size} {}
+                    auto size() const -> geom::Size override { return size_; }
+                private:
+                    geom::Size const size_;
+                };
+                return std::make_unique<StubFramebuffer>(buffer->size());
+            }
+        };
+        return std::make_unique<StubFramebufferProvider>();
+    }
+};
+
 struct DefaultDisplayBufferCompositor : public testing::Test
 {
     DefaultDisplayBufferCompositor()
@@ -169,6 +197,54 @@ TEST_F(DefaultDisplayBufferCompositor, all_expected_reports_are_received_during_
     compositor.composite(make_scene_elements({big}));
 }
 
+TEST_F(DefaultDisplayBufferCompositor, reports_gpu_time_measured_by_renderer)
+{
+    using namespace testing;
+    auto report = std::make_shared<NiceMock<mtd::MockCompositorReport>>();
+    std::chrono::nanoseconds const gpu_time{std::chrono::milliseconds{3}};
+
+    EXPECT_CALL(mock_renderer, completed_gpu_time())
+        .WillOnce(Return(std::nullopt))
+        .WillOnce(Return(gpu_time));
+    EXPECT_CALL(*report, rendered_frame_on_gpu(_, gpu_time))
+        .Times(1);
+
+    mc::DefaultDisplayBufferCompositor compositor(
+        display_sink,
+        gl_provider,
+        mt::fake_shared(mock_renderer),
+        report);
+    compositor.composite(make_scene_elements({big}));
+    compositor.composite(make_scene_elements({big}));
+}
+
+TEST_F(DefaultDisplayBufferCompositor, reports_its_display_and_posts_as_the_compositor_that_rendered_them)
+{
+    using namespace testing;
+    auto report = std::make_shared<NiceMock<mtd::MockCompositorReport>>();
+    std::chrono::nanoseconds const refresh_period{std::chrono::milliseconds{16}};
+    mc::CompositorReport::SubCompositorId added{nullptr}, began{nullptr}, posted{nullptr};
+
+    EXPECT_CALL(*report, added_display(_,_,_,_,_))
+        .WillOnce(SaveArg<4>(&added));
+    EXPECT_CALL(*report, began_frame(_))
+        .WillOnce(SaveArg<0>(&began));
+    EXPECT_CALL(*report, posted_frame(_, Eq(refresh_period)))
+        .WillOnce(SaveArg<0>(&posted));
+
+    mc::DefaultDisplayBufferCompositor compositor(
+        display_sink,
+        gl_provider,
+        mt::fake_shared(mock_renderer),
+        report);
+    compositor.composite(make_scene_elements({big}));
+    compositor.frame_posted(refresh_period);
+
+    EXPECT_THAT(added, NotNull());
+    EXPECT_THAT(began, Eq(added));
+    EXPECT_THAT(posted, Eq(added));
+}
+
 TEST_F(DefaultDisplayBufferCompositor, elements_provided_to_composite_are_rendered_in_order)
 {
     using namespace testing;
@@ -331,3 +407,124 @@ TEST_F(DefaultDisplayBufferCompositor, marks_occluded_scene_elements)
     compositor.composite({element0_occluded, element1_rendered, element2_occluded});
 }
 
+
+TEST_F(DefaultDisplayBufferCompositor, damage_is_limited_to_changed_renderables)
+{
+    using namespace testing;
+
+    mc::DefaultDisplayBufferCompositor compositor(
+        display_sink,
+        gl_provider,
+        mt::fake_shared(mock_renderer),
+        mr::null_compositor_report());
+
+    EXPECT_CALL(mock_renderer, set_damage(geom::Rectangles{screen}));
+    compositor.composite(make_scene_elements({big, small}));
+    Mock::VerifyAndClearExpectations(&mock_renderer);
+
+    small->set_buffer(std::make_shared<mtd::StubBuffer>());
+
+    EXPECT_CALL(mock_renderer, set_damage(geom::Rectangles{small->screen_position()}));
+    compositor.composite(make_scene_elements({big, small}));
+}
+
+TEST_F(DefaultDisplayBufferCompositor, whole_output_is_damaged_after_overlay)
+{
+    using namespace testing;
+
+    mc::DefaultDisplayBufferCompositor compositor(
+        display_sink,
+        gl_provider,
+        mt::fake_shared(mock_renderer),
+        mr::null_compositor_report());
+
+    compositor.composite(make_scene_elements({big}));
+
+    EXPECT_CALL(display_sink, overlay(_))
+        .WillOnce(Return(true))
+        .WillRepeatedly(Return(false));
+    compositor.composite(make_scene_elements({}));
+
+    EXPECT_CALL(mock_renderer, set_damage(geom::Rectangles{screen}));
+    compositor.composite(make_scene_elements({big}));
+}
+
+TEST_F(DefaultDisplayBufferCompositor, topmost_renderables_shown_above_next_image_are_not_composited)
+{
+    using namespace testing;
+    ScanoutGlRenderingProvider scanout_provider;
+
+    mc::DefaultDisplayBufferCompositor compositor(
+        display_sink,
+        scanout_provider,
+        mt::fake_shared(mock_renderer),
+        mr::null_compositor_report());
+
+    EXPECT_CALL(display_sink, overlay_above_next_image(SizeIs(2)))
+        .WillOnce(Return(1));
+    EXPECT_CALL(mock_renderer, render(ContainerEq(mg::RenderableList{big})));
+    EXPECT_CALL(display_sink, set_next_image(_));
+
+    compositor.composite(make_scene_elements({big, small}));
+}
+
+TEST_F(DefaultDisplayBufferCompositor, renderables_are_offered_for_overlay_bottom_to_top)
+{
+    using namespace testing;
+    ScanoutGlRenderingProvider scanout_provider;
+
+    mc::DefaultDisplayBufferCompositor compositor(
+        display_sink,
+        scanout_provider,
+        mt::fake_shared(mock_renderer),
+        mr::null_compositor_report());
+
+    std::vector<mg::DisplayElement> offered;
+    EXPECT_CALL(display_sink, overlay_above_next_image(_))
+        .WillOnce(DoAll(SaveArg<0>(&offered), Return(0)));
+
+    compositor.composite(make_scene_elements({big, small}));
+
+    ASSERT_THAT(offered, SizeIs(2));
+    EXPECT_THAT(offered[0].screen_positon, Eq(big->screen_position()));
+    EXPECT_THAT(offered[1].screen_positon, Eq(small->screen_position()));
+}
+
+TEST_F(DefaultDisplayBufferCompositor, translucent_renderables_are_composited_with_those_below)
+{
+    using namespace testing;
+    ScanoutGlRenderingProvider scanout_provider;
+    auto const translucent = std::make_shared<mtd::FakeRenderable>(geom::Rectangle{{10, 20},{30, 40}}, 0.5f);
+
+    mc::DefaultDisplayBufferCompositor compositor(
+        display_sink,
+        scanout_provider,
+        mt::fake_shared(mock_renderer),
+        mr::null_compositor_report());
+
+    EXPECT_CALL(display_sink, overlay(_)).Times(0);
+    EXPECT_CALL(display_sink, overlay_above_next_image(_)).Times(0);
+    EXPECT_CALL(mock_renderer, render(ContainerEq(mg::RenderableList{big, translucent})));
+
+    compositor.composite(make_scene_elements({big, translucent}));
+}
+
+TEST_F(DefaultDisplayBufferCompositor, damage_covers_a_renderable_no_longer_shown_above_next_image)
+{
+    using namespace testing;
+    ScanoutGlRenderingProvider scanout_provider;
+
+    mc::DefaultDisplayBufferCompositor compositor(
+        display_sink,
+        scanout_provider,
+        mt::fake_shared(mock_renderer),
+        mr::null_compositor_report());
+
+    EXPECT_CALL(display_sink, overlay_above_next_image(_))
+        .WillOnce(Return(1))
+        .WillOnce(Return(0));
+    compositor.composite(make_scene_elements({big, small}));
+
+    EXPECT_CALL(mock_renderer, set_damage(geom::Rectangles{small->screen_position()}));
+    compositor.composite(make_scene_elements({big, small}));
+}
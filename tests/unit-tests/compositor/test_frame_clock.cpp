@@ -0,0 +1,98 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/compositor/frame_clock.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <thread>
+
+using namespace testing;
+using namespace std::chrono_literals;
+namespace mc = mir::compositor;
+
+namespace
+{
+struct FrameClock : public Test
+{
+    std::shared_ptr<mc::FrameClock> const clock{std::make_shared<mc::FrameClock>()};
+    mir::time::Timestamp const start{std::chrono::steady_clock::now()};
+};
+}
+
+TEST_F(FrameClock, runs_work_when_the_next_frame_is_presented)
+{
+    int runs = 0;
+    clock->spawn([&runs] { ++runs; });
+    clock->spawn([&runs] { ++runs; });
+
+    EXPECT_THAT(runs, Eq(0));
+
+    clock->frame_presented(start, 16ms);
+    EXPECT_THAT(runs, Eq(2));
+
+    clock->frame_presented(start + 16ms, 16ms);
+    EXPECT_THAT(runs, Eq(2));
+}
+
+TEST_F(FrameClock, is_only_current_on_the_thread_it_was_set_for)
+{
+    mc::FrameClock::set_for_this_thread(clock);
+
+    std::shared_ptr<mc::FrameClock> other_thread_clock{clock};
+    std::thread{[&] { other_thread_clock = mc::FrameClock::for_this_thread(); }}.join();
+
+    EXPECT_THAT(mc::FrameClock::for_this_thread(), Eq(clock));
+    EXPECT_THAT(other_thread_clock, IsNull());
+
+    mc::FrameClock::set_for_this_thread(nullptr);
+    EXPECT_THAT(mc::FrameClock::for_this_thread(), IsNull());
+}
+
+TEST_F(FrameClock, does_not_predict_frames_without_a_refresh_interval)
+{
+    EXPECT_THAT(clock->next_frame_after(start), Eq(std::nullopt));
+
+    clock->frame_presented(start, std::nullopt);
+    EXPECT_THAT(clock->next_frame_after(start), Eq(std::nullopt));
+}
+
+TEST_F(FrameClock, predicts_the_next_refresh)
+{
+    auto const interval = 7ms;
+    clock->frame_presented(start, interval);
+
+    EXPECT_THAT(clock->next_frame_after(start + 1ms), Eq(start + interval));
+    EXPECT_THAT(clock->next_frame_after(start + 3 * interval + 1ms), Eq(start + 4 * interval));
+}
+
+TEST_F(FrameClock, work_sees_the_presentation_of_its_frame)
+{
+    mir::graphics::FramePresentation presented;
+    presented.frame.msc = 17;
+    presented.vsync = true;
+
+    std::optional<mir::graphics::FramePresentation> seen;
+    clock->spawn([this, &seen] { seen = clock->last_presentation(); });
+
+    clock->frame_presented(start, 16ms, presented);
+
+    ASSERT_TRUE(seen);
+    EXPECT_THAT(seen->frame.msc, Eq(17));
+    EXPECT_TRUE(seen->vsync);
+    EXPECT_THAT(clock->refresh(), Eq(16ms));
+}
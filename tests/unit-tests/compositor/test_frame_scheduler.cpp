@@ -0,0 +1,105 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/server/compositor/frame_scheduler.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+using namespace testing;
+using namespace std::chrono_literals;
+namespace mc = mir::compositor;
+
+namespace
+{
+struct FrameScheduler : public Test
+{
+    std::chrono::nanoseconds const budget{7ms};
+
+    /// Simulate a frame that starts when we were told to, and whose post() returns \a interval after the last
+    void run_frame(std::chrono::nanoseconds render_time, std::chrono::nanoseconds interval)
+    {
+        auto const last_posted = now;
+        auto const started = now + scheduler.recommended_sleep().value_or(0ns);
+        scheduler.frame_started(started);
+        scheduler.frame_rendered(started + render_time);
+        now = last_posted + interval;
+        scheduler.frame_posted(now, budget);
+    }
+
+    /// Simulate frames that hit their deadlines
+    void run_frames(int count, std::chrono::nanoseconds render_time)
+    {
+        for (auto i = 0; i != count; ++i)
+        {
+            run_frame(render_time, budget);
+        }
+    }
+
+    mc::FrameScheduler::Clock::time_point now;
+    mc::FrameScheduler scheduler;
+};
+}
+
+TEST_F(FrameScheduler, has_no_recommendation_without_a_budget)
+{
+    scheduler.frame_started(now);
+    scheduler.frame_rendered(now + 1ms);
+    scheduler.frame_posted(now + 2ms, std::nullopt);
+
+    EXPECT_THAT(scheduler.recommended_sleep(), Eq(std::nullopt));
+}
+
+TEST_F(FrameScheduler, does_not_sleep_until_it_has_measured_some_frames)
+{
+    run_frames(1, 1ms);
+
+    EXPECT_THAT(scheduler.recommended_sleep(), Eq(0ns));
+}
+
+TEST_F(FrameScheduler, sleeps_for_the_budget_not_needed_for_rendering)
+{
+    run_frames(20, 2ms);
+
+    EXPECT_THAT(scheduler.predicted_render_time(), Eq(2ms));
+    EXPECT_THAT(scheduler.recommended_sleep(), Optional(AllOf(Gt(0ns), Le(budget - 2ms))));
+}
+
+TEST_F(FrameScheduler, plans_for_slow_frames)
+{
+    run_frames(50, 1ms);
+    run_frames(10, 4ms);
+
+    EXPECT_THAT(scheduler.predicted_render_time(), Eq(4ms));
+}
+
+TEST_F(FrameScheduler, never_recommends_a_negative_sleep)
+{
+    run_frames(20, 10ms);
+
+    EXPECT_THAT(scheduler.recommended_sleep(), Eq(0ns));
+}
+
+TEST_F(FrameScheduler, starts_earlier_after_missing_a_deadline)
+{
+    run_frames(20, 2ms);
+    auto const sleep_before = scheduler.recommended_sleep().value();
+
+    // This frame takes as long as usual, but still misses the deadline
+    run_frame(2ms, 2 * budget);
+
+    EXPECT_THAT(scheduler.recommended_sleep().value(), Lt(sleep_before));
+}
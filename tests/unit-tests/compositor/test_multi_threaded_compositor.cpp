@@ -36,6 +36,7 @@
 
 #include <boost/throw_exception.hpp>
 
+#include <atomic>
 #include <unordered_map>
 #include <unordered_set>
 #include <thread>
@@ -452,8 +453,6 @@ TEST(MultiThreadedCompositor, reports_in_the_right_places)
             .WillRepeatedly(Return(geom::Rectangle()));
     });
 
-    EXPECT_CALL(*mock_report, added_display(_,_,_,_,_))
-        .Times(1);
     EXPECT_CALL(*mock_report, scheduled())
         .Times(2);
 
@@ -467,6 +466,53 @@ TEST(MultiThreadedCompositor, reports_in_the_right_places)
     compositor.stop();
 }
 
+TEST(MultiThreadedCompositor, tells_display_buffer_compositors_when_their_frames_are_posted)
+{
+    class PostCountingDisplayBufferCompositor : public mc::DisplayBufferCompositor
+    {
+    public:
+        PostCountingDisplayBufferCompositor(std::atomic<int>& posts)
+            : posts{posts}
+        {
+        }
+
+        bool composite(mc::SceneElementSequence&&) override
+        {
+            return true;
+        }
+
+        void frame_posted(std::optional<std::chrono::nanoseconds>) override
+        {
+            ++posts;
+        }
+
+    private:
+        std::atomic<int>& posts;
+    };
+
+    class PostCountingDisplayBufferCompositorFactory : public mc::DisplayBufferCompositorFactory
+    {
+    public:
+        std::unique_ptr<mc::DisplayBufferCompositor> create_compositor_for(mg::DisplaySink&) override
+        {
+            return std::make_unique<PostCountingDisplayBufferCompositor>(posts);
+        }
+
+        std::atomic<int> posts{0};
+    };
+
+    auto display = std::make_shared<mtd::StubDisplay>(1);
+    auto scene = std::make_shared<StubScene>();
+    auto db_compositor_factory = std::make_shared<PostCountingDisplayBufferCompositorFactory>();
+    mc::MultiThreadedCompositor compositor{display, scene, db_compositor_factory, null_display_listener, null_report, default_delay, true};
+
+    compositor.start();
+    scene->emit_change_event();
+    while (db_compositor_factory->posts == 0)
+        std::this_thread::yield();
+    compositor.stop();
+}
+
 /*
  * It's difficult to test that a render won't happen, without some further
  * introspective capabilities that would complicate the code. This test will
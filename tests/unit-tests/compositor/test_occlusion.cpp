@@ -60,6 +60,22 @@ struct OcclusionFilterTest : public Test
     Rectangle monitor_rect;
 };
 
+/// A translucent-format renderable that declares part of itself opaque
+struct PartlyOpaqueRenderable : mtd::FakeRenderable
+{
+    PartlyOpaqueRenderable(Rectangle const& position, Rectangle const& opaque)
+        : FakeRenderable{position, 1.0f, false},
+          opaque{opaque}
+    {
+    }
+
+    auto opaque_region() const -> Rectangles override
+    {
+        return {opaque};
+    }
+
+    Rectangle const opaque;
+};
 }
 
 TEST_F(OcclusionFilterTest, single_window_not_occluded)
@@ -200,3 +216,69 @@ TEST_F(OcclusionFilterTest,
     EXPECT_THAT(renderables_from(occlusions), ElementsAre(partially_onscreen));
     EXPECT_THAT(renderables_from(elements), ElementsAre(covering));
 }
+
+TEST_F(OcclusionFilterTest, window_covered_by_two_neighbours_is_occluded)
+{
+    auto const left = std::make_shared<mtd::FakeRenderable>(0, 0, 960, 1200);
+    auto const right = std::make_shared<mtd::FakeRenderable>(960, 0, 960, 1200);
+    auto const behind = std::make_shared<mtd::FakeRenderable>(800, 100, 300, 300);
+    auto elements = scene_elements_from({behind, left, right});
+
+    auto const& occlusions = filter_occlusions_from(elements, monitor_rect);
+
+    EXPECT_THAT(renderables_from(occlusions), ElementsAre(behind));
+    EXPECT_THAT(renderables_from(elements), ElementsAre(left, right));
+}
+
+TEST_F(OcclusionFilterTest, window_only_partly_covered_by_neighbours_is_not_occluded)
+{
+    auto const left = std::make_shared<mtd::FakeRenderable>(0, 0, 900, 1200);
+    auto const right = std::make_shared<mtd::FakeRenderable>(960, 0, 960, 1200);
+    auto const behind = std::make_shared<mtd::FakeRenderable>(800, 100, 300, 300);
+    auto elements = scene_elements_from({behind, left, right});
+
+    auto const& occlusions = filter_occlusions_from(elements, monitor_rect);
+
+    EXPECT_THAT(renderables_from(occlusions), IsEmpty());
+    EXPECT_THAT(renderables_from(elements), ElementsAre(behind, left, right));
+}
+
+TEST_F(OcclusionFilterTest, opaque_region_of_shaped_window_occludes)
+{
+    // e.g. a client-side decorated window with a translucent shadow around an opaque body
+    auto const top = std::make_shared<PartlyOpaqueRenderable>(
+        Rectangle{{0, 0}, {200, 200}},
+        Rectangle{{20, 20}, {160, 160}});
+    auto const under_body = std::make_shared<mtd::FakeRenderable>(50, 50, 100, 100);
+    auto const under_shadow = std::make_shared<mtd::FakeRenderable>(5, 5, 100, 100);
+    auto elements = scene_elements_from({under_shadow, under_body, top});
+
+    auto const& occlusions = filter_occlusions_from(elements, monitor_rect);
+
+    EXPECT_THAT(renderables_from(occlusions), ElementsAre(under_body));
+    EXPECT_THAT(renderables_from(elements), ElementsAre(under_shadow, top));
+}
+
+TEST_F(OcclusionFilterTest, translucent_window_opaque_region_occludes_nothing)
+{
+    struct TranslucentPartlyOpaqueRenderable : PartlyOpaqueRenderable
+    {
+        using PartlyOpaqueRenderable::PartlyOpaqueRenderable;
+
+        float alpha() const override
+        {
+            return 0.5f;
+        }
+    };
+
+    auto const top = std::make_shared<TranslucentPartlyOpaqueRenderable>(
+        Rectangle{{0, 0}, {200, 200}},
+        Rectangle{{0, 0}, {200, 200}});
+    auto const bottom = std::make_shared<mtd::FakeRenderable>(50, 50, 100, 100);
+    auto elements = scene_elements_from({bottom, top});
+
+    auto const& occlusions = filter_occlusions_from(elements, monitor_rect);
+
+    EXPECT_THAT(renderables_from(occlusions), IsEmpty());
+    EXPECT_THAT(renderables_from(elements), ElementsAre(bottom, top));
+}
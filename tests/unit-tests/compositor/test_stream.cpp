@@ -53,7 +53,7 @@ struct Stream : Test
 TEST_F(Stream, transitions_from_queuing_to_framedropping)
 {
     for(auto& buffer : buffers)
-        stream.submit_buffer(buffer);
+        stream.submit_buffer(buffer, {});
     stream.allow_framedropping(true);
 
     std::vector<std::shared_ptr<mg::Buffer>> cbuffers;
@@ -75,7 +75,7 @@ TEST_F(Stream, transitions_from_framedropping_to_queuing)
     stream.allow_framedropping(true);
 
     for(auto& buffer : buffers)
-        stream.submit_buffer(buffer);
+        stream.submit_buffer(buffer, {});
 
     // Only the last buffer should be owned by the stream...
     EXPECT_THAT(
@@ -84,7 +84,7 @@ TEST_F(Stream, transitions_from_framedropping_to_queuing)
 
     stream.allow_framedropping(false);
     for(auto& buffer : buffers)
-        stream.submit_buffer(buffer);
+        stream.submit_buffer(buffer, {});
 
     // All buffers should be now owned by the the stream
     EXPECT_THAT(
@@ -100,7 +100,7 @@ TEST_F(Stream, transitions_from_framedropping_to_queuing)
 TEST_F(Stream, indicates_buffers_ready_when_queueing)
 {
     for(auto& buffer : buffers)
-        stream.submit_buffer(buffer);
+        stream.submit_buffer(buffer, {});
 
     for(auto i = 0u; i < buffers.size(); i++)
     {
@@ -116,7 +116,7 @@ TEST_F(Stream, indicates_buffers_ready_when_dropping)
     stream.allow_framedropping(true);
 
     for(auto& buffer : buffers)
-        stream.submit_buffer(buffer);
+        stream.submit_buffer(buffer, {});
 
     EXPECT_THAT(stream.buffers_ready_for_compositor(this), Eq(1));
     stream.lock_compositor_buffer(this);
@@ -126,35 +126,35 @@ TEST_F(Stream, indicates_buffers_ready_when_dropping)
 TEST_F(Stream, tracks_has_buffer)
 {
     EXPECT_FALSE(stream.has_submitted_buffer());
-    stream.submit_buffer(buffers[0]);
+    stream.submit_buffer(buffers[0], {});
     EXPECT_TRUE(stream.has_submitted_buffer());
 }
 
 TEST_F(Stream, calls_frame_callback_after_scheduling_on_submissions)
 {
     int frame_count{0};
-    stream.set_frame_posted_callback([&frame_count](auto) { ++frame_count;});
-    stream.submit_buffer(buffers[0]);
-    stream.set_frame_posted_callback([](auto) {});
-    stream.submit_buffer(buffers[0]);
+    stream.set_frame_posted_callback([&frame_count](auto, auto) { ++frame_count;});
+    stream.submit_buffer(buffers[0], {});
+    stream.set_frame_posted_callback([](auto, auto) {});
+    stream.submit_buffer(buffers[0], {});
     EXPECT_THAT(frame_count, Eq(1));
 }
 
 TEST_F(Stream, frame_callback_is_called_without_scheduling_lock)
 {
     stream.set_frame_posted_callback(
-        [this](auto)
+        [this](auto, auto)
         {
             EXPECT_THAT(stream.buffers_ready_for_compositor(this), Eq(1));
             EXPECT_TRUE(stream.has_submitted_buffer());
         });
-    stream.submit_buffer(buffers[0]);
+    stream.submit_buffer(buffers[0], {});
 }
 
 TEST_F(Stream, flattens_queue_out_when_told_to_drop)
 {
     for(auto& buffer : buffers)
-        stream.submit_buffer(buffer);
+        stream.submit_buffer(buffer, {});
 
     EXPECT_THAT(stream.buffers_ready_for_compositor(this), Eq(1));
     stream.drop_old_buffers();
@@ -165,9 +165,9 @@ TEST_F(Stream, flattens_queue_out_when_told_to_drop)
 TEST_F(Stream, forces_a_new_buffer_when_told_to_drop_buffers)
 {
     int that{0};
-    stream.submit_buffer(buffers[0]);
-    stream.submit_buffer(buffers[1]);
-    stream.submit_buffer(buffers[2]);
+    stream.submit_buffer(buffers[0], {});
+    stream.submit_buffer(buffers[1], {});
+    stream.submit_buffer(buffers[2], {});
 
     auto a = stream.lock_compositor_buffer(this);
     stream.drop_old_buffers();
@@ -180,9 +180,9 @@ TEST_F(Stream, forces_a_new_buffer_when_told_to_drop_buffers)
 
 TEST_F(Stream, throws_on_nullptr_submissions)
 {
-    stream.set_frame_posted_callback([](auto) { FAIL() << "frame-posted should not be called on null buffer"; });
+    stream.set_frame_posted_callback([](auto, auto) { FAIL() << "frame-posted should not be called on null buffer"; });
     EXPECT_THROW({
-        stream.submit_buffer(nullptr);
+        stream.submit_buffer(nullptr, {});
     }, std::invalid_argument);
     EXPECT_FALSE(stream.has_submitted_buffer());
 }
@@ -194,7 +194,7 @@ TEST_F(Stream, reports_size)
     geom::Size new_size{333,139};
     auto new_size_buffer = std::make_shared<mtd::StubBuffer>(new_size);
     EXPECT_THAT(stream.stream_size(), Eq(initial_size));
-    stream.submit_buffer(new_size_buffer);
+    stream.submit_buffer(new_size_buffer, {});
     EXPECT_THAT(stream.stream_size(), Eq(new_size));
 }
 
@@ -206,9 +206,9 @@ TEST_F(Stream, reports_format)
 
 TEST_F(Stream, returns_buffers_to_client_when_told_to_bring_queue_up_to_date)
 {
-    stream.submit_buffer(buffers[0]);
-    stream.submit_buffer(buffers[1]);
-    stream.submit_buffer(buffers[2]);
+    stream.submit_buffer(buffers[0], {});
+    stream.submit_buffer(buffers[1], {});
+    stream.submit_buffer(buffers[2], {});
 
     // Buffers should be owned by the stream, and our test
     ASSERT_THAT(buffers[0].use_count(), Eq(2));
@@ -225,7 +225,7 @@ TEST_F(Stream, returns_buffers_to_client_when_told_to_bring_queue_up_to_date)
 
 TEST_F(Stream, stream_size_scaled)
 {
-    stream.submit_buffer(buffers[0]);
+    stream.submit_buffer(buffers[0], {});
     stream.set_scale(2.0f);
     ASSERT_THAT(stream.stream_size(), Eq(initial_size / 2));
 }
@@ -233,6 +233,64 @@ TEST_F(Stream, stream_size_scaled)
 TEST_F(Stream, stream_remembers_scale_when_buffer_added)
 {
     stream.set_scale(2.0f);
-    stream.submit_buffer(buffers[0]);
+    stream.submit_buffer(buffers[0], {});
     ASSERT_THAT(stream.stream_size(), Eq(initial_size / 2));
 }
+
+TEST_F(Stream, accumulates_damage_between_buffers)
+{
+    geom::Rectangle const first_damage{{1, 0}, {2, 1}};
+    geom::Rectangle const second_damage{{10, 1}, {3, 1}};
+
+    stream.submit_buffer(buffers[0], {});
+    stream.submit_buffer(buffers[1], {first_damage});
+    stream.submit_buffer(buffers[2], {second_damage});
+
+    EXPECT_THAT(stream.damage_between(buffers[1]->id(), buffers[2]->id()), Eq(geom::Rectangles{second_damage}));
+    EXPECT_THAT(
+        stream.damage_between(buffers[0]->id(), buffers[2]->id()),
+        Eq(geom::Rectangles{second_damage, first_damage}));
+    EXPECT_THAT(stream.damage_between(buffers[2]->id(), buffers[2]->id()), Eq(geom::Rectangles{}));
+}
+
+TEST_F(Stream, clips_damage_to_the_buffer)
+{
+    stream.submit_buffer(buffers[0], {});
+    stream.submit_buffer(buffers[1], {{{40, 0}, {100, 100}}});
+
+    EXPECT_THAT(
+        stream.damage_between(buffers[0]->id(), buffers[1]->id()),
+        Eq(geom::Rectangles{{{40, 0}, {4, 2}}}));
+}
+
+TEST_F(Stream, damages_the_whole_buffer_when_size_changes)
+{
+    auto const resized_buffer = std::make_shared<mtd::StubBuffer>(initial_size * 2);
+
+    stream.submit_buffer(buffers[0], {});
+    stream.submit_buffer(resized_buffer, {{{1, 1}, {1, 1}}});
+
+    EXPECT_THAT(
+        stream.damage_between(buffers[0]->id(), resized_buffer->id()),
+        Eq(geom::Rectangles{{{}, initial_size * 2}}));
+}
+
+TEST_F(Stream, damage_is_unknown_for_buffers_it_has_not_seen)
+{
+    stream.submit_buffer(buffers[1], {});
+
+    EXPECT_THAT(stream.damage_between(buffers[0]->id(), buffers[1]->id()), Eq(std::nullopt));
+}
+
+TEST_F(Stream, frame_posted_callback_receives_damage)
+{
+    geom::Rectangle const damage{{1, 1}, {2, 1}};
+    geom::Rectangles posted_damage;
+    stream.set_frame_posted_callback([&](auto, auto const& damage) { posted_damage = damage; });
+
+    stream.submit_buffer(buffers[0], {});
+    EXPECT_THAT(posted_damage, Eq(geom::Rectangles{{{}, initial_size}}));
+
+    stream.submit_buffer(buffers[1], {damage});
+    EXPECT_THAT(posted_damage, Eq(geom::Rectangles{damage}));
+}
@@ -0,0 +1,243 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/server/frontend_wayland/frame_executor.h"
+#include "mir/time/alarm_factory.h"
+
+#include "mir/test/doubles/advanceable_clock.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace mf = mir::frontend;
+namespace mt = mir::time;
+namespace mtd = mir::test::doubles;
+
+using namespace testing;
+using namespace std::chrono_literals;
+
+namespace
+{
+/// What the executor has asked of its alarm, kept apart from the alarm so it can be checked after it's destroyed
+struct AlarmRecord
+{
+    std::function<void()> callback;
+    std::optional<mt::Timestamp> scheduled_for;
+    int reschedules{0};
+    bool destroyed{false};
+};
+
+class StubAlarm : public mt::Alarm
+{
+public:
+    explicit StubAlarm(AlarmRecord& record)
+        : record{record}
+    {
+    }
+
+    ~StubAlarm() override
+    {
+        record.destroyed = true;
+        record.scheduled_for = std::nullopt;
+    }
+
+    bool cancel() override
+    {
+        record.scheduled_for = std::nullopt;
+        return true;
+    }
+
+    State state() const override
+    {
+        return record.scheduled_for ? State::pending : State::triggered;
+    }
+
+    bool reschedule_in(std::chrono::milliseconds) override
+    {
+        ADD_FAILURE() << "FrameExecutor should schedule for a time point";
+        return false;
+    }
+
+    bool reschedule_for(mt::Timestamp timeout) override
+    {
+        bool const was_pending = record.scheduled_for.has_value();
+        record.scheduled_for = timeout;
+        ++record.reschedules;
+        return was_pending;
+    }
+
+private:
+    AlarmRecord& record;
+};
+
+/// Lets the test run the alarm's callback itself, as the main loop would when it fires
+class StubAlarmFactory : public mt::AlarmFactory
+{
+public:
+    explicit StubAlarmFactory(AlarmRecord& record)
+        : record{record}
+    {
+    }
+
+    auto create_alarm(std::function<void()> const& callback) -> std::unique_ptr<mt::Alarm> override
+    {
+        record.callback = callback;
+        return std::make_unique<StubAlarm>(record);
+    }
+
+    auto create_alarm(std::unique_ptr<mir::LockableCallback>) -> std::unique_ptr<mt::Alarm> override
+    {
+        ADD_FAILURE() << "FrameExecutor should not need a LockableCallback";
+        return nullptr;
+    }
+
+private:
+    AlarmRecord& record;
+};
+
+struct FrameExecutor : Test
+{
+    /// Advance to when the alarm is set for, and fire it
+    void fire_alarm()
+    {
+        ASSERT_THAT(alarm.scheduled_for, Ne(std::nullopt));
+        if (auto const now = clock->now(); *alarm.scheduled_for > now)
+        {
+            clock->advance_by(*alarm.scheduled_for - now);
+        }
+        alarm.scheduled_for = std::nullopt;
+        alarm.callback();
+    }
+
+    std::shared_ptr<mtd::AdvanceableClock> const clock{std::make_shared<mtd::AdvanceableClock>()};
+    mt::Timestamp const start{clock->now()};
+    AlarmRecord alarm;
+    StubAlarmFactory alarm_factory{alarm};
+    std::unique_ptr<mf::FrameExecutor> executor{std::make_unique<mf::FrameExecutor>(alarm_factory, clock)};
+    std::vector<std::string> ran;
+};
+}
+
+TEST_F(FrameExecutor, runs_a_callback_when_it_is_due)
+{
+    executor->spawn_at(start + 10ms, [this] { ran.push_back("a"); });
+
+    EXPECT_THAT(alarm.scheduled_for, Optional(start + 10ms));
+    fire_alarm();
+    EXPECT_THAT(ran, ElementsAre("a"));
+}
+
+TEST_F(FrameExecutor, callback_spawned_for_earlier_while_the_alarm_is_pending_brings_it_forward)
+{
+    executor->spawn_at(start + 20ms, [this] { ran.push_back("later"); });
+    executor->spawn_at(start + 10ms, [this] { ran.push_back("earlier"); });
+
+    EXPECT_THAT(alarm.scheduled_for, Optional(start + 10ms));
+    fire_alarm();
+    EXPECT_THAT(ran, ElementsAre("earlier"));
+
+    EXPECT_THAT(alarm.scheduled_for, Optional(start + 20ms));
+    fire_alarm();
+    EXPECT_THAT(ran, ElementsAre("earlier", "later"));
+}
+
+TEST_F(FrameExecutor, callback_spawned_for_later_while_the_alarm_is_pending_leaves_it_alone)
+{
+    executor->spawn_at(start + 10ms, [this] { ran.push_back("earlier"); });
+    executor->spawn_at(start + 20ms, [this] { ran.push_back("later"); });
+
+    EXPECT_THAT(alarm.reschedules, Eq(1));
+    EXPECT_THAT(alarm.scheduled_for, Optional(start + 10ms));
+    fire_alarm();
+    EXPECT_THAT(ran, ElementsAre("earlier"));
+
+    EXPECT_THAT(alarm.scheduled_for, Optional(start + 20ms));
+    fire_alarm();
+    EXPECT_THAT(ran, ElementsAre("earlier", "later"));
+}
+
+TEST_F(FrameExecutor, callbacks_due_together_run_on_one_alarm)
+{
+    executor->spawn_at(start + 10ms, [this] { ran.push_back("a"); });
+    executor->spawn_at(start + 10ms + 500us, [this] { ran.push_back("b"); });
+
+    fire_alarm();
+
+    EXPECT_THAT(ran, ElementsAre("a", "b"));
+    EXPECT_THAT(alarm.scheduled_for, Eq(std::nullopt));
+}
+
+TEST_F(FrameExecutor, callback_spawned_by_a_running_callback_gets_the_alarm)
+{
+    executor->spawn_at(
+        start + 10ms,
+        [this]
+        {
+            ran.push_back("first");
+            executor->spawn_at(start + 30ms, [this] { ran.push_back("second"); });
+        });
+    executor->spawn_at(start + 40ms, [this] { ran.push_back("third"); });
+
+    fire_alarm();
+    EXPECT_THAT(alarm.scheduled_for, Optional(start + 30ms));
+
+    fire_alarm();
+    EXPECT_THAT(alarm.scheduled_for, Optional(start + 40ms));
+
+    fire_alarm();
+    EXPECT_THAT(ran, ElementsAre("first", "second", "third"));
+}
+
+TEST_F(FrameExecutor, destroying_the_executor_with_an_alarm_outstanding_drops_its_callbacks)
+{
+    executor->spawn_at(start + 10ms, [this] { ran.push_back("a"); });
+
+    executor.reset();
+    EXPECT_TRUE(alarm.destroyed);
+
+    // A main loop already dispatching the alarm may still call it
+    clock->advance_by(20ms);
+    alarm.callback();
+
+    EXPECT_THAT(ran, IsEmpty());
+}
+
+TEST_F(FrameExecutor, callback_may_destroy_the_executor_running_it)
+{
+    executor->spawn_at(
+        start + 10ms,
+        [this]
+        {
+            ran.push_back("destroyer");
+            executor.reset();
+        });
+    executor->spawn_at(start + 20ms, [this] { ran.push_back("dropped"); });
+    auto const reschedules = alarm.reschedules;
+
+    fire_alarm();
+
+    EXPECT_TRUE(alarm.destroyed);
+    EXPECT_THAT(alarm.reschedules, Eq(reschedules));
+
+    clock->advance_by(20ms);
+    alarm.callback();
+
+    EXPECT_THAT(ran, ElementsAre("destroyer"));
+}
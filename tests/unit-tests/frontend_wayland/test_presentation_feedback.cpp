@@ -0,0 +1,150 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/server/frontend_wayland/presentation_time.h"
+#include "mir/wayland/lifetime_tracker.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+namespace mf = mir::frontend;
+namespace mg = mir::graphics;
+namespace mw = mir::wayland;
+
+using namespace testing;
+using namespace std::chrono_literals;
+
+namespace
+{
+struct MockFeedback : mf::PendingPresentationFeedback::Feedback, mw::LifetimeTracker
+{
+    auto destroyed_flag() const -> std::shared_ptr<bool const> override
+    {
+        return LifetimeTracker::destroyed_flag();
+    }
+
+    MOCK_METHOD(void, presented,
+        (mg::FramePresentation const& presentation, std::optional<std::chrono::nanoseconds> refresh), (override));
+    MOCK_METHOD(void, discarded, (), (override));
+};
+
+auto weak(MockFeedback& feedback) -> mw::Weak<mf::PendingPresentationFeedback::Feedback>
+{
+    return mw::make_weak<mf::PendingPresentationFeedback::Feedback>(&feedback);
+}
+
+struct PresentationFeedback : Test
+{
+    NiceMock<MockFeedback> feedback;
+    NiceMock<MockFeedback> next_feedback;
+    mf::SurfacePresentationFeedback surface;
+};
+}
+
+TEST_F(PresentationFeedback, new_content_waits_for_a_compositor)
+{
+    auto const pending = surface.commit(true, true, {weak(feedback)});
+
+    ASSERT_THAT(pending, NotNull());
+    EXPECT_TRUE(pending->claim());
+}
+
+TEST_F(PresentationFeedback, only_one_consumer_can_claim_the_feedback)
+{
+    auto const pending = surface.commit(true, true, {weak(feedback)});
+
+    EXPECT_TRUE(pending->claim());
+    EXPECT_FALSE(pending->claim());
+}
+
+TEST_F(PresentationFeedback, presented_feedback_reports_the_frame_and_refresh)
+{
+    mg::FramePresentation presentation;
+    presentation.frame.msc = 42;
+    presentation.vsync = true;
+    auto const pending = surface.commit(true, true, {weak(feedback)});
+
+    EXPECT_CALL(feedback, presented(
+        AllOf(Field(&mg::FramePresentation::frame, Field(&mg::Frame::msc, Eq(42))),
+              Field(&mg::FramePresentation::vsync, IsTrue())),
+        Eq(16ms)));
+    pending->claim();
+    pending->send(presentation, 16ms);
+}
+
+TEST_F(PresentationFeedback, feedback_is_discarded_when_the_presentation_is_unknown)
+{
+    auto const pending = surface.commit(true, true, {weak(feedback)});
+
+    EXPECT_CALL(feedback, discarded());
+    pending->claim();
+    pending->send(std::nullopt, std::nullopt);
+}
+
+TEST_F(PresentationFeedback, unclaimed_feedback_is_discarded_when_a_new_buffer_supersedes_it)
+{
+    surface.commit(true, true, {weak(feedback)});
+
+    EXPECT_CALL(feedback, discarded());
+    surface.commit(true, true, {weak(next_feedback)});
+}
+
+TEST_F(PresentationFeedback, claimed_feedback_is_left_to_the_compositor_when_a_new_buffer_arrives)
+{
+    auto const pending = surface.commit(true, true, {weak(feedback)});
+    pending->claim();
+
+    EXPECT_CALL(feedback, discarded()).Times(0);
+    surface.commit(true, true, {weak(next_feedback)});
+}
+
+TEST_F(PresentationFeedback, feedback_is_discarded_when_the_buffer_is_removed)
+{
+    surface.commit(true, true, {weak(feedback)});
+
+    EXPECT_CALL(feedback, discarded());
+    EXPECT_CALL(next_feedback, discarded());
+    EXPECT_THAT(surface.commit(true, false, {weak(next_feedback)}), IsNull());
+}
+
+TEST_F(PresentationFeedback, commit_without_a_buffer_discards_its_own_feedback_but_not_the_last_buffers)
+{
+    surface.commit(true, true, {weak(feedback)});
+
+    EXPECT_CALL(feedback, discarded()).Times(0);
+    EXPECT_CALL(next_feedback, discarded());
+    EXPECT_THAT(surface.commit(false, false, {weak(next_feedback)}), IsNull());
+}
+
+TEST_F(PresentationFeedback, unclaimed_feedback_is_discarded_with_the_surface)
+{
+    auto destroyed_surface = std::make_unique<mf::SurfacePresentationFeedback>();
+    destroyed_surface->commit(true, true, {weak(feedback)});
+
+    EXPECT_CALL(feedback, discarded());
+    destroyed_surface.reset();
+}
+
+TEST_F(PresentationFeedback, destroyed_feedback_is_not_sent)
+{
+    auto destroyed_feedback = std::make_unique<NiceMock<MockFeedback>>();
+    auto const pending = surface.commit(true, true, {weak(*destroyed_feedback), weak(feedback)});
+    destroyed_feedback.reset();
+
+    EXPECT_CALL(feedback, discarded());
+    pending->claim();
+    pending->send(std::nullopt, std::nullopt);
+}
@@ -231,3 +231,22 @@ TEST(geometry, rectangle_intersection)
             << "test_case.rect = " << test_case.rect;
     }
 }
+
+TEST(geometry, rectangle_difference)
+{
+    using namespace testing;
+    using namespace geom;
+
+    Rectangle const rect{{0,0}, {10,10}};
+
+    EXPECT_THAT(difference_of(rect, Rectangle{{20,20}, {5,5}}), ElementsAre(rect));
+    EXPECT_THAT(difference_of(rect, Rectangle{{-5,-5}, {20,20}}), IsEmpty());
+    EXPECT_THAT(difference_of(rect, Rectangle{{0,5}, {10,10}}), ElementsAre(Rectangle{{0,0}, {10,5}}));
+    EXPECT_THAT(
+        difference_of(rect, Rectangle{{3,4}, {2,2}}),
+        ElementsAre(
+            Rectangle{{0,0}, {10,4}},   // Above the hole
+            Rectangle{{0,6}, {10,4}},   // Below it
+            Rectangle{{0,4}, {3,2}},    // Left of it
+            Rectangle{{5,4}, {5,2}}));  // Right of it
+}
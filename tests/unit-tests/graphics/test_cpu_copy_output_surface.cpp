@@ -0,0 +1,221 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/platforms/common/server/cpu_copy_output_surface.h"
+#include "mir/graphics/buffer_properties.h"
+
+#include "mir/test/doubles/mock_gl.h"
+#include "mir/test/doubles/mock_egl.h"
+#include "mir/test/doubles/stub_buffer.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include <GLES2/gl2ext.h>
+#include <drm_fourcc.h>
+
+namespace mg = mir::graphics;
+namespace mgc = mir::graphics::common;
+namespace mtd = mir::test::doubles;
+namespace geom = mir::geometry;
+using namespace testing;
+
+namespace
+{
+class StubMappableFB : public mg::CPUAddressableDisplayAllocator::MappableFB
+{
+public:
+    StubMappableFB(std::shared_ptr<mtd::StubBuffer> const& buffer, int age)
+        : buffer{buffer},
+          age{age}
+    {
+    }
+
+    auto size() const -> geom::Size override { return buffer->size(); }
+    auto format() const -> MirPixelFormat override { return buffer->format(); }
+    auto stride() const -> geom::Stride override { return buffer->stride(); }
+    auto map_writeable() -> std::unique_ptr<mir::renderer::software::Mapping<unsigned char>> override
+    {
+        return buffer->map_writeable();
+    }
+    auto buffer_age() const -> int override { return age; }
+
+private:
+    std::shared_ptr<mtd::StubBuffer> const buffer;
+    int const age;
+};
+
+/// Hands out the same framebuffer every time, claiming whatever age the test asks for
+class StubAllocator : public mg::CPUAddressableDisplayAllocator
+{
+public:
+    StubAllocator(geom::Size size, geom::Stride stride)
+        : framebuffer{std::make_shared<mtd::StubBuffer>(
+              mg::BufferProperties{size, mir_pixel_format_xrgb_8888, mg::BufferUsage::software}, stride)}
+    {
+    }
+
+    auto supported_formats() const -> std::vector<mg::DRMFormat> override
+    {
+        return {mg::DRMFormat{DRM_FORMAT_XRGB8888}};
+    }
+
+    auto alloc_fb(mg::DRMFormat) -> std::unique_ptr<MappableFB> override
+    {
+        return std::make_unique<StubMappableFB>(framebuffer, next_age);
+    }
+
+    auto output_size() const -> geom::Size override
+    {
+        return framebuffer->size();
+    }
+
+    /// Where the pixel at (x, y) of the framebuffer is
+    auto pixel_at(int x, int y) -> unsigned char*
+    {
+        return framebuffer->map_writeable()->data() + y * framebuffer->stride().as_int() + x * 4;
+    }
+
+    int next_age{0};
+
+private:
+    std::shared_ptr<mtd::StubBuffer> const framebuffer;
+};
+
+struct CPUCopyOutputSurface : Test
+{
+    CPUCopyOutputSurface()
+    {
+        ON_CALL(mock_egl, eglQueryString(_, EGL_EXTENSIONS))
+            .WillByDefault(Return("EGL_KHR_no_config_context"));
+        ON_CALL(mock_gl, glGetString(GL_VERSION))
+            .WillByDefault(Return(reinterpret_cast<GLubyte const*>("OpenGL ES 2.0")));
+    }
+
+    /// Commit a frame drawn with \a damage into a framebuffer of age \a age
+    void commit_frame(mgc::CPUCopyOutputSurface& surface, int age, std::optional<geom::Rectangle> const& damage)
+    {
+        allocator.next_age = age;
+        surface.set_damage(damage);
+        surface.commit();
+    }
+
+    NiceMock<mtd::MockEGL> mock_egl;
+    NiceMock<mtd::MockGL> mock_gl;
+
+    geom::Size const size{100, 80};
+    int const width{size.width.as_int()};
+    StubAllocator allocator{size, geom::Stride{width * 4}};
+    EGLDisplay const dpy{reinterpret_cast<EGLDisplay>(0xd1)};
+    EGLContext const share_ctx{reinterpret_cast<EGLContext>(0xc7)};
+    geom::Rectangle const damage{{10, 20}, {30, 40}};
+};
+}
+
+TEST_F(CPUCopyOutputSurface, reads_back_the_whole_frame_into_a_new_framebuffer)
+{
+    mgc::CPUCopyOutputSurface surface{dpy, share_ctx, allocator};
+
+    EXPECT_CALL(mock_gl, glReadPixels(0, 0, width, 80, GL_BGRA_EXT, GL_UNSIGNED_BYTE, allocator.pixel_at(0, 0)));
+
+    commit_frame(surface, 0, damage);
+}
+
+TEST_F(CPUCopyOutputSurface, reads_back_only_the_damaged_rows_into_the_previous_framebuffer)
+{
+    mgc::CPUCopyOutputSurface surface{dpy, share_ctx, allocator};
+    commit_frame(surface, 0, damage);
+
+    EXPECT_CALL(mock_gl, glReadPixels(0, 20, width, 40, GL_BGRA_EXT, GL_UNSIGNED_BYTE, allocator.pixel_at(0, 20)));
+
+    commit_frame(surface, 1, damage);
+}
+
+TEST_F(CPUCopyOutputSurface, reads_back_only_the_damaged_rectangle_where_gl_can_pack_a_subimage)
+{
+    ON_CALL(mock_gl, glGetString(GL_VERSION))
+        .WillByDefault(Return(reinterpret_cast<GLubyte const*>("OpenGL ES 3.2 Mesa")));
+    mgc::CPUCopyOutputSurface surface{dpy, share_ctx, allocator};
+    commit_frame(surface, 0, damage);
+
+    InSequence seq;
+    EXPECT_CALL(mock_gl, glPixelStorei(GL_PACK_ROW_LENGTH_NV, width));
+    EXPECT_CALL(mock_gl, glReadPixels(10, 20, 30, 40, GL_BGRA_EXT, GL_UNSIGNED_BYTE, allocator.pixel_at(10, 20)));
+    EXPECT_CALL(mock_gl, glPixelStorei(GL_PACK_ROW_LENGTH_NV, 0));
+
+    commit_frame(surface, 1, damage);
+}
+
+TEST_F(CPUCopyOutputSurface, reads_back_the_damage_of_every_frame_the_framebuffer_lacks)
+{
+    mgc::CPUCopyOutputSurface surface{dpy, share_ctx, allocator};
+    commit_frame(surface, 0, geom::Rectangle{{0, 0}, {5, 5}});
+    commit_frame(surface, 0, geom::Rectangle{{50, 60}, {10, 10}});
+
+    // The framebuffer holds the first frame, so lacks the second's damage as well as this one's
+    EXPECT_CALL(mock_gl, glReadPixels(0, 20, width, 50, GL_BGRA_EXT, GL_UNSIGNED_BYTE, allocator.pixel_at(0, 20)));
+
+    commit_frame(surface, 2, damage);
+}
+
+TEST_F(CPUCopyOutputSurface, reads_back_the_whole_frame_if_a_frame_the_framebuffer_lacks_has_unknown_damage)
+{
+    mgc::CPUCopyOutputSurface surface{dpy, share_ctx, allocator};
+    commit_frame(surface, 0, damage);
+    commit_frame(surface, 0, std::nullopt);
+
+    EXPECT_CALL(mock_gl, glReadPixels(0, 0, width, 80, _, _, allocator.pixel_at(0, 0)));
+
+    commit_frame(surface, 2, damage);
+}
+
+TEST_F(CPUCopyOutputSurface, reads_back_the_whole_frame_if_its_damage_is_unknown)
+{
+    mgc::CPUCopyOutputSurface surface{dpy, share_ctx, allocator};
+    commit_frame(surface, 0, damage);
+
+    EXPECT_CALL(mock_gl, glReadPixels(0, 0, width, 80, _, _, allocator.pixel_at(0, 0)));
+
+    commit_frame(surface, 1, std::nullopt);
+}
+
+TEST_F(CPUCopyOutputSurface, reads_back_the_whole_frame_into_a_framebuffer_older_than_it_tracks)
+{
+    mgc::CPUCopyOutputSurface surface{dpy, share_ctx, allocator};
+    for (auto i = 0; i != 8; ++i)
+    {
+        commit_frame(surface, 0, damage);
+    }
+
+    EXPECT_CALL(mock_gl, glReadPixels(0, 0, width, 80, _, _, allocator.pixel_at(0, 0)));
+
+    commit_frame(surface, 8, damage);
+}
+
+TEST_F(CPUCopyOutputSurface, reads_back_row_by_row_into_a_padded_framebuffer)
+{
+    StubAllocator padded_allocator{size, geom::Stride{width * 4 + 64}};
+    mgc::CPUCopyOutputSurface surface{dpy, share_ctx, padded_allocator};
+    padded_allocator.next_age = 0;
+    surface.commit();
+
+    InSequence seq;
+    EXPECT_CALL(mock_gl, glReadPixels(0, 20, width, 1, _, _, padded_allocator.pixel_at(0, 20)));
+    EXPECT_CALL(mock_gl, glReadPixels(0, 21, width, 1, _, _, padded_allocator.pixel_at(0, 21)));
+
+    padded_allocator.next_age = 1;
+    surface.set_damage(geom::Rectangle{{10, 20}, {30, 2}});
+    surface.commit();
+}
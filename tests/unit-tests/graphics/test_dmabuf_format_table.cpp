@@ -0,0 +1,190 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/platform/graphics/dmabuf_format_table.h"
+#include "mir/graphics/platform.h"
+
+#include <drm_fourcc.h>
+#include <sys/mman.h>
+#include <sys/sysmacros.h>
+
+#include <map>
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+namespace mg = mir::graphics;
+using namespace testing;
+
+namespace
+{
+class StubScanoutDisplay : public mg::GBMDisplayProvider
+{
+public:
+    StubScanoutDisplay(dev_t device, std::map<uint32_t, std::vector<uint64_t>> formats)
+        : device{device},
+          formats{std::move(formats)}
+    {
+    }
+
+    auto is_same_device(mir::udev::Device const&) const -> bool override { return false; }
+    auto on_this_sink(mg::DisplaySink&) const -> bool override { return false; }
+    auto gbm_device() const -> std::shared_ptr<struct gbm_device> override { return nullptr; }
+
+    auto scanout_formats() const -> std::vector<mg::DRMFormat> override
+    {
+        std::vector<mg::DRMFormat> result;
+        for (auto const& [format, _] : formats)
+        {
+            result.emplace_back(format);
+        }
+        return result;
+    }
+
+    auto scanout_modifiers_for_format(mg::DRMFormat format) const -> std::vector<uint64_t> override
+    {
+        if (auto const modifiers = formats.find(format); modifiers != formats.end())
+        {
+            return modifiers->second;
+        }
+        return {};
+    }
+
+    auto scanout_device() const -> dev_t override { return device; }
+
+private:
+    dev_t const device;
+    std::map<uint32_t, std::vector<uint64_t>> const formats;
+};
+
+struct Entry
+{
+    uint32_t format;
+    uint32_t padding;
+    uint64_t modifier;
+};
+
+auto entries_of(mg::DmaBufFormatTable const& table) -> std::vector<Entry>
+{
+    auto const file = table.file();
+    auto const mapping = mmap(nullptr, table.size(), PROT_READ, MAP_PRIVATE, file, 0);
+    if (mapping == MAP_FAILED)
+    {
+        ADD_FAILURE() << "Failed to map the format table";
+        return {};
+    }
+    auto const begin = static_cast<Entry const*>(mapping);
+    std::vector<Entry> entries{begin, begin + table.size() / sizeof(Entry)};
+    munmap(mapping, table.size());
+    return entries;
+}
+
+struct DmaBufFormatTable : Test
+{
+    dev_t const render_device{makedev(226, 128)};
+    dev_t const display_device{makedev(226, 1)};
+
+    std::vector<std::pair<mg::DRMFormat, std::vector<uint64_t>>> const importable{
+        {mg::DRMFormat{DRM_FORMAT_XRGB8888}, {DRM_FORMAT_MOD_LINEAR, I915_FORMAT_MOD_X_TILED, I915_FORMAT_MOD_Y_TILED}},
+        {mg::DRMFormat{DRM_FORMAT_ARGB8888}, {DRM_FORMAT_MOD_LINEAR}},
+        {mg::DRMFormat{DRM_FORMAT_NV12}, {DRM_FORMAT_MOD_LINEAR}}};
+
+    // Scans out a subset of what can be imported, and something that can't be
+    StubScanoutDisplay const display{
+        display_device,
+        {{DRM_FORMAT_XRGB8888, {DRM_FORMAT_MOD_LINEAR, I915_FORMAT_MOD_X_TILED}},
+         {DRM_FORMAT_XBGR8888, {DRM_FORMAT_MOD_LINEAR}}}};
+};
+}
+
+TEST_F(DmaBufFormatTable, file_holds_every_importable_format_and_modifier)
+{
+    mg::DmaBufFormatTable const table{render_device, importable, &display};
+
+    auto const entries = entries_of(table);
+
+    ASSERT_THAT(entries.size(), Eq(5u));
+    EXPECT_THAT(entries[0].format, Eq(DRM_FORMAT_XRGB8888));
+    EXPECT_THAT(entries[0].modifier, Eq(DRM_FORMAT_MOD_LINEAR));
+    EXPECT_THAT(entries[2].modifier, Eq(I915_FORMAT_MOD_Y_TILED));
+    EXPECT_THAT(entries[3].format, Eq(DRM_FORMAT_ARGB8888));
+    EXPECT_THAT(entries[4].format, Eq(DRM_FORMAT_NV12));
+}
+
+TEST_F(DmaBufFormatTable, clients_cannot_write_to_the_shared_file)
+{
+    mg::DmaBufFormatTable const table{render_device, importable, &display};
+
+    auto const mapping = mmap(nullptr, table.size(), PROT_READ | PROT_WRITE, MAP_SHARED, table.file(), 0);
+
+    EXPECT_THAT(mapping, Eq(MAP_FAILED));
+    if (mapping != MAP_FAILED)
+    {
+        munmap(mapping, table.size());
+    }
+}
+
+TEST_F(DmaBufFormatTable, main_device_is_the_importing_device)
+{
+    mg::DmaBufFormatTable const table{render_device, importable, &display};
+
+    EXPECT_THAT(table.main_device(), Eq(render_device));
+}
+
+TEST_F(DmaBufFormatTable, feedback_for_other_surfaces_has_only_the_render_tranche)
+{
+    mg::DmaBufFormatTable const table{render_device, importable, &display};
+
+    auto const tranches = table.tranches(false);
+
+    ASSERT_THAT(tranches.size(), Eq(1u));
+    EXPECT_THAT(tranches[0].target_device, Eq(render_device));
+    EXPECT_FALSE(tranches[0].scanout);
+    EXPECT_THAT(tranches[0].indices, ElementsAre(0, 1, 2, 3, 4));
+}
+
+TEST_F(DmaBufFormatTable, feedback_for_scanout_candidates_prefers_what_the_display_device_can_scan_out)
+{
+    mg::DmaBufFormatTable const table{render_device, importable, &display};
+
+    auto const tranches = table.tranches(true);
+
+    ASSERT_THAT(tranches.size(), Eq(2u));
+    EXPECT_THAT(tranches[0].target_device, Eq(display_device));
+    EXPECT_TRUE(tranches[0].scanout);
+    EXPECT_THAT(tranches[0].indices, ElementsAre(0, 1));
+    EXPECT_THAT(tranches[1].target_device, Eq(render_device));
+    EXPECT_FALSE(tranches[1].scanout);
+}
+
+TEST_F(DmaBufFormatTable, without_a_scanout_display_scanout_candidates_get_only_the_render_tranche)
+{
+    mg::DmaBufFormatTable const table{render_device, importable, nullptr};
+
+    auto const tranches = table.tranches(true);
+
+    ASSERT_THAT(tranches.size(), Eq(1u));
+    EXPECT_THAT(tranches[0].target_device, Eq(render_device));
+    EXPECT_FALSE(tranches[0].scanout);
+}
+
+TEST_F(DmaBufFormatTable, a_display_that_can_scan_out_nothing_importable_adds_no_tranche)
+{
+    StubScanoutDisplay const mismatched_display{display_device, {{DRM_FORMAT_XBGR8888, {DRM_FORMAT_MOD_LINEAR}}}};
+    mg::DmaBufFormatTable const table{render_device, importable, &mismatched_display};
+
+    EXPECT_THAT(table.tranches(true).size(), Eq(1u));
+}
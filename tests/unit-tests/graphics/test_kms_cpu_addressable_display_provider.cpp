@@ -0,0 +1,164 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/platforms/common/server/kms_cpu_addressable_display_provider.h"
+#include "src/platforms/common/server/kms_framebuffer.h"
+
+#include "mir/test/doubles/mock_drm.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include <drm_fourcc.h>
+
+#include <utility>
+
+#include <fcntl.h>
+
+namespace mg = mir::graphics;
+namespace mtd = mir::test::doubles;
+namespace geom = mir::geometry;
+using namespace testing;
+
+namespace
+{
+auto fb_id_of(mg::Framebuffer const& fb) -> uint32_t
+{
+    return dynamic_cast<mg::FBHandle const&>(fb);
+}
+
+struct KMSCPUAddressableDisplayAllocator : Test
+{
+    KMSCPUAddressableDisplayAllocator()
+    {
+        ON_CALL(mock_drm, drmGetCap(_, DRM_CAP_ADDFB2_MODIFIERS, _))
+            .WillByDefault(DoAll(SetArgPointee<2>(0), Return(0)));
+        // Give each framebuffer its own ID, so we can tell them apart
+        ON_CALL(mock_drm, drmModeAddFB2(_, _, _, _, _, _, _, _, _))
+            .WillByDefault(Invoke(
+                [this](auto, auto, auto, auto, auto, auto, auto, uint32_t* buf_id, auto)
+                {
+                    *buf_id = ++last_fb_id;
+                    return 0;
+                }));
+    }
+
+    NiceMock<mtd::MockDRM> mock_drm;
+    uint32_t last_fb_id{0};
+    mir::Fd const drm_fd{::open("/dev/null", O_RDWR | O_CLOEXEC)};
+    mg::DRMFormat const xrgb8888{DRM_FORMAT_XRGB8888};
+    std::shared_ptr<mg::kms::CPUAddressableDisplayAllocator> allocator{
+        mg::kms::CPUAddressableDisplayAllocator::create_if_supported(drm_fd, geom::Size{64, 48})};
+};
+}
+
+TEST_F(KMSCPUAddressableDisplayAllocator, new_framebuffer_has_undefined_contents)
+{
+    auto const fb = allocator->alloc_fb(xrgb8888);
+
+    EXPECT_THAT(fb->buffer_age(), Eq(0));
+}
+
+TEST_F(KMSCPUAddressableDisplayAllocator, framebuffer_released_before_the_next_allocation_is_reused_with_age_1)
+{
+    auto first = allocator->alloc_fb(xrgb8888);
+    auto const first_id = fb_id_of(*first);
+    first.reset();
+
+    auto const second = allocator->alloc_fb(xrgb8888);
+
+    EXPECT_THAT(fb_id_of(*second), Eq(first_id));
+    EXPECT_THAT(second->buffer_age(), Eq(1));
+}
+
+TEST_F(KMSCPUAddressableDisplayAllocator, double_buffered_framebuffers_have_age_2)
+{
+    auto front = allocator->alloc_fb(xrgb8888);
+    auto back = allocator->alloc_fb(xrgb8888);
+
+    for (auto i = 0; i != 4; ++i)
+    {
+        // The display has flipped to back, so releases front
+        auto const front_id = fb_id_of(*front);
+        front = std::exchange(back, nullptr);
+        back = allocator->alloc_fb(xrgb8888);
+
+        EXPECT_THAT(fb_id_of(*back), Eq(front_id));
+        EXPECT_THAT(back->buffer_age(), Eq(2));
+    }
+}
+
+TEST_F(KMSCPUAddressableDisplayAllocator, reuses_the_most_recently_used_spare_framebuffer)
+{
+    auto older = allocator->alloc_fb(xrgb8888);
+    auto newer = allocator->alloc_fb(xrgb8888);
+    auto const newer_id = fb_id_of(*newer);
+    newer.reset();
+    older.reset();
+
+    auto const reused = allocator->alloc_fb(xrgb8888);
+
+    EXPECT_THAT(fb_id_of(*reused), Eq(newer_id));
+    EXPECT_THAT(reused->buffer_age(), Eq(1));
+}
+
+TEST_F(KMSCPUAddressableDisplayAllocator, does_not_reuse_a_framebuffer_of_another_format)
+{
+    auto xrgb = allocator->alloc_fb(xrgb8888);
+    auto const xrgb_id = fb_id_of(*xrgb);
+    xrgb.reset();
+
+    auto const argb = allocator->alloc_fb(mg::DRMFormat{DRM_FORMAT_ARGB8888});
+
+    EXPECT_THAT(fb_id_of(*argb), Ne(xrgb_id));
+    EXPECT_THAT(argb->buffer_age(), Eq(0));
+}
+
+TEST_F(KMSCPUAddressableDisplayAllocator, drops_the_stalest_framebuffer_beyond_two_spares)
+{
+    auto stalest = allocator->alloc_fb(xrgb8888);
+    auto middle = allocator->alloc_fb(xrgb8888);
+    auto newest = allocator->alloc_fb(xrgb8888);
+    auto const stalest_id = fb_id_of(*stalest);
+    auto const middle_id = fb_id_of(*middle);
+    auto const newest_id = fb_id_of(*newest);
+
+    EXPECT_CALL(mock_drm, drmModeRmFB(_, stalest_id));
+    stalest.reset();
+    middle.reset();
+    newest.reset();
+    Mock::VerifyAndClearExpectations(&mock_drm);
+
+    auto const first = allocator->alloc_fb(xrgb8888);
+    auto const second = allocator->alloc_fb(xrgb8888);
+    auto const third = allocator->alloc_fb(xrgb8888);
+
+    EXPECT_THAT(fb_id_of(*first), Eq(newest_id));
+    EXPECT_THAT(first->buffer_age(), Eq(1));
+    EXPECT_THAT(fb_id_of(*second), Eq(middle_id));
+    EXPECT_THAT(second->buffer_age(), Eq(3));
+    EXPECT_THAT(third->buffer_age(), Eq(0));
+}
+
+TEST_F(KMSCPUAddressableDisplayAllocator, framebuffer_may_outlive_the_allocator)
+{
+    auto fb = allocator->alloc_fb(xrgb8888);
+    auto const fb_id = fb_id_of(*fb);
+    allocator.reset();
+
+    EXPECT_CALL(mock_drm, drmModeRmFB(_, fb_id));
+
+    fb.reset();
+}
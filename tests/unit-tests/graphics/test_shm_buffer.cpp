@@ -142,6 +142,17 @@ TEST_F(ShmBufferTest, cant_upload_bgr_888)
     buf.bind();
 }
 
+TEST_F(ShmBufferTest, upload_at_bind_does_not_wait_for_the_gpu)
+{
+    PlatformlessShmBuffer buf(size, mir_pixel_format_rgb_565, egl_delegate);
+
+    // The renderer samples the texture on the same context, after the upload
+    EXPECT_CALL(mock_gl, glTexImage2D(GL_TEXTURE_2D, 0, _, _, _, 0, _, _, buf.pixel_buffer()));
+    EXPECT_CALL(mock_gl, glFinish()).Times(0);
+
+    buf.bind();
+}
+
 struct BufferUploadDesc
 {
     geom::Size size;
@@ -351,3 +362,80 @@ TEST_F(ShmBufferTest, texture_is_destroyed_on_thread_with_current_context)
         eglMakeCurrent(dummy_dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
     }
 }
+
+TEST_F(ShmBufferTest, mappable_buffer_is_uploaded_on_egl_thread_before_bind)
+{
+    auto const contents = std::make_shared<PlatformlessShmBuffer>(size, mir_pixel_format_rgb_565, egl_delegate);
+    EGLContext const egl_thread_ctx{reinterpret_cast<EGLContext>(42)};
+    auto const renderer_thread = std::this_thread::get_id();
+
+    EXPECT_CALL(mock_gl, glTexImage2D(GL_TEXTURE_2D, 0, _, _, _, 0, _, _, contents->pixel_buffer()))
+        .WillOnce(InvokeWithoutArgs(
+            [&]()
+            {
+                EXPECT_THAT(std::this_thread::get_id(), Ne(renderer_thread));
+                EXPECT_THAT(mock_egl.current_contexts[std::this_thread::get_id()], Eq(egl_thread_ctx));
+            }));
+
+    auto egl_delegate = std::make_shared<mgc::EGLContextExecutor>(
+        std::make_unique<DumbGLContext>(egl_thread_ctx));
+
+    mgc::MappableBackedShmBuffer buffer{contents, egl_delegate};
+
+    // The upload was queued on construction, so has completed once the EGL thread gets to this
+    wait_for_egl_thread(*egl_delegate);
+
+    buffer.bind();
+}
+
+TEST_F(ShmBufferTest, mappable_buffer_is_not_uploaded_until_bound_if_not_wanted_at_commit)
+{
+    auto const contents = std::make_shared<PlatformlessShmBuffer>(size, mir_pixel_format_rgb_565, egl_delegate);
+
+    EXPECT_CALL(mock_gl, glTexImage2D(_, _, _, _, _, _, _, _, _)).Times(0);
+
+    {
+        mgc::MappableBackedShmBuffer buffer{contents, egl_delegate, nullptr, std::nullopt, false};
+        wait_for_egl_thread(*egl_delegate);
+    }
+
+    wait_for_egl_thread(*egl_delegate);
+}
+
+TEST_F(ShmBufferTest, recommitted_buffer_uploads_only_the_damage)
+{
+    auto const format = mir_pixel_format_rgb_565;
+    auto const contents = std::make_shared<PlatformlessShmBuffer>(size, format, egl_delegate);
+    auto const stride = contents->map_readable()->stride();
+    geom::Rectangle const damage{{10, 20}, {30, 40}};
+    mgc::ShmTextureCache textures{egl_delegate};
+
+    InSequence seq;
+    EXPECT_CALL(mock_gl, glTexImage2D(GL_TEXTURE_2D, 0, _, size.width.as_int(), size.height.as_int(), 0, _, _, _));
+    EXPECT_CALL(mock_gl, glTexSubImage2D(GL_TEXTURE_2D, 0, 10, 20, 30, 40, _, _,
+        contents->pixel_buffer() + 20 * stride.as_int() + 10 * MIR_BYTES_PER_PIXEL(format)));
+
+    mgc::MappableBackedShmBuffer first{contents, egl_delegate, textures.texture_for(contents)};
+    first.bind();
+
+    mgc::MappableBackedShmBuffer second{contents, egl_delegate, textures.texture_for(contents), geom::Rectangles{damage}};
+    second.bind();
+
+    wait_for_egl_thread(*egl_delegate);
+}
+
+TEST_F(ShmBufferTest, client_buffer_is_not_released_until_its_contents_are_uploaded)
+{
+    auto const contents = std::make_shared<PlatformlessShmBuffer>(size, mir_pixel_format_rgb_565, egl_delegate);
+    MockFunction<void()> on_release;
+
+    InSequence seq;
+    EXPECT_CALL(mock_gl, glTexImage2D(GL_TEXTURE_2D, 0, _, _, _, 0, _, _, contents->pixel_buffer()));
+    EXPECT_CALL(on_release, Call());
+
+    {
+        mgc::NotifyingMappableBackedShmBuffer buffer{contents, egl_delegate, [](){}, on_release.AsStdFunction()};
+    }
+
+    wait_for_egl_thread(*egl_delegate);
+}
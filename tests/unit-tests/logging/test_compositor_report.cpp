@@ -187,3 +187,53 @@ TEST_F(LoggingCompositorReport, bypass_has_no_render_time)
 
     report.stopped();
 }
+
+TEST_F(LoggingCompositorReport, reports_average_gpu_time_when_measured)
+{
+    const void* const id = "My Screen";
+
+    auto const frame = [&](chrono::microseconds gpu_time, chrono::microseconds then_wait)
+        {
+            report.began_frame(id);
+            clock->advance_by(chrono::microseconds(1234));
+            report.rendered_frame(id);
+            report.rendered_frame_on_gpu(id, gpu_time);
+            report.finished_frame(id);
+            clock->advance_by(then_wait);
+        };
+
+    report.started();
+
+    // The first report only sets the baseline
+    frame(chrono::microseconds(1000), chrono::seconds(2));
+    frame(chrono::microseconds(1000), chrono::microseconds(10000));
+
+    frame(chrono::microseconds(3000), chrono::microseconds(10000));
+    frame(chrono::microseconds(4000), chrono::seconds(2));
+    frame(chrono::microseconds(5000), chrono::microseconds(10000));
+
+    EXPECT_TRUE(recorder->last_message_contains("ms/frame (GPU 4.000 ms)"))
+        << recorder->last_message();
+
+    report.stopped();
+}
+
+TEST_F(LoggingCompositorReport, omits_gpu_time_when_not_measured)
+{
+    const void* const id = "My Screen";
+
+    report.started();
+
+    for (int f = 0; f < 3; ++f)
+    {
+        report.began_frame(id);
+        clock->advance_by(chrono::microseconds(1234));
+        report.rendered_frame(id);
+        report.finished_frame(id);
+        clock->advance_by(chrono::microseconds(12345678));
+    }
+    EXPECT_FALSE(recorder->last_message_contains("GPU"))
+        << recorder->last_message();
+
+    report.stopped();
+}
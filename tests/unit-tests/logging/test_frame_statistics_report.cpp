@@ -0,0 +1,222 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "src/server/report/frame_statistics_report.h"
+#include "mir/logging/logger.h"
+#include "mir/test/doubles/advanceable_clock.h"
+#include "mir/test/doubles/mock_compositor_report.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include <string>
+
+using namespace std;
+using namespace testing;
+
+namespace mtd = mir::test::doubles;
+namespace mr = mir::report;
+namespace ml = mir::logging;
+namespace geom = mir::geometry;
+
+namespace
+{
+
+class Recorder : public ml::Logger
+{
+public:
+    void log(ml::Severity, string const& message, string const&)
+    {
+        last = message;
+    }
+    string const& last_message() const
+    {
+        return last;
+    }
+    bool last_message_contains(char const* substr)
+    {
+        return last.find(substr) != string::npos;
+    }
+private:
+    string last;
+};
+
+struct FrameStatisticsReport : Test
+{
+    /// Finish a frame after the reporting interval, so the statistics so far are reported
+    void complete_interval()
+    {
+        clock->advance_by(chrono::seconds(1));
+        report.began_frame(id);
+        report.finished_frame(id);
+    }
+
+    const void* const id = "My Screen";
+    chrono::microseconds const refresh_period{10000};
+    shared_ptr<mtd::AdvanceableClock> const clock = make_shared<mtd::AdvanceableClock>();
+    shared_ptr<Recorder> const recorder = make_shared<Recorder>();
+    shared_ptr<NiceMock<mtd::MockCompositorReport>> const next = make_shared<NiceMock<mtd::MockCompositorReport>>();
+    mr::FrameStatisticsReport report{next, clock, recorder};
+};
+
+} // namespace
+
+TEST_F(FrameStatisticsReport, reports_frame_time_percentiles)
+{
+    report.started();
+    report.added_display(1920, 1080, 0, 0, id);
+
+    // 100 frames posted on consecutive refreshes, each taking longer to render than the last
+    for (int f = 1; f <= 100; ++f)
+    {
+        report.scheduled();
+        report.began_frame(id);
+        clock->advance_by(chrono::microseconds(50 * f - 25));
+        report.rendered_frame(id);
+        report.finished_frame(id);
+        clock->advance_by(refresh_period - chrono::microseconds(50 * f - 25));
+        report.posted_frame(id, refresh_period);
+    }
+
+    complete_interval();
+
+    auto const statistics = report.frame_statistics();
+    ASSERT_EQ(1u, statistics.size());
+    EXPECT_EQ((geom::Rectangle{{0, 0}, {1920, 1080}}), statistics[0].display_area);
+    EXPECT_EQ(100, statistics[0].frames);
+    EXPECT_EQ(refresh_period, statistics[0].frame_interval.p99);
+    // Percentiles are rounded up to the histogram's 100µs buckets; the maximum is exact
+    EXPECT_EQ(chrono::microseconds(2500), statistics[0].render_time.p50);
+    EXPECT_EQ(chrono::microseconds(4800), statistics[0].render_time.p95);
+    EXPECT_EQ(chrono::microseconds(4975), statistics[0].render_time.max);
+    EXPECT_EQ(refresh_period, statistics[0].latency.max);
+    EXPECT_EQ(0, statistics[0].missed_vblanks);
+    EXPECT_TRUE(recorder->last_message_contains("p50/p95/p99/max"))
+        << recorder->last_message();
+
+    report.stopped();
+}
+
+TEST_F(FrameStatisticsReport, counts_refreshes_missed_while_a_frame_was_due)
+{
+    auto const frame = [&](chrono::microseconds duration)
+        {
+            report.began_frame(id);
+            report.rendered_frame(id);
+            report.finished_frame(id);
+            clock->advance_by(duration);
+            report.posted_frame(id, refresh_period);
+        };
+
+    report.started();
+    report.scheduled();
+    frame(refresh_period);
+
+    // Scheduled before the previous post, so due from then: two refreshes missed
+    frame(3 * refresh_period);
+
+    // Nothing was due while idle, so the wait before this doesn't count
+    clock->advance_by(chrono::milliseconds(500));
+    report.scheduled();
+    frame(refresh_period);
+
+    complete_interval();
+
+    auto const statistics = report.frame_statistics();
+    ASSERT_EQ(1u, statistics.size());
+    EXPECT_EQ(2, statistics[0].missed_vblanks);
+    EXPECT_TRUE(recorder->last_message_contains("2 missed vblanks"))
+        << recorder->last_message();
+
+    report.stopped();
+}
+
+TEST_F(FrameStatisticsReport, idle_gaps_are_not_frame_intervals)
+{
+    report.started();
+    report.scheduled();
+    clock->advance_by(refresh_period);
+    report.posted_frame(id, refresh_period);
+
+    // Scheduled while the previous frame was posted, so the next follows on from it
+    report.scheduled();
+    clock->advance_by(refresh_period);
+    report.posted_frame(id, refresh_period);
+
+    // Scheduled after half a second of nothing changing
+    clock->advance_by(chrono::milliseconds(500));
+    report.scheduled();
+    clock->advance_by(refresh_period);
+    report.posted_frame(id, refresh_period);
+
+    complete_interval();
+
+    auto const statistics = report.frame_statistics();
+    ASSERT_EQ(1u, statistics.size());
+    EXPECT_EQ(3, statistics[0].frames);
+    EXPECT_EQ(refresh_period, statistics[0].frame_interval.max);
+
+    report.stopped();
+}
+
+TEST_F(FrameStatisticsReport, passes_everything_to_the_next_report)
+{
+    mir::graphics::RenderableList const renderables;
+
+    EXPECT_CALL(*next, started());
+    EXPECT_CALL(*next, added_display(1920, 1080, 0, 0, id));
+    EXPECT_CALL(*next, scheduled());
+    EXPECT_CALL(*next, began_frame(id));
+    EXPECT_CALL(*next, renderables_in_frame(id, Ref(renderables)));
+    EXPECT_CALL(*next, rendered_frame(id));
+    EXPECT_CALL(*next, finished_frame(id));
+    EXPECT_CALL(*next, rendered_frame_on_gpu(id, chrono::nanoseconds(1234)));
+    EXPECT_CALL(*next, posted_frame(id, Optional(chrono::nanoseconds(refresh_period))));
+    EXPECT_CALL(*next, stopped());
+
+    report.started();
+    report.added_display(1920, 1080, 0, 0, id);
+    report.scheduled();
+    report.began_frame(id);
+    report.renderables_in_frame(id, renderables);
+    report.rendered_frame(id);
+    report.finished_frame(id);
+    report.rendered_frame_on_gpu(id, chrono::nanoseconds(1234));
+    report.posted_frame(id, refresh_period);
+    report.stopped();
+}
+
+TEST_F(FrameStatisticsReport, gathers_statistics_without_a_logger)
+{
+    mr::FrameStatisticsReport unlogged{next, clock, nullptr};
+
+    unlogged.started();
+    for (int f = 0; f != 3; ++f)
+    {
+        unlogged.scheduled();
+        clock->advance_by(refresh_period);
+        unlogged.posted_frame(id, refresh_period);
+    }
+    clock->advance_by(chrono::seconds(1));
+    unlogged.began_frame(id);
+    unlogged.finished_frame(id);
+
+    auto const statistics = unlogged.frame_statistics();
+    ASSERT_EQ(1u, statistics.size());
+    EXPECT_EQ(3, statistics[0].frames);
+
+    unlogged.stopped();
+}
@@ -48,7 +48,12 @@ struct MockKMSOutput : public graphics::gbm::KMSOutput
         return schedule_page_flip_thunk(&fb);
     }
     MOCK_METHOD1(schedule_page_flip_thunk, bool(graphics::FBHandle const*));
-    MOCK_METHOD0(wait_for_page_flip, void());
+    MOCK_METHOD0(wait_for_page_flip, std::optional<graphics::Frame>());
+    MOCK_METHOD0(page_flip_completed, bool());
+
+    MOCK_CONST_METHOD0(overlay_plane_count, size_t());
+    MOCK_METHOD1(can_show_overlays, bool(std::vector<graphics::gbm::KMSOverlay> const&));
+    MOCK_METHOD1(set_overlays, void(std::vector<graphics::gbm::KMSOverlay> const&));
 
     MOCK_CONST_METHOD0(last_frame, graphics::Frame());
 
@@ -59,6 +64,8 @@ struct MockKMSOutput : public graphics::gbm::KMSOutput
 
     MOCK_METHOD1(set_power_mode, void(MirPowerMode));
     MOCK_METHOD1(set_gamma, void(mir::graphics::GammaCurves const&));
+    MOCK_METHOD1(set_variable_refresh, void(bool));
+    MOCK_METHOD1(set_tearing, void(bool));
 
     MOCK_METHOD0(refresh_hardware_state, void());
     MOCK_CONST_METHOD1(update_from_hardware_state, void(graphics::DisplayConfigurationOutput&));
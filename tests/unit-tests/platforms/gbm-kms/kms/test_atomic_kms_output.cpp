@@ -0,0 +1,617 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "kms_framebuffer.h"
+#include "src/platforms/gbm-kms/server/kms/atomic_kms_output.h"
+#include "src/platforms/gbm-kms/server/kms/real_kms_output_container.h"
+#include "src/platforms/gbm-kms/server/kms/page_flipper.h"
+#include "src/platforms/gbm-kms/server/kms/display_sink.h"
+#include "src/server/report/null_report_factory.h"
+#include "mir/graphics/display_configuration.h"
+
+#include "mir/test/fake_shared.h"
+
+#include "mir/test/doubles/mock_drm.h"
+#include "mir/test/doubles/mock_gbm.h"
+
+#include <cstring>
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include <fcntl.h>
+
+namespace mg = mir::graphics;
+namespace mgg = mir::graphics::gbm;
+namespace geom = mir::geometry;
+namespace mt = mir::test;
+namespace mtd = mir::test::doubles;
+
+using namespace ::testing;
+
+namespace
+{
+
+class MockPageFlipper : public mgg::PageFlipper
+{
+public:
+    MOCK_METHOD3(schedule_flip, bool(uint32_t,uint32_t,uint32_t));
+    MOCK_METHOD3(schedule_async_flip, bool(uint32_t,uint32_t,uint32_t));
+    MOCK_METHOD3(schedule_atomic_flip, bool(uint32_t,drmModeAtomicReq*,uint32_t));
+    MOCK_METHOD1(wait_for_flip, mg::Frame(uint32_t));
+    MOCK_METHOD1(flip_completed, bool(uint32_t));
+};
+
+class StubKMSFramebuffer : public mg::FBHandle
+{
+public:
+    StubKMSFramebuffer(uint32_t fb_id, geom::Size size = {})
+        : fb_id{fb_id},
+          size_{size}
+    {
+    }
+
+    operator uint32_t() const override
+    {
+        return fb_id;
+    }
+
+    auto size() const -> geom::Size override
+    {
+        return size_;
+    }
+private:
+    uint32_t const fb_id;
+    geom::Size const size_;
+};
+
+/* The default fake DRM device has connector 31 driven by CRTC 11 (the second CRTC),
+ * with primary plane 41 and overlay planes 43 (second CRTC only) and 44 (either CRTC).
+ */
+class AtomicKMSOutputTest : public ::testing::Test
+{
+public:
+    AtomicKMSOutputTest()
+        : drm_fd{open(drm_device, 0, 0)}
+    {
+        mock_drm.enable_atomic(drm_device);
+
+        ON_CALL(mock_page_flipper, schedule_atomic_flip(_, _, _))
+            .WillByDefault(Return(true));
+        ON_CALL(mock_page_flipper, wait_for_flip(_))
+            .WillByDefault(Return(mg::Frame{}));
+    }
+
+    auto create_output() -> std::unique_ptr<mgg::AtomicKMSOutput>
+    {
+        return std::make_unique<mgg::AtomicKMSOutput>(
+            drm_fd,
+            mg::kms::get_connector(drm_fd, connector_id),
+            mt::fake_shared(mock_page_flipper));
+    }
+
+    static auto property(drmModeAtomicReq* request, uint32_t object_id, char const* name) -> std::optional<uint64_t>
+    {
+        return mtd::MockDRM::atomic_property(request, object_id, name);
+    }
+
+    /// The fake device's "zpos" property, but fixed by the driver rather than a range the client can set
+    static auto immutable_zpos_property() -> drmModePropertyRes
+    {
+        auto property = *mtd::FakeDRMResources::find_property(mtd::FakeDRMResources::property_id("zpos"));
+        property.flags = DRM_MODE_PROP_IMMUTABLE | DRM_MODE_PROP_RANGE;
+        return property;
+    }
+
+    NiceMock<mtd::MockDRM> mock_drm;
+    NiceMock<mtd::MockGBM> mock_gbm;
+    NiceMock<MockPageFlipper> mock_page_flipper;
+
+    char const* const drm_device = "/dev/dri/card0";
+    int const drm_fd;
+
+    uint32_t const connector_id{31};
+    uint32_t const crtc_id{11};
+    uint32_t const primary_plane_id{41};
+    uint32_t const overlay_plane_id{43};
+    uint32_t const second_overlay_plane_id{47};    ///< Added by tests that need two overlay planes
+
+    StubKMSFramebuffer const fb{67};
+};
+
+}
+
+TEST_F(AtomicKMSOutputTest, set_crtc_tests_then_commits_mode_crtc_and_primary_plane)
+{
+    auto const output = create_output();
+
+    drmModeModeInfo committed_mode{};
+    {
+        InSequence seq;
+        EXPECT_CALL(mock_drm, drmModeAtomicCommit(_, _, DRM_MODE_ATOMIC_TEST_ONLY | DRM_MODE_ATOMIC_ALLOW_MODESET, _));
+        EXPECT_CALL(mock_drm, drmModeAtomicCommit(_, _, DRM_MODE_ATOMIC_ALLOW_MODESET, _))
+            .WillOnce(
+                [&](int, drmModeAtomicReq* request, uint32_t, void*)
+                {
+                    EXPECT_THAT(property(request, connector_id, "CRTC_ID"), Optional(crtc_id));
+                    EXPECT_THAT(property(request, crtc_id, "ACTIVE"), Optional(1u));
+                    EXPECT_THAT(property(request, primary_plane_id, "FB_ID"), Optional(67u));
+                    EXPECT_THAT(property(request, primary_plane_id, "CRTC_ID"), Optional(crtc_id));
+                    EXPECT_THAT(property(request, primary_plane_id, "SRC_W"), Optional(1920u << 16));
+                    EXPECT_THAT(property(request, primary_plane_id, "SRC_H"), Optional(1080u << 16));
+                    EXPECT_THAT(property(request, primary_plane_id, "CRTC_W"), Optional(1920u));
+                    EXPECT_THAT(property(request, primary_plane_id, "CRTC_H"), Optional(1080u));
+
+                    auto const mode_blob = property(request, crtc_id, "MODE_ID");
+                    EXPECT_TRUE(mode_blob);
+                    if (mode_blob)
+                    {
+                        auto const& data = mock_drm.blob_data(*mode_blob);
+                        EXPECT_THAT(data.size(), Eq(sizeof(committed_mode)));
+                        memcpy(&committed_mode, data.data(), std::min(data.size(), sizeof(committed_mode)));
+                    }
+                    return 0;
+                });
+    }
+    EXPECT_CALL(mock_drm, drmModeSetCrtc(_, _, _, _, _, _, _, _)).Times(0);
+
+    EXPECT_TRUE(output->set_crtc(fb));
+    EXPECT_THAT(committed_mode.hdisplay, Eq(1920));
+    EXPECT_THAT(committed_mode.vdisplay, Eq(1080));
+
+    // (Restoring the CRTC we found on shutdown is allowed to use the legacy call)
+    Mock::VerifyAndClearExpectations(&mock_drm);
+}
+
+TEST_F(AtomicKMSOutputTest, set_crtc_does_not_apply_configuration_that_fails_test_commit)
+{
+    auto const output = create_output();
+
+    EXPECT_CALL(mock_drm, drmModeAtomicCommit(_, _, DRM_MODE_ATOMIC_TEST_ONLY | DRM_MODE_ATOMIC_ALLOW_MODESET, _))
+        .WillOnce(Return(-EINVAL));
+    EXPECT_CALL(mock_drm, drmModeAtomicCommit(_, _, DRM_MODE_ATOMIC_ALLOW_MODESET, _)).Times(0);
+
+    EXPECT_FALSE(output->set_crtc(fb));
+}
+
+TEST_F(AtomicKMSOutputTest, page_flip_is_scheduled_as_non_modesetting_atomic_commit)
+{
+    auto const output = create_output();
+    ASSERT_TRUE(output->set_crtc(fb));
+
+    StubKMSFramebuffer const next_fb{68};
+    EXPECT_CALL(mock_page_flipper, schedule_atomic_flip(crtc_id, NotNull(), connector_id))
+        .WillOnce(
+            [&](uint32_t, drmModeAtomicReq* request, uint32_t)
+            {
+                EXPECT_THAT(property(request, primary_plane_id, "FB_ID"), Optional(68u));
+                EXPECT_THAT(property(request, crtc_id, "MODE_ID"), Eq(std::nullopt));
+                EXPECT_THAT(property(request, connector_id, "CRTC_ID"), Eq(std::nullopt));
+                return true;
+            });
+    EXPECT_CALL(mock_page_flipper, schedule_flip(_, _, _)).Times(0);
+
+    EXPECT_TRUE(output->schedule_page_flip(next_fb));
+}
+
+TEST_F(AtomicKMSOutputTest, only_uses_overlay_planes_not_shared_with_an_earlier_crtc)
+{
+    auto const output = create_output();
+    ASSERT_TRUE(output->set_crtc(fb));
+
+    /* Plane 44 can also be used with the first CRTC, so belongs to that */
+    EXPECT_THAT(output->overlay_plane_count(), Eq(1u));
+}
+
+TEST_F(AtomicKMSOutputTest, can_show_overlays_asks_the_driver_with_test_only_commit)
+{
+    auto const output = create_output();
+    ASSERT_TRUE(output->set_crtc(fb));
+
+    std::vector<mgg::KMSOverlay> const overlays{
+        {std::make_shared<StubKMSFramebuffer>(70), {{10, 20}, {100, 50}}, {{0, 0}, {100, 50}}}};
+
+    EXPECT_CALL(mock_drm, drmModeAtomicCommit(_, _, DRM_MODE_ATOMIC_TEST_ONLY, _))
+        .WillOnce(
+            [&](int, drmModeAtomicReq* request, uint32_t, void*)
+            {
+                EXPECT_THAT(property(request, overlay_plane_id, "FB_ID"), Optional(70u));
+                EXPECT_THAT(property(request, overlay_plane_id, "CRTC_X"), Optional(10u));
+                EXPECT_THAT(property(request, overlay_plane_id, "CRTC_Y"), Optional(20u));
+                EXPECT_THAT(property(request, overlay_plane_id, "SRC_W"), Optional(100u << 16));
+                return 0;
+            })
+        .WillOnce(Return(-EINVAL));
+
+    EXPECT_TRUE(output->can_show_overlays(overlays));
+    EXPECT_FALSE(output->can_show_overlays(overlays));
+}
+
+TEST_F(AtomicKMSOutputTest, cannot_show_more_overlays_than_it_has_planes)
+{
+    auto const output = create_output();
+    ASSERT_TRUE(output->set_crtc(fb));
+
+    auto const overlay_fb = std::make_shared<StubKMSFramebuffer>(70);
+    std::vector<mgg::KMSOverlay> const overlays{
+        {overlay_fb, {{0, 0}, {100, 50}}, {{0, 0}, {100, 50}}},
+        {overlay_fb, {{0, 100}, {100, 50}}, {{0, 0}, {100, 50}}}};
+
+    EXPECT_FALSE(output->can_show_overlays(overlays));
+    EXPECT_THROW(output->set_overlays(overlays), std::logic_error);
+}
+
+TEST_F(AtomicKMSOutputTest, overlays_are_stacked_in_order_above_the_primary_plane)
+{
+    mock_drm.add_plane(drm_device, second_overlay_plane_id, DRM_PLANE_TYPE_OVERLAY, 0x2);
+    mock_drm.prepare(drm_device);
+
+    auto const output = create_output();
+    ASSERT_TRUE(output->set_crtc(fb));
+
+    std::vector<mgg::KMSOverlay> const overlays{
+        {std::make_shared<StubKMSFramebuffer>(70), {{0, 0}, {100, 50}}, {{0, 0}, {100, 50}}},
+        {std::make_shared<StubKMSFramebuffer>(71), {{0, 100}, {100, 50}}, {{0, 0}, {100, 50}}}};
+
+    EXPECT_CALL(mock_drm, drmModeAtomicCommit(_, _, DRM_MODE_ATOMIC_TEST_ONLY, _))
+        .WillOnce(
+            [&](int, drmModeAtomicReq* request, uint32_t, void*)
+            {
+                EXPECT_THAT(property(request, overlay_plane_id, "FB_ID"), Optional(70u));
+                EXPECT_THAT(property(request, overlay_plane_id, "zpos"), Optional(1u));
+                EXPECT_THAT(property(request, second_overlay_plane_id, "FB_ID"), Optional(71u));
+                EXPECT_THAT(property(request, second_overlay_plane_id, "zpos"), Optional(2u));
+                return 0;
+            });
+
+    EXPECT_TRUE(output->can_show_overlays(overlays));
+}
+
+TEST_F(AtomicKMSOutputTest, overlays_use_planes_with_immutable_zpos_in_stacking_order)
+{
+    mock_drm.add_plane(drm_device, second_overlay_plane_id, DRM_PLANE_TYPE_OVERLAY, 0x2);
+    mock_drm.prepare(drm_device);
+    auto immutable_zpos = immutable_zpos_property();
+    ON_CALL(mock_drm, drmModeGetProperty(_, immutable_zpos.prop_id)).WillByDefault(Return(&immutable_zpos));
+    mock_drm.set_property_value(drm_device, primary_plane_id, "zpos", 0);
+    mock_drm.set_property_value(drm_device, overlay_plane_id, "zpos", 3);
+    mock_drm.set_property_value(drm_device, second_overlay_plane_id, "zpos", 1);
+
+    auto const output = create_output();
+    ASSERT_TRUE(output->set_crtc(fb));
+
+    std::vector<mgg::KMSOverlay> const overlays{
+        {std::make_shared<StubKMSFramebuffer>(70), {{0, 0}, {100, 50}}, {{0, 0}, {100, 50}}},
+        {std::make_shared<StubKMSFramebuffer>(71), {{0, 100}, {100, 50}}, {{0, 0}, {100, 50}}}};
+
+    EXPECT_CALL(mock_drm, drmModeAtomicCommit(_, _, DRM_MODE_ATOMIC_TEST_ONLY, _))
+        .WillOnce(
+            [&](int, drmModeAtomicReq* request, uint32_t, void*)
+            {
+                EXPECT_THAT(property(request, second_overlay_plane_id, "FB_ID"), Optional(70u));
+                EXPECT_THAT(property(request, overlay_plane_id, "FB_ID"), Optional(71u));
+                EXPECT_THAT(property(request, second_overlay_plane_id, "zpos"), Eq(std::nullopt));
+                EXPECT_THAT(property(request, overlay_plane_id, "zpos"), Eq(std::nullopt));
+                return 0;
+            });
+
+    EXPECT_TRUE(output->can_show_overlays(overlays));
+}
+
+TEST_F(AtomicKMSOutputTest, overlays_skip_planes_with_immutable_zpos_below_the_primary_plane)
+{
+    mock_drm.add_plane(drm_device, second_overlay_plane_id, DRM_PLANE_TYPE_OVERLAY, 0x2);
+    mock_drm.prepare(drm_device);
+    auto immutable_zpos = immutable_zpos_property();
+    ON_CALL(mock_drm, drmModeGetProperty(_, immutable_zpos.prop_id)).WillByDefault(Return(&immutable_zpos));
+    mock_drm.set_property_value(drm_device, primary_plane_id, "zpos", 2);
+    mock_drm.set_property_value(drm_device, overlay_plane_id, "zpos", 1);
+    mock_drm.set_property_value(drm_device, second_overlay_plane_id, "zpos", 3);
+
+    auto const output = create_output();
+    ASSERT_TRUE(output->set_crtc(fb));
+
+    auto const overlay_fb = std::make_shared<StubKMSFramebuffer>(70);
+    std::vector<mgg::KMSOverlay> const one_overlay{
+        {overlay_fb, {{0, 0}, {100, 50}}, {{0, 0}, {100, 50}}}};
+    std::vector<mgg::KMSOverlay> const two_overlays{
+        {overlay_fb, {{0, 0}, {100, 50}}, {{0, 0}, {100, 50}}},
+        {overlay_fb, {{0, 100}, {100, 50}}, {{0, 0}, {100, 50}}}};
+
+    EXPECT_CALL(mock_drm, drmModeAtomicCommit(_, _, DRM_MODE_ATOMIC_TEST_ONLY, _))
+        .WillOnce(
+            [&](int, drmModeAtomicReq* request, uint32_t, void*)
+            {
+                EXPECT_THAT(property(request, second_overlay_plane_id, "FB_ID"), Optional(70u));
+                EXPECT_THAT(property(request, overlay_plane_id, "FB_ID"), Optional(0u));
+                return 0;
+            });
+
+    EXPECT_TRUE(output->can_show_overlays(one_overlay));
+    EXPECT_FALSE(output->can_show_overlays(two_overlays));
+}
+
+TEST_F(AtomicKMSOutputTest, overlays_change_with_the_next_page_flip)
+{
+    auto const output = create_output();
+    ASSERT_TRUE(output->set_crtc(fb));
+
+    output->set_overlays({{std::make_shared<StubKMSFramebuffer>(70), {{0, 0}, {100, 50}}, {{0, 0}, {100, 50}}}});
+
+    EXPECT_CALL(mock_page_flipper, schedule_atomic_flip(_, _, _))
+        .WillOnce(
+            [&](uint32_t, drmModeAtomicReq* request, uint32_t)
+            {
+                EXPECT_THAT(property(request, overlay_plane_id, "FB_ID"), Optional(70u));
+                EXPECT_THAT(property(request, overlay_plane_id, "CRTC_ID"), Optional(crtc_id));
+                return true;
+            })
+        .WillOnce(
+            [&](uint32_t, drmModeAtomicReq* request, uint32_t)
+            {
+                EXPECT_THAT(property(request, overlay_plane_id, "FB_ID"), Optional(0u));
+                EXPECT_THAT(property(request, overlay_plane_id, "CRTC_ID"), Optional(0u));
+                return true;
+            });
+
+    EXPECT_TRUE(output->schedule_page_flip(fb));
+    output->set_overlays({});
+    EXPECT_TRUE(output->schedule_page_flip(fb));
+}
+
+TEST_F(AtomicKMSOutputTest, display_sink_shows_overlaid_elements_on_the_primary_and_overlay_planes)
+{
+    std::shared_ptr<mgg::KMSOutput> const output = create_output();
+    ASSERT_TRUE(output->set_crtc(fb));
+
+    geom::Rectangle const area{{0, 0}, {1920, 1080}};
+    mgg::DisplaySink sink{
+        mir::Fd{mir::IntOwnedFd{drm_fd}},
+        nullptr,
+        mgg::BypassOption::allowed,
+        mir::report::null_display_report(),
+        {output},
+        area,
+        glm::mat2{1}};
+
+    auto const fullscreen_fb = std::make_shared<StubKMSFramebuffer>(68, area.size);
+    auto const window_fb = std::make_shared<StubKMSFramebuffer>(70, geom::Size{100, 50});
+    std::vector<mg::DisplayElement> const elements{
+        {area, {{0, 0}, {1920, 1080}}, fullscreen_fb},
+        {{{10, 20}, {100, 50}}, {{0, 0}, {100, 50}}, window_fb}};
+
+    EXPECT_CALL(mock_page_flipper, schedule_atomic_flip(crtc_id, NotNull(), connector_id))
+        .WillOnce(
+            [&](uint32_t, drmModeAtomicReq* request, uint32_t)
+            {
+                EXPECT_THAT(property(request, primary_plane_id, "FB_ID"), Optional(68u));
+                EXPECT_THAT(property(request, overlay_plane_id, "FB_ID"), Optional(70u));
+                EXPECT_THAT(property(request, overlay_plane_id, "CRTC_ID"), Optional(crtc_id));
+                EXPECT_THAT(property(request, overlay_plane_id, "CRTC_X"), Optional(10u));
+                EXPECT_THAT(property(request, overlay_plane_id, "CRTC_Y"), Optional(20u));
+                EXPECT_THAT(property(request, overlay_plane_id, "CRTC_W"), Optional(100u));
+                EXPECT_THAT(property(request, overlay_plane_id, "SRC_H"), Optional(50u << 16));
+                return true;
+            });
+
+    ASSERT_TRUE(sink.overlay(elements));
+    sink.post();
+}
+
+TEST_F(AtomicKMSOutputTest, display_sink_does_not_overlay_elements_the_driver_rejects)
+{
+    std::shared_ptr<mgg::KMSOutput> const output = create_output();
+    ASSERT_TRUE(output->set_crtc(fb));
+
+    geom::Rectangle const area{{0, 0}, {1920, 1080}};
+    mgg::DisplaySink sink{
+        mir::Fd{mir::IntOwnedFd{drm_fd}},
+        nullptr,
+        mgg::BypassOption::allowed,
+        mir::report::null_display_report(),
+        {output},
+        area,
+        glm::mat2{1}};
+
+    std::vector<mg::DisplayElement> const elements{
+        {area, {{0, 0}, {1920, 1080}}, std::make_shared<StubKMSFramebuffer>(68, area.size)},
+        {{{10, 20}, {100, 50}}, {{0, 0}, {100, 50}}, std::make_shared<StubKMSFramebuffer>(70, geom::Size{100, 50})}};
+
+    EXPECT_CALL(mock_drm, drmModeAtomicCommit(_, _, DRM_MODE_ATOMIC_TEST_ONLY, _))
+        .WillOnce(Return(-EINVAL));
+
+    EXPECT_FALSE(sink.overlay(elements));
+}
+
+TEST_F(AtomicKMSOutputTest, gamma_is_applied_with_the_next_page_flip)
+{
+    auto const output = create_output();
+    ASSERT_TRUE(output->set_crtc(fb));
+
+    mg::GammaCurves gamma{
+        std::vector<uint16_t>(256, 1),
+        std::vector<uint16_t>(256, 2),
+        std::vector<uint16_t>(256, 3)};
+
+    EXPECT_CALL(mock_drm, drmModeAtomicCommit(_, _, _, _)).Times(0);
+    EXPECT_CALL(mock_drm, drmModeCrtcSetGamma(_, _, _, _, _, _)).Times(0);
+    EXPECT_CALL(mock_page_flipper, schedule_atomic_flip(_, _, _))
+        .WillOnce(
+            [&](uint32_t, drmModeAtomicReq* request, uint32_t)
+            {
+                auto const lut_blob = property(request, crtc_id, "GAMMA_LUT");
+                EXPECT_TRUE(lut_blob);
+                if (lut_blob)
+                {
+                    auto const& data = mock_drm.blob_data(*lut_blob);
+                    EXPECT_THAT(data.size(), Eq(256 * sizeof(drm_color_lut)));
+                    if (data.size() >= sizeof(drm_color_lut))
+                    {
+                        drm_color_lut entry;
+                        memcpy(&entry, data.data(), sizeof(entry));
+                        EXPECT_THAT(entry.red, Eq(1));
+                        EXPECT_THAT(entry.green, Eq(2));
+                        EXPECT_THAT(entry.blue, Eq(3));
+                    }
+                }
+                return true;
+            })
+        .WillOnce(
+            [&](uint32_t, drmModeAtomicReq* request, uint32_t)
+            {
+                EXPECT_THAT(property(request, crtc_id, "GAMMA_LUT"), Eq(std::nullopt));
+                return true;
+            });
+
+    output->set_gamma(gamma);
+    EXPECT_TRUE(output->schedule_page_flip(fb));
+    EXPECT_TRUE(output->schedule_page_flip(fb));
+}
+
+TEST_F(AtomicKMSOutputTest, gamma_of_size_unsupported_by_gamma_lut_falls_back_to_legacy_ramp)
+{
+    auto const output = create_output();
+    ASSERT_TRUE(output->set_crtc(fb));
+
+    mg::GammaCurves gamma{{1}, {2}, {3}};
+
+    EXPECT_CALL(mock_drm, drmModeCrtcSetGamma(drm_fd, crtc_id, 1, _, _, _));
+
+    output->set_gamma(gamma);
+}
+
+TEST_F(AtomicKMSOutputTest, variable_refresh_is_applied_with_the_next_page_flip)
+{
+    auto const output = create_output();
+    ASSERT_TRUE(output->set_crtc(fb));
+
+    EXPECT_CALL(mock_page_flipper, schedule_atomic_flip(_, _, _))
+        .WillOnce(
+            [&](uint32_t, drmModeAtomicReq* request, uint32_t)
+            {
+                EXPECT_THAT(property(request, crtc_id, "VRR_ENABLED"), Optional(1u));
+                return true;
+            })
+        .WillOnce(
+            [&](uint32_t, drmModeAtomicReq* request, uint32_t)
+            {
+                EXPECT_THAT(property(request, crtc_id, "VRR_ENABLED"), Optional(0u));
+                return true;
+            });
+
+    output->set_variable_refresh(true);
+    EXPECT_TRUE(output->schedule_page_flip(fb));
+    output->set_variable_refresh(false);
+    EXPECT_TRUE(output->schedule_page_flip(fb));
+}
+
+TEST_F(AtomicKMSOutputTest, reports_whether_connector_is_vrr_capable)
+{
+    auto const output = create_output();
+
+    mg::DisplayConfigurationOutput conf{};
+    output->update_from_hardware_state(conf);
+    EXPECT_FALSE(conf.vrr_capable);
+
+    mock_drm.set_property_value(drm_device, connector_id, "vrr_capable", 1);
+
+    output->update_from_hardware_state(conf);
+    EXPECT_TRUE(conf.vrr_capable);
+}
+
+TEST_F(AtomicKMSOutputTest, clear_crtc_disables_crtc_and_its_planes)
+{
+    auto const output = create_output();
+    ASSERT_TRUE(output->set_crtc(fb));
+
+    EXPECT_CALL(mock_drm, drmModeAtomicCommit(_, _, DRM_MODE_ATOMIC_ALLOW_MODESET, _))
+        .WillOnce(
+            [&](int, drmModeAtomicReq* request, uint32_t, void*)
+            {
+                EXPECT_THAT(property(request, connector_id, "CRTC_ID"), Optional(0u));
+                EXPECT_THAT(property(request, crtc_id, "ACTIVE"), Optional(0u));
+                EXPECT_THAT(property(request, crtc_id, "MODE_ID"), Optional(0u));
+                EXPECT_THAT(property(request, primary_plane_id, "FB_ID"), Optional(0u));
+                EXPECT_THAT(property(request, overlay_plane_id, "FB_ID"), Optional(0u));
+                return 0;
+            });
+
+    output->clear_crtc();
+}
+
+TEST_F(AtomicKMSOutputTest, clear_crtc_is_non_fatal_on_permission_error)
+{
+    auto const output = create_output();
+    ASSERT_TRUE(output->set_crtc(fb));
+
+    EXPECT_CALL(mock_drm, drmModeAtomicCommit(_, _, DRM_MODE_ATOMIC_ALLOW_MODESET, _))
+        .WillOnce(Return(-EACCES));
+
+    EXPECT_NO_THROW(output->clear_crtc());
+}
+
+TEST_F(AtomicKMSOutputTest, power_mode_sets_crtc_active_state)
+{
+    auto const output = create_output();
+    ASSERT_TRUE(output->set_crtc(fb));
+
+    EXPECT_CALL(mock_drm, drmModeAtomicCommit(_, _, DRM_MODE_ATOMIC_ALLOW_MODESET, _))
+        .WillOnce(
+            [&](int, drmModeAtomicReq* request, uint32_t, void*)
+            {
+                EXPECT_THAT(property(request, crtc_id, "ACTIVE"), Optional(0u));
+                return 0;
+            })
+        .WillOnce(
+            [&](int, drmModeAtomicReq* request, uint32_t, void*)
+            {
+                EXPECT_THAT(property(request, crtc_id, "ACTIVE"), Optional(1u));
+                return 0;
+            });
+    EXPECT_CALL(mock_drm, drmModeConnectorSetProperty(_, _, _, _)).Times(0);
+
+    output->set_power_mode(mir_power_mode_off);
+    output->set_power_mode(mir_power_mode_on);
+}
+
+TEST_F(AtomicKMSOutputTest, output_container_creates_atomic_outputs_when_driver_supports_atomic)
+{
+    mgg::RealKMSOutputContainer container{mir::Fd{mir::IntOwnedFd{drm_fd}}, mt::fake_shared(mock_page_flipper)};
+    container.update_from_hardware_state();
+
+    int outputs{0};
+    container.for_each_output(
+        [&](auto const& output)
+        {
+            ++outputs;
+            EXPECT_THAT(std::dynamic_pointer_cast<mgg::AtomicKMSOutput>(output), NotNull());
+        });
+    EXPECT_THAT(outputs, Gt(0));
+}
+
+TEST_F(AtomicKMSOutputTest, output_container_creates_legacy_outputs_when_driver_lacks_atomic)
+{
+    ON_CALL(mock_drm, drmSetClientCap(_, DRM_CLIENT_CAP_ATOMIC, _))
+        .WillByDefault(Return(-EOPNOTSUPP));
+
+    mgg::RealKMSOutputContainer container{mir::Fd{mir::IntOwnedFd{drm_fd}}, mt::fake_shared(mock_page_flipper)};
+    container.update_from_hardware_state();
+
+    container.for_each_output(
+        [&](auto const& output)
+        {
+            EXPECT_THAT(std::dynamic_pointer_cast<mgg::AtomicKMSOutput>(output), IsNull());
+        });
+}
@@ -444,6 +444,47 @@ TEST_F(MesaDisplayConfigurationTest, reads_subpixel_information_correctly)
     }
 }
 
+TEST_F(MesaDisplayConfigurationTest, vrr_is_offered_on_vrr_capable_connectors)
+{
+    using namespace ::testing;
+
+    uint32_t const crtc0_id{10};
+    uint32_t const encoder0_id{20};
+    uint32_t const connector0_id{30};
+    geom::Size const connector0_physical_size_mm{480, 270};
+    std::vector<uint32_t> possible_encoder_ids_empty;
+    uint32_t const possible_crtcs_mask_empty{0};
+
+    mock_drm.reset(drm_device);
+    mock_drm.add_crtc(drm_device, crtc0_id, modes0[1]);
+    mock_drm.add_encoder(drm_device, encoder0_id, crtc0_id, possible_crtcs_mask_empty);
+    mock_drm.add_connector(
+        drm_device,
+        connector0_id,
+        DRM_MODE_CONNECTOR_HDMIA,
+        DRM_MODE_CONNECTED,
+        encoder0_id,
+        modes0,
+        possible_encoder_ids_empty,
+        connector0_physical_size_mm);
+    mock_drm.prepare(drm_device);
+    // The connector's "vrr_capable" property is only exposed to atomic clients
+    mock_drm.enable_atomic(drm_device);
+    mock_drm.set_property_value(drm_device, connector0_id, "vrr_capable", 1);
+
+    auto display = create_display(create_platform());
+    auto conf = display->configuration();
+
+    int output_count{0};
+    conf->for_each_output(
+        [&](mg::DisplayConfigurationOutput const& output)
+        {
+            EXPECT_TRUE(output.vrr_capable);
+            ++output_count;
+        });
+    EXPECT_THAT(output_count, Eq(1));
+}
+
 TEST_F(MesaDisplayConfigurationTest, reads_updated_subpixel_information)
 {
     using namespace ::testing;
@@ -29,6 +29,7 @@
 #include "mir/test/doubles/fake_renderable.h"
 #include "mir/graphics/transformation.h"
 #include "mock_kms_output.h"
+#include "mir/test/signal.h"
 
 #include <fcntl.h>
 #include <gtest/gtest.h>
@@ -233,6 +234,461 @@ TEST_F(MesaDisplaySinkTest, untransformed_with_bypassable_list_can_bypass)
     EXPECT_TRUE(sink.overlay(bypassable_list));
 }
 
+TEST_F(MesaDisplaySinkTest, frame_budget_is_one_refresh_after_page_flip)
+{
+    graphics::gbm::DisplaySink sink(
+        drm_fd,
+        gbm,
+        graphics::gbm::BypassOption::allowed,
+        null_display_report(),
+        {mock_kms_output},
+        display_area,
+        identity);
+
+    EXPECT_THAT(sink.frame_budget(), Eq(std::nullopt));
+
+    ASSERT_TRUE(sink.overlay(bypassable_list));
+    sink.post();
+
+    EXPECT_THAT(sink.frame_budget(), Eq(std::chrono::nanoseconds{std::chrono::seconds{1}} / mock_refresh_rate));
+}
+
+TEST_F(MesaDisplaySinkTest, cloned_outputs_are_paced_by_the_fastest)
+{
+    Signal slow_flip_done;
+    Signal third_frame_scheduled;
+    auto const slow_output = std::make_shared<NiceMock<MockKMSOutput>>();
+    ON_CALL(*slow_output, schedule_page_flip_thunk(_))
+        .WillByDefault(Return(true));
+    ON_CALL(*slow_output, max_refresh_rate())
+        .WillByDefault(Return(mock_refresh_rate / 2));
+
+    graphics::gbm::DisplaySink sink(
+        drm_fd,
+        gbm,
+        graphics::gbm::BypassOption::allowed,
+        null_display_report(),
+        {slow_output, mock_kms_output},
+        display_area,
+        identity);
+
+    auto third_frame = std::make_unique<NiceMock<MockKMSFramebuffer>>();
+    auto const third_fb = third_frame.get();
+
+    // Only the fastest output is waited on while the other is free to flip...
+    EXPECT_CALL(*mock_kms_output, schedule_page_flip_thunk(_)).Times(3);
+    EXPECT_CALL(*mock_kms_output, wait_for_page_flip()).Times(3);
+    {
+        InSequence seq;
+        EXPECT_CALL(*slow_output, schedule_page_flip_thunk(_));
+        // ...so while it's still flipping to the first frame it skips the second, without blocking...
+        EXPECT_CALL(*slow_output, page_flip_completed())
+            .Times(2)
+            .WillRepeatedly(Return(false));
+        EXPECT_CALL(*slow_output, wait_for_page_flip())
+            .WillOnce(InvokeWithoutArgs(
+                [&]
+                {
+                    slow_flip_done.wait_for(std::chrono::seconds{10});
+                    return std::optional<graphics::Frame>{};
+                }));
+        // ...and picks up the third once that's done
+        EXPECT_CALL(*slow_output, schedule_page_flip_thunk(Eq(third_fb)))
+            .WillOnce(DoAll(InvokeWithoutArgs([&] { third_frame_scheduled.raise(); }), Return(true)));
+    }
+
+    ASSERT_TRUE(sink.overlay(bypassable_list));
+    sink.post();
+
+    EXPECT_THAT(sink.frame_budget(), Eq(std::chrono::nanoseconds{std::chrono::seconds{1}} / mock_refresh_rate));
+
+    sink.set_next_image(std::make_unique<NiceMock<MockKMSFramebuffer>>());
+    sink.post();
+
+    sink.set_next_image(std::move(third_frame));
+    sink.post();
+
+    slow_flip_done.raise();
+    EXPECT_TRUE(third_frame_scheduled.wait_for(std::chrono::seconds{10}));
+}
+
+TEST_F(MesaDisplaySinkTest, lagging_clone_is_flipped_to_the_final_frame_without_further_posts)
+{
+    Signal slow_flip_done;
+    Signal final_frame_scheduled;
+    auto const slow_output = std::make_shared<NiceMock<MockKMSOutput>>();
+    ON_CALL(*slow_output, schedule_page_flip_thunk(_))
+        .WillByDefault(Return(true));
+    ON_CALL(*slow_output, max_refresh_rate())
+        .WillByDefault(Return(mock_refresh_rate / 2));
+    ON_CALL(*slow_output, page_flip_completed())
+        .WillByDefault(Return(false));
+
+    graphics::gbm::DisplaySink sink(
+        drm_fd,
+        gbm,
+        graphics::gbm::BypassOption::allowed,
+        null_display_report(),
+        {slow_output, mock_kms_output},
+        display_area,
+        identity);
+
+    auto final_frame = std::make_unique<NiceMock<MockKMSFramebuffer>>();
+    auto const final_fb = final_frame.get();
+
+    {
+        InSequence seq;
+        EXPECT_CALL(*slow_output, schedule_page_flip_thunk(_));
+        EXPECT_CALL(*slow_output, wait_for_page_flip())
+            .WillOnce(InvokeWithoutArgs(
+                [&]
+                {
+                    slow_flip_done.wait_for(std::chrono::seconds{10});
+                    return std::optional<graphics::Frame>{};
+                }));
+        EXPECT_CALL(*slow_output, schedule_page_flip_thunk(Eq(final_fb)))
+            .WillOnce(DoAll(InvokeWithoutArgs([&] { final_frame_scheduled.raise(); }), Return(true)));
+    }
+
+    ASSERT_TRUE(sink.overlay(bypassable_list));
+    sink.post();
+
+    // The slow output is still flipping to the first frame when the last is posted...
+    sink.set_next_image(std::move(final_frame));
+    sink.post();
+    EXPECT_FALSE(final_frame_scheduled.raised());
+
+    // ...and nothing more is, but it still gets the last frame once it's ready
+    slow_flip_done.raise();
+    EXPECT_TRUE(final_frame_scheduled.wait_for(std::chrono::seconds{10}));
+}
+
+TEST_F(MesaDisplaySinkTest, variable_refresh_follows_bypassed_client_frames_when_allowed)
+{
+    graphics::gbm::DisplaySink sink(
+        drm_fd,
+        gbm,
+        graphics::gbm::BypassOption::allowed,
+        null_display_report(),
+        {mock_kms_output},
+        display_area,
+        identity);
+    sink.allow_variable_refresh(true);
+
+    {
+        InSequence seq;
+        EXPECT_CALL(*mock_kms_output, set_variable_refresh(true));
+        EXPECT_CALL(*mock_kms_output, schedule_page_flip_thunk(_));
+        EXPECT_CALL(*mock_kms_output, set_variable_refresh(false));
+        EXPECT_CALL(*mock_kms_output, schedule_page_flip_thunk(_));
+    }
+
+    ASSERT_TRUE(sink.overlay(bypassable_list));
+    sink.post();
+
+    // The client's frame rate drives the display, so the compositor has no deadline
+    EXPECT_THAT(sink.frame_budget(), Eq(std::nullopt));
+
+    sink.set_next_image(std::make_unique<NiceMock<MockKMSFramebuffer>>());
+    sink.post();
+
+    EXPECT_THAT(sink.frame_budget(), Eq(std::chrono::nanoseconds{std::chrono::seconds{1}} / mock_refresh_rate));
+}
+
+TEST_F(MesaDisplaySinkTest, variable_refresh_is_not_used_unless_allowed)
+{
+    graphics::gbm::DisplaySink sink(
+        drm_fd,
+        gbm,
+        graphics::gbm::BypassOption::allowed,
+        null_display_report(),
+        {mock_kms_output},
+        display_area,
+        identity);
+
+    EXPECT_CALL(*mock_kms_output, set_variable_refresh(true)).Times(0);
+
+    ASSERT_TRUE(sink.overlay(bypassable_list));
+    sink.post();
+}
+
+TEST_F(MesaDisplaySinkTest, bypassed_client_frames_tear_when_the_client_allows)
+{
+    std::vector<mir::graphics::DisplayElement> const tearing_list{
+        mir::graphics::DisplayElement{
+            display_area,
+            {
+                {0, 0},
+                {display_area.size.width.as_value(), display_area.size.height.as_value()}
+            },
+            bypass_framebuffer,
+            true}
+        };
+    ON_CALL(*mock_kms_output, wait_for_page_flip())
+        .WillByDefault(Return(graphics::Frame{}));
+
+    graphics::gbm::DisplaySink sink(
+        drm_fd,
+        gbm,
+        graphics::gbm::BypassOption::allowed,
+        null_display_report(),
+        {mock_kms_output},
+        display_area,
+        identity);
+
+    {
+        InSequence seq;
+        EXPECT_CALL(*mock_kms_output, set_tearing(true));
+        EXPECT_CALL(*mock_kms_output, schedule_page_flip_thunk(_));
+        EXPECT_CALL(*mock_kms_output, set_tearing(false));
+        EXPECT_CALL(*mock_kms_output, schedule_page_flip_thunk(_));
+    }
+
+    ASSERT_TRUE(sink.overlay(tearing_list));
+    sink.post();
+
+    // The frame is shown as soon as it's ready, so there's no deadline for the next...
+    EXPECT_THAT(sink.frame_budget(), Eq(std::nullopt));
+    // ...and it wasn't in step with the vblank
+    ASSERT_TRUE(sink.last_presentation());
+    EXPECT_FALSE(sink.last_presentation()->vsync);
+
+    // Composited frames never tear
+    sink.set_next_image(std::make_unique<NiceMock<MockKMSFramebuffer>>());
+    sink.post();
+
+    ASSERT_TRUE(sink.last_presentation());
+    EXPECT_TRUE(sink.last_presentation()->vsync);
+}
+
+TEST_F(MesaDisplaySinkTest, frame_budget_is_unknown_when_nothing_was_flipped)
+{
+    graphics::gbm::DisplaySink sink(
+        drm_fd,
+        gbm,
+        graphics::gbm::BypassOption::allowed,
+        null_display_report(),
+        {mock_kms_output},
+        display_area,
+        identity);
+
+    ASSERT_TRUE(sink.overlay(bypassable_list));
+    sink.post();
+    sink.post();
+
+    EXPECT_THAT(sink.frame_budget(), Eq(std::nullopt));
+}
+
+TEST_F(MesaDisplaySinkTest, last_presentation_reports_page_flip_frame)
+{
+    graphics::Frame const flipped{
+        42,
+        mir::time::PosixTimestamp{CLOCK_MONOTONIC, std::chrono::nanoseconds{123456789}}};
+    ON_CALL(*mock_kms_output, wait_for_page_flip())
+        .WillByDefault(Return(flipped));
+
+    graphics::gbm::DisplaySink sink(
+        drm_fd,
+        gbm,
+        graphics::gbm::BypassOption::allowed,
+        null_display_report(),
+        {mock_kms_output},
+        display_area,
+        identity);
+
+    EXPECT_THAT(sink.last_presentation(), Eq(std::nullopt));
+
+    ASSERT_TRUE(sink.overlay(bypassable_list));
+    sink.post();
+
+    auto const presentation = sink.last_presentation();
+    ASSERT_TRUE(presentation);
+    EXPECT_THAT(presentation->frame.msc, Eq(flipped.msc));
+    EXPECT_THAT(presentation->frame.ust, Eq(flipped.ust));
+    EXPECT_TRUE(presentation->vsync);
+    EXPECT_TRUE(presentation->hw_clock);
+    EXPECT_TRUE(presentation->hw_completion);
+    EXPECT_TRUE(presentation->zero_copy);
+}
+
+TEST_F(MesaDisplaySinkTest, last_presentation_is_unknown_when_nothing_was_flipped)
+{
+    ON_CALL(*mock_kms_output, wait_for_page_flip())
+        .WillByDefault(Return(graphics::Frame{}));
+
+    graphics::gbm::DisplaySink sink(
+        drm_fd,
+        gbm,
+        graphics::gbm::BypassOption::allowed,
+        null_display_report(),
+        {mock_kms_output},
+        display_area,
+        identity);
+
+    ASSERT_TRUE(sink.overlay(bypassable_list));
+    sink.post();
+    sink.post();
+
+    EXPECT_THAT(sink.last_presentation(), Eq(std::nullopt));
+}
+
+TEST_F(MesaDisplaySinkTest, window_above_bypassable_buffer_is_shown_on_an_overlay_plane)
+{
+    auto const window_framebuffer = std::make_shared<NiceMock<MockKMSFramebuffer>>();
+    ON_CALL(*window_framebuffer, size()).WillByDefault(Return(geometry::Size{10, 10}));
+    auto list = bypassable_list;
+    list.push_back({{display_area.top_left + geometry::Displacement{4, 5}, {10, 10}}, {{0, 0}, {10, 10}}, window_framebuffer});
+
+    ON_CALL(*mock_kms_output, overlay_plane_count()).WillByDefault(Return(1));
+    ON_CALL(*mock_kms_output, can_show_overlays(_)).WillByDefault(Return(true));
+
+    graphics::gbm::DisplaySink sink(
+        drm_fd,
+        gbm,
+        graphics::gbm::BypassOption::allowed,
+        null_display_report(),
+        {mock_kms_output},
+        display_area,
+        identity);
+
+    std::vector<KMSOverlay> overlays;
+    EXPECT_CALL(*mock_kms_output, set_overlays(_))
+        .WillOnce(SaveArg<0>(&overlays));
+
+    ASSERT_TRUE(sink.overlay(list));
+    sink.post();
+
+    ASSERT_THAT(overlays, SizeIs(1));
+    EXPECT_THAT(overlays[0].fb, Eq(window_framebuffer));
+    EXPECT_THAT(overlays[0].destination, Eq(geometry::Rectangle{{4, 5}, {10, 10}}));
+    EXPECT_THAT(overlays[0].source, Eq(geometry::RectangleF{{0, 0}, {10, 10}}));
+}
+
+TEST_F(MesaDisplaySinkTest, cannot_overlay_more_elements_than_there_are_planes)
+{
+    auto const window_framebuffer = std::make_shared<NiceMock<MockKMSFramebuffer>>();
+    ON_CALL(*window_framebuffer, size()).WillByDefault(Return(geometry::Size{10, 10}));
+    auto list = bypassable_list;
+    list.push_back({{display_area.top_left, {10, 10}}, {{0, 0}, {10, 10}}, window_framebuffer});
+    list.push_back({{display_area.top_left, {10, 10}}, {{0, 0}, {10, 10}}, window_framebuffer});
+
+    ON_CALL(*mock_kms_output, overlay_plane_count()).WillByDefault(Return(1));
+    ON_CALL(*mock_kms_output, can_show_overlays(_)).WillByDefault(Return(true));
+
+    graphics::gbm::DisplaySink sink(
+        drm_fd,
+        gbm,
+        graphics::gbm::BypassOption::allowed,
+        null_display_report(),
+        {mock_kms_output},
+        display_area,
+        identity);
+
+    EXPECT_FALSE(sink.overlay(list));
+}
+
+TEST_F(MesaDisplaySinkTest, cannot_overlay_elements_the_output_cannot_show)
+{
+    auto const window_framebuffer = std::make_shared<NiceMock<MockKMSFramebuffer>>();
+    ON_CALL(*window_framebuffer, size()).WillByDefault(Return(geometry::Size{10, 10}));
+    auto list = bypassable_list;
+    list.push_back({{display_area.top_left, {10, 10}}, {{0, 0}, {10, 10}}, window_framebuffer});
+
+    ON_CALL(*mock_kms_output, overlay_plane_count()).WillByDefault(Return(1));
+    ON_CALL(*mock_kms_output, can_show_overlays(_)).WillByDefault(Return(false));
+
+    graphics::gbm::DisplaySink sink(
+        drm_fd,
+        gbm,
+        graphics::gbm::BypassOption::allowed,
+        null_display_report(),
+        {mock_kms_output},
+        display_area,
+        identity);
+
+    EXPECT_FALSE(sink.overlay(list));
+}
+
+TEST_F(MesaDisplaySinkTest, scaled_elements_are_not_overlaid)
+{
+    auto const window_framebuffer = std::make_shared<NiceMock<MockKMSFramebuffer>>();
+    ON_CALL(*window_framebuffer, size()).WillByDefault(Return(geometry::Size{10, 10}));
+    auto list = bypassable_list;
+    list.push_back({{display_area.top_left, {20, 20}}, {{0, 0}, {10, 10}}, window_framebuffer});
+
+    ON_CALL(*mock_kms_output, overlay_plane_count()).WillByDefault(Return(1));
+    ON_CALL(*mock_kms_output, can_show_overlays(_)).WillByDefault(Return(true));
+
+    graphics::gbm::DisplaySink sink(
+        drm_fd,
+        gbm,
+        graphics::gbm::BypassOption::allowed,
+        null_display_report(),
+        {mock_kms_output},
+        display_area,
+        identity);
+
+    EXPECT_FALSE(sink.overlay(list));
+}
+
+TEST_F(MesaDisplaySinkTest, topmost_elements_that_fit_on_planes_are_shown_above_next_image)
+{
+    auto const lower_framebuffer = std::make_shared<NiceMock<MockKMSFramebuffer>>();
+    auto const upper_framebuffer = std::make_shared<NiceMock<MockKMSFramebuffer>>();
+    ON_CALL(*lower_framebuffer, size()).WillByDefault(Return(geometry::Size{10, 10}));
+    ON_CALL(*upper_framebuffer, size()).WillByDefault(Return(geometry::Size{10, 10}));
+    std::vector<mir::graphics::DisplayElement> const elements{
+        {{display_area.top_left, {10, 10}}, {{0, 0}, {10, 10}}, lower_framebuffer},
+        {{display_area.top_left, {10, 10}}, {{0, 0}, {10, 10}}, upper_framebuffer}};
+
+    ON_CALL(*mock_kms_output, overlay_plane_count()).WillByDefault(Return(1));
+    ON_CALL(*mock_kms_output, can_show_overlays(_)).WillByDefault(Return(true));
+
+    graphics::gbm::DisplaySink sink(
+        drm_fd,
+        gbm,
+        graphics::gbm::BypassOption::allowed,
+        null_display_report(),
+        {mock_kms_output},
+        display_area,
+        identity);
+
+    std::vector<KMSOverlay> overlays;
+    EXPECT_CALL(*mock_kms_output, set_overlays(_))
+        .WillOnce(SaveArg<0>(&overlays));
+
+    EXPECT_THAT(sink.overlay_above_next_image(elements), Eq(1u));
+
+    auto composited = std::make_unique<NiceMock<MockKMSFramebuffer>>();
+    ON_CALL(*composited, size()).WillByDefault(Return(display_area.size));
+    sink.set_next_image(std::move(composited));
+    sink.post();
+
+    ASSERT_THAT(overlays, SizeIs(1));
+    EXPECT_THAT(overlays[0].fb, Eq(upper_framebuffer));
+}
+
+TEST_F(MesaDisplaySinkTest, nothing_is_shown_above_next_image_without_overlay_planes)
+{
+    auto const window_framebuffer = std::make_shared<NiceMock<MockKMSFramebuffer>>();
+    ON_CALL(*window_framebuffer, size()).WillByDefault(Return(geometry::Size{10, 10}));
+    std::vector<mir::graphics::DisplayElement> const elements{
+        {{display_area.top_left, {10, 10}}, {{0, 0}, {10, 10}}, window_framebuffer}};
+
+    ON_CALL(*mock_kms_output, overlay_plane_count()).WillByDefault(Return(0));
+
+    graphics::gbm::DisplaySink sink(
+        drm_fd,
+        gbm,
+        graphics::gbm::BypassOption::allowed,
+        null_display_report(),
+        {mock_kms_output},
+        display_area,
+        identity);
+
+    EXPECT_THAT(sink.overlay_above_next_image(elements), Eq(0u));
+}
+
 namespace
 {
 template<typename T>
@@ -0,0 +1,187 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/platforms/gbm-kms/server/dmabuf_framebuffer_provider.h"
+#include "kms_framebuffer.h"
+#include "mir/graphics/dmabuf_buffer.h"
+#include "mir/graphics/drm_formats.h"
+#include "mir/test/doubles/mock_buffer.h"
+#include "mir/test/doubles/mock_drm.h"
+#include "mir/test/doubles/mock_gbm.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <drm_fourcc.h>
+#include <gbm.h>
+
+namespace mg = mir::graphics;
+namespace mgg = mir::graphics::gbm;
+namespace mtd = mir::test::doubles;
+namespace geom = mir::geometry;
+
+using namespace testing;
+
+namespace
+{
+class MockDMABufBuffer : public mg::DMABufBuffer
+{
+public:
+    MOCK_METHOD(std::optional<uint64_t>, modifier, (), (const override));
+    MOCK_METHOD(std::vector<PlaneDescriptor> const&, planes, (), (const override));
+    MOCK_METHOD(geom::Size, size, (), (const override));
+    MOCK_METHOD(mg::gl::Texture::Layout, layout, (), (const override));
+    MOCK_METHOD(mg::DRMFormat, format, (), (const override));
+};
+
+MATCHER_P(ImportsWithModifier, modifier, "")
+{
+    auto const data = static_cast<gbm_import_fd_modifier_data const*>(arg);
+    return data->modifier == modifier;
+}
+
+struct DMABufFramebufferProvider : Test
+{
+    DMABufFramebufferProvider()
+    {
+        ON_CALL(mock_gbm, gbm_device_get_fd(_)).WillByDefault(Return(drm_fd));
+        ON_CALL(mock_gbm, gbm_bo_import(_, _, _, _)).WillByDefault(Return(mock_gbm.fake_gbm.bo));
+        ON_CALL(mock_drm, drmModeAddFB2WithModifiers(_, _, _, _, _, _, _, _, _, _))
+            .WillByDefault(DoAll(SetArgPointee<8>(fb_id), Return(0)));
+        ON_CALL(mock_drm, drmModeAddFB2(_, _, _, _, _, _, _, _, _))
+            .WillByDefault(DoAll(SetArgPointee<7>(fb_id), Return(0)));
+
+        ON_CALL(dmabuf, planes()).WillByDefault(ReturnRef(planes));
+        ON_CALL(dmabuf, size()).WillByDefault(Return(size));
+        ON_CALL(dmabuf, format()).WillByDefault(Return(mg::DRMFormat{DRM_FORMAT_XRGB8888}));
+        ON_CALL(dmabuf, modifier()).WillByDefault(Return(DRM_FORMAT_MOD_LINEAR));
+
+        ON_CALL(*buffer, size()).WillByDefault(Return(size));
+        ON_CALL(*buffer, native_buffer_base()).WillByDefault(Return(&dmabuf));
+    }
+
+    int const drm_fd{33};
+    uint32_t const fb_id{0x4b};
+    geom::Size const size{640, 480};
+
+    NiceMock<mtd::MockGBM> mock_gbm;
+    NiceMock<mtd::MockDRM> mock_drm;
+
+    std::vector<mg::DMABufBuffer::PlaneDescriptor> const planes{{mir::Fd{mir::IntOwnedFd{7}}, 2560, 0}};
+    NiceMock<MockDMABufBuffer> dmabuf;
+    std::shared_ptr<NiceMock<mtd::MockBuffer>> buffer{std::make_shared<NiceMock<mtd::MockBuffer>>()};
+
+    std::vector<std::shared_ptr<mg::Buffer>> scanned_out;
+    mgg::DMABufFramebufferProvider provider{
+        std::shared_ptr<gbm_device>{mock_gbm.fake_gbm.device, [](auto) {}},
+        [this](std::shared_ptr<mg::Buffer> const& buffer) { scanned_out.push_back(buffer); }};
+};
+}
+
+TEST_F(DMABufFramebufferProvider, buffer_that_is_not_a_dmabuf_has_no_framebuffer)
+{
+    ON_CALL(*buffer, native_buffer_base()).WillByDefault(Return(nullptr));
+
+    EXPECT_CALL(mock_gbm, gbm_bo_import(_, _, _, _)).Times(0);
+
+    EXPECT_THAT(provider.buffer_to_framebuffer(buffer), IsNull());
+    EXPECT_THAT(scanned_out, IsEmpty());
+}
+
+TEST_F(DMABufFramebufferProvider, dmabuf_is_imported_for_scanout_as_a_kms_framebuffer)
+{
+    EXPECT_CALL(
+        mock_gbm,
+        gbm_bo_import(mock_gbm.fake_gbm.device, GBM_BO_IMPORT_FD_MODIFIER, ImportsWithModifier(DRM_FORMAT_MOD_LINEAR), GBM_BO_USE_SCANOUT));
+    EXPECT_CALL(
+        mock_drm,
+        drmModeAddFB2WithModifiers(drm_fd, 640, 480, DRM_FORMAT_XRGB8888, _, _, _, _, _, DRM_MODE_FB_MODIFIERS));
+
+    auto const fb = provider.buffer_to_framebuffer(buffer);
+
+    ASSERT_THAT(fb, NotNull());
+    auto const& kms_fb = dynamic_cast<mg::FBHandle const&>(*fb);
+    EXPECT_THAT(static_cast<uint32_t>(kms_fb), Eq(fb_id));
+    EXPECT_THAT(kms_fb.size(), Eq(size));
+}
+
+TEST_F(DMABufFramebufferProvider, dmabuf_without_a_modifier_is_added_without_one)
+{
+    ON_CALL(dmabuf, modifier()).WillByDefault(Return(std::nullopt));
+
+    EXPECT_CALL(mock_gbm, gbm_bo_import(_, _, ImportsWithModifier(DRM_FORMAT_MOD_INVALID), _));
+    EXPECT_CALL(mock_drm, drmModeAddFB2WithModifiers(_, _, _, _, _, _, _, _, _, _)).Times(0);
+    EXPECT_CALL(mock_drm, drmModeAddFB2(drm_fd, 640, 480, DRM_FORMAT_XRGB8888, _, _, _, _, 0));
+
+    EXPECT_THAT(provider.buffer_to_framebuffer(buffer), NotNull());
+}
+
+TEST_F(DMABufFramebufferProvider, scanned_out_buffer_is_marked_consumed)
+{
+    auto const fb = provider.buffer_to_framebuffer(buffer);
+
+    EXPECT_THAT(scanned_out, ElementsAre(buffer));
+}
+
+TEST_F(DMABufFramebufferProvider, buffer_is_imported_once_for_all_its_frames)
+{
+    EXPECT_CALL(mock_gbm, gbm_bo_import(_, _, _, _)).Times(1);
+    EXPECT_CALL(mock_drm, drmModeAddFB2WithModifiers(_, _, _, _, _, _, _, _, _, _)).Times(1);
+
+    auto const first = provider.buffer_to_framebuffer(buffer);
+    auto const second = provider.buffer_to_framebuffer(buffer);
+
+    ASSERT_THAT(second, NotNull());
+    EXPECT_THAT(static_cast<uint32_t>(dynamic_cast<mg::FBHandle const&>(*second)), Eq(fb_id));
+}
+
+TEST_F(DMABufFramebufferProvider, buffer_the_display_cannot_import_is_not_retried)
+{
+    EXPECT_CALL(mock_gbm, gbm_bo_import(_, _, _, _)).WillOnce(Return(nullptr));
+
+    EXPECT_THAT(provider.buffer_to_framebuffer(buffer), IsNull());
+    EXPECT_THAT(provider.buffer_to_framebuffer(buffer), IsNull());
+    EXPECT_THAT(scanned_out, IsEmpty());
+}
+
+TEST_F(DMABufFramebufferProvider, failing_to_add_the_framebuffer_releases_the_import)
+{
+    ON_CALL(mock_drm, drmModeAddFB2WithModifiers(_, _, _, _, _, _, _, _, _, _)).WillByDefault(Return(-EINVAL));
+
+    EXPECT_CALL(mock_gbm, gbm_bo_destroy(mock_gbm.fake_gbm.bo));
+
+    EXPECT_THAT(provider.buffer_to_framebuffer(buffer), IsNull());
+}
+
+TEST_F(DMABufFramebufferProvider, framebuffer_is_removed_once_its_buffer_is_gone)
+{
+    auto fb = provider.buffer_to_framebuffer(buffer);
+    scanned_out.clear();
+
+    EXPECT_CALL(mock_drm, drmModeRmFB(_, _)).Times(0);
+    EXPECT_CALL(mock_gbm, gbm_bo_destroy(_)).Times(0);
+    // The framebuffer keeps the buffer alive while it might be on screen
+    buffer.reset();
+    fb.reset();
+    Mock::VerifyAndClearExpectations(&mock_drm);
+    Mock::VerifyAndClearExpectations(&mock_gbm);
+
+    EXPECT_CALL(mock_drm, drmModeRmFB(drm_fd, fb_id));
+    EXPECT_CALL(mock_gbm, gbm_bo_destroy(mock_gbm.fake_gbm.bo));
+
+    auto const other_buffer = std::make_shared<NiceMock<mtd::MockBuffer>>();
+    provider.buffer_to_framebuffer(other_buffer);
+}
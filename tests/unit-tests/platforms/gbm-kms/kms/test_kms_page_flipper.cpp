@@ -126,6 +126,94 @@ TEST_F(KMSPageFlipperTest, wait_for_flip_handles_drm_event)
     page_flipper.wait_for_flip(crtc_id);
 }
 
+TEST_F(KMSPageFlipperTest, flip_completed_handles_drm_event_without_blocking)
+{
+    using namespace testing;
+
+    uint32_t const crtc_id{10};
+    uint32_t const fb_id{101};
+    uint32_t const connector_id{345};
+    void* user_data{nullptr};
+
+    EXPECT_CALL(mock_drm, drmModePageFlip(drm_fd, crtc_id, fb_id, _, _))
+        .Times(1)
+        .WillOnce(DoAll(SaveArg<4>(&user_data), Return(0)));
+
+    EXPECT_CALL(mock_drm, drmHandleEvent(drm_fd, _))
+        .Times(1)
+        .WillOnce(DoAll(InvokePageFlipHandler(&user_data), Return(0)));
+
+    page_flipper.schedule_flip(crtc_id, fb_id, connector_id);
+
+    /* No event yet, so the flip is still pending */
+    EXPECT_FALSE(page_flipper.flip_completed(crtc_id));
+
+    /* Fake a DRM event */
+    mock_drm.generate_event_on(drm_device);
+
+    EXPECT_TRUE(page_flipper.flip_completed(crtc_id));
+}
+
+TEST_F(KMSPageFlipperTest, schedule_atomic_flip_commits_request_without_blocking)
+{
+    using namespace testing;
+
+    uint32_t const crtc_id{10};
+    uint32_t const connector_id{345};
+    auto const request = drmModeAtomicAlloc();
+
+    EXPECT_CALL(mock_drm, drmModeAtomicCommit(drm_fd, request, DRM_MODE_ATOMIC_NONBLOCK | DRM_MODE_PAGE_FLIP_EVENT, NotNull()))
+        .Times(1);
+
+    EXPECT_TRUE(page_flipper.schedule_atomic_flip(crtc_id, request, connector_id));
+
+    drmModeAtomicFree(request);
+}
+
+TEST_F(KMSPageFlipperTest, wait_for_flip_handles_drm_event_of_atomic_flip)
+{
+    using namespace testing;
+
+    uint32_t const crtc_id{10};
+    uint32_t const connector_id{345};
+    void* user_data{nullptr};
+    auto const request = drmModeAtomicAlloc();
+
+    EXPECT_CALL(mock_drm, drmModeAtomicCommit(drm_fd, request, _, _))
+        .Times(1)
+        .WillOnce(DoAll(SaveArg<3>(&user_data), Return(0)));
+
+    EXPECT_CALL(mock_drm, drmHandleEvent(drm_fd, _))
+        .Times(1)
+        .WillOnce(DoAll(InvokePageFlipHandler(&user_data), Return(0)));
+
+    page_flipper.schedule_atomic_flip(crtc_id, request, connector_id);
+
+    /* Fake a DRM event */
+    mock_drm.generate_event_on(drm_device);
+
+    page_flipper.wait_for_flip(crtc_id);
+
+    drmModeAtomicFree(request);
+}
+
+TEST_F(KMSPageFlipperTest, failed_atomic_flip_is_not_pending)
+{
+    using namespace testing;
+
+    uint32_t const crtc_id{10};
+    uint32_t const connector_id{345};
+    auto const request = drmModeAtomicAlloc();
+
+    EXPECT_CALL(mock_drm, drmModeAtomicCommit(drm_fd, request, _, _))
+        .WillOnce(Return(-EBUSY));
+
+    EXPECT_FALSE(page_flipper.schedule_atomic_flip(crtc_id, request, connector_id));
+    EXPECT_NO_THROW(page_flipper.schedule_flip(crtc_id, 101, connector_id));
+
+    drmModeAtomicFree(request);
+}
+
 TEST_F(KMSPageFlipperTest, wait_for_flip_reports_vsync)
 {
     using namespace testing;
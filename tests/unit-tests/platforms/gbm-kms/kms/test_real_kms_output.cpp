@@ -45,14 +45,20 @@ class NullPageFlipper : public mgg::PageFlipper
 {
 public:
     bool schedule_flip(uint32_t,uint32_t,uint32_t) override { return true; }
+    bool schedule_async_flip(uint32_t,uint32_t,uint32_t) override { return true; }
+    bool schedule_atomic_flip(uint32_t,drmModeAtomicReq*,uint32_t) override { return true; }
     mg::Frame wait_for_flip(uint32_t) override { return {}; }
+    bool flip_completed(uint32_t) override { return true; }
 };
 
 class MockPageFlipper : public mgg::PageFlipper
 {
 public:
     MOCK_METHOD3(schedule_flip, bool(uint32_t,uint32_t,uint32_t));
+    MOCK_METHOD3(schedule_async_flip, bool(uint32_t,uint32_t,uint32_t));
+    MOCK_METHOD3(schedule_atomic_flip, bool(uint32_t,drmModeAtomicReq*,uint32_t));
     MOCK_METHOD1(wait_for_flip, mg::Frame(uint32_t));
+    MOCK_METHOD1(flip_completed, bool(uint32_t));
 };
 
 class MockKMSFramebuffer : public mg::FBHandle
@@ -555,3 +561,77 @@ TEST_F(RealKMSOutputTest, drm_set_gamma_failure_does_not_throw)
 
     EXPECT_NO_THROW(output.set_gamma(gamma););
 }
+
+TEST_F(RealKMSOutputTest, offers_no_overlay_planes)
+{
+    using namespace testing;
+
+    setup_outputs_connected_crtc();
+
+    mgg::RealKMSOutput output{
+        drm_fd,
+        mg::kms::get_connector(drm_fd, connector_ids[0]),
+        mt::fake_shared(mock_page_flipper)};
+
+    auto const fb = std::make_shared<MockKMSFramebuffer>(uint32_t{42});
+    std::vector<mgg::KMSOverlay> const overlay{{fb, {{0, 0}, {10, 10}}, {{0, 0}, {10, 10}}}};
+
+    EXPECT_THAT(output.overlay_plane_count(), Eq(0u));
+    EXPECT_FALSE(output.can_show_overlays(overlay));
+    EXPECT_TRUE(output.can_show_overlays({}));
+    EXPECT_NO_THROW(output.set_overlays({}));
+}
+
+TEST_F(RealKMSOutputTest, tearing_flips_asynchronously_if_driver_supports_it)
+{
+    using namespace testing;
+
+    setup_outputs_connected_crtc();
+
+    ON_CALL(mock_drm, drmGetCap(_, DRM_CAP_ASYNC_PAGE_FLIP, _))
+        .WillByDefault(DoAll(SetArgPointee<2>(1), Return(0)));
+
+    uint32_t const fb_id{42};
+    auto const fb = std::make_shared<MockKMSFramebuffer>(fb_id);
+
+    mgg::RealKMSOutput output{
+        drm_fd,
+        mg::kms::get_connector(drm_fd, connector_ids[0]),
+        mt::fake_shared(mock_page_flipper)};
+
+    EXPECT_TRUE(output.set_crtc(*fb));
+
+    EXPECT_CALL(mock_page_flipper, schedule_async_flip(crtc_ids[0], fb_id, connector_ids[0]))
+        .WillOnce(Return(true));
+    EXPECT_CALL(mock_page_flipper, schedule_flip(_, _, _)).Times(0);
+
+    output.set_tearing(true);
+    EXPECT_TRUE(output.schedule_page_flip(*fb));
+}
+
+TEST_F(RealKMSOutputTest, tearing_falls_back_to_vsync_if_driver_cannot_flip_asynchronously)
+{
+    using namespace testing;
+
+    setup_outputs_connected_crtc();
+
+    ON_CALL(mock_drm, drmGetCap(_, DRM_CAP_ASYNC_PAGE_FLIP, _))
+        .WillByDefault(DoAll(SetArgPointee<2>(0), Return(0)));
+
+    uint32_t const fb_id{42};
+    auto const fb = std::make_shared<MockKMSFramebuffer>(fb_id);
+
+    mgg::RealKMSOutput output{
+        drm_fd,
+        mg::kms::get_connector(drm_fd, connector_ids[0]),
+        mt::fake_shared(mock_page_flipper)};
+
+    EXPECT_TRUE(output.set_crtc(*fb));
+
+    EXPECT_CALL(mock_page_flipper, schedule_async_flip(_, _, _)).Times(0);
+    EXPECT_CALL(mock_page_flipper, schedule_flip(crtc_ids[0], fb_id, connector_ids[0]))
+        .WillOnce(Return(true));
+
+    output.set_tearing(true);
+    EXPECT_TRUE(output.schedule_page_flip(*fb));
+}
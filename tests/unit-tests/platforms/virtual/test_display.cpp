@@ -19,9 +19,13 @@
 
 #include "src/platforms/virtual/display.h"
 #include "src/platforms/virtual/platform.h"
+#include "src/server/report/null/display_report.h"
 
 #include "mir/graphics/display_configuration.h"
 #include "mir/graphics/default_display_configuration_policy.h"
+#include "mir/graphics/display_sink.h"
+#include "mir/graphics/platform.h"
+#include "mir/renderer/sw/pixel_source.h"
 
 #include "mir/test/doubles/null_display_configuration_policy.h"
 #include "mir/test/doubles/mock_egl.h"
@@ -48,7 +52,7 @@ public:
 
     std::shared_ptr<mgv::Display> create_display(std::vector<mgv::VirtualOutputConfig> sizes)
     {
-        return std::make_shared<mgv::Display>(sizes);
+        return std::make_shared<mgv::Display>(sizes, std::make_shared<mir::report::null::DisplayReport>());
     }
 
     mtd::NullDisplayConfigurationPolicy null_display_configuration_policy;
@@ -106,7 +110,7 @@ TEST_F(VirtualDisplayTest, reports_multiple_outputs_when_provided_multiple_outpu
     EXPECT_THAT(output_count, Eq(2));
 }
 
-TEST_F(VirtualDisplayTest, for_each_display_group_iterates_no_display_groups)
+TEST_F(VirtualDisplayTest, for_each_display_group_iterates_a_display_group_per_output)
 {
     auto display = create_display({
         mgv::VirtualOutputConfig({Size{1280, 1024}}),
@@ -119,7 +123,95 @@ TEST_F(VirtualDisplayTest, for_each_display_group_iterates_no_display_groups)
         count++;
     });
 
-    EXPECT_THAT(count, Eq(0));
+    EXPECT_THAT(count, Eq(2));
+}
+
+TEST_F(VirtualDisplayTest, display_sinks_cover_their_outputs)
+{
+    auto display = create_display({
+        mgv::VirtualOutputConfig({Size{1280, 1024}}),
+        mgv::VirtualOutputConfig({Size{800, 600}})
+    });
+
+    {
+        auto const conf = display->configuration();
+        mg::SideBySideDisplayConfigurationPolicy{}.apply_to(*conf);
+        display->configure(*conf);
+    }
+
+    std::vector<Rectangle> view_areas;
+    display->for_each_display_sync_group([&](mg::DisplaySyncGroup& group)
+        {
+            group.for_each_display_sink([&](mg::DisplaySink& sink) { view_areas.push_back(sink.view_area()); });
+        });
+
+    EXPECT_THAT(view_areas, ElementsAre(Rectangle{{0, 0}, {1280, 1024}}, Rectangle{{1280, 0}, {800, 600}}));
+}
+
+TEST_F(VirtualDisplayTest, display_sinks_provide_cpu_addressable_framebuffers_of_the_output_size)
+{
+    auto display = create_display({mgv::VirtualOutputConfig({Size{640, 480}})});
+
+    display->for_each_display_sync_group([&](mg::DisplaySyncGroup& group)
+        {
+            group.for_each_display_sink([&](mg::DisplaySink& sink)
+                {
+                    auto const allocator = sink.acquire_compatible_allocator<mg::CPUAddressableDisplayAllocator>();
+                    ASSERT_THAT(allocator, NotNull());
+                    EXPECT_THAT(allocator->output_size(), Eq(Size{640, 480}));
+
+                    auto const fb = allocator->alloc_fb(allocator->supported_formats().front());
+                    auto const mapping = fb->map_writeable();
+                    EXPECT_THAT(mapping->size(), Eq(Size{640, 480}));
+                    EXPECT_THAT(mapping->len(), Ge(640u * 480u * 4u));
+                });
+        });
+}
+
+TEST_F(VirtualDisplayTest, reused_framebuffers_report_their_age)
+{
+    auto display = create_display({mgv::VirtualOutputConfig({Size{640, 480}})});
+
+    std::vector<int> ages;
+    display->for_each_display_sync_group([&](mg::DisplaySyncGroup& group)
+        {
+            group.for_each_display_sink([&](mg::DisplaySink& sink)
+                {
+                    auto const allocator = sink.acquire_compatible_allocator<mg::CPUAddressableDisplayAllocator>();
+                    auto const format = allocator->supported_formats().front();
+                    for (auto i = 0; i != 4; ++i)
+                    {
+                        auto fb = allocator->alloc_fb(format);
+                        ages.push_back(fb->buffer_age());
+                        sink.set_next_image(std::move(fb));
+                    }
+                });
+        });
+
+    // The framebuffer last set as the next image is still held, so frames alternate between two
+    EXPECT_THAT(ages, ElementsAre(0, 0, 2, 2));
+}
+
+TEST_F(VirtualDisplayTest, post_waits_for_the_next_simulated_refresh)
+{
+    auto display = create_display({mgv::VirtualOutputConfig({Size{640, 480}}, {100.0})});
+
+    display->for_each_display_sync_group([&](mg::DisplaySyncGroup& group)
+        {
+            EXPECT_THAT(group.frame_budget(), Eq(std::chrono::milliseconds{10}));
+
+            group.post();
+            auto const first = group.last_presentation();
+            group.post();
+            auto const second = group.last_presentation();
+
+            ASSERT_THAT(first, Ne(std::nullopt));
+            ASSERT_THAT(second, Ne(std::nullopt));
+            EXPECT_THAT(second->frame.msc, Gt(first->frame.msc));
+            EXPECT_THAT(
+                second->frame.ust - first->frame.ust,
+                Eq(std::chrono::milliseconds{10} * (second->frame.msc - first->frame.msc)));
+        });
 }
 
 }
@@ -172,7 +264,7 @@ TEST_F(VirtualDisplayTest, displays_can_be_inverted)
     EXPECT_THAT(orientations, ElementsAre(mir_orientation_inverted, mir_orientation_inverted));
 }
 
-TEST_F(VirtualDisplayTest, displays_can_be_resized_without_reallocating_buffers)
+TEST_F(VirtualDisplayTest, displays_can_be_resized)
 {
     auto display = create_display({
         mgv::VirtualOutputConfig({Size{1280, 1024}, Size{640, 512}}),
@@ -190,8 +282,8 @@ TEST_F(VirtualDisplayTest, displays_can_be_resized_without_reallocating_buffers)
                 }
             });
 
-        // This may seem unexpected, but there are no buffers for this platform
-        EXPECT_THAT(display->apply_if_configuration_preserves_display_buffers(*conf), IsTrue());
+        // The framebuffers are the size of the mode, so must be reallocated
+        EXPECT_THAT(display->apply_if_configuration_preserves_display_buffers(*conf), IsFalse());
         display->configure(*conf);
     }
 
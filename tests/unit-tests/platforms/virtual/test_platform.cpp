@@ -68,6 +68,22 @@ TEST_F(VirtualGraphicsPlatformTest, multiple_output_sizes_are_set_correctly_when
         mgv::VirtualOutputConfig(std::vector<geom::Size>{geom::Size{1280, 1024}, geom::Size{800, 600}})));
 }
 
+TEST_F(VirtualGraphicsPlatformTest, refresh_rates_are_set_when_provided)
+{
+    auto config = mgv::Platform::parse_output_sizes({"1280x1024@144:800x600"});
+    EXPECT_THAT(config, ElementsAre(
+        mgv::VirtualOutputConfig(
+            std::vector<geom::Size>{geom::Size{1280, 1024}, geom::Size{800, 600}},
+            std::vector<double>{144.0, mgv::VirtualOutputConfig::default_refresh_rate})));
+}
+
+TEST_F(VirtualGraphicsPlatformTest, refresh_rate_parsing_throws_on_bad_input)
+{
+    EXPECT_THROW(mgv::Platform::parse_output_sizes({"1280x1024@"}), std::runtime_error) << "No refresh rate";
+    EXPECT_THROW(mgv::Platform::parse_output_sizes({"1280x1024@fast"}), std::runtime_error) << "Not a number";
+    EXPECT_THROW(mgv::Platform::parse_output_sizes({"1280x1024@0"}), std::runtime_error) << "Zero";
+}
+
 TEST_F(VirtualGraphicsPlatformTest, can_acquire_interface_for_cpu_addressable_display_provider)
 {
     auto platform = create_platform();
@@ -15,6 +15,14 @@
  */
 
 #include <stdexcept>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <set>
+#include <system_error>
+#include <stdlib.h>
+#include <GLES2/gl2ext.h>
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
 #include <mir/geometry/rectangle.h>
@@ -35,6 +43,7 @@ using testing::ReturnRef;
 using testing::Pointee;
 using testing::AnyNumber;
 using testing::AtLeast;
+using testing::Eq;
 using testing::DoAll;
 using testing::_;
 
@@ -436,3 +445,462 @@ TEST_F(GLRenderer, sets_viewport_downscaled_wide)
     mrg::Renderer renderer(gl_platform, std::move(output_surface));
     renderer.set_viewport(view_area);
 }
+
+TEST_F(GLRenderer, limits_repaint_to_damage_when_buffer_holds_previous_frame)
+{
+    mir::geometry::Rectangle const view_area{{0, 0}, {128, 128}};
+
+    auto output_surface = make_output_surface();
+    ON_CALL(*output_surface, size())
+        .WillByDefault(Return(mir::geometry::Size{128, 128}));
+    ON_CALL(*output_surface, buffer_age())
+        .WillByDefault(Return(1));
+
+    mrg::Renderer renderer(gl_platform, std::move(output_surface));
+    renderer.set_viewport(view_area);
+
+    // The first frame is always repainted in full
+    EXPECT_CALL(mock_gl, glScissor(_, _, _, _)).Times(0);
+    renderer.render(renderable_list);
+    testing::Mock::VerifyAndClearExpectations(&mock_gl);
+
+    // Rounded outwards and padded by a pixel, with GL's bottom-left origin
+    EXPECT_CALL(mock_gl, glEnable(GL_SCISSOR_TEST));
+    EXPECT_CALL(mock_gl, glScissor(15, 79, 34, 34));
+    renderer.set_damage({{{16, 16}, {32, 32}}});
+    renderer.render(renderable_list);
+}
+
+TEST_F(GLRenderer, tells_output_surface_the_repainted_area_before_commit)
+{
+    mir::geometry::Rectangle const view_area{{0, 0}, {128, 128}};
+
+    auto output_surface = make_output_surface();
+    ON_CALL(*output_surface, size())
+        .WillByDefault(Return(mir::geometry::Size{128, 128}));
+    ON_CALL(*output_surface, buffer_age())
+        .WillByDefault(Return(1));
+    auto& surface = *output_surface;
+
+    mrg::Renderer renderer(gl_platform, std::move(output_surface));
+    renderer.set_viewport(view_area);
+
+    {
+        InSequence seq;
+        EXPECT_CALL(surface, set_damage(Eq(std::nullopt)));
+        EXPECT_CALL(surface, commit());
+    }
+    renderer.render(renderable_list);
+    testing::Mock::VerifyAndClearExpectations(&surface);
+
+    {
+        InSequence seq;
+        EXPECT_CALL(surface, set_damage(Eq(mir::geometry::Rectangle{{15, 79}, {34, 34}})));
+        EXPECT_CALL(surface, commit());
+    }
+    renderer.set_damage({{{16, 16}, {32, 32}}});
+    renderer.render(renderable_list);
+}
+
+TEST_F(GLRenderer, repaints_everything_when_buffer_age_is_unknown)
+{
+    mir::geometry::Rectangle const view_area{{0, 0}, {128, 128}};
+
+    auto output_surface = make_output_surface();
+    ON_CALL(*output_surface, size())
+        .WillByDefault(Return(mir::geometry::Size{128, 128}));
+    ON_CALL(*output_surface, buffer_age())
+        .WillByDefault(Return(0));
+
+    mrg::Renderer renderer(gl_platform, std::move(output_surface));
+    renderer.set_viewport(view_area);
+    renderer.render(renderable_list);
+
+    EXPECT_CALL(mock_gl, glScissor(_, _, _, _)).Times(0);
+    renderer.set_damage({{{16, 16}, {32, 32}}});
+    renderer.render(renderable_list);
+}
+
+TEST_F(GLRenderer, repaints_older_buffers_in_full_after_the_output_transform_changes)
+{
+    mir::geometry::Rectangle const view_area{{0, 0}, {128, 128}};
+
+    auto output_surface = make_output_surface();
+    ON_CALL(*output_surface, size())
+        .WillByDefault(Return(mir::geometry::Size{128, 128}));
+    ON_CALL(*output_surface, buffer_age())
+        .WillByDefault(Return(2));
+
+    mrg::Renderer renderer(gl_platform, std::move(output_surface));
+    renderer.set_viewport(view_area);
+    renderer.render(renderable_list);
+    renderer.set_damage({{{16, 16}, {32, 32}}});
+    renderer.render(renderable_list);
+
+    renderer.set_output_transform(glm::mat2{-1, 0, 0, -1});
+    renderer.set_damage({{{16, 16}, {32, 32}}});
+    renderer.render(renderable_list);
+
+    // The back buffer was last drawn with the old transform
+    EXPECT_CALL(mock_gl, glScissor(_, _, _, _)).Times(0);
+    renderer.set_damage({{{16, 16}, {32, 32}}});
+    renderer.render(renderable_list);
+}
+
+TEST_F(GLRenderer, uploads_all_vertices_of_a_frame_at_once)
+{
+    auto const second = std::make_shared<testing::NiceMock<mtd::MockRenderable>>();
+    ON_CALL(*second, buffer()).WillByDefault(Return(mock_buffer));
+    ON_CALL(*second, alpha()).WillByDefault(Return(1.0f));
+    ON_CALL(*second, transformation()).WillByDefault(Return(trans));
+    ON_CALL(*second, screen_position()).WillByDefault(Return(mir::geometry::Rectangle{{5, 6}, {7, 8}}));
+    renderable_list.push_back(second);
+
+    EXPECT_CALL(mock_gl, glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(8 * sizeof(mir::gl::Vertex)), _, _));
+    {
+        InSequence seq;
+        EXPECT_CALL(mock_gl, glDrawArrays(_, 0, 4));
+        EXPECT_CALL(mock_gl, glDrawArrays(_, 4, 4));
+    }
+
+    mrg::Renderer renderer(gl_platform, make_output_surface());
+    renderer.render(renderable_list);
+}
+
+TEST_F(GLRenderer, only_sets_state_that_changes_between_renderables)
+{
+    auto const second = std::make_shared<testing::NiceMock<mtd::MockRenderable>>();
+    ON_CALL(*second, buffer()).WillByDefault(Return(mock_buffer));
+    ON_CALL(*second, alpha()).WillByDefault(Return(1.0f));
+    ON_CALL(*second, transformation()).WillByDefault(Return(glm::mat4{1}));
+    ON_CALL(*second, screen_position()).WillByDefault(Return(mir::geometry::Rectangle{{5, 6}, {7, 8}}));
+    EXPECT_CALL(*renderable, transformation()).WillRepeatedly(Return(glm::mat4{1}));
+    renderable_list.push_back(second);
+
+    EXPECT_CALL(mock_gl, glUseProgram(_)).Times(1);
+    EXPECT_CALL(mock_gl, glDisable(GL_BLEND)).Times(1);
+    // The two screen-wide matrices, and the transformation both renderables share
+    EXPECT_CALL(mock_gl, glUniformMatrix4fv(_, _, GL_FALSE, _)).Times(3);
+    EXPECT_CALL(mock_gl, glDrawArrays(_, _, _)).Times(2);
+
+    mrg::Renderer renderer(gl_platform, make_output_surface());
+    renderer.render(renderable_list);
+}
+
+namespace
+{
+/// The GL_EXT_disjoint_timer_query entry points, which the renderer looks up with eglGetProcAddress()
+class MockTimerQueries
+{
+public:
+    MOCK_METHOD(void, gen_queries, (GLsizei n, GLuint* ids));
+    MOCK_METHOD(void, delete_queries, (GLsizei n, GLuint const* ids));
+    MOCK_METHOD(void, begin_query, (GLenum target, GLuint id));
+    MOCK_METHOD(void, end_query, (GLenum target));
+    MOCK_METHOD(void, get_query_object_uiv, (GLuint id, GLenum pname, GLuint* params));
+    MOCK_METHOD(void, get_query_object_ui64v, (GLuint id, GLenum pname, GLuint64* params));
+};
+
+MockTimerQueries* timer_queries{nullptr};
+
+void fake_glGenQueriesEXT(GLsizei n, GLuint* ids) { timer_queries->gen_queries(n, ids); }
+void fake_glDeleteQueriesEXT(GLsizei n, GLuint const* ids) { timer_queries->delete_queries(n, ids); }
+void fake_glBeginQueryEXT(GLenum target, GLuint id) { timer_queries->begin_query(target, id); }
+void fake_glEndQueryEXT(GLenum target) { timer_queries->end_query(target); }
+void fake_glGetQueryObjectuivEXT(GLuint id, GLenum pname, GLuint* params)
+{
+    timer_queries->get_query_object_uiv(id, pname, params);
+}
+void fake_glGetQueryObjectui64vEXT(GLuint id, GLenum pname, GLuint64* params)
+{
+    timer_queries->get_query_object_ui64v(id, pname, params);
+}
+
+class GLRendererWithTimerQueries : public GLRenderer
+{
+public:
+    GLRendererWithTimerQueries()
+    {
+        using namespace testing;
+        using func_ptr_t = mtd::MockEGL::generic_function_pointer_t;
+
+        timer_queries = &queries;
+
+        ON_CALL(mock_gl, glGetString(GL_EXTENSIONS))
+            .WillByDefault(Return(reinterpret_cast<GLubyte const*>("GL_OES_EGL_image GL_EXT_disjoint_timer_query")));
+        ON_CALL(mock_egl, eglGetProcAddress(StrEq("glGenQueriesEXT")))
+            .WillByDefault(Return(reinterpret_cast<func_ptr_t>(&fake_glGenQueriesEXT)));
+        ON_CALL(mock_egl, eglGetProcAddress(StrEq("glDeleteQueriesEXT")))
+            .WillByDefault(Return(reinterpret_cast<func_ptr_t>(&fake_glDeleteQueriesEXT)));
+        ON_CALL(mock_egl, eglGetProcAddress(StrEq("glBeginQueryEXT")))
+            .WillByDefault(Return(reinterpret_cast<func_ptr_t>(&fake_glBeginQueryEXT)));
+        ON_CALL(mock_egl, eglGetProcAddress(StrEq("glEndQueryEXT")))
+            .WillByDefault(Return(reinterpret_cast<func_ptr_t>(&fake_glEndQueryEXT)));
+        ON_CALL(mock_egl, eglGetProcAddress(StrEq("glGetQueryObjectuivEXT")))
+            .WillByDefault(Return(reinterpret_cast<func_ptr_t>(&fake_glGetQueryObjectuivEXT)));
+        ON_CALL(mock_egl, eglGetProcAddress(StrEq("glGetQueryObjectui64vEXT")))
+            .WillByDefault(Return(reinterpret_cast<func_ptr_t>(&fake_glGetQueryObjectui64vEXT)));
+
+        ON_CALL(queries, gen_queries(_, _))
+            .WillByDefault(Invoke([](GLsizei n, GLuint* ids)
+                {
+                    for (GLsizei i = 0; i != n; ++i)
+                        ids[i] = first_query + i;
+                }));
+    }
+
+    ~GLRendererWithTimerQueries()
+    {
+        timer_queries = nullptr;
+    }
+
+    /// The GPU finishes each frame it's given in \a elapsed
+    void gpu_finishes_frames_in(std::chrono::nanoseconds elapsed)
+    {
+        using namespace testing;
+        ON_CALL(queries, get_query_object_uiv(_, GL_QUERY_RESULT_AVAILABLE_EXT, _))
+            .WillByDefault(SetArgPointee<2>(GL_TRUE));
+        ON_CALL(queries, get_query_object_ui64v(_, GL_QUERY_RESULT_EXT, _))
+            .WillByDefault(SetArgPointee<2>(static_cast<GLuint64>(elapsed.count())));
+    }
+
+    static constexpr GLuint first_query{100};
+    testing::NiceMock<MockTimerQueries> queries;
+};
+}
+
+TEST_F(GLRenderer, does_not_time_frames_without_timer_queries)
+{
+    EXPECT_CALL(mock_egl, eglGetProcAddress(testing::StrEq("glBeginQueryEXT"))).Times(0);
+
+    mrg::Renderer renderer(gl_platform, make_output_surface());
+    renderer.render(renderable_list);
+    renderer.render(renderable_list);
+
+    EXPECT_THAT(renderer.completed_gpu_time(), Eq(std::nullopt));
+}
+
+TEST_F(GLRendererWithTimerQueries, brackets_each_frame_with_a_time_elapsed_query)
+{
+    {
+        InSequence seq;
+        EXPECT_CALL(queries, begin_query(GL_TIME_ELAPSED_EXT, _));
+        EXPECT_CALL(mock_gl, glDrawArrays(_, _, _));
+        EXPECT_CALL(queries, end_query(GL_TIME_ELAPSED_EXT));
+    }
+
+    mrg::Renderer renderer(gl_platform, make_output_surface());
+    renderer.render(renderable_list);
+}
+
+TEST_F(GLRendererWithTimerQueries, reports_gpu_time_once_the_gpu_has_finished_the_frame)
+{
+    using namespace std::chrono_literals;
+    mrg::Renderer renderer(gl_platform, make_output_surface());
+    renderer.render(renderable_list);
+    EXPECT_THAT(renderer.completed_gpu_time(), Eq(std::nullopt));
+
+    gpu_finishes_frames_in(3ms);
+    renderer.render(renderable_list);
+
+    EXPECT_THAT(renderer.completed_gpu_time(), Eq(3ms));
+    // Each result is only reported once
+    EXPECT_THAT(renderer.completed_gpu_time(), Eq(std::nullopt));
+}
+
+TEST_F(GLRendererWithTimerQueries, does_not_wait_for_results_the_gpu_has_not_finished)
+{
+    EXPECT_CALL(queries, get_query_object_uiv(first_query + 3, GL_QUERY_RESULT_AVAILABLE_EXT, _))
+        .WillRepeatedly(SetArgPointee<2>(GL_FALSE));
+    EXPECT_CALL(queries, get_query_object_ui64v(_, _, _)).Times(0);
+
+    mrg::Renderer renderer(gl_platform, make_output_surface());
+    renderer.render(renderable_list);
+    renderer.render(renderable_list);
+
+    EXPECT_THAT(renderer.completed_gpu_time(), Eq(std::nullopt));
+}
+
+TEST_F(GLRendererWithTimerQueries, discards_results_spanning_a_disjoint_event)
+{
+    using namespace std::chrono_literals;
+    ON_CALL(mock_gl, glGetIntegerv(GL_GPU_DISJOINT_EXT, _))
+        .WillByDefault(SetArgPointee<1>(GL_TRUE));
+    gpu_finishes_frames_in(3ms);
+
+    mrg::Renderer renderer(gl_platform, make_output_surface());
+    renderer.render(renderable_list);
+    renderer.render(renderable_list);
+
+    EXPECT_THAT(renderer.completed_gpu_time(), Eq(std::nullopt));
+}
+
+TEST_F(GLRendererWithTimerQueries, stops_timing_frames_while_every_query_awaits_the_gpu)
+{
+    // Nothing ever becomes available, so the pool of four queries runs dry
+    EXPECT_CALL(queries, begin_query(GL_TIME_ELAPSED_EXT, _)).Times(4);
+    EXPECT_CALL(queries, end_query(GL_TIME_ELAPSED_EXT)).Times(4);
+
+    mrg::Renderer renderer(gl_platform, make_output_surface());
+    for (int i = 0; i != 6; ++i)
+    {
+        renderer.render(renderable_list);
+    }
+}
+
+TEST_F(GLRendererWithTimerQueries, deletes_its_queries)
+{
+    EXPECT_CALL(queries, delete_queries(4, _));
+
+    mrg::Renderer renderer(gl_platform, make_output_surface());
+    renderer.render(renderable_list);
+}
+
+namespace
+{
+/// The GL_OES_get_program_binary entry points, which the renderer looks up with eglGetProcAddress()
+class MockProgramBinaries
+{
+public:
+    MOCK_METHOD(void, get_program_binary, (GLuint program, GLsizei size, GLsizei* length, GLenum* format, void* binary));
+    MOCK_METHOD(void, program_binary, (GLuint program, GLenum format, void const* binary, GLint length));
+};
+
+MockProgramBinaries* program_binaries{nullptr};
+
+void fake_glGetProgramBinaryOES(GLuint program, GLsizei size, GLsizei* length, GLenum* format, void* binary)
+{
+    program_binaries->get_program_binary(program, size, length, format, binary);
+}
+void fake_glProgramBinaryOES(GLuint program, GLenum format, void const* binary, GLint length)
+{
+    program_binaries->program_binary(program, format, binary, length);
+}
+
+class GLRendererWithProgramBinaries : public GLRenderer
+{
+public:
+    GLRendererWithProgramBinaries()
+    {
+        using namespace testing;
+        using func_ptr_t = mtd::MockEGL::generic_function_pointer_t;
+
+        // Can't use std::string, as mkdtemp mutates its argument.
+        char tmp_name[] = "/tmp/mir_gl_renderer_cache_XXXXXX";
+        if (mkdtemp(tmp_name) == NULL)
+        {
+            throw std::system_error{errno, std::system_category(), "Failed to create temporary directory"};
+        }
+        cache_home = tmp_name;
+        if (auto const old_cache_home = getenv("XDG_CACHE_HOME"))
+        {
+            saved_cache_home = old_cache_home;
+        }
+        setenv("XDG_CACHE_HOME", cache_home.c_str(), 1);
+
+        program_binaries = &binaries;
+
+        ON_CALL(mock_gl, glGetString(GL_EXTENSIONS))
+            .WillByDefault(Return(reinterpret_cast<GLubyte const*>("GL_OES_EGL_image GL_OES_get_program_binary")));
+        ON_CALL(mock_gl, glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS_OES, _))
+            .WillByDefault(SetArgPointee<1>(1));
+        ON_CALL(mock_egl, eglGetProcAddress(StrEq("glGetProgramBinaryOES")))
+            .WillByDefault(Return(reinterpret_cast<func_ptr_t>(&fake_glGetProgramBinaryOES)));
+        ON_CALL(mock_egl, eglGetProcAddress(StrEq("glProgramBinaryOES")))
+            .WillByDefault(Return(reinterpret_cast<func_ptr_t>(&fake_glProgramBinaryOES)));
+
+        driver_produces_binary("stale binary");
+    }
+
+    ~GLRendererWithProgramBinaries()
+    {
+        program_binaries = nullptr;
+        if (saved_cache_home)
+        {
+            setenv("XDG_CACHE_HOME", saved_cache_home->c_str(), 1);
+        }
+        else
+        {
+            unsetenv("XDG_CACHE_HOME");
+        }
+        std::error_code ignored;
+        std::filesystem::remove_all(cache_home, ignored);
+    }
+
+    /// glGetProgramBinaryOES() hands back \a contents for every program
+    void driver_produces_binary(std::string const& contents)
+    {
+        using namespace testing;
+        ON_CALL(mock_gl, glGetProgramiv(_, GL_PROGRAM_BINARY_LENGTH_OES, _))
+            .WillByDefault(SetArgPointee<2>(static_cast<GLint>(contents.size())));
+        ON_CALL(binaries, get_program_binary(_, _, _, _, _))
+            .WillByDefault(Invoke([contents](GLuint, GLsizei size, GLsizei* length, GLenum* format, void* binary)
+                {
+                    *length = std::min(size, static_cast<GLsizei>(contents.size()));
+                    *format = binary_format;
+                    memcpy(binary, contents.data(), *length);
+                }));
+    }
+
+    /// The contents of every file in the shader cache
+    auto cached_files() const -> std::vector<std::string>
+    {
+        std::vector<std::string> contents;
+        for (auto const& entry : std::filesystem::directory_iterator{cache_home / "mir" / "shaders"})
+        {
+            std::ifstream in{entry.path(), std::ios::binary};
+            contents.emplace_back(std::istreambuf_iterator<char>{in}, std::istreambuf_iterator<char>{});
+        }
+        return contents;
+    }
+
+    static constexpr GLenum binary_format{0x1234};
+    std::filesystem::path cache_home;
+    std::optional<std::string> saved_cache_home;
+    testing::NiceMock<MockProgramBinaries> binaries;
+};
+}
+
+TEST_F(GLRendererWithProgramBinaries, recompiles_and_recaches_programs_whose_cached_binary_the_driver_rejects)
+{
+    using namespace testing;
+
+    // A first run caches the programs it links
+    {
+        mrg::Renderer renderer(gl_platform, make_output_surface());
+        renderer.render(renderable_list);
+    }
+    ASSERT_THAT(cached_files(), Not(IsEmpty()));
+
+    // ...but after an update the driver won't take them back, without the version strings saying so
+    GLuint next_program{stub_program};
+    std::set<GLuint> loaded_from_binary;
+    ON_CALL(mock_gl, glCreateProgram())
+        .WillByDefault(Invoke([&next_program] { return next_program++; }));
+    ON_CALL(mock_gl, glGetProgramiv(_, GL_LINK_STATUS, _))
+        .WillByDefault(Invoke([&loaded_from_binary](GLuint program, GLenum, GLint* status)
+            {
+                *status = loaded_from_binary.contains(program) ? GL_FALSE : GL_TRUE;
+            }));
+    driver_produces_binary("fresh binary");
+
+    EXPECT_CALL(binaries, program_binary(_, binary_format, _, _))
+        .Times(AtLeast(1))
+        .WillRepeatedly(Invoke([&loaded_from_binary](GLuint program, GLenum, void const*, GLint)
+            {
+                loaded_from_binary.insert(program);
+            }));
+    EXPECT_CALL(mock_gl, glCompileShader(_)).Times(AtLeast(1));
+    EXPECT_CALL(mock_gl, glLinkProgram(_)).Times(AtLeast(1));
+
+    {
+        mrg::Renderer renderer(gl_platform, make_output_surface());
+        renderer.render(renderable_list);
+    }
+
+    for (auto const& file : cached_files())
+    {
+        EXPECT_THAT(file, HasSubstr("fresh binary"));
+        EXPECT_THAT(file, Not(HasSubstr("stale binary")));
+    }
+}
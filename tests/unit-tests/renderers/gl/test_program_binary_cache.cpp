@@ -0,0 +1,161 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <src/renderers/gl/program_binary_cache.h>
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <fstream>
+#include <system_error>
+
+#include <stdlib.h>
+
+namespace mrg = mir::renderer::gl;
+namespace fs = std::filesystem;
+
+using namespace testing;
+
+namespace
+{
+struct ProgramBinaryCache : Test
+{
+    ProgramBinaryCache()
+    {
+        // Can't use std::string, as mkdtemp mutates its argument.
+        char tmp_name[] = "/tmp/mir_program_binaries_XXXXXX";
+        if (mkdtemp(tmp_name) == NULL)
+        {
+            throw std::system_error{errno, std::system_category(), "Failed to create temporary directory"};
+        }
+        temporary_directory = tmp_name;
+    }
+
+    ~ProgramBinaryCache()
+    {
+        std::error_code ignored;
+        fs::remove_all(temporary_directory, ignored);
+    }
+
+    fs::path temporary_directory;
+    mrg::ProgramBinaryCache::Binary const binary{0x1234, {'s', 'o', 'm', 'e', '\0', 'b', 'i', 'n'}};
+};
+}
+
+TEST_F(ProgramBinaryCache, returns_stored_binary)
+{
+    mrg::ProgramBinaryCache const cache{temporary_directory};
+
+    cache.store("key", binary);
+    auto const loaded = cache.load("key");
+
+    ASSERT_THAT(loaded, Ne(std::nullopt));
+    EXPECT_THAT(loaded->format, Eq(binary.format));
+    EXPECT_THAT(loaded->data, Eq(binary.data));
+}
+
+TEST_F(ProgramBinaryCache, binaries_persist_between_instances)
+{
+    mrg::ProgramBinaryCache{temporary_directory}.store("key", binary);
+
+    auto const loaded = mrg::ProgramBinaryCache{temporary_directory}.load("key");
+
+    ASSERT_THAT(loaded, Ne(std::nullopt));
+    EXPECT_THAT(loaded->data, Eq(binary.data));
+}
+
+TEST_F(ProgramBinaryCache, does_not_return_binary_for_a_different_key)
+{
+    mrg::ProgramBinaryCache const cache{temporary_directory};
+
+    cache.store("driver 1.0", binary);
+
+    EXPECT_THAT(cache.load("driver 1.1"), Eq(std::nullopt));
+}
+
+TEST_F(ProgramBinaryCache, creates_missing_directory)
+{
+    auto const directory = temporary_directory / "mir" / "shaders";
+    mrg::ProgramBinaryCache const cache{directory};
+
+    cache.store("key", binary);
+
+    EXPECT_TRUE(fs::is_directory(directory));
+    EXPECT_THAT(cache.load("key"), Ne(std::nullopt));
+}
+
+TEST_F(ProgramBinaryCache, ignores_corrupt_files)
+{
+    mrg::ProgramBinaryCache const cache{temporary_directory};
+    cache.store("key", binary);
+
+    for (auto const& entry : fs::directory_iterator{temporary_directory})
+    {
+        fs::resize_file(entry.path(), fs::file_size(entry.path()) - 1);
+    }
+
+    EXPECT_THAT(cache.load("key"), Eq(std::nullopt));
+}
+
+TEST_F(ProgramBinaryCache, ignores_files_whose_binary_length_is_wrong)
+{
+    mrg::ProgramBinaryCache const cache{temporary_directory};
+    cache.store("key", binary);
+
+    // The binary length follows the magic, the key and the format
+    auto const length_offset = sizeof "mir-program-binary-1" + sizeof(uint32_t) + std::string{"key"}.size() + sizeof(uint32_t);
+    for (auto const& entry : fs::directory_iterator{temporary_directory})
+    {
+        std::fstream file{entry.path(), std::ios::binary | std::ios::in | std::ios::out};
+        file.seekp(length_offset);
+        uint64_t const huge_length{0xffffffffffffull};
+        file.write(reinterpret_cast<char const*>(&huge_length), sizeof huge_length);
+    }
+
+    EXPECT_THAT(cache.load("key"), Eq(std::nullopt));
+}
+
+TEST_F(ProgramBinaryCache, removes_files_it_cannot_use)
+{
+    mrg::ProgramBinaryCache const cache{temporary_directory};
+    cache.store("key", binary);
+
+    for (auto const& entry : fs::directory_iterator{temporary_directory})
+    {
+        fs::resize_file(entry.path(), fs::file_size(entry.path()) - 1);
+    }
+    cache.load("key");
+
+    EXPECT_TRUE(fs::is_empty(temporary_directory));
+}
+
+TEST_F(ProgramBinaryCache, removes_file_stored_under_another_key)
+{
+    mrg::ProgramBinaryCache const cache{temporary_directory};
+    cache.store("key", binary);
+
+    // As a file left by a key that hashes the same would be
+    auto const key_offset = sizeof "mir-program-binary-1" + sizeof(uint32_t);
+    for (auto const& entry : fs::directory_iterator{temporary_directory})
+    {
+        std::fstream file{entry.path(), std::ios::binary | std::ios::in | std::ios::out};
+        file.seekp(key_offset);
+        file.write("kex", 3);
+    }
+
+    EXPECT_THAT(cache.load("key"), Eq(std::nullopt));
+    EXPECT_TRUE(fs::is_empty(temporary_directory));
+}
@@ -0,0 +1,358 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <src/renderers/software/renderer.h>
+#include <src/renderers/software/pixel_kernels.h>
+
+#include <mir/graphics/platform.h>
+#include <mir/graphics/buffer_properties.h>
+#include <mir/test/doubles/mock_renderable.h>
+#include <mir/test/doubles/stub_buffer.h>
+#include <mir/test/fake_shared.h>
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <array>
+#include <cstring>
+
+namespace mg = mir::graphics;
+namespace geom = mir::geometry;
+namespace mrs = mir::renderer::software;
+namespace mt = mir::test;
+namespace mtd = mir::test::doubles;
+
+using namespace testing;
+
+namespace
+{
+auto const xrgb_8888 = mg::DRMFormat::from_mir_format(mir_pixel_format_xrgb_8888);
+
+/// Pixel values we compare against have their (undefined) X channel masked off
+uint32_t const rgb_mask = 0x00ffffff;
+
+class StubMappableFB : public mg::CPUAddressableDisplayAllocator::MappableFB
+{
+public:
+    StubMappableFB(std::shared_ptr<mtd::StubBuffer> const& buffer, int age)
+        : buffer{buffer},
+          age{age}
+    {
+    }
+
+    auto size() const -> geom::Size override { return buffer->size(); }
+    auto format() const -> MirPixelFormat override { return buffer->format(); }
+    auto stride() const -> geom::Stride override { return buffer->stride(); }
+    auto map_writeable() -> std::unique_ptr<mir::renderer::software::Mapping<unsigned char>> override
+    {
+        return buffer->map_writeable();
+    }
+    auto buffer_age() const -> int override { return age; }
+
+private:
+    std::shared_ptr<mtd::StubBuffer> const buffer;
+    int const age;
+};
+
+/// Hands out the same framebuffer every frame, as a display with a single buffer would
+class StubAllocator : public mg::CPUAddressableDisplayAllocator
+{
+public:
+    StubAllocator(geom::Size size)
+        : framebuffer{std::make_shared<mtd::StubBuffer>(
+              mg::BufferProperties{size, mir_pixel_format_xrgb_8888, mg::BufferUsage::software})}
+    {
+    }
+
+    auto supported_formats() const -> std::vector<mg::DRMFormat> override
+    {
+        return {xrgb_8888};
+    }
+
+    auto alloc_fb(mg::DRMFormat) -> std::unique_ptr<MappableFB> override
+    {
+        return std::make_unique<StubMappableFB>(framebuffer, std::exchange(age, std::max(age, 1)));
+    }
+
+    auto output_size() const -> geom::Size override
+    {
+        return framebuffer->size();
+    }
+
+    auto pixel(int x, int y) const -> uint32_t
+    {
+        uint32_t value;
+        std::memcpy(
+            &value,
+            framebuffer->written_pixels.data() + y * framebuffer->stride().as_int() + x * sizeof value,
+            sizeof value);
+        return value;
+    }
+
+    void set_pixel(int x, int y, uint32_t value)
+    {
+        std::memcpy(
+            framebuffer->written_pixels.data() + y * framebuffer->stride().as_int() + x * sizeof value,
+            &value,
+            sizeof value);
+    }
+
+    std::shared_ptr<mtd::StubBuffer> const framebuffer;
+    int age{0};
+};
+
+/// Alternates between two framebuffers, as a double-buffered display would
+class DoubleBufferedAllocator : public mg::CPUAddressableDisplayAllocator
+{
+public:
+    DoubleBufferedAllocator(geom::Size size)
+        : buffers{std::make_unique<StubAllocator>(size), std::make_unique<StubAllocator>(size)}
+    {
+    }
+
+    auto supported_formats() const -> std::vector<mg::DRMFormat> override
+    {
+        return {xrgb_8888};
+    }
+
+    auto alloc_fb(mg::DRMFormat format) -> std::unique_ptr<MappableFB> override
+    {
+        auto& next = *buffers[frames++ % 2];
+        if (next.age)
+        {
+            // It holds the frame before last
+            next.age = 2;
+        }
+        return next.alloc_fb(format);
+    }
+
+    auto output_size() const -> geom::Size override
+    {
+        return buffers[0]->output_size();
+    }
+
+    /// The framebuffer the next frame will be drawn into
+    auto next() -> StubAllocator&
+    {
+        return *buffers[frames % 2];
+    }
+
+private:
+    std::array<std::unique_ptr<StubAllocator>, 2> const buffers;
+    int frames{0};
+};
+
+auto solid_buffer(geom::Size size, MirPixelFormat format, uint32_t colour) -> std::shared_ptr<mtd::StubBuffer>
+{
+    auto const buffer = std::make_shared<mtd::StubBuffer>(
+        mg::BufferProperties{size, format, mg::BufferUsage::software});
+    auto const pixels = buffer->written_pixels.size() / sizeof colour;
+    for (size_t i = 0; i != pixels; ++i)
+    {
+        std::memcpy(buffer->written_pixels.data() + i * sizeof colour, &colour, sizeof colour);
+    }
+    return buffer;
+}
+
+struct SoftwareRenderer : Test
+{
+    SoftwareRenderer()
+    {
+        ON_CALL(renderable, buffer()).WillByDefault(Invoke([this] { return buffer; }));
+        ON_CALL(renderable, screen_position()).WillByDefault(Return(geom::Rectangle{{2, 3}, {2, 2}}));
+        ON_CALL(renderable, transformation()).WillByDefault(Return(glm::mat4{1}));
+    }
+
+    geom::Size const output_size{8, 8};
+    StubAllocator allocator{output_size};
+    std::shared_ptr<mtd::StubBuffer> buffer{solid_buffer({2, 2}, mir_pixel_format_xrgb_8888, 0xff112233)};
+    NiceMock<mtd::MockRenderable> renderable;
+    mg::RenderableList const renderables{mt::fake_shared(renderable)};
+    mrs::Renderer renderer{allocator, xrgb_8888};
+};
+}
+
+TEST_F(SoftwareRenderer, draws_opaque_buffer_at_its_screen_position)
+{
+    renderer.render(renderables);
+
+    for (auto y = 0; y != output_size.height.as_int(); ++y)
+    {
+        for (auto x = 0; x != output_size.width.as_int(); ++x)
+        {
+            auto const inside = 2 <= x && x < 4 && 3 <= y && y < 5;
+            EXPECT_THAT(allocator.pixel(x, y) & rgb_mask, Eq(inside ? 0x112233u : 0u))
+                << "at (" << x << ", " << y << ")";
+        }
+    }
+}
+
+TEST_F(SoftwareRenderer, scales_buffer_to_its_screen_position)
+{
+    buffer = solid_buffer({1, 1}, mir_pixel_format_xrgb_8888, 0xffaabbcc);
+
+    renderer.render(renderables);
+
+    EXPECT_THAT(allocator.pixel(1, 3) & rgb_mask, Eq(0u));
+    EXPECT_THAT(allocator.pixel(2, 3) & rgb_mask, Eq(0xaabbccu));
+    EXPECT_THAT(allocator.pixel(3, 4) & rgb_mask, Eq(0xaabbccu));
+    EXPECT_THAT(allocator.pixel(4, 4) & rgb_mask, Eq(0u));
+}
+
+TEST_F(SoftwareRenderer, filters_scaled_buffer_as_gl_linear_filtering_does)
+{
+    buffer = std::make_shared<mtd::StubBuffer>(
+        mg::BufferProperties{{2, 1}, mir_pixel_format_xrgb_8888, mg::BufferUsage::software});
+    uint32_t const texels[] = {0xff000000, 0xff0000ff};
+    std::memcpy(buffer->written_pixels.data(), texels, sizeof texels);
+    ON_CALL(renderable, screen_position()).WillByDefault(Return(geom::Rectangle{{2, 3}, {4, 1}}));
+
+    renderer.render(renderables);
+
+    // Pixel centres fall a quarter and three quarters of the way between the texel centres
+    EXPECT_THAT(allocator.pixel(2, 3) & 0xff, Eq(0x00u));
+    EXPECT_THAT(allocator.pixel(3, 3) & 0xff, AllOf(Ge(0x3fu), Le(0x40u)));
+    EXPECT_THAT(allocator.pixel(4, 3) & 0xff, AllOf(Ge(0xbfu), Le(0xc0u)));
+    EXPECT_THAT(allocator.pixel(5, 3) & 0xff, Eq(0xffu));
+}
+
+TEST_F(SoftwareRenderer, blends_translucent_buffer_over_those_below)
+{
+    NiceMock<mtd::MockRenderable> below;
+    ON_CALL(below, buffer()).WillByDefault(Return(solid_buffer({8, 8}, mir_pixel_format_xrgb_8888, 0xffffffff)));
+    ON_CALL(below, screen_position()).WillByDefault(Return(geom::Rectangle{{0, 0}, output_size}));
+    ON_CALL(below, transformation()).WillByDefault(Return(glm::mat4{1}));
+
+    // Half-transparent blue, premultiplied
+    buffer = solid_buffer({2, 2}, mir_pixel_format_argb_8888, 0x80000080);
+    ON_CALL(renderable, shaped()).WillByDefault(Return(true));
+
+    renderer.render({mt::fake_shared(below), mt::fake_shared(renderable)});
+
+    EXPECT_THAT(allocator.pixel(0, 0) & rgb_mask, Eq(0xffffffu));
+    EXPECT_THAT(allocator.pixel(2, 3) & rgb_mask, Eq(0x7f7fffu));
+}
+
+TEST_F(SoftwareRenderer, fades_buffer_by_its_alpha)
+{
+    ON_CALL(renderable, alpha()).WillByDefault(Return(0.5f));
+    buffer = solid_buffer({2, 2}, mir_pixel_format_xrgb_8888, 0xffffffff);
+
+    renderer.render(renderables);
+
+    auto const faded = allocator.pixel(2, 3) & 0xff;
+    EXPECT_THAT(faded, AllOf(Ge(0x7fu), Le(0x80u)));
+}
+
+TEST_F(SoftwareRenderer, only_repaints_damage_when_framebuffer_holds_previous_frame)
+{
+    renderer.render(renderables);
+
+    uint32_t const sentinel = 0xff123456;
+    allocator.set_pixel(7, 7, sentinel);
+    allocator.set_pixel(2, 3, sentinel);
+
+    renderer.set_damage(geom::Rectangles{geom::Rectangle{{2, 3}, {1, 1}}});
+    renderer.render(renderables);
+
+    EXPECT_THAT(allocator.pixel(7, 7), Eq(sentinel));
+    EXPECT_THAT(allocator.pixel(2, 3) & rgb_mask, Eq(0x112233u));
+}
+
+TEST_F(SoftwareRenderer, repaints_everything_without_damage_information)
+{
+    renderer.render(renderables);
+
+    uint32_t const sentinel = 0xff123456;
+    allocator.set_pixel(7, 7, sentinel);
+
+    renderer.render(renderables);
+
+    EXPECT_THAT(allocator.pixel(7, 7) & rgb_mask, Eq(0u));
+}
+
+TEST_F(SoftwareRenderer, repaints_every_framebuffer_in_full_after_the_output_transform_changes)
+{
+    DoubleBufferedAllocator double_buffered{output_size};
+    mrs::Renderer double_buffered_renderer{double_buffered, xrgb_8888};
+    double_buffered_renderer.render(renderables);
+    double_buffered_renderer.render(renderables);
+
+    // Half a turn
+    double_buffered_renderer.set_output_transform(glm::mat2{-1, 0, 0, -1});
+    double_buffered_renderer.set_damage(geom::Rectangles{geom::Rectangle{{2, 3}, {1, 1}}});
+    double_buffered_renderer.render(renderables);
+
+    // This one was last drawn before the transform changed, and only a pixel was damaged since
+    auto& stale = double_buffered.next();
+    uint32_t const sentinel = 0xff123456;
+    stale.set_pixel(7, 7, sentinel);
+    double_buffered_renderer.set_damage(geom::Rectangles{geom::Rectangle{{2, 3}, {1, 1}}});
+    double_buffered_renderer.render(renderables);
+
+    EXPECT_THAT(stale.pixel(7, 7) & rgb_mask, Eq(0u));
+    EXPECT_THAT(stale.pixel(2, 3) & rgb_mask, Eq(0u));
+    EXPECT_THAT(stale.pixel(4, 3) & rgb_mask, Eq(0x112233u));
+    EXPECT_THAT(stale.pixel(5, 4) & rgb_mask, Eq(0x112233u));
+}
+
+TEST(SoftwarePixelKernels, blend_matches_premultiplied_over_operator)
+{
+    // Enough pixels to exercise both the vector and scalar paths
+    size_t const n = 19;
+    std::vector<uint32_t> source(n), dest(n), expected(n);
+    for (size_t i = 0; i != n; ++i)
+    {
+        uint32_t const a = (i * 37) & 0xff;
+        auto const channel = [&](uint32_t c) { return c * a / 255; };
+        source[i] = a << 24 | channel((i * 91) & 0xff) << 16 | channel((i * 53) & 0xff) << 8 | channel((i * 17) & 0xff);
+        dest[i] = 0xff000000 | ((i * 29) & 0xff) << 16 | ((i * 71) & 0xff) << 8 | ((i * 13) & 0xff);
+    }
+
+    for (size_t i = 0; i != n; ++i)
+    {
+        uint32_t result = 0;
+        uint32_t const inverse_alpha = 255 - (source[i] >> 24);
+        for (auto shift : {0, 8, 16, 24})
+        {
+            uint32_t const s = (source[i] >> shift) & 0xff;
+            uint32_t const d = (dest[i] >> shift) & 0xff;
+            result |= (s + (d * inverse_alpha + 127) / 255) << shift;
+        }
+        expected[i] = result;
+    }
+
+    mrs::blend_pixels(dest.data(), source.data(), n, 255, false);
+
+    for (size_t i = 0; i != n; ++i)
+    {
+        for (auto shift : {0, 8, 16, 24})
+        {
+            int const got = (dest[i] >> shift) & 0xff;
+            int const want = (expected[i] >> shift) & 0xff;
+            EXPECT_THAT(got, AllOf(Ge(want - 1), Le(want + 1))) << "pixel " << i << " shift " << shift;
+        }
+    }
+}
+
+TEST(SoftwarePixelKernels, swap_red_blue_converts_between_abgr_and_argb)
+{
+    std::vector<uint32_t> pixels(19, 0x80112233);
+
+    mrs::swap_red_blue(pixels.data(), pixels.size());
+
+    EXPECT_THAT(pixels, Each(Eq(0x80332211u)));
+}
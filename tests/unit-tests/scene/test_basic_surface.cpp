@@ -28,6 +28,7 @@
 #include "mir/test/doubles/stub_cursor_image.h"
 #include "mir/test/doubles/mock_buffer_stream.h"
 #include "mir/test/doubles/stub_buffer.h"
+#include "mir/test/doubles/stub_renderable.h"
 #include "mir/test/doubles/stub_session.h"
 #include "mir/test/doubles/explicit_executor.h"
 #include "mir/test/fake_shared.h"
@@ -74,6 +75,7 @@ public:
     MOCK_METHOD2(cursor_image_set_to, void(ms::Surface const*, std::weak_ptr<mir::graphics::CursorImage> const& image));
     MOCK_METHOD1(cursor_image_removed, void(ms::Surface const*));
     MOCK_METHOD2(application_id_set_to, void(ms::Surface const*, std::string const&));
+    MOCK_METHOD2(input_region_set_to, void(ms::Surface const*, std::vector<geom::Rectangle> const&));
 };
 
 struct BasicSurfaceTest : public testing::Test
@@ -1018,7 +1020,7 @@ TEST_F(BasicSurfaceTest, when_frame_is_posted_an_observer_is_notified_of_frame_w
         .WillByDefault(Return(rect.size));
 
     EXPECT_CALL(*mock_surface_observer, frame_posted(_, _, mt::RectSizeEq(rect.size)));
-    buffer_stream->frame_posted_callback(rect.size);
+    buffer_stream->frame_posted_callback(rect.size, {});
 }
 
 TEST_F(BasicSurfaceTest, when_stream_size_differs_from_buffer_size_an_observer_is_notified_of_frame_with_stream_size)
@@ -1027,7 +1029,7 @@ TEST_F(BasicSurfaceTest, when_stream_size_differs_from_buffer_size_an_observer_i
     geom::Size const stream_size{rect.size * 1.5};
 
     auto buffer_stream = std::make_shared<NiceMock<mtd::MockBufferStream>>();
-    std::function<void(geom::Size const&)> frame_posted_callback;
+    std::function<void(geom::Size const&, geom::Rectangles const&)> frame_posted_callback;
     ON_CALL(*buffer_stream, stream_size())
         .WillByDefault(Return(stream_size));
 
@@ -1035,7 +1037,7 @@ TEST_F(BasicSurfaceTest, when_stream_size_differs_from_buffer_size_an_observer_i
     surface.set_streams({ms::StreamInfo{buffer_stream, {}, {}}});
 
     EXPECT_CALL(*mock_surface_observer, frame_posted(_, _, mt::RectSizeEq(stream_size)));
-    buffer_stream->frame_posted_callback(stream_size * 2);
+    buffer_stream->frame_posted_callback(stream_size * 2, {});
 }
 
 TEST_F(BasicSurfaceTest, when_stream_info_has_explicit_size_an_observer_is_notified_of_frame_with_stream_info_size)
@@ -1045,7 +1047,7 @@ TEST_F(BasicSurfaceTest, when_stream_info_has_explicit_size_an_observer_is_notif
     geom::Size const stream_size{stream_info_size * 2};
 
     auto buffer_stream = std::make_shared<NiceMock<mtd::MockBufferStream>>();
-    std::function<void(geom::Size const&)> frame_posted_callback;
+    std::function<void(geom::Size const&, geom::Rectangles const&)> frame_posted_callback;
     ON_CALL(*buffer_stream, stream_size())
         .WillByDefault(Return(stream_size));
 
@@ -1053,7 +1055,7 @@ TEST_F(BasicSurfaceTest, when_stream_info_has_explicit_size_an_observer_is_notif
     surface.set_streams({ms::StreamInfo{buffer_stream, {}, stream_info_size}});
 
     EXPECT_CALL(*mock_surface_observer, frame_posted(_, _, mt::RectSizeEq(stream_info_size)));
-    buffer_stream->frame_posted_callback(stream_size);
+    buffer_stream->frame_posted_callback(stream_size, {});
 }
 
 TEST_F(BasicSurfaceTest, when_frame_is_posted_an_observer_is_notified_of_frame_at_origin)
@@ -1065,7 +1067,7 @@ TEST_F(BasicSurfaceTest, when_frame_is_posted_an_observer_is_notified_of_frame_a
     surface.set_streams({ms::StreamInfo{buffer_stream, {}, {}}});
 
     EXPECT_CALL(*mock_surface_observer, frame_posted(_, _, mt::RectTopLeftEq(geom::Point{})));
-    buffer_stream->frame_posted_callback(rect.size);
+    buffer_stream->frame_posted_callback(rect.size, {});
 }
 
 TEST_F(BasicSurfaceTest, when_stream_info_has_offset_an_observer_is_notified_of_frame_with_correct_offset)
@@ -1074,13 +1076,13 @@ TEST_F(BasicSurfaceTest, when_stream_info_has_offset_an_observer_is_notified_of_
     geom::Displacement const stream_info_offset{7, 10};
 
     auto buffer_stream = std::make_shared<NiceMock<mtd::MockBufferStream>>();
-    std::function<void(geom::Size const&)> frame_posted_callback;
+    std::function<void(geom::Size const&, geom::Rectangles const&)> frame_posted_callback;
 
     surface.register_interest(mock_surface_observer, executor);
     surface.set_streams({ms::StreamInfo{buffer_stream, stream_info_offset, {}}});
 
     EXPECT_CALL(*mock_surface_observer, frame_posted(_, _, mt::RectTopLeftEq(geom::Point{} + stream_info_offset)));
-    buffer_stream->frame_posted_callback(rect.size);
+    buffer_stream->frame_posted_callback(rect.size, {});
 }
 
 TEST_F(BasicSurfaceTest, when_surface_has_margins_an_observer_is_notified_of_frame_with_correct_offset)
@@ -1090,14 +1092,14 @@ TEST_F(BasicSurfaceTest, when_surface_has_margins_an_observer_is_notified_of_fra
     geom::DeltaX const margin_left{3}, margin_right{5};
 
     auto buffer_stream = std::make_shared<NiceMock<mtd::MockBufferStream>>();
-    std::function<void(geom::Size const&)> frame_posted_callback;
+    std::function<void(geom::Size const&, geom::Rectangles const&)> frame_posted_callback;
 
     surface.register_interest(mock_surface_observer, executor);
     surface.set_streams({ms::StreamInfo{buffer_stream, {}, {}}});
 
     EXPECT_CALL(*mock_surface_observer, frame_posted(_, _, mt::RectTopLeftEq(geom::Point{} + margin_top + margin_left)));
     surface.set_window_margins(margin_top, margin_left, margin_bottom, margin_right);
-    buffer_stream->frame_posted_callback({20, 30});
+    buffer_stream->frame_posted_callback({20, 30}, {});
 }
 
 TEST_F(BasicSurfaceTest, default_application_id)
@@ -1142,6 +1144,37 @@ TEST_F(BasicSurfaceTest, does_not_notify_if_application_id_is_unchanged)
     surface.set_application_id(id);
 }
 
+TEST_F(BasicSurfaceTest, notifies_about_input_region_changes)
+{
+    using namespace testing;
+
+    std::vector<geom::Rectangle> const region{{{0, 0}, {5, 5}}, {{-10, 2}, {3, 3}}};
+
+    EXPECT_CALL(*mock_surface_observer, input_region_set_to(_, region))
+        .Times(1);
+
+    surface.register_interest(mock_surface_observer, executor);
+
+    surface.set_input_region(region);
+}
+
+TEST_F(BasicSurfaceTest, does_not_notify_if_input_region_is_unchanged)
+{
+    using namespace testing;
+
+    std::vector<geom::Rectangle> const region{{{0, 0}, {5, 5}}};
+
+    EXPECT_CALL(*mock_surface_observer, input_region_set_to(_, _))
+        .Times(2);
+
+    surface.register_interest(mock_surface_observer, executor);
+
+    surface.set_input_region({});
+    surface.set_input_region(region);
+    surface.set_input_region(region);
+    surface.set_input_region({});
+}
+
 TEST_F(BasicSurfaceTest, notifies_of_client_close_request)
 {
     using namespace testing;
@@ -1573,7 +1606,7 @@ TEST_F(BasicSurfaceTest, buffer_can_be_submitted_to_original_stream_after_surfac
 
     auto local_stream = std::make_shared<NiceMock<mtd::MockBufferStream>>();
     std::list<ms::StreamInfo> local_stream_list = { { local_stream, {}, {} } };
-    std::function<void(geom::Size const&)> callback = [](auto){};
+    std::function<void(geom::Size const&, geom::Rectangles const&)> callback = [](auto, auto){};
 
     EXPECT_CALL(*local_stream, set_frame_posted_callback(_))
         .Times(AtLeast(1))
@@ -1590,7 +1623,7 @@ TEST_F(BasicSurfaceTest, buffer_can_be_submitted_to_original_stream_after_surfac
         report);
 
     surface.reset();
-    callback({10, 10});
+    callback({10, 10}, {});
 }
 
 TEST_F(BasicSurfaceTest, buffer_can_be_submitted_to_set_stream_after_surface_destroyed)
@@ -1599,7 +1632,7 @@ TEST_F(BasicSurfaceTest, buffer_can_be_submitted_to_set_stream_after_surface_des
 
     auto local_stream = std::make_shared<NiceMock<mtd::MockBufferStream>>();
     std::list<ms::StreamInfo> local_stream_list = { { local_stream, {}, {} } };
-    std::function<void(geom::Size const&)> callback = [](auto){};
+    std::function<void(geom::Size const&, geom::Rectangles const&)> callback = [](auto, auto){};
 
     EXPECT_CALL(*local_stream, set_frame_posted_callback(_))
         .Times(AtLeast(1))
@@ -1618,5 +1651,65 @@ TEST_F(BasicSurfaceTest, buffer_can_be_submitted_to_set_stream_after_surface_des
     surface->set_streams(local_stream_list);
 
     surface.reset();
-    callback({10, 10});
+    callback({10, 10}, {});
+}
+
+TEST_F(BasicSurfaceTest, opaque_region_of_translucent_stream_is_mapped_to_screen_and_clipped)
+{
+    using namespace testing;
+
+    auto const buffer_stream = std::make_shared<NiceMock<mtd::MockBufferStream>>();
+    ON_CALL(*buffer_stream, pixel_format())
+        .WillByDefault(Return(mir_pixel_format_argb_8888));
+    ON_CALL(*buffer_stream, stream_size())
+        .WillByDefault(Return(rect.size));
+
+    auto const opaque_region = std::make_shared<std::vector<geom::Rectangle> const>(
+        std::vector<geom::Rectangle>{geom::Rectangle{{2, 3}, {20, 5}}});
+    surface.set_streams({ms::StreamInfo{buffer_stream, {}, {}, opaque_region}});
+
+    auto const renderables = surface.generate_renderables(compositor_id);
+    ASSERT_THAT(renderables.size(), Eq(1));
+    EXPECT_THAT(renderables[0]->opaque_region(), Eq(geom::Rectangles{geom::Rectangle{{6, 10}, {10, 5}}}));
+}
+
+TEST_F(BasicSurfaceTest, translucent_stream_without_opaque_region_is_not_opaque)
+{
+    using namespace testing;
+
+    auto const buffer_stream = std::make_shared<NiceMock<mtd::MockBufferStream>>();
+    ON_CALL(*buffer_stream, pixel_format())
+        .WillByDefault(Return(mir_pixel_format_argb_8888));
+
+    surface.set_streams({ms::StreamInfo{buffer_stream, {}, {}}});
+
+    auto const renderables = surface.generate_renderables(compositor_id);
+    ASSERT_THAT(renderables.size(), Eq(1));
+    EXPECT_THAT(renderables[0]->opaque_region(), Eq(geom::Rectangles{}));
+}
+
+TEST_F(BasicSurfaceTest, appends_renderables_to_an_existing_list)
+{
+    using namespace testing;
+
+    mg::RenderableList renderables{std::make_shared<mtd::StubRenderable>()};
+    surface.append_renderables(compositor_id, renderables);
+
+    ASSERT_THAT(renderables.size(), Eq(2));
+    EXPECT_THAT(renderables[1]->id(), Eq(mock_buffer_stream.get()));
+}
+
+TEST_F(BasicSurfaceTest, snapshots_reuse_the_memory_of_released_snapshots)
+{
+    using namespace testing;
+
+    auto renderables = surface.generate_renderables(compositor_id);
+    ASSERT_THAT(renderables.size(), Eq(1));
+    auto const first_snapshot = renderables[0].get();
+
+    renderables = {};
+    renderables = surface.generate_renderables(compositor_id);
+
+    ASSERT_THAT(renderables.size(), Eq(1));
+    EXPECT_THAT(renderables[0].get(), Eq(first_snapshot));
 }
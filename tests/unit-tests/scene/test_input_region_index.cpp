@@ -0,0 +1,124 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/server/scene/input_region_index.h"
+#include "mir/test/doubles/stub_surface.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+namespace ms = mir::scene;
+namespace geom = mir::geometry;
+namespace mtd = mir::test::doubles;
+
+using namespace testing;
+
+namespace
+{
+struct FakeSurface : mtd::StubSurface
+{
+    FakeSurface(geom::Rectangle const& content) : content{content} {}
+
+    geom::Rectangle input_bounds() const override { return content; }
+    std::vector<geom::Rectangle> get_input_region() const override { return input_region; }
+
+    geom::Rectangle content;
+    std::vector<geom::Rectangle> input_region;
+};
+
+struct InputRegionIndex : Test
+{
+    auto candidates_at(geom::Point point) const -> std::vector<ms::Surface const*>
+    {
+        std::vector<ms::Surface const*> candidates;
+        index.candidates_at(point, candidates);
+        return candidates;
+    }
+
+    ms::InputRegionIndex index;
+    FakeSurface surface1{{{0, 0}, {100, 100}}};
+    FakeSurface surface2{{{50, 50}, {1000, 700}}};
+};
+}
+
+TEST_F(InputRegionIndex, finds_surfaces_whose_content_contains_the_point)
+{
+    index.add(surface1);
+    index.add(surface2);
+
+    EXPECT_THAT(candidates_at({10, 10}), Contains(&surface1));
+    EXPECT_THAT(candidates_at({75, 75}), IsSupersetOf({&surface1, &surface2}));
+    EXPECT_THAT(candidates_at({1000, 700}), Contains(&surface2));
+}
+
+TEST_F(InputRegionIndex, does_not_find_surfaces_far_from_the_point)
+{
+    index.add(surface1);
+    index.add(surface2);
+
+    EXPECT_THAT(candidates_at({5000, 5000}), IsEmpty());
+    EXPECT_THAT(candidates_at({-1000, 10}), IsEmpty());
+    EXPECT_THAT(candidates_at({10, 2000}), Not(Contains(&surface1)));
+}
+
+TEST_F(InputRegionIndex, follows_updated_surfaces)
+{
+    index.add(surface1);
+
+    surface1.content.top_left = {3000, -3000};
+    index.update(surface1);
+
+    EXPECT_THAT(candidates_at({10, 10}), IsEmpty());
+    EXPECT_THAT(candidates_at({3010, -2990}), ElementsAre(&surface1));
+}
+
+TEST_F(InputRegionIndex, uses_the_input_region_relative_to_the_content)
+{
+    surface1.input_region = {{{-50, -50}, {10, 10}}, {{400, 0}, {10, 10}}};
+    index.add(surface1);
+
+    EXPECT_THAT(candidates_at({-45, -45}), ElementsAre(&surface1));
+    EXPECT_THAT(candidates_at({405, 5}), ElementsAre(&surface1));
+}
+
+TEST_F(InputRegionIndex, ignores_updates_to_surfaces_not_added)
+{
+    index.update(surface1);
+
+    EXPECT_THAT(candidates_at({10, 10}), IsEmpty());
+}
+
+TEST_F(InputRegionIndex, does_not_find_removed_surfaces)
+{
+    index.add(surface1);
+    index.add(surface2);
+
+    index.remove(surface1);
+
+    EXPECT_THAT(candidates_at({75, 75}), ElementsAre(&surface2));
+}
+
+TEST_F(InputRegionIndex, finds_surfaces_with_huge_input_regions)
+{
+    surface1.input_region = {{{-100000, -100000}, {200000, 200000}}};
+    index.add(surface1);
+
+    EXPECT_THAT(candidates_at({-99000, 99000}), ElementsAre(&surface1));
+
+    index.remove(surface1);
+
+    EXPECT_THAT(candidates_at({-99000, 99000}), IsEmpty());
+}
@@ -0,0 +1,105 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/server/scene/recycling_pool.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <array>
+#include <thread>
+
+namespace ms = mir::scene;
+
+using namespace testing;
+
+namespace
+{
+struct RecyclingPool : Test
+{
+    std::shared_ptr<ms::RecyclingPool> const pool = std::make_shared<ms::RecyclingPool>();
+};
+}
+
+TEST_F(RecyclingPool, reuses_a_freed_block_of_the_same_size)
+{
+    auto const first = pool->allocate(64);
+    pool->deallocate(first, 64);
+
+    auto const second = pool->allocate(64);
+
+    EXPECT_THAT(second, Eq(first));
+    pool->deallocate(second, 64);
+}
+
+TEST_F(RecyclingPool, does_not_reuse_a_freed_block_of_a_different_size)
+{
+    auto const small = pool->allocate(16);
+    pool->deallocate(small, 16);
+
+    auto const large = pool->allocate(256);
+
+    EXPECT_THAT(large, Ne(small));
+    pool->deallocate(large, 256);
+}
+
+TEST_F(RecyclingPool, live_blocks_are_distinct)
+{
+    auto const first = pool->allocate(32);
+    auto const second = pool->allocate(32);
+
+    EXPECT_THAT(second, Ne(first));
+    pool->deallocate(first, 32);
+    pool->deallocate(second, 32);
+}
+
+TEST_F(RecyclingPool, shared_objects_reuse_the_memory_of_destroyed_ones)
+{
+    ms::RecyclingAllocator<std::array<int, 8>> const allocator{pool};
+
+    auto object = std::allocate_shared<std::array<int, 8>>(allocator);
+    auto const first = object.get();
+    object.reset();
+
+    object = std::allocate_shared<std::array<int, 8>>(allocator);
+
+    EXPECT_THAT(object.get(), Eq(first));
+}
+
+TEST_F(RecyclingPool, shared_objects_keep_the_pool_alive)
+{
+    auto local_pool = std::make_shared<ms::RecyclingPool>();
+    std::weak_ptr<ms::RecyclingPool> const weak_pool = local_pool;
+
+    auto object = std::allocate_shared<int>(ms::RecyclingAllocator<int>{std::move(local_pool)}, 42);
+
+    EXPECT_FALSE(weak_pool.expired());
+    object.reset();
+    EXPECT_TRUE(weak_pool.expired());
+}
+
+TEST_F(RecyclingPool, blocks_can_be_freed_on_another_thread)
+{
+    ms::RecyclingAllocator<int> const allocator{pool};
+
+    auto object = std::allocate_shared<int>(allocator, 42);
+    auto const first = object.get();
+
+    std::thread{[object = std::move(object)]() mutable { object.reset(); }}.join();
+
+    auto const second = std::allocate_shared<int>(allocator, 7);
+    EXPECT_THAT(second.get(), Eq(first));
+}
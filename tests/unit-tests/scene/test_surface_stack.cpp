@@ -35,6 +35,7 @@
 #include <stdexcept>
 #include <atomic>
 #include <future>
+#include <set>
 
 namespace mc = mir::compositor;
 namespace mg = mir::graphics;
@@ -53,7 +54,7 @@ namespace
 
 void post_a_frame(mc::BufferStream& s)
 {
-    s.submit_buffer(std::make_shared<mtd::StubBuffer>());
+    s.submit_buffer(std::make_shared<mtd::StubBuffer>(), {});
 }
 
 MATCHER_P(SurfaceWithInputReceptionMode, mode, "")
@@ -452,6 +453,32 @@ TEST_F(SurfaceStack, generate_elementelements)
         stack.remove_surface(surface);
 }
 
+TEST_F(SurfaceStack, scene_elements_reuse_the_memory_of_released_elements)
+{
+    using namespace testing;
+
+    stack.register_compositor(compositor_id);
+    stack.add_surface(stub_surface1, mi::InputReceptionMode::normal);
+    stack.add_surface(stub_surface2, mi::InputReceptionMode::normal);
+
+    std::set<mc::SceneElement const*> first_elements;
+    for (auto const& element : stack.scene_elements_for(compositor_id))
+    {
+        first_elements.insert(element.get());
+    }
+
+    std::set<mc::SceneElement const*> second_elements;
+    for (auto const& element : stack.scene_elements_for(compositor_id))
+    {
+        second_elements.insert(element.get());
+    }
+
+    EXPECT_THAT(second_elements.size(), Eq(2));
+    EXPECT_THAT(second_elements, Eq(first_elements));
+
+    stack.unregister_compositor(compositor_id);
+}
+
 TEST_F(SurfaceStack, scene_observer_notified_of_add_and_remove)
 {
     using namespace ::testing;
@@ -987,6 +1014,7 @@ TEST_F(SurfaceStack, surface_at_returns_top_surface_under_cursor)
     stub_surface1->resize({900, 900});
     stub_surface2->resize({500, 200});
     stub_surface3->resize({200, 500});
+    executor.execute();
 
     EXPECT_THAT(stack.surface_at(cursor_over_all),  Eq(stub_surface3));
     EXPECT_THAT(stack.surface_at(cursor_over_12),   Eq(stub_surface2));
@@ -1008,6 +1036,7 @@ TEST_F(SurfaceStack, input_surface_at_returns_top_surface_under_cursor)
     stub_surface1->resize({900, 900});
     stub_surface2->resize({500, 200});
     stub_surface3->resize({200, 500});
+    executor.execute();
 
     EXPECT_THAT(stack.surface_at(cursor_over_all),  Eq(stub_surface3));
     EXPECT_THAT(stack.surface_at(cursor_over_12),   Eq(stub_surface2));
@@ -1031,6 +1060,7 @@ TEST_F(SurfaceStack, surface_at_returns_top_visible_surface_under_cursor)
     stub_surface2->resize({500, 200});
     stub_surface3->resize({200, 500});
     invisible_stub_surface->resize({999, 999});
+    executor.execute();
 
     EXPECT_THAT(stack.surface_at(cursor_over_all),  Eq(stub_surface3));
     EXPECT_THAT(stack.surface_at(cursor_over_12),   Eq(stub_surface2));
@@ -1054,6 +1084,7 @@ TEST_F(SurfaceStack, input_surface_at_returns_top_visible_surface_under_cursor)
     stub_surface2->resize({500, 200});
     stub_surface3->resize({200, 500});
     invisible_stub_surface->resize({999, 999});
+    executor.execute();
 
     EXPECT_THAT(stack.surface_at(cursor_over_all),  Eq(stub_surface3));
     EXPECT_THAT(stack.surface_at(cursor_over_12),   Eq(stub_surface2));
@@ -1061,6 +1092,81 @@ TEST_F(SurfaceStack, input_surface_at_returns_top_visible_surface_under_cursor)
     EXPECT_THAT(stack.surface_at(cursor_over_none).get(), IsNull());
 }
 
+TEST_F(SurfaceStack, surface_at_finds_a_moved_surface)
+{
+    stack.add_surface(stub_surface1, mi::InputReceptionMode::normal);
+    stack.add_surface(stub_surface2, mi::InputReceptionMode::normal);
+
+    stub_surface1->resize({100, 100});
+    stub_surface2->resize({100, 100});
+    stub_surface2->move_to({5000, 3000});
+    executor.execute();
+
+    EXPECT_THAT(stack.surface_at({10, 10}), Eq(stub_surface1));
+    EXPECT_THAT(stack.surface_at({5010, 3010}), Eq(stub_surface2));
+
+    stub_surface1->move_to({5050, 3050});
+    executor.execute();
+
+    EXPECT_THAT(stack.surface_at({10, 10}).get(), IsNull());
+    EXPECT_THAT(stack.surface_at({5010, 3010}), Eq(stub_surface2));
+    EXPECT_THAT(stack.surface_at({5060, 3060}), Eq(stub_surface2));
+    EXPECT_THAT(stack.surface_at({5120, 3120}), Eq(stub_surface1));
+}
+
+TEST_F(SurfaceStack, surface_at_follows_the_input_region)
+{
+    stack.add_surface(stub_surface1, mi::InputReceptionMode::normal);
+
+    stub_surface1->resize({100, 100});
+    stub_surface1->move_to({200, 200});
+    stub_surface1->set_input_region({{{-100, -100}, {50, 50}}});
+    executor.execute();
+
+    EXPECT_THAT(stack.surface_at({110, 110}), Eq(stub_surface1));
+    EXPECT_THAT(stack.surface_at({210, 210}).get(), IsNull());
+
+    stub_surface1->set_input_region({});
+    executor.execute();
+
+    EXPECT_THAT(stack.surface_at({110, 110}).get(), IsNull());
+    EXPECT_THAT(stack.surface_at({210, 210}), Eq(stub_surface1));
+}
+
+TEST_F(SurfaceStack, surface_at_finds_a_raised_surface)
+{
+    stack.add_surface(stub_surface1, mi::InputReceptionMode::normal);
+    stack.add_surface(stub_surface2, mi::InputReceptionMode::normal);
+
+    stub_surface1->resize({100, 100});
+    stub_surface2->resize({100, 100});
+    executor.execute();
+
+    EXPECT_THAT(stack.surface_at({10, 10}), Eq(stub_surface2));
+
+    stack.raise(stub_surface1);
+
+    EXPECT_THAT(stack.surface_at({10, 10}), Eq(stub_surface1));
+}
+
+TEST_F(SurfaceStack, surface_at_does_not_find_a_removed_surface)
+{
+    stack.add_surface(stub_surface1, mi::InputReceptionMode::normal);
+    stack.add_surface(stub_surface2, mi::InputReceptionMode::normal);
+
+    stub_surface1->resize({100, 100});
+    stub_surface2->resize({100, 100});
+    executor.execute();
+
+    stack.remove_surface(stub_surface2);
+
+    EXPECT_THAT(stack.surface_at({10, 10}), Eq(stub_surface1));
+
+    stack.remove_surface(stub_surface1);
+
+    EXPECT_THAT(stack.surface_at({10, 10}).get(), IsNull());
+}
+
 TEST_F(SurfaceStack, raise_surfaces_to_top)
 {
     stack.add_surface(stub_surface1, mi::InputReceptionMode::normal);